@@ -0,0 +1,58 @@
+#ifndef __NVCUDAPROXY_H__
+#define __NVCUDAPROXY_H__
+
+/* The small subset of the CUDA driver API used by the filter for stream synchronization, to identify the GPU and driver,
+* and to reserve the device memory the image arena sub-allocates.
+* Resolved at runtime from nvcuda.dll by nvCudaProxy.cpp, the same way the NvVFX and NvCVImage libraries are,
+* so the plugin neither links against nor requires the CUDA toolkit.
+*/
+
+#include <stddef.h>
+
+#ifdef _WIN32
+  #define CUDAAPI __stdcall
+#else // !_WIN32
+  #define CUDAAPI
+#endif // _WIN32
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef int CUresult;
+typedef struct CUevent_st *CUevent;
+typedef int CUdevice;
+typedef unsigned long long CUdeviceptr;
+typedef struct CUctx_st *CUcontext;
+
+#define CUDA_SUCCESS                                0   //!< The API call returned with no errors.
+#define CUDA_ERROR_INVALID_CONTEXT                201   //!< There is no context current to the calling thread.
+#define CUDA_ERROR_NOT_READY                      600   //!< The asynchronous operations issued previously have not completed yet.
+#define CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND 302   //!< The CUDA driver, or the requested entry point, could not be loaded.
+
+#define CU_EVENT_DEFAULT          0x0   //!< Default event flag
+#define CU_EVENT_BLOCKING_SYNC    0x1   //!< Event uses blocking synchronization
+#define CU_EVENT_DISABLE_TIMING   0x2   //!< Event will not record timing data
+
+CUresult CUDAAPI cuEventCreate(CUevent *phEvent, unsigned int Flags);
+CUresult CUDAAPI cuEventRecord(CUevent hEvent, struct CUstream_st *hStream);
+CUresult CUDAAPI cuEventQuery(CUevent hEvent);
+CUresult CUDAAPI cuEventSynchronize(CUevent hEvent);
+CUresult CUDAAPI cuEventDestroy(CUevent hEvent);
+CUresult CUDAAPI cuStreamSynchronize(struct CUstream_st *hStream);
+CUresult CUDAAPI cuStreamWaitEvent(struct CUstream_st *hStream, CUevent hEvent, unsigned int Flags);
+CUresult CUDAAPI cuInit(unsigned int Flags);
+CUresult CUDAAPI cuDriverGetVersion(int *driverVersion);
+CUresult CUDAAPI cuDeviceGet(CUdevice *device, int ordinal);
+CUresult CUDAAPI cuDeviceGetName(char *name, int len, CUdevice dev);
+CUresult CUDAAPI cuMemAlloc(CUdeviceptr *dptr, size_t bytesize);
+CUresult CUDAAPI cuMemFree(CUdeviceptr dptr);
+CUresult CUDAAPI cuDevicePrimaryCtxRetain(CUcontext *pctx, CUdevice dev);
+CUresult CUDAAPI cuDevicePrimaryCtxRelease(CUdevice dev);
+CUresult CUDAAPI cuCtxSetCurrent(CUcontext ctx);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // __NVCUDAPROXY_H__
@@ -0,0 +1,172 @@
+#if defined(linux) || defined(unix) || defined(__linux)
+#warning nvCudaProxy.cpp not ported
+#else // _WIN32_
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+#include "include/nvCudaProxy.h"
+
+#ifdef _WIN32
+  #define _WINSOCKAPI_
+  #include <windows.h>
+#else // !_WIN32
+  #include <dlfcn.h>
+  typedef void* HINSTANCE;
+#endif // _WIN32
+
+// Parameter string does not include the file extension
+#ifdef _WIN32
+  #define nvLoadLibrary(library) LoadLibrary(TEXT(library ".dll"))
+#else // !_WIN32
+  #define nvLoadLibrary(library) dlopen("lib" library ".so", RTLD_LAZY)
+#endif // _WIN32
+
+
+static inline void* cuGetProcAddress(HINSTANCE handle, const char* proc) {
+  if (nullptr == handle) return nullptr;
+#ifdef _WIN32
+  return GetProcAddress(handle, proc);
+#else // !_WIN32
+  return dlsym(handle, proc);
+#endif // _WIN32
+}
+
+// The driver library ships with the display driver, it is always found on the system path if an NVIDIA GPU is installed
+HINSTANCE getCudaLib() {
+#ifdef _WIN32
+  static const HINSTANCE cudaLib = nvLoadLibrary("nvcuda");
+#else // !_WIN32
+  static const HINSTANCE cudaLib = nvLoadLibrary("cuda");
+#endif // _WIN32
+  return cudaLib;
+}
+
+CUresult CUDAAPI cuEventCreate(CUevent *phEvent, unsigned int Flags) {
+  static const auto funcPtr = (decltype(cuEventCreate)*)cuGetProcAddress(getCudaLib(), "cuEventCreate");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(phEvent, Flags);
+}
+
+CUresult CUDAAPI cuEventRecord(CUevent hEvent, struct CUstream_st *hStream) {
+  static const auto funcPtr = (decltype(cuEventRecord)*)cuGetProcAddress(getCudaLib(), "cuEventRecord");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(hEvent, hStream);
+}
+
+CUresult CUDAAPI cuEventQuery(CUevent hEvent) {
+  static const auto funcPtr = (decltype(cuEventQuery)*)cuGetProcAddress(getCudaLib(), "cuEventQuery");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(hEvent);
+}
+
+CUresult CUDAAPI cuEventSynchronize(CUevent hEvent) {
+  static const auto funcPtr = (decltype(cuEventSynchronize)*)cuGetProcAddress(getCudaLib(), "cuEventSynchronize");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(hEvent);
+}
+
+CUresult CUDAAPI cuEventDestroy(CUevent hEvent) {
+  // cuEventDestroy is a macro for the _v2 entry point in cuda.h
+  static const auto funcPtr = (decltype(cuEventDestroy)*)cuGetProcAddress(getCudaLib(), "cuEventDestroy_v2");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(hEvent);
+}
+
+CUresult CUDAAPI cuStreamSynchronize(struct CUstream_st *hStream) {
+  static const auto funcPtr = (decltype(cuStreamSynchronize)*)cuGetProcAddress(getCudaLib(), "cuStreamSynchronize");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(hStream);
+}
+
+CUresult CUDAAPI cuStreamWaitEvent(struct CUstream_st *hStream, CUevent hEvent, unsigned int Flags) {
+  static const auto funcPtr = (decltype(cuStreamWaitEvent)*)cuGetProcAddress(getCudaLib(), "cuStreamWaitEvent");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(hStream, hEvent, Flags);
+}
+
+CUresult CUDAAPI cuInit(unsigned int Flags) {
+  static const auto funcPtr = (decltype(cuInit)*)cuGetProcAddress(getCudaLib(), "cuInit");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(Flags);
+}
+
+CUresult CUDAAPI cuDriverGetVersion(int *driverVersion) {
+  static const auto funcPtr = (decltype(cuDriverGetVersion)*)cuGetProcAddress(getCudaLib(), "cuDriverGetVersion");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(driverVersion);
+}
+
+CUresult CUDAAPI cuDeviceGet(CUdevice *device, int ordinal) {
+  static const auto funcPtr = (decltype(cuDeviceGet)*)cuGetProcAddress(getCudaLib(), "cuDeviceGet");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(device, ordinal);
+}
+
+CUresult CUDAAPI cuDeviceGetName(char *name, int len, CUdevice dev) {
+  static const auto funcPtr = (decltype(cuDeviceGetName)*)cuGetProcAddress(getCudaLib(), "cuDeviceGetName");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(name, len, dev);
+}
+
+/* The _v2 entry points are the ones cuda.h maps these names to */
+CUresult CUDAAPI cuMemAlloc(CUdeviceptr *dptr, size_t bytesize) {
+  static const auto funcPtr = (decltype(cuMemAlloc)*)cuGetProcAddress(getCudaLib(), "cuMemAlloc_v2");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(dptr, bytesize);
+}
+
+CUresult CUDAAPI cuMemFree(CUdeviceptr dptr) {
+  static const auto funcPtr = (decltype(cuMemFree)*)cuGetProcAddress(getCudaLib(), "cuMemFree_v2");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(dptr);
+}
+
+CUresult CUDAAPI cuDevicePrimaryCtxRetain(CUcontext *pctx, CUdevice dev) {
+  static const auto funcPtr = (decltype(cuDevicePrimaryCtxRetain)*)cuGetProcAddress(getCudaLib(), "cuDevicePrimaryCtxRetain");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(pctx, dev);
+}
+
+CUresult CUDAAPI cuDevicePrimaryCtxRelease(CUdevice dev) {
+  static const auto funcPtr = (decltype(cuDevicePrimaryCtxRelease)*)cuGetProcAddress(getCudaLib(), "cuDevicePrimaryCtxRelease_v2");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(dev);
+}
+
+CUresult CUDAAPI cuCtxSetCurrent(CUcontext ctx) {
+  static const auto funcPtr = (decltype(cuCtxSetCurrent)*)cuGetProcAddress(getCudaLib(), "cuCtxSetCurrent");
+
+  if (nullptr == funcPtr) return CUDA_ERROR_SHARED_OBJECT_SYMBOL_NOT_FOUND;
+  return funcPtr(ctx);
+}
+
+#endif // enabling for this file
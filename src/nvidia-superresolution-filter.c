@@ -19,11 +19,22 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <obs-module.h>
 #include <plugin-support.h>
 #include <util/threading.h>
+#include <util/platform.h>
+#define COBJMACROS // the C macros of the COM interfaces, such as ID3D11Texture2D_AddRef
 #include <dxgi.h>
 #include <d3d11.h>
 #include <d3d11_1.h>
 #include <tchar.h>
 #include "include/nvvfx.h"
+#include "include/nvCudaProxy.h"
+#include "superres-convert.h"
+#include "superres-fingerprint.h"
+#include "superres-tiles.h"
+#include "superres-batch.h"
+#include "superres-caps.h"
+#include "superres-snapshot.h"
+#include "superres-plan.h"
+#include "superres-arena.h"
 
 
 
@@ -72,6 +83,40 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #define S_STRENGTH "strength"
 #define S_STRENGTH_DEFAULT 0.4f
 
+#define S_PIPELINED "pipelined"
+#define S_PIPELINED_LATENCY "pipelined_latency"
+
+#define S_ASYNC "async"
+#define S_SKIP_UNCHANGED "skip_unchanged"
+#define S_TILED_UPDATES "tiled_updates"
+#define S_TILE_OVERSIZED "tile_oversized"
+
+#define S_ROI "roi"
+#define S_ROI_LEFT "roi_left"
+#define S_ROI_TOP "roi_top"
+#define S_ROI_WIDTH "roi_width"
+#define S_ROI_HEIGHT "roi_height"
+#define S_ROI_MAX 16384
+
+#define S_BATCH "batch"
+
+#define S_BACKGROUND_RELOAD "background_reload"
+
+#define S_POOL_VRAM "pool_vram"
+#define S_POOL_VRAM_DEFAULT 256 // MB
+#define S_POOL_VRAM_MAX 4096
+
+#define S_HALF_PRECISION "half_precision"
+#define S_PROPS_BENCHMARK "benchmark_precision"
+
+#define S_TIERS "tiers"
+#define S_TIER "tier%u" // the settings of tier n, and whether it's enabled
+#define S_TIER_TYPE "tier%u_type"
+#define S_TIER_SCALE "tier%u_scale"
+#define S_TIER_MODE "tier%u_sr_mode"
+#define S_TIER_STRENGTH "tier%u_strength"
+#define S_TIER_HOTKEY "nv_superres_tier%u"
+
 #define S_VALID_TARGET "target_valid"
 #define S_FATAL_ERROR "error_fatal"
 #define S_INVALID_ERROR "error_invalid"
@@ -115,6 +160,37 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #define TEXT_INVALID_WARNING_AR MT_("SuperResolution.InvalidAR")
 #define TEXT_INVALID_WARNING_SR MT_("SuperResolution.InvalidSR")
 #define TEXT_BUTTON_VERIFY MT_("SuperResolution.Verify")
+#define TEXT_PIPELINED MT_("SuperResolution.Pipelined")
+#define TEXT_PIPELINED_DESC MT_("SuperResolution.Pipelined.Desc")
+#define TEXT_PIPELINED_LATENCY MT_("SuperResolution.Pipelined.Latency")
+#define TEXT_ASYNC MT_("SuperResolution.Async")
+#define TEXT_ASYNC_DESC MT_("SuperResolution.Async.Desc")
+#define TEXT_SKIP_UNCHANGED MT_("SuperResolution.SkipUnchanged")
+#define TEXT_SKIP_UNCHANGED_DESC MT_("SuperResolution.SkipUnchanged.Desc")
+#define TEXT_TILED_UPDATES MT_("SuperResolution.TiledUpdates")
+#define TEXT_TILED_UPDATES_DESC MT_("SuperResolution.TiledUpdates.Desc")
+#define TEXT_TILE_OVERSIZED MT_("SuperResolution.TileOversized")
+#define TEXT_TILE_OVERSIZED_DESC MT_("SuperResolution.TileOversized.Desc")
+#define TEXT_ROI MT_("SuperResolution.ROI")
+#define TEXT_ROI_DESC MT_("SuperResolution.ROI.Desc")
+#define TEXT_ROI_LEFT MT_("SuperResolution.ROI.Left")
+#define TEXT_ROI_TOP MT_("SuperResolution.ROI.Top")
+#define TEXT_ROI_WIDTH MT_("SuperResolution.ROI.Width")
+#define TEXT_ROI_HEIGHT MT_("SuperResolution.ROI.Height")
+#define TEXT_BATCH MT_("SuperResolution.Batch")
+#define TEXT_BATCH_DESC MT_("SuperResolution.Batch.Desc")
+#define TEXT_BACKGROUND_RELOAD MT_("SuperResolution.BackgroundReload")
+#define TEXT_BACKGROUND_RELOAD_DESC MT_("SuperResolution.BackgroundReload.Desc")
+#define TEXT_POOL_VRAM MT_("SuperResolution.PoolVram")
+#define TEXT_POOL_VRAM_DESC MT_("SuperResolution.PoolVram.Desc")
+#define TEXT_HALF_PRECISION MT_("SuperResolution.HalfPrecision")
+#define TEXT_HALF_PRECISION_DESC MT_("SuperResolution.HalfPrecision.Desc")
+#define TEXT_BUTTON_BENCHMARK MT_("SuperResolution.HalfPrecision.Benchmark")
+#define TEXT_TIERS MT_("SuperResolution.Tiers")
+#define TEXT_TIERS_DESC MT_("SuperResolution.Tiers.Desc")
+#define TEXT_TIER MT_("SuperResolution.Tier")
+#define TEXT_TIER_HOTKEY MT_("SuperResolution.Tier.Hotkey")
+#define TEXT_TIER_HOTKEY_MAIN MT_("SuperResolution.Tier.Hotkey.Main")
 
 
 /* Set at module load time, checks to see if the NvVFX SDK is loaded, and what the users GPU and drivers supports */
@@ -124,6 +200,74 @@ static bool nvvfx_supports_ar = false;
 static bool nvvfx_supports_sr = false;
 static bool nvvfx_supports_up = false;
 
+/* Set once an effect failed to load on F16 planar buffers, every filter allocates them as F32 from then on, see planar_comp_type */
+static volatile bool nvvfx_rejects_f16 = false;
+
+/* Set once NvCVImage couldn't be bound to the render sRGB sources are drawn into, they go through render_unorm from then on, see bind_fused_render */
+static bool fused_render_unsupported = false;
+
+/* Runs the SuperRes and Upscaling effects of filters with the same configuration together, created by the first filter to batch */
+static struct nv_batch_service *batch_service = NULL;
+
+/* The device memory of every filter's images is sub-allocated from the arena, which reserves it NV_ARENA_CHUNK_BYTES at a time,
+* see alloc_arena_image. The first chunk is reserved when the plugin is loaded and kept until it's unloaded.
+* Rows are aligned to NV_ARENA_PITCH_ALIGN so they start on a memory transaction. It's set at build time by ARENA_PITCH_ALIGN
+* rather than per filter, as the buffers parked in the size pool and shared through the plan are reused with the pitch they were made with
+*/
+#define NV_ARENA_CHUNK_BYTES (64ull << 20)
+#ifndef NV_ARENA_PITCH_ALIGN
+#define NV_ARENA_PITCH_ALIGN 256
+#endif
+
+static struct nv_arena *gpu_arena = NULL;
+static CUcontext arena_context = NULL; // the primary context, retained for threads the CUDA runtime hasn't made it current on
+static CUdevice arena_device = 0;
+
+/* An effect shared by every filter that runs the same configuration, so the model is only loaded once, see share_loaded_fx */
+struct nv_fx_entry
+{
+	struct nv_fx_entry *next;
+	long refs; // filters using the effect
+	bool loaded; // the effect is loaded for the configuration below, and can be shared
+	NvVFX_EffectSelector effect;
+	uint32_t mode;
+	float strength; // the NVVFX_STRENGTH the effect is set to, which isn't part of the configuration as it's set before each run, see bind_strength
+	uint32_t width; // size of the input
+	uint32_t height;
+	uint32_t out_width; // size of the output
+	uint32_t out_height;
+	NvCVImage_ComponentType comp_type; // of the images the effect is loaded with, F16 or F32 planar buffers can't be swapped for each other
+
+	NvVFX_Handle handle;
+	CUstream stream; // the stream the effect was last set to run on
+	NvCVImage *input; // the images the effect was last set to, NULL to have them set again before the next run
+	NvCVImage *output;
+	CUevent done; // recorded after every run, a run from another stream waits on it as the effect's scratch buffers are shared
+	bool ran; // done has been recorded
+};
+
+/* Every filter draws its CUDA stream from a small pool, rather than creating one of its own */
+#define NV_STREAM_POOL_SIZE 4
+
+struct nv_stream_entry
+{
+	CUstream stream;
+	long refs;
+};
+
+/* Guards fx_cache and stream_pool, filters are created outside of the graphics thread */
+static pthread_mutex_t fx_cache_mutex;
+static struct nv_fx_entry *fx_cache = NULL;
+static struct nv_stream_entry stream_pool[NV_STREAM_POOL_SIZE];
+
+/* What loading the effects came to for the sizes they've been loaded with, and the largest input they report, for the GPU and driver in use.
+* Kept across sessions in NV_CAPS_FILE of the module config directory, so sizes an effect rejected aren't tried again
+*/
+#define NV_CAPS_FILE "capabilities.txt"
+
+static pthread_mutex_t caps_mutex; // the effects are loaded on the reconfiguration threads of every filter
+static struct nv_caps *capabilities = NULL;
+
 /* while the filter allows for non 16:9 aspect ratios, these 16:9 values are used to validate input source sizes
 * so even though a 4:3 source may be provided that has the same pixel count as a 16:9 source -
 * if the resolution is outside these bounds it will be deemed invalid for processing
@@ -139,13 +283,312 @@ static const uint32_t nv_type_resolutions[S_SCALE_N][2][2] =
 	{{160, 90}, {960, 540}}    // S_SCALE_4x
 };
 
+/* Number of output slots used when pipelining, one being processed and one finished frame being drawn */
+#define NV_OUTPUT_RING_SIZE 2
+
+/* Fingerprints are read back a frame after they're staged, so mapping the stage surface never waits on the GPU */
+#define NV_FINGERPRINT_STAGES 2
+
+/* Tiled updates run the effects on NV_TILE_SIZE square tiles of the source, with NV_TILE_OVERLAP pixels of context around each core.
+* 240 is a multiple of every supported scale's denominator and above the minimum input size of every effect
+*/
+#define NV_TILE_SIZE 240
+#define NV_TILE_OVERLAP 12
+#define NV_TILE_MAX 64 // more dirty tiles than this in a frame and the whole frame is processed instead, also the most tiles an oversized source is split into
+/* A slot is processed in full after this many tiled updates, so a change the fingerprint missed doesn't stay on screen for good */
+#define NV_TILE_REFRESH_FRAMES 120
+
+/* Settings that reload the effects are applied once they haven't changed for 300ms */
+#define NV_SETTLE_NS 300000000ULL
+
+/* A source being resized, such as a window capture being dragged, is only reconfigured for once it has kept its size for this many ticks */
+#define NV_RESIZE_SETTLE_FRAMES 15
+
+/* Quality tiers, tier 0 is the main settings and the rest are configured in the Quality Tiers group, see switch_tier */
+#define NV_TIER_MAX 4
+
+/* Bits of nv_batch_key.variant, the inputs of a batch's members agree on their range and precision */
+#define NV_BATCH_VARIANT_AR 1 // SuperRes is fed the [0, 1] AR output, rather than the [0, 255] source
+#define NV_BATCH_VARIANT_F16 2 // BGR f16 planar frames rather than f32
+
+/* The most buffer and output texture sets of other sizes a filter keeps parked, see start_size_swap */
+#define NV_POOL_SETS 4
+
+
+
+/* An output of the filter pipeline, the texture drawn by OBS and the NvCVImage bound to the texture the pipeline writes to */
+struct nv_output_slot
+{
+	NvCVImage *dst_img; // the final processed image, pointing to a live d3d11 gs_texture used by obs. RGBA, or BGR planar stacked into a single f32 channel
+	ID3D11Texture2D *dst_texture; // the texture dst_img is registered with CUDA for, see alloc_image_from_texture
+	gs_texture_t *scaled_texture; // the final RGBA U8 processed texture of the filter, RGBA 16F when hdr is set
+	/* BGR f32 planar output of the AR or SR pass, planes stacked vertically. Resolved into scaled_texture by the ResolvePlanar pass
+	* as NvCVImage_Transfer has no BGRf32 -> D3D RGBAu8 conversion, see Table 4, Pixel Conversions
+	* https://docs.nvidia.com/deeplearning/maxine/nvcvimage-api-guide/index.html#nvcvimage-transfer__section_wgp_qtd_xpb
+	* https://forums.developer.nvidia.com/t/no-transfer-conversion-from-planar-ncv-bgr-nvcv-f32-to-dx11-textures/183964/2
+	*/
+	gs_texture_t *planar_texture;
+	/* Region of interest, the full size output. The rest of the source stretched by the Stretch pass, with scaled_texture drawn over it */
+	gs_texture_t *frame_texture;
+	bool hdr; // scaled_texture holds linear GS_CS_709_EXTENDED, see uses_hdr_path
+	bool ready; // a frame has been processed into this slot since it was allocated
+	bool needs_compose; // scaled_texture hasn't been drawn over the stretched source in frame_texture yet
+
+	/* Asynchronous completion, the effects are queued on the CUDA stream without blocking and done is recorded after them */
+	CUevent done; // created on first use, signalled once the GPU has finished writing dst_img
+	bool in_flight; // done has been recorded for the last frame and hasn't been waited on yet
+	bool needs_resolve; // planar_texture holds a frame that hasn't been resolved into scaled_texture yet
+
+	/* Tiled updates, the fingerprint of the source frame this slot holds the processed output of */
+	struct nv_fingerprint fingerprint;
+	bool has_fingerprint;
+	uint32_t tiled_frames; // frames only the changed tiles of were processed into this slot since it was last processed in full
+};
+
+
+
+/* A second set of effects loaded at the size of a single tile, used to process only the changed parts of a frame */
+struct nv_tile_pass
+{
+	struct nv_tile_layout layout;
+	bool enabled; // the layout is valid and the effects and images below are created
+	bool loaded; // the effects below are loaded with the current settings
+	uint32_t out_width; // size of the output of a single tile
+	uint32_t out_height;
+
+	NvVFX_Handle ar_handle;
+	NvVFX_Handle sr_handle;
+	NvCVImage *ar_src_img; // All BGR f32 planar, sized to a tile or its output
+	NvCVImage *ar_dst_img;
+	NvCVImage *sr_src_img; // only allocated when SuperRes runs without the AR pass, otherwise it reads ar_dst_img
+	NvCVImage *sr_dst_img;
+
+	/* Feathered seams, see nv_tile_blend_rects */
+	bool feather; // the output of tiles is blended into the slot, until NvCVImage_CompositeRect rejects our images
+	uint32_t ramp; // output pixels across a blended band
+	NvCVImage *blend_img; // BGR planar, the part of the output slot under the tile output, at the same place as in the tile output
+	NvCVImage *ramp_x_img; // A f32 mattes ramping from 0 to 1 across a band, ramp x out_height and out_width x ramp
+	NvCVImage *ramp_y_img;
+};
+
+
+
+/* What a quality tier runs, the AR pass and everything else is set for all of them by the main settings */
+struct nv_tier_config
+{
+	int type; // one of S_TYPE_
+	int scale; // one of S_SCALE_
+	int sr_mode; // one of S_MODE_
+	float strength;
+};
+
+
+
+/*
+* The effects, buffers and output textures of a quality tier. The tier being rendered is the filter's live one, the others are
+* parked in their nv_tier. Either is (re)loaded inside an nv_fx_load, see load_fx
+*/
+struct nv_tier_state
+{
+	NvVFX_Handle sr_handle; // the handle of sr_fx
+	NvVFX_Handle ar_handle; // the handle of ar_fx
+	struct nv_fx_entry *sr_fx; // our reference to the shared effect cache, see share_loaded_fx
+	struct nv_fx_entry *ar_fx;
+
+	/* Ring of outputs. There is a single slot unless pipelining, in which case each frame is processed into the next slot
+	* while the slot finished on the previous frame is drawn, taking the NvVFX effects off the critical path of the render loop
+	*/
+	struct nv_output_slot outputs[NV_OUTPUT_RING_SIZE];
+	uint32_t output_count; // number of slots in use
+	uint32_t output_index; // the slot the last frame was processed into
+	uint32_t draw_index; // the slot drawn to the scene
+
+	struct nv_tile_pass tiles;
+
+	/* Artifact Reduction Buffers in BGRf32 Planar format */
+	NvCVImage *gpu_ar_src_img;
+	NvCVImage *gpu_ar_dst_img;
+
+	/* Super Resolution buffers in either BGRf32 Planar or Upscaling buffers in RGBAu8 Chunky format */
+	NvCVImage *gpu_sr_src_img; // src img in appropriate filter format on GPU, not allocated when SuperRes reads gpu_ar_dst_img directly
+	NvCVImage *gpu_sr_dst_img; // final processed image in appropriate filter format on gpu
+	
+	/* A staging buffer that is the maximal size for the selected filters to avoid allocations during transfers
+	* Only used with the Upscaling filter, BGRf32 planar images never undergo a conversion while going to or from a D3D texture
+	*/
+	NvCVImage *gpu_staging_img; // RGBAu8 Chunky
+
+	/* The allocations the AR and SR buffers above are views into, buffers that are never live at the same time share one */
+	NvCVImage *planned[NV_PLAN_BUFFERS];
+	NvCVImage_ComponentType planar_comp; // what the BGR planar buffers were last allocated as
+
+	uint32_t out_width;     // output width of the effects
+	uint32_t out_height;	// output height of the effects
+	uint32_t frame_out_width;  // output width determined by filter
+	uint32_t frame_out_height; // output height determined by filter
+};
+
+
+
+/* What the buffers and output textures of the live tier were allocated for, a parked set is only taken back for the same key */
+struct nv_size_key
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t out_width;
+	uint32_t out_height;
+	uint32_t frame_out_width;
+	uint32_t frame_out_height;
+	enum gs_color_space space;
+	NvCVImage_ComponentType planar_comp;
+	int type;
+	bool ar; // the AR effect exists
+	bool sr; // the SuperRes or Upscaling effect exists
+	bool target_valid;
+	bool batch;
+	bool pipelined;
+	bool roi_enabled;
+	bool oversized;
+};
+
+
+
+/* The buffers and output textures of a size the source had before, parked in the size pool until it returns to that size */
+struct nv_size_set
+{
+	bool used;
+	struct nv_size_key key;
+	NvCVImage *gpu_ar_src_img;
+	NvCVImage *gpu_ar_dst_img;
+	NvCVImage *gpu_sr_src_img;
+	NvCVImage *gpu_sr_dst_img;
+	NvCVImage *gpu_staging_img;
+	NvCVImage *planned[NV_PLAN_BUFFERS];
+	struct nv_output_slot outputs[NV_OUTPUT_RING_SIZE];
+	uint32_t output_count;
+	uint64_t bytes; // device memory the set holds, counted against pool_cap
+	uint64_t parked_at; // os_gettime_ns, the set parked the longest is evicted first
+};
+
+
+
+/* The rest of the filter a parked tier was loaded for, the tier is loaded again once any of it changes */
+struct nv_tier_base
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t frame_width;
+	uint32_t frame_height;
+	struct nv_rect roi;
+	enum gs_color_space space;
+	int ar_mode;
+	bool apply_ar;
+	bool pipelined;
+	bool tiled_updates;
+	bool roi_enabled;
+	bool half_precision;
+};
+
+
+
+struct nv_tier
+{
+	bool enabled; // always set for tier 0
+	struct nv_tier_config config;
+	bool stale; // the config changed since the tier was loaded, see update_tiers
+	bool parked; // state holds the tier loaded and ready to be switched to
+	bool failed; // loading the tier failed, it isn't tried again until its config or base changes
+	struct nv_tier_base base; // what state was loaded for, or failed to load for
+	struct nv_tier_state state;
+	obs_hotkey_id hotkey;
+};
+
+
+
+/*
+* Loading the effects and buffers of a tier, see load_fx. Everything loading them reads is copied in, so the load runs on a thread of its own
+* without touching the filter: start_reconfigure takes the live tier out of the filter into reconfig, start_warming loads a tier to park
+*/
+struct nv_fx_load
+{
+	struct nv_tier_state state; // the tier, its effects and buffers are (re)created and loaded in place, its output slots left alone
+	struct nv_tier_config config;
+	CUstream stream;
+	uint32_t width; // the effects input, see the filter
+	uint32_t height;
+	int ar_mode;
+	bool apply_ar;
+	bool half_precision;
+	bool is_target_valid;
+	bool oversized;
+	bool tiled_updates;
+	bool batch;
+
+	/* The flags of the filter the load follows and updates, handed back with the live tier */
+	bool destroy_ar;
+	bool destroy_sr;
+	bool reload_ar_fx;
+	bool reload_sr_fx;
+	bool are_images_allocated;
+	bool images; // (re)allocate the buffers, see reconfig_images
+	bool pool_restored; // the buffers were taken from the size pool, the effects only have to be loaded with them
+	bool invalid_ar_size;
+	bool invalid_sr_size;
+
+	bool f16_rejected; // an effect just failed to load on F16 buffers, load_fx loads it again on F32 ones
+	bool success; // the buffers were allocated
+	bool loaded; // the effects were loaded
+	bool stopped; // a fatal error, see load_error
+	volatile bool done; // set once load_fx is done with the tier
+};
+
+
+
+/*
+* The settings of a filter as nv_superres_filter_update reads them. Published whole through a snapshot and applied on the
+* graphics thread by apply_settings, so the render loop works with one generation of the settings throughout a frame
+*/
+struct nv_settings
+{
+	int type;
+	int scale;
+	int sr_mode;
+	bool apply_ar;
+	int ar_mode;
+	float strength;
+	bool pipelined;
+	bool async_run;
+	bool skip_unchanged;
+	bool tile_oversized;
+	bool batch;
+	bool background_reload;
+	int pool_vram; // MB
+	bool roi_enabled;
+	struct nv_rect roi;
+	bool tiled_updates;
+	bool half_precision;
+	bool tiers_enabled;
+	bool tier_enabled[NV_TIER_MAX];
+	struct nv_tier_config tiers[NV_TIER_MAX]; // tier 0 is the main settings above
+};
+
+
+
+/* Lifecycle of a filter. Any thread reads it with get_lifecycle, it's only moved between states by set_lifecycle and stop_processing */
+enum nv_lifecycle
+{
+	NV_LIFECYCLE_RUNNING, // processing frames, or getting ready to on the graphics thread
+	NV_LIFECYCLE_RECONFIGURING, // the effects and their buffers belong to the reconfiguration until it's finished, see start_reconfigure
+	NV_LIFECYCLE_STOPPED, // a fatal error stopped processing, until the filter is reset
+	NV_LIFECYCLE_DESTROYING, // the destruction of the filter is queued, nothing moves it out of this state
+};
+
 
 
 struct nv_superresolution_data
 {
 	/* OBS and other vars */
-	volatile bool processing_stopped; // essentially a mutex to use, as a signal to stop processing of things outside of our block
-																		// or to signal a catastrophic failure has occured
+	volatile long lifecycle; // one of nv_lifecycle
 	obs_source_t *context;
 	bool processed_frame;
 	bool done_initial_render;
@@ -153,7 +596,7 @@ struct nv_superresolution_data
 	bool invalid_ar_size;
 	bool invalid_sr_size;
 	bool show_size_error;
-	bool got_new_frame;
+	volatile bool got_new_frame; // set by the video thread
 	signal_handler_t *handler;
 	bool reload_ar_fx;
 	bool reload_sr_fx;
@@ -163,55 +606,128 @@ struct nv_superresolution_data
 	bool are_images_allocated;
 	bool destroy_ar;
 	bool destroy_sr;
-	bool destroying;
+	bool pipelined; // process each frame while drawing the one finished before it
+	bool half_precision; // allocate the BGR planar buffers and textures as F16, see planar_comp_type
+	enum gs_color_format render_planar_format; // what render_planar was created as, it's recreated when a tier switch changes planar_comp
+	bool async_run; // queue the effects without blocking, waiting on the slot's completion event only when it's drawn
+	bool async_requested; // the Asynchronous setting, async_run is off despite it after a failure
+	bool async_failed; // CUDA events failed, the effects run synchronously until the Asynchronous setting is changed
+	bool skip_unchanged; // reuse the last output for non async sources while their fingerprint doesn't change
+	bool tiled_updates; // only run the effects on the tiles of the source that changed since the frame in the output slot
+	bool tile_oversized; // accept sources larger than nv_type_resolutions allows, and process them in tiles within those limits
+	bool oversized; // the current source is larger than the effects accept, and is only ever processed by the tile pass
+	bool roi_enabled; // only run the effects on the region of interest, stretching the rest of the source
+	struct nv_rect roi_setting; // the region of interest as set by the user, a width or height of 0 extends it to the edge of the source
+	struct nv_rect roi; // the region of interest within the current source, the whole source when disabled
+	bool fingerprint_valid; // fingerprint holds the fingerprint of the last frame rendered with the current settings
+	struct nv_fingerprint fingerprint;
+	bool batch; // run the SuperRes or Upscaling pass in a batch with the other filters that have the same configuration
+	bool batch_failed; // running the batch failed, the filter runs its own effects until its settings change
+	struct nv_batch_member *batch_member; // the filter's membership of its batch group, while it's eligible to batch
+	CUevent batch_staged; // recorded on our stream once the input of the frame submitted to the batch has been written
+	uint32_t batch_slot; // the output slot the frame submitted to the batch goes to
+
+	/* Size pool. When the source changes size, the buffers and output textures of the old size are parked rather than destroyed,
+	* and taken back if it returns to that size, see start_size_swap
+	*/
+	struct nv_size_set pool[NV_POOL_SETS];
+	uint64_t pool_cap; // bytes of device memory the parked sets may take, nothing is parked when 0
+	struct nv_size_key images_key; // what the live buffers and output textures were allocated for
+	bool images_keyed; // images_key is valid, a tier switch replacing the live buffers clears it
+	bool pool_restored; // the reconfiguration took the buffers from the pool rather than allocating them, and takes its output textures too
+	struct nv_size_set parking; // the buffers replaced by the reconfiguration, parked with the output textures drawn meanwhile once it's done
+	struct nv_size_set restoring; // the output textures of the set the reconfiguration took from the pool
+
+	/* Reconfiguration, the effects and their buffers are recreated and reloaded on a thread of their own while the last output is drawn.
+	* The live tier is taken out into reconfig, and the graphics thread leaves the sizes alone until reconfig.done is set, see start_reconfigure
+	*/
+	bool background_reload; // reconfigure on reconfig_thread rather than on the graphics thread
+	bool reconfig_threaded; // the reconfiguration runs on reconfig_thread, which has to be joined
+	bool reconfig_pending; // reconfig holds the live tier, until join_reconfigure hands it back
+	struct nv_fx_load reconfig;
+	bool reconfig_images; // the NvCVImage buffers were reallocated, the textures have to be recreated to match
+	enum gs_color_space reconfig_space; // the color space of the source the reconfiguration was started for
+	pthread_t reconfig_thread;
+
+	/* Settings, published by nv_superres_filter_update and applied by the tick between reconfigurations */
+	struct nv_snapshot *settings;
+	pthread_mutex_t settings_mutex; // there's a single writer of the snapshot at a time
+	uint64_t settings_generation; // the generation of the settings applied
+
+	/* Quality tiers. The live tier is in live, the others are loaded on warm_thread through a load of their own while the live tier
+	* keeps running, and parked until a hotkey switches to them, see switch_tier
+	*/
+	bool tiers_enabled;
+	struct nv_tier tiers[NV_TIER_MAX];
+	uint32_t active_tier; // the live tier
+	volatile long requested_tier; // set by the hotkeys
+	struct nv_fx_load *warming; // the load of warming_tier, while it runs on warm_thread
+	uint32_t warming_tier;
+	pthread_t warm_thread;
 
 	/* RTX SDK vars */
 	unsigned int version;
-	NvVFX_Handle sr_handle;
-	NvVFX_Handle ar_handle;
-	CUstream stream;	// CUDA stream
+	CUstream stream;	// CUDA stream, drawn from stream_pool
 	int ar_mode;		// filter mode, should be one of S_MODE_AR
 	int sr_mode;		// filter mode, should be one of S_MODE_SR
 	int type;			// filter type, should be one of S_TYPE_
 	int scale;			// sr_scale mode, should be one of S_SCALE_
 	float strength;		// effect strength, only effects upscaling filter?
 
+	/* Changes that need the effects reloaded are held back until the settings have stayed the same for NV_SETTLE_NS,
+	* so dragging a slider reloads the effects once when it's let go of rather than on every step, see apply_held_settings
+	*/
+	bool settling; // a change is being held back
+	uint64_t changed_at; // os_gettime_ns of the last change held back
+	int requested_sr_mode;
+	int requested_ar_mode;
+	struct nv_rect requested_roi;
+	float batch_strength; // the strength settled on, batches are loaded with their strength
+
+	/* Source size changes are held back the same way, until the source has kept its size for NV_RESIZE_SETTLE_FRAMES ticks.
+	* Meanwhile the last output is drawn stretched to the output size the source will have, see draw_previous_output
+	*/
+	bool resizing; // the source size differs from the one the filter is configured for, and hasn't settled yet
+	uint32_t resize_width; // the source size being settled on
+	uint32_t resize_height;
+	uint32_t resize_out_width; // the output size it will have
+	uint32_t resize_out_height;
+	uint32_t resize_frames; // ticks the source has kept resize_width x resize_height
+
 	/* OBS render buffers for NvVFX */
 	NvCVImage *src_img; // src img in obs format (RGBA) on GPU pointing to a live d3d11 gs_texture used by obs
-	NvCVImage *dst_img; // the final processed image, in obs format (RGBA)  pointing to a live d3d11 gs_texture used by obs
-
-	/* Artifact Reduction Buffers in BGRf32 Planar format */
-	NvCVImage *gpu_ar_src_img;
-	NvCVImage *gpu_ar_dst_img;
+	ID3D11Texture2D *src_texture; // the texture src_img is registered with CUDA for, see alloc_image_from_texture
+	NvCVImage *ingest_tmp; // GPU copy of the planes of the last async frame ingested, see ingest_frame
+	NvCVImage *ingested_img; // the first effect input, once ingest_frame has converted the current async frame into it
 
-	/* Super Resolution buffers in either BGRf32 Planar or Upscaling buffers in RGBAu8 Chunky format */
-	NvCVImage *gpu_sr_src_img; // src img in appropriate filter format on GPU
-	NvCVImage *gpu_sr_dst_img; // final processed image in appropriate filter format on gpu
-	
-	/* A staging buffer that is the maximal size for the selected filters to avoid allocations during transfers */
-	NvCVImage *gpu_staging_img; // RGBAu8 Chunky if Upscaling only, BGRf32 otherwise
-
-	/* Intermediate buffer between final destination image, and dst_img. Should be removed if nvidia ever fixes this issue.
-	* Not used with Upscaling filter as this is only needed with BGRf32 -> D3D RGBAu8 transfers
-	* See Table 4, Pixel Conversions https://docs.nvidia.com/deeplearning/maxine/nvcvimage-api-guide/index.html#nvcvimage-transfer__section_wgp_qtd_xpb
-	* See this for a very basic and non-informational official response from 2021 as to why this is needed
-	* https://forums.developer.nvidia.com/t/no-transfer-conversion-from-planar-ncv-bgr-nvcv-f32-to-dx11-textures/183964/2
-	*/
-	NvCVImage *gpu_dst_tmp_img; // RGBAu8 chunky Format
+	/* The live tier, whose effects and buffers frames are processed with and whose output textures are drawn */
+	struct nv_tier_state live;
 
 	/* upscaling effect vars */
 	gs_effect_t *effect;
 	gs_texrender_t *render;
-	gs_texrender_t *render_unorm; // the converted RGBA U8 render of our source
-	gs_texture_t *scaled_texture; // the final RGBA U8 processed texture of the filter
-	uint32_t width;         // width of source
-	uint32_t height;        // height of source
-	uint32_t out_width;     // output width determined by filter
-	uint32_t out_height;	// output height determined by filter
+	gs_texrender_t *render_unorm; // the converted RGBA U8 render of our source, only created for sources that aren't 8 bit sRGB, see uses_fused_render
+	gs_texrender_t *src_render; // the texrender src_img is bound to
+	gs_texrender_t *render_planar; // the converted BGR f32 planar render of our source, planes stacked vertically
+	gs_texrender_t *fingerprint_partial; // RGBA f32 sub-cells of the fingerprint, NV_FINGERPRINT_SPLIT times finer than its grid
+	gs_texrender_t *fingerprint_render; // RGBA f32 NV_FINGERPRINT_GRID square reduction of fingerprint_partial
+	gs_texrender_t *render_frame; // region of interest, the converted RGBA U8 render of the whole source that is stretched around it
+	gs_stagesurf_t *fingerprint_stages[NV_FINGERPRINT_STAGES]; // ring of CPU readbacks of fingerprint_render
+	bool fingerprint_staged[NV_FINGERPRINT_STAGES]; // the stage holds the fingerprint of a frame of the current source size
+	uint32_t fingerprint_stage; // the stage the next fingerprint goes to, the other holds the one of the previous frame
+	uint32_t width;         // width of the effects input, the source or its region of interest
+	uint32_t height;        // height of the effects input, the source or its region of interest
+	uint32_t frame_width;   // width of source
+	uint32_t frame_height;  // height of source
 	enum gs_color_space space;
 	gs_eparam_t *image_param;
 	gs_eparam_t *upscaled_param;
 	gs_eparam_t *multiplier_param;
+	gs_eparam_t *plane_height_param;
+	gs_eparam_t *planar_scale_param;
+	gs_eparam_t *source_width_param;
+	gs_eparam_t *source_height_param;
+	gs_eparam_t *source_offset_param;
 };
 
 
@@ -229,1158 +745,5359 @@ typedef struct img_create_params
 
 
 
-static void nv_sdk_path(TCHAR *buffer, size_t len)
+static inline enum nv_lifecycle get_lifecycle(struct nv_superresolution_data *filter)
 {
-	/* Currently hardcoded to find windows install directory, as that is the only supported OS supported by NvVFX */
-#ifdef _WIN32
-	TCHAR path[MAX_PATH];
+	return (enum nv_lifecycle)os_atomic_load_long(&filter->lifecycle);
+}
 
-	// There can be multiple apps on the system,
-	// some might include the SDK in the app package and
-	// others might expect the SDK to be installed in Program Files
-	GetEnvironmentVariable(TEXT("NV_VIDEO_EFFECTS_PATH"), path, MAX_PATH);
 
-	if (_tcscmp(path, TEXT("USE_APP_PATH")))
+
+/*
+* Moves the filter from one state of its lifecycle to another
+* return - True if the filter was in the from state, and is in the to state now
+*/
+static inline bool set_lifecycle(struct nv_superresolution_data *filter, enum nv_lifecycle from, enum nv_lifecycle to)
+{
+	return os_atomic_compare_swap_long(&filter->lifecycle, (long)from, (long)to);
+}
+
+
+
+/* Stops processing after a fatal error, from any thread. A filter being destroyed stays so */
+static inline void stop_processing(struct nv_superresolution_data *filter)
+{
+	enum nv_lifecycle state = get_lifecycle(filter);
+
+	while (state < NV_LIFECYCLE_STOPPED && !set_lifecycle(filter, state, NV_LIFECYCLE_STOPPED))
 	{
-		// App has not set environment variable to "USE_APP_PATH"
-		// So pick up the SDK dll and dependencies from Program Files
-		GetEnvironmentVariable(TEXT("ProgramFiles"), path, MAX_PATH);
-		_stprintf_s(buffer, len, TEXT("%s\\NVIDIA Corporation\\NVIDIA Video Effects\\"), path);
+		state = get_lifecycle(filter);
 	}
-#else
-#error Platform not supported, at this time the nVidia Maxine VFX SDK only supports Windows
-#endif
 }
 
 
 
-static void get_nvfx_sdk_path(char *buffer, size_t len)
+/* return - True if the filter has stopped processing, after a fatal error or because it's being destroyed */
+static inline bool is_stopped(struct nv_superresolution_data *filter)
 {
-	TCHAR tbuffer[MAX_PATH];
-	TCHAR tmodelDir[MAX_PATH];
+	return get_lifecycle(filter) >= NV_LIFECYCLE_STOPPED;
+}
 
-	nv_sdk_path(tbuffer, MAX_PATH);
 
-	size_t max_len = sizeof(tbuffer) / sizeof(TCHAR);
-	_snwprintf_s(tmodelDir, max_len, max_len, TEXT("%s\\models"), tbuffer);
 
-	wcstombs_s(0, buffer, len, tmodelDir, MAX_PATH);
+static inline bool is_reconfiguring(struct nv_superresolution_data *filter)
+{
+	return get_lifecycle(filter) == NV_LIFECYCLE_RECONFIGURING;
 }
 
 
 
 /*
-* Scales the input dimensions by the given sr_scale enum, giving the output
-* param sr_scale - sr_scale enum, should be one of S_SCALE_133x, S_SCALE_15x, S_SCALE_2x, S_SCALE_3x, S_SCALE_4x
-* param in_x - input width
-* param in_y - input height
-* param out_x - scaled width output
-* param out_y - scaled height output
+* Returns true if the first effect in a tier's pipeline takes a BGR f32 planar image, ie. the AR pass or the SuperRes filter,
+* in which case our source is converted by the ConvertPlanar shader pass instead of being transferred from the RGBA U8 render
+* 
+* param tier - the effects of the tier
+* param type - the type of its SR pass, one of S_TYPE_
 */
-static inline void get_scale_factor(uint32_t s_scale, uint32_t in_x, uint32_t in_y, uint32_t *out_x, uint32_t *out_y)
+static inline bool tier_planar_input(const struct nv_tier_state *tier, int type)
 {
-	const float scale_133 = 4.0f / 3.0f;
-	float scale = 1.0f;
+	return tier->ar_handle || (tier->sr_handle && type == S_TYPE_SR);
+}
 
-	switch (s_scale)
-	{
-	case S_SCALE_133x:
-		scale = scale_133;
-		break;
-	case S_SCALE_15x:
-		scale = 1.5f;
-		break;
-	case S_SCALE_2x:
-		scale = 2.0f;
-		break;
-	case S_SCALE_3x:
-		scale = 3.0f;
-		break;
-	case S_SCALE_4x:
-		scale = 4.0f;
-		break;
-	}
 
-	*out_x = (uint32_t)(in_x * scale + 0.5f);
-	*out_y = (uint32_t)(in_y * scale + 0.5f);
-}
 
+/*
+* Returns true if the last effect in a tier's pipeline outputs a BGR f32 planar image, ie. anything but the Upscaling filter,
+* in which case the output is copied to planar_texture and resolved into scaled_texture by the ResolvePlanar shader pass
+*/
+static inline bool tier_planar_output(const struct nv_tier_state *tier, int type)
+{
+	return tier->sr_handle ? type == S_TYPE_SR : tier->ar_handle != NULL;
+}
 
 
 
-static inline bool validate_scaling_aspect(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2)
+/*
+* Returns true if the SuperRes filter of a tier is bound directly to the AR output buffer instead of its own source buffer.
+* Both are BGR f32 planar at the source size, so there is no need to copy between them
+*/
+static inline bool tier_reads_ar_output(const struct nv_tier_state *tier, int type)
 {
-	return (x1 * y2) == (y1 * x2);
+	return tier->ar_handle && type == S_TYPE_SR;
 }
 
 
 
 /*
-* Scales the input dimensions by the given sr_scale enum, giving the output
-* param sr_scale - sr_scale enum, should be one of S_SCALE_133x, S_SCALE_15x, S_SCALE_2x, S_SCALE_3x, S_SCALE_4x
-* param in_x - input width
-* param in_y - input height
-* param out_x - scaled width output
-* param out_y - scaled height output
-* 
-* return - True if the input resolution is valid and falls within the bounds defined by nVidia,
-						and the output resolution is properly valid and falls within the bounds defined by nVidia
-						and if the aspect ratio of the input and output resolutions matches
+* Returns true if the pipeline of a tier can be run on tiles of the source, which requires it to be BGR f32 planar from end to end
+* so tiles can be copied in and out of the planar textures without conversion. Everything but the Upscaling filter
 */
-static inline bool validate_source_size(uint32_t scale, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2)
+static inline bool tier_supports_tiles(const struct nv_tier_state *tier, int type)
 {
-	if (scale < 0 || scale >= S_SCALE_N)
-		return false;
+	return tier_planar_input(tier, type) && tier_planar_output(tier, type);
+}
 
-	uint32_t min_width = nv_type_resolutions[scale][0][0];
-	uint32_t max_width = nv_type_resolutions[scale][1][0];
-	uint32_t min_height = nv_type_resolutions[scale][0][1];
-	uint32_t max_height = nv_type_resolutions[scale][1][1];
 
-	return (x1 >= min_width && x1 <= max_width && y1 >= min_height && y1 <= max_height);
+
+/* tier_planar_input of the live tier */
+static inline bool uses_planar_input(struct nv_superresolution_data *filter)
+{
+	return tier_planar_input(&filter->live, filter->type);
 }
 
 
 
-/*
-* Properly destroys the supplied fx and images, and nulls them out.
-* 
-* param fx - the NvFX handle of the effect to destroy
-* param src - the source image of the fx to destroy
-* param dst - the destination image of the fx to destroy
-*/
-static void nv_destroy_fx_filter(NvVFX_Handle *fx, NvCVImage **src, NvCVImage **dst)
+/* tier_planar_output of the live tier */
+static inline bool uses_planar_output(struct nv_superresolution_data *filter)
 {
-	if (src && *src)
-	{
-		debug("nv_destroy_fx_filter: destorying src %X", *src);
+	return tier_planar_output(&filter->live, filter->type);
+}
+
+
+
+/* tier_reads_ar_output of the live tier */
+static inline bool sr_reads_ar_output(struct nv_superresolution_data *filter)
+{
+	return tier_reads_ar_output(&filter->live, filter->type);
+}
+
+
+
+/*
+* The scale the ResolvePlanar pass applies to the planar output to bring it back to the [0, 1] range.
+* The AR pass outputs [0, 1], which SuperRes preserves when run after it, SuperRes on its own outputs [0, 255]
+* This is where the range difference between the AR output and the SuperRes input is accounted for, rather than with a scaled copy
+*/
+static inline float planar_output_scale(struct nv_superresolution_data *filter)
+{
+	return filter->live.ar_handle ? 1.0f : 1.0f / 255.0f;
+}
+
+
+
+/* tier_supports_tiles of the live tier */
+static inline bool supports_tiles(struct nv_superresolution_data *filter)
+{
+	return tier_supports_tiles(&filter->live, filter->type);
+}
+
+
+
+/*
+* The component type to allocate the BGR planar buffers and textures between the source and the output as. F16 halves their memory
+* and bandwidth, and is only used when the pipeline is BGR planar from end to end, as the Upscaling filter's RGBA U8 conversions
+* are only from F32. Every planar texture and NvCVImage follows the type, so the hops between them stay plain copies
+* 
+* param tier, type - the tier the buffers are allocated for, see tier_planar_input
+* param half_precision - the Half Precision setting
+*/
+static inline NvCVImage_ComponentType planar_comp_type(const struct nv_tier_state *tier, int type, bool half_precision)
+{
+	return half_precision && tier_supports_tiles(tier, type) && !os_atomic_load_bool(&nvvfx_rejects_f16) ? NVCV_F16 : NVCV_F32;
+}
+
+
+
+/* The format of the planar textures matching the component type of the planar buffers */
+static inline enum gs_color_format planar_format(NvCVImage_ComponentType comp_type)
+{
+	return comp_type == NVCV_F16 ? GS_R16F : GS_R32F;
+}
+
+
+
+/*
+* Returns true if an HDR source keeps its range through the pipeline. Its render is PQ encoded into the planar input by the
+* ConvertPlanarPQ pass rather than tonemapped down to 8 bit sRGB, the effects run on the f32 planes as they are, and ResolvePlanarPQ
+* decodes the planar output into an RGBA 16F scaled_texture that is drawn as GS_CS_709_EXTENDED.
+* Only a pipeline that is BGR f32 planar from end to end carries it, and only without a region of interest
+* 
+* param filter - our OBS filter structure
+* param tier, type - the tier drawing the source, see tier_planar_input
+*/
+static inline bool uses_hdr_path(struct nv_superresolution_data *filter, const struct nv_tier_state *tier, int type)
+{
+	return (filter->space == GS_CS_709_EXTENDED || filter->space == GS_CS_709_SCRGB) && tier_supports_tiles(tier, type) &&
+	       !filter->roi_enabled;
+}
+
+
+
+static void nv_sdk_path(TCHAR *buffer, size_t len)
+{
+	/* Currently hardcoded to find windows install directory, as that is the only supported OS supported by NvVFX */
+#ifdef _WIN32
+	TCHAR path[MAX_PATH];
+
+	// There can be multiple apps on the system,
+	// some might include the SDK in the app package and
+	// others might expect the SDK to be installed in Program Files
+	GetEnvironmentVariable(TEXT("NV_VIDEO_EFFECTS_PATH"), path, MAX_PATH);
+
+	if (_tcscmp(path, TEXT("USE_APP_PATH")))
+	{
+		// App has not set environment variable to "USE_APP_PATH"
+		// So pick up the SDK dll and dependencies from Program Files
+		GetEnvironmentVariable(TEXT("ProgramFiles"), path, MAX_PATH);
+		_stprintf_s(buffer, len, TEXT("%s\\NVIDIA Corporation\\NVIDIA Video Effects\\"), path);
+	}
+#else
+#error Platform not supported, at this time the nVidia Maxine VFX SDK only supports Windows
+#endif
+}
+
+
+
+static void get_nvfx_sdk_path(char *buffer, size_t len)
+{
+	TCHAR tbuffer[MAX_PATH];
+	TCHAR tmodelDir[MAX_PATH];
+
+	nv_sdk_path(tbuffer, MAX_PATH);
+
+	size_t max_len = sizeof(tbuffer) / sizeof(TCHAR);
+	_snwprintf_s(tmodelDir, max_len, max_len, TEXT("%s\\models"), tbuffer);
+
+	wcstombs_s(0, buffer, len, tmodelDir, MAX_PATH);
+}
+
+
+
+/*
+* Scales the input dimensions by the given sr_scale enum, giving the output
+* param sr_scale - sr_scale enum, should be one of S_SCALE_133x, S_SCALE_15x, S_SCALE_2x, S_SCALE_3x, S_SCALE_4x
+* param in_x - input width
+* param in_y - input height
+* param out_x - scaled width output
+* param out_y - scaled height output
+*/
+static inline void get_scale_factor(uint32_t s_scale, uint32_t in_x, uint32_t in_y, uint32_t *out_x, uint32_t *out_y)
+{
+	const float scale_133 = 4.0f / 3.0f;
+	float scale = 1.0f;
+
+	switch (s_scale)
+	{
+	case S_SCALE_133x:
+		scale = scale_133;
+		break;
+	case S_SCALE_15x:
+		scale = 1.5f;
+		break;
+	case S_SCALE_2x:
+		scale = 2.0f;
+		break;
+	case S_SCALE_3x:
+		scale = 3.0f;
+		break;
+	case S_SCALE_4x:
+		scale = 4.0f;
+		break;
+	}
+
+	*out_x = (uint32_t)(in_x * scale + 0.5f);
+	*out_y = (uint32_t)(in_y * scale + 0.5f);
+}
+
+
+
+
+static inline bool validate_scaling_aspect(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2)
+{
+	return (x1 * y2) == (y1 * x2);
+}
+
+
+
+/*
+* Gets the largest input an effect accepts at the given scale, the limit of nv_type_resolutions narrowed by the limit the effect reports
+* 
+* param scale - sr_scale enum, S_SCALE_AR for the Artifact Reduction effect and any other for the SuperRes effect
+* param width - receives the largest input width
+* param height - receives the largest input height
+*/
+static void get_max_input_size(uint32_t scale, uint32_t *width, uint32_t *height)
+{
+	*width = nv_type_resolutions[scale][1][0];
+	*height = nv_type_resolutions[scale][1][1];
+
+	uint32_t reported_width;
+	uint32_t reported_height;
+
+	pthread_mutex_lock(&caps_mutex);
+
+	if (capabilities && nv_caps_max_input(capabilities, scale == S_SCALE_AR ? NVVFX_FX_ARTIFACT_REDUCTION : NVVFX_FX_SUPER_RES,
+					      &reported_width, &reported_height))
+	{
+		*width = reported_width < *width ? reported_width : *width;
+		*height = reported_height < *height ? reported_height : *height;
+	}
+
+	pthread_mutex_unlock(&caps_mutex);
+}
+
+
+
+/*
+* Scales the input dimensions by the given sr_scale enum, giving the output
+* param sr_scale - sr_scale enum, should be one of S_SCALE_133x, S_SCALE_15x, S_SCALE_2x, S_SCALE_3x, S_SCALE_4x
+* param in_x - input width
+* param in_y - input height
+* param out_x - scaled width output
+* param out_y - scaled height output
+* 
+* return - True if the input resolution is valid and falls within the bounds defined by nVidia,
+						and the output resolution is properly valid and falls within the bounds defined by nVidia
+						and if the aspect ratio of the input and output resolutions matches
+*/
+static inline bool validate_source_size(uint32_t scale, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2)
+{
+	if (scale < 0 || scale >= S_SCALE_N)
+		return false;
+
+	uint32_t min_width = nv_type_resolutions[scale][0][0];
+	uint32_t min_height = nv_type_resolutions[scale][0][1];
+	uint32_t max_width;
+	uint32_t max_height;
+	get_max_input_size(scale, &max_width, &max_height);
+
+	return (x1 >= min_width && x1 <= max_width && y1 >= min_height && y1 <= max_height);
+}
+
+
+
+/*
+* Gets the size of the tiles a source is split into when it's larger than the effects accept,
+* the largest input every pass of the pipeline accepts, or the source size along an axis where it already fits
+* 
+* param apply_ar - the pipeline has the AR pass
+* param type - the type of its SR pass, one of S_TYPE_
+* param scale - the scale of its SR pass, one of S_SCALE_
+* param width - width of the source
+* param height - height of the source
+* param tile_width - receives the tile width
+* param tile_height - receives the tile height
+*/
+static void get_tile_size(bool apply_ar, int type, int scale, uint32_t width, uint32_t height, uint32_t *tile_width,
+			  uint32_t *tile_height)
+{
+	*tile_width = width;
+	*tile_height = height;
+
+	uint32_t max_width;
+	uint32_t max_height;
+
+	if (apply_ar)
+	{
+		get_max_input_size(S_SCALE_AR, &max_width, &max_height);
+		*tile_width = *tile_width < max_width ? *tile_width : max_width;
+		*tile_height = *tile_height < max_height ? *tile_height : max_height;
+	}
+
+	if (type == S_TYPE_SR && scale >= 0 && scale < S_SCALE_N)
+	{
+		get_max_input_size(scale, &max_width, &max_height);
+		*tile_width = *tile_width < max_width ? *tile_width : max_width;
+		*tile_height = *tile_height < max_height ? *tile_height : max_height;
+	}
+}
+
+
+
+/*
+* Validates a source that is larger than the given scale accepts, for processing in tiles
+* 
+* return - True if the source is at least the minimum size of the scale, and splits into no more than NV_TILE_MAX tiles
+*/
+static bool validate_tiled_source_size(struct nv_superresolution_data *filter, uint32_t scale, uint32_t width, uint32_t height)
+{
+	if (width < nv_type_resolutions[scale][0][0] || height < nv_type_resolutions[scale][0][1])
+		return false;
+
+	uint32_t tile_width;
+	uint32_t tile_height;
+	get_tile_size(filter->apply_ar, filter->type, filter->scale, width, height, &tile_width, &tile_height);
+
+	struct nv_tile_layout layout;
+	return nv_tile_layout_init(&layout, width, height, tile_width, tile_height, NV_TILE_OVERLAP) && layout.cols * layout.rows <= NV_TILE_MAX;
+}
+
+
+
+/* The key of an effect configuration in the capability table */
+static struct nv_caps_key get_caps_key(const struct nv_fx_entry *config)
+{
+	const struct nv_caps_key key =
+	{
+		.effect = config->effect,
+		.mode = config->mode,
+		.width = config->width,
+		.height = config->height,
+		.out_width = config->out_width,
+		.out_height = config->out_height
+	};
+
+	return key;
+}
+
+
+
+/*
+* Checks if an effect has been rejected by NvVFX_Load for a configuration before, on this GPU and driver
+* 
+* param config - the configuration, only the fields up to the handle are used
+* return - True if loading the effect for it failed with NVCV_ERR_RESOLUTION
+*/
+static bool known_rejected(const struct nv_fx_entry *config)
+{
+	const struct nv_caps_key key = get_caps_key(config);
+
+	pthread_mutex_lock(&caps_mutex);
+	const bool rejected = capabilities && nv_caps_lookup(capabilities, &key) == NV_CAPS_REJECTED;
+	pthread_mutex_unlock(&caps_mutex);
+
+	return rejected;
+}
+
+
+
+/*
+* Records what loading an effect for a configuration came to, errors other than the resolution being rejected aren't recorded
+* 
+* param config - the configuration, only the fields up to the handle are used
+* param vfxErr - the result of NvVFX_Load
+*/
+static void record_load_result(const struct nv_fx_entry *config, NvCV_Status vfxErr)
+{
+	if (vfxErr != NVCV_SUCCESS && vfxErr != NVCV_ERR_RESOLUTION)
+	{
+		return;
+	}
+
+	const struct nv_caps_key key = get_caps_key(config);
+
+	pthread_mutex_lock(&caps_mutex);
+
+	if (capabilities)
+	{
+		nv_caps_record(capabilities, &key, vfxErr == NVCV_SUCCESS ? NV_CAPS_ACCEPTED : NV_CAPS_REJECTED);
+	}
+
+	pthread_mutex_unlock(&caps_mutex);
+}
+
+
+
+/*
+* Reads the version of the display driver's user mode driver from the adapter OBS renders on, which the effects run on too.
+* It changes with every driver update, unlike the CUDA version the driver implements
+* 
+* param version - receives the version as its 4 parts, eg. 31.0.15.5222
+* return - True if the version was read
+*/
+static bool get_umd_version(uint16_t version[4])
+{
+	IDXGIDevice *dxgi_device = NULL;
+	IDXGIAdapter *adapter = NULL;
+	LARGE_INTEGER umd;
+	bool found = false;
+
+	obs_enter_graphics();
+
+	ID3D11Device *device = (ID3D11Device *)gs_get_device_obj();
+
+	if (device && SUCCEEDED(ID3D11Device_QueryInterface(device, &IID_IDXGIDevice, (void **)&dxgi_device)) &&
+	    SUCCEEDED(IDXGIDevice_GetAdapter(dxgi_device, &adapter)))
+	{
+		/* Only the IDXGIDevice interface reports the UMD version, any other is unsupported */
+		found = SUCCEEDED(IDXGIAdapter_CheckInterfaceSupport(adapter, &IID_IDXGIDevice, &umd));
+	}
+
+	if (adapter)
+		IDXGIAdapter_Release(adapter);
+	if (dxgi_device)
+		IDXGIDevice_Release(dxgi_device);
+
+	obs_leave_graphics();
+
+	if (found)
+	{
+		version[0] = (uint16_t)((uint32_t)umd.HighPart >> 16);
+		version[1] = (uint16_t)((uint32_t)umd.HighPart & 0xffff);
+		version[2] = (uint16_t)(umd.LowPart >> 16);
+		version[3] = (uint16_t)(umd.LowPart & 0xffff);
+	}
+
+	return found;
+}
+
+
+
+/*
+* Identifies the GPU the effects run on, its display driver and the SDK, the capability table only holds for the one it was made with
+* 
+* param buffer - receives the identity
+* param len - size of the buffer
+*/
+static void get_device_identity(char *buffer, size_t len)
+{
+	char name[128];
+	char driver[64];
+	uint16_t umd[4];
+	unsigned int sdk = 0;
+	CUdevice device;
+
+	if (cuInit(0) != CUDA_SUCCESS || cuDeviceGet(&device, 0) != CUDA_SUCCESS || cuDeviceGetName(name, sizeof(name), device) != CUDA_SUCCESS)
+	{
+		snprintf(name, sizeof(name), "Unknown GPU");
+	}
+
+	/* The CUDA version only changes with major driver releases, it's only used if the display driver can't be asked */
+	if (get_umd_version(umd))
+	{
+		snprintf(driver, sizeof(driver), "driver %u.%u.%u.%u", umd[0], umd[1], umd[2], umd[3]);
+	}
+	else
+	{
+		int cuda = 0;
+		cuDriverGetVersion(&cuda);
+		snprintf(driver, sizeof(driver), "CUDA driver %d", cuda);
+	}
+
+	NvVFX_GetVersion(&sdk);
+
+	snprintf(buffer, len, "%s, %s, Video Effects SDK %u.%u.%u.%u", name, driver, sdk >> 24, (sdk >> 16) & 0xff, (sdk >> 8) & 0xff,
+		 sdk & 0xff);
+}
+
+
+
+/*
+* Asks an effect for the largest input it accepts, unless the capability table already knows it
+* 
+* param effect - one of the NVVFX_FX_ selectors
+*/
+static void probe_max_input(NvVFX_EffectSelector effect)
+{
+	uint32_t width;
+	uint32_t height;
+
+	if (nv_caps_max_input(capabilities, effect, &width, &height))
+	{
+		return;
+	}
+
+	NvVFX_Handle handle = NULL;
+
+	if (NvVFX_CreateEffect(effect, &handle) != NVCV_SUCCESS)
+	{
+		return;
+	}
+
+	/* Not every effect reports it, those are left to nv_type_resolutions */
+	if (NvVFX_GetU32(handle, NVVFX_MAX_INPUT_WIDTH, &width) == NVCV_SUCCESS &&
+	    NvVFX_GetU32(handle, NVVFX_MAX_INPUT_HEIGHT, &height) == NVCV_SUCCESS && width > 0 && height > 0)
+	{
+		debug("probe_max_input: %s accepts up to %ux%u", effect, width, height);
+		nv_caps_set_max_input(capabilities, effect, width, height);
+	}
+
+	NvVFX_DestroyEffect(handle);
+}
+
+
+
+/*
+* Creates the capability table for our GPU and driver, reading back the one saved by an earlier session if it was made for the same ones
+*/
+static void load_capabilities(void)
+{
+	char identity[256];
+	get_device_identity(identity, sizeof(identity));
+
+	capabilities = nv_caps_create(identity);
+
+	if (!capabilities)
+	{
+		return;
+	}
+
+	char *path = obs_module_config_path(NV_CAPS_FILE);
+	char *text = path ? os_quick_read_utf8_file(path) : NULL;
+
+	if (text && !nv_caps_parse(capabilities, text))
+	{
+		info("Discarding the saved capabilities, they were found with another GPU or driver than %s", identity);
+	}
+
+	bfree(text);
+	bfree(path);
+
+	if (nvvfx_supports_ar)
+	{
+		probe_max_input(NVVFX_FX_ARTIFACT_REDUCTION);
+	}
+
+	if (nvvfx_supports_sr)
+	{
+		probe_max_input(NVVFX_FX_SUPER_RES);
+	}
+}
+
+
+
+/*
+* Saves the capability table to the module config directory if anything new was found this session, and destroys it
+*/
+static void save_capabilities(void)
+{
+	if (!capabilities)
+	{
+		return;
+	}
+
+	const size_t len = nv_caps_modified(capabilities) ? nv_caps_serialize(capabilities, NULL, 0) : 0;
+	char *text = len ? (char *)bmalloc(len + 1) : NULL;
+
+	if (text && nv_caps_serialize(capabilities, text, len + 1) == len)
+	{
+		char *dir = obs_module_config_path("");
+		char *path = obs_module_config_path(NV_CAPS_FILE);
+
+		if (dir && path && (os_mkdirs(dir) == MKDIR_ERROR || !os_quick_write_utf8_file_safe(path, text, len, false, "tmp", NULL)))
+		{
+			warn("Failed to save the capabilities to %s", path);
+		}
+
+		bfree(dir);
+		bfree(path);
+	}
+
+	bfree(text);
+
+	nv_caps_destroy(capabilities);
+	capabilities = NULL;
+}
+
+
+
+/*
+* Clamps the region of interest set by the user to the source
+* 
+* param setting - the region of interest as set by the user, a width or height of 0 extends it to the edge of the source
+* param width - width of the source
+* param height - height of the source
+* param roi - receives the region of interest within the source, at least a pixel in size
+*/
+static void get_roi(const struct nv_rect *setting, uint32_t width, uint32_t height, struct nv_rect *roi)
+{
+	roi->x = setting->x < width ? setting->x : width - 1;
+	roi->y = setting->y < height ? setting->y : height - 1;
+	roi->width = setting->width == 0 || setting->width > width - roi->x ? width - roi->x : setting->width;
+	roi->height = setting->height == 0 || setting->height > height - roi->y ? height - roi->y : setting->height;
+}
+
+
+
+/*
+* Properly destroys the supplied fx and images, and nulls them out.
+* 
+* param fx - the NvFX handle of the effect to destroy
+* param src - the source image of the fx to destroy
+* param dst - the destination image of the fx to destroy
+*/
+static void nv_destroy_fx_filter(NvVFX_Handle *fx, NvCVImage **src, NvCVImage **dst)
+{
+	if (src && *src)
+	{
+		debug("nv_destroy_fx_filter: destorying src %X", *src);
 		NvCVImage_Destroy(*src);
 		*src = NULL;
 	}
 
-	if (dst && *dst)
+	if (dst && *dst)
+	{
+		debug("nv_destroy_fx_filter: destorying dst %X", *dst);
+		NvCVImage_Destroy(*dst);
+		*dst = NULL;
+	}
+
+	if (fx && *fx)
+	{
+		debug("nv_destroy_fx_filter: destorying fx %X", *fx);
+		NvVFX_DestroyEffect(*fx);
+		*fx = NULL;
+	}
+}
+
+
+
+/*
+* Destroys an image bound to a texture by alloc_image_from_texture, unregistering the texture, and releases the texture
+* param image - the image, nulled out
+* param bound - the texture it's bound to, nulled out
+*/
+static void unbind_texture_image(NvCVImage **image, ID3D11Texture2D **bound)
+{
+	nv_destroy_fx_filter(NULL, image, NULL);
+
+	if (*bound)
+	{
+		ID3D11Texture2D_Release(*bound);
+		*bound = NULL;
+	}
+}
+
+
+
+/* Destroys the backing allocations of the intermediate buffers from the given one on, any image viewing them must be destroyed or rebound */
+static void destroy_planned_backings(NvCVImage *planned[NV_PLAN_BUFFERS], uint32_t first)
+{
+	for (uint32_t i = first; i < NV_PLAN_BUFFERS; ++i)
+	{
+		nv_destroy_fx_filter(NULL, &planned[i], NULL);
+	}
+}
+
+
+
+/*
+* Releases a reference to an effect, destroying it once no filter uses it anymore
+* 
+* param entry - the reference to release, nulled out
+* param handle - the handle of the effect, nulled out
+*/
+static void release_fx(struct nv_fx_entry **entry, NvVFX_Handle *handle)
+{
+	struct nv_fx_entry *released = *entry;
+	*entry = NULL;
+	*handle = NULL;
+
+	if (!released)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&fx_cache_mutex);
+
+	const bool destroy = --released->refs == 0;
+
+	if (destroy)
+	{
+		struct nv_fx_entry **link = &fx_cache;
+
+		while (*link != released)
+		{
+			link = &(*link)->next;
+		}
+
+		*link = released->next;
+	}
+
+	pthread_mutex_unlock(&fx_cache_mutex);
+
+	if (destroy)
+	{
+		debug("release_fx: destroying effect %s", released->effect);
+
+		NvVFX_DestroyEffect(released->handle);
+
+		if (released->done)
+		{
+			cuEventDestroy(released->done);
+		}
+
+		bfree(released);
+	}
+}
+
+
+
+/*
+* Releases a reference to a stream of the pool, destroying it once nobody uses it anymore
+* 
+* param stream - the stream to release, nulled out
+*/
+static void release_stream(CUstream *stream)
+{
+	pthread_mutex_lock(&fx_cache_mutex);
+
+	for (uint32_t i = 0; i < NV_STREAM_POOL_SIZE; ++i)
+	{
+		if (stream_pool[i].stream != *stream || !*stream)
+		{
+			continue;
+		}
+
+		if (--stream_pool[i].refs == 0)
+		{
+			/* Shared effects may still have work queued on it, and would otherwise wait on it next time they're run */
+			cuStreamSynchronize(stream_pool[i].stream);
+
+			for (struct nv_fx_entry *entry = fx_cache; entry; entry = entry->next)
+			{
+				if (entry->stream == stream_pool[i].stream)
+				{
+					entry->stream = NULL;
+					entry->ran = false;
+				}
+			}
+
+			NvVFX_CudaStreamDestroy(stream_pool[i].stream);
+			stream_pool[i].stream = NULL;
+		}
+
+		break;
+	}
+
+	pthread_mutex_unlock(&fx_cache_mutex);
+
+	*stream = NULL;
+}
+
+
+
+/*
+* Destroys the textures and image of an output slot, and nulls them out. Must be called within the graphics context
+* 
+* param slot - the output slot to destroy
+*/
+static void destroy_output_slot(struct nv_output_slot *slot)
+{
+	unbind_texture_image(&slot->dst_img, &slot->dst_texture);
+
+	if (slot->scaled_texture)
+	{
+		gs_texture_destroy(slot->scaled_texture);
+		slot->scaled_texture = NULL;
+	}
+
+	if (slot->planar_texture)
+	{
+		gs_texture_destroy(slot->planar_texture);
+		slot->planar_texture = NULL;
+	}
+
+	if (slot->frame_texture)
+	{
+		gs_texture_destroy(slot->frame_texture);
+		slot->frame_texture = NULL;
+	}
+
+	if (slot->done)
+	{
+		cuEventDestroy(slot->done);
+		slot->done = NULL;
+	}
+
+	slot->ready = false;
+	slot->in_flight = false;
+	slot->needs_resolve = false;
+	slot->needs_compose = false;
+	slot->has_fingerprint = false;
+}
+
+
+
+/*
+* Destroys the effects and images of the tile pass, and disables it
+* 
+* param pass - the tile pass to destroy
+*/
+static void destroy_tile_pass(struct nv_tile_pass *pass)
+{
+	nv_destroy_fx_filter(&pass->ar_handle, &pass->ar_src_img, &pass->ar_dst_img);
+	nv_destroy_fx_filter(&pass->sr_handle, &pass->sr_src_img, &pass->sr_dst_img);
+	nv_destroy_fx_filter(NULL, &pass->ramp_x_img, &pass->ramp_y_img);
+	nv_destroy_fx_filter(NULL, &pass->blend_img, NULL);
+
+	pass->feather = false;
+	pass->enabled = false;
+	pass->loaded = false;
+}
+
+
+
+/*
+* Destroys the effects, buffers and output textures of a tier that isn't live, the output textures need the graphics context
+* param state - the state to destroy, left empty
+*/
+static void destroy_tier_state(struct nv_tier_state *state)
+{
+	release_fx(&state->ar_fx, &state->ar_handle);
+	release_fx(&state->sr_fx, &state->sr_handle);
+	nv_destroy_fx_filter(NULL, &state->gpu_ar_src_img, &state->gpu_ar_dst_img);
+	nv_destroy_fx_filter(NULL, &state->gpu_sr_src_img, &state->gpu_sr_dst_img);
+	nv_destroy_fx_filter(NULL, &state->gpu_staging_img, NULL);
+	destroy_planned_backings(state->planned, 0);
+	destroy_tile_pass(&state->tiles);
+
+	for (uint32_t i = 0; i < NV_OUTPUT_RING_SIZE; ++i)
+	{
+		destroy_output_slot(&state->outputs[i]);
+	}
+
+	memset(state, 0, sizeof(*state));
+}
+
+
+
+/*
+* Waits for the reconfiguration to be done with the live tier, and hands its effects and buffers back to the filter with the flags it followed.
+* The output slots and sizes stay the filter's, the last output is drawn meanwhile. Must be called within the graphics context
+* 
+* param filter - our OBS filter structure
+*/
+static void join_reconfigure(struct nv_superresolution_data *filter)
+{
+	struct nv_fx_load *load = &filter->reconfig;
+
+	if (filter->reconfig_threaded)
+	{
+		pthread_join(filter->reconfig_thread, NULL);
+		filter->reconfig_threaded = false;
+	}
+
+	if (!filter->reconfig_pending)
+	{
+		return;
+	}
+
+	filter->live.ar_handle = load->state.ar_handle;
+	filter->live.sr_handle = load->state.sr_handle;
+	filter->live.ar_fx = load->state.ar_fx;
+	filter->live.sr_fx = load->state.sr_fx;
+	filter->live.gpu_ar_src_img = load->state.gpu_ar_src_img;
+	filter->live.gpu_ar_dst_img = load->state.gpu_ar_dst_img;
+	filter->live.gpu_sr_src_img = load->state.gpu_sr_src_img;
+	filter->live.gpu_sr_dst_img = load->state.gpu_sr_dst_img;
+	filter->live.gpu_staging_img = load->state.gpu_staging_img;
+	memcpy(filter->live.planned, load->state.planned, sizeof(filter->live.planned));
+	filter->live.planar_comp = load->state.planar_comp;
+	filter->live.tiles = load->state.tiles;
+
+	/* A reset meanwhile flags the effects again, which the reconfiguration mustn't clear */
+	filter->destroy_ar = filter->destroy_ar || load->destroy_ar;
+	filter->destroy_sr = filter->destroy_sr || load->destroy_sr;
+	filter->reload_ar_fx = filter->reload_ar_fx || load->reload_ar_fx;
+	filter->reload_sr_fx = filter->reload_sr_fx || load->reload_sr_fx;
+	filter->are_images_allocated = filter->are_images_allocated && load->are_images_allocated;
+	filter->invalid_ar_size = load->invalid_ar_size;
+	filter->invalid_sr_size = load->invalid_sr_size;
+	filter->reconfig_images = load->images;
+	filter->pool_restored = load->pool_restored;
+	filter->reconfig_pending = false;
+
+	if (load->stopped)
+	{
+		stop_processing(filter);
+	}
+}
+
+
+
+/*
+* Gets what the buffers and output textures of the reconfiguration have to be allocated for, with the effects the filter has now
+* param filter - our OBS filter structure
+* param key - OUTPUT parameter
+*/
+static void get_size_key(struct nv_superresolution_data *filter, struct nv_size_key *key)
+{
+	key->width = filter->width;
+	key->height = filter->height;
+	key->out_width = filter->live.out_width;
+	key->out_height = filter->live.out_height;
+	key->frame_out_width = filter->live.frame_out_width;
+	key->frame_out_height = filter->live.frame_out_height;
+	key->space = filter->reconfig_space;
+	key->planar_comp = planar_comp_type(&filter->live, filter->type, filter->half_precision);
+	key->type = filter->type;
+	key->ar = filter->live.ar_handle != NULL;
+	key->sr = filter->live.sr_handle != NULL;
+	key->target_valid = filter->is_target_valid;
+	key->batch = filter->batch;
+	key->pipelined = filter->pipelined;
+	key->roi_enabled = filter->roi_enabled;
+	key->oversized = filter->oversized;
+}
+
+
+
+static bool size_key_equal(const struct nv_size_key *a, const struct nv_size_key *b)
+{
+	return a->width == b->width && a->height == b->height && a->out_width == b->out_width && a->out_height == b->out_height &&
+	       a->frame_out_width == b->frame_out_width && a->frame_out_height == b->frame_out_height && a->space == b->space &&
+	       a->planar_comp == b->planar_comp && a->type == b->type && a->ar == b->ar && a->sr == b->sr &&
+	       a->target_valid == b->target_valid && a->batch == b->batch && a->pipelined == b->pipelined &&
+	       a->roi_enabled == b->roi_enabled && a->oversized == b->oversized;
+}
+
+
+
+/* return - the bytes of device memory a texture takes, 0 for NULL */
+static uint64_t texture_bytes(gs_texture_t *texture)
+{
+	if (!texture)
+	{
+		return 0;
+	}
+
+	return (uint64_t)gs_texture_get_width(texture) * gs_texture_get_height(texture) * gs_get_format_bpp(gs_texture_get_color_format(texture)) / 8;
+}
+
+
+
+/* return - the bytes of device memory an image owns, 0 for NULL and for the views into the planned backings */
+static uint64_t image_owned_bytes(NvCVImage *image)
+{
+	return image && image->deletePtr ? image->bufferBytes : 0;
+}
+
+
+
+/*
+* Destroys the buffers and output textures of a parked set, and marks it unused. Must be called within the graphics context
+* param set - the set to destroy
+*/
+static void destroy_size_set(struct nv_size_set *set)
+{
+	nv_destroy_fx_filter(NULL, &set->gpu_ar_src_img, &set->gpu_ar_dst_img);
+	nv_destroy_fx_filter(NULL, &set->gpu_sr_src_img, &set->gpu_sr_dst_img);
+	nv_destroy_fx_filter(NULL, &set->gpu_staging_img, NULL);
+	destroy_planned_backings(set->planned, 0);
+
+	for (uint32_t i = 0; i < NV_OUTPUT_RING_SIZE; ++i)
+	{
+		destroy_output_slot(&set->outputs[i]);
+	}
+
+	memset(set, 0, sizeof(*set));
+}
+
+
+
+/*
+* Destroys the sets parked the longest until the pool takes no more than cap. Must be called within the graphics context
+* param filter - our OBS filter structure
+* param cap - bytes the parked sets may take, 0 empties the pool
+*/
+static void trim_size_pool(struct nv_superresolution_data *filter, uint64_t cap)
+{
+	for (;;)
+	{
+		uint64_t total = 0;
+		struct nv_size_set *oldest = NULL;
+
+		for (uint32_t i = 0; i < NV_POOL_SETS; ++i)
+		{
+			struct nv_size_set *set = &filter->pool[i];
+
+			if (set->used)
+			{
+				total += set->bytes;
+				oldest = !oldest || set->parked_at < oldest->parked_at ? set : oldest;
+			}
+		}
+
+		if (!oldest || total <= cap)
+		{
+			return;
+		}
+
+		debug("trim_size_pool: evicting the %ux%u set, %.1f MB", oldest->key.width, oldest->key.height,
+		      (double)oldest->bytes / (1024.0 * 1024.0));
+
+		destroy_size_set(oldest);
+	}
+}
+
+
+
+/*
+* Moves the live NvVFX buffers into a set, leaving the filter without any
+* param filter - our OBS filter structure
+* param set - OUTPUT parameter, the set
+*/
+static void store_size_buffers(struct nv_superresolution_data *filter, struct nv_size_set *set)
+{
+	set->gpu_ar_src_img = filter->live.gpu_ar_src_img;
+	set->gpu_ar_dst_img = filter->live.gpu_ar_dst_img;
+	set->gpu_sr_src_img = filter->live.gpu_sr_src_img;
+	set->gpu_sr_dst_img = filter->live.gpu_sr_dst_img;
+	set->gpu_staging_img = filter->live.gpu_staging_img;
+	memcpy(set->planned, filter->live.planned, sizeof(set->planned));
+
+	filter->live.gpu_ar_src_img = NULL;
+	filter->live.gpu_ar_dst_img = NULL;
+	filter->live.gpu_sr_src_img = NULL;
+	filter->live.gpu_sr_dst_img = NULL;
+	filter->live.gpu_staging_img = NULL;
+	memset(filter->live.planned, 0, sizeof(filter->live.planned));
+}
+
+
+
+/*
+* Moves the NvVFX buffers of a set into the filter, which must have none
+* param filter - our OBS filter structure
+* param set - the set, left without any buffers
+*/
+static void load_size_buffers(struct nv_superresolution_data *filter, struct nv_size_set *set)
+{
+	filter->live.gpu_ar_src_img = set->gpu_ar_src_img;
+	filter->live.gpu_ar_dst_img = set->gpu_ar_dst_img;
+	filter->live.gpu_sr_src_img = set->gpu_sr_src_img;
+	filter->live.gpu_sr_dst_img = set->gpu_sr_dst_img;
+	filter->live.gpu_staging_img = set->gpu_staging_img;
+	memcpy(filter->live.planned, set->planned, sizeof(filter->live.planned));
+	filter->live.planar_comp = set->key.planar_comp;
+
+	set->gpu_ar_src_img = NULL;
+	set->gpu_ar_dst_img = NULL;
+	set->gpu_sr_src_img = NULL;
+	set->gpu_sr_dst_img = NULL;
+	set->gpu_staging_img = NULL;
+	memset(set->planned, 0, sizeof(set->planned));
+}
+
+
+
+/*
+* Moves the output slots of a set into the filter, which must have none. The slots are emptied, they held frames of another size
+* param filter - our OBS filter structure
+* param set - the set, left without any output slots
+*/
+static void load_size_outputs(struct nv_superresolution_data *filter, struct nv_size_set *set)
+{
+	memcpy(filter->live.outputs, set->outputs, sizeof(filter->live.outputs));
+	filter->live.output_count = set->output_count;
+	filter->live.output_index = 0;
+	filter->live.draw_index = 0;
+
+	for (uint32_t i = 0; i < NV_OUTPUT_RING_SIZE; ++i)
+	{
+		struct nv_output_slot *slot = &filter->live.outputs[i];
+
+		slot->ready = false;
+		slot->in_flight = false;
+		slot->needs_resolve = false;
+		slot->needs_compose = false;
+		slot->has_fingerprint = false;
+	}
+
+	memset(set->outputs, 0, sizeof(set->outputs));
+	set->output_count = 0;
+}
+
+
+
+/*
+* Parks a set in the pool, in an unused place or the place of the set parked the longest, then keeps the pool within pool_cap.
+* Must be called within the graphics context
+* 
+* param filter - our OBS filter structure
+* param set - the set to park, left unused
+*/
+static void park_size_set(struct nv_superresolution_data *filter, struct nv_size_set *set)
+{
+	struct nv_size_set *place = &filter->pool[0];
+
+	for (uint32_t i = 1; i < NV_POOL_SETS && place->used; ++i)
+	{
+		if (!filter->pool[i].used || filter->pool[i].parked_at < place->parked_at)
+		{
+			place = &filter->pool[i];
+		}
+	}
+
+	destroy_size_set(place);
+
+	set->parked_at = os_gettime_ns();
+	set->bytes = image_owned_bytes(set->gpu_ar_src_img) + image_owned_bytes(set->gpu_ar_dst_img) +
+		     image_owned_bytes(set->gpu_sr_src_img) + image_owned_bytes(set->gpu_sr_dst_img) + image_owned_bytes(set->gpu_staging_img);
+
+	for (uint32_t i = 0; i < NV_PLAN_BUFFERS; ++i)
+	{
+		set->bytes += image_owned_bytes(set->planned[i]);
+	}
+
+	for (uint32_t i = 0; i < NV_OUTPUT_RING_SIZE; ++i)
+	{
+		set->bytes += texture_bytes(set->outputs[i].scaled_texture) + texture_bytes(set->outputs[i].planar_texture) +
+			      texture_bytes(set->outputs[i].frame_texture);
+	}
+
+	debug("park_size_set: parked the %ux%u set, %.1f MB", set->key.width, set->key.height, (double)set->bytes / (1024.0 * 1024.0));
+
+	*place = *set;
+	memset(set, 0, sizeof(*set));
+
+	trim_size_pool(filter, filter->pool_cap);
+}
+
+
+
+/*
+* Swaps the live NvVFX buffers for those of a parked set of the size the filter is being reconfigured for, so a source flipping
+* between a few sizes doesn't reallocate its buffers and output textures on every flip. The live buffers are held in parking, and
+* the output textures taken in restoring, until finish_size_swap as the live output keeps being drawn during the reconfiguration.
+* Must be called within the graphics context, with no frame in flight
+* 
+* param filter - our OBS filter structure
+* return - True if a parked set was taken, the effects only have to be loaded with its buffers
+*/
+static bool start_size_swap(struct nv_superresolution_data *filter)
+{
+	/* Left by a reconfiguration that failed */
+	destroy_size_set(&filter->parking);
+	destroy_size_set(&filter->restoring);
+	trim_size_pool(filter, filter->pool_cap);
+
+	/* Only the effects the filter already has are keyed, ones about to be created or destroyed change what is allocated */
+	const bool creates_ar = filter->apply_ar && !filter->live.ar_handle;
+	const bool creates_sr = filter->type != S_TYPE_NONE && !filter->live.sr_handle;
+
+	if (!filter->images_keyed || filter->pool_cap == 0 || filter->destroy_ar || filter->destroy_sr || creates_ar || creates_sr)
+	{
+		return false;
+	}
+
+	struct nv_size_key key;
+	get_size_key(filter, &key);
+
+	if (size_key_equal(&key, &filter->images_key))
+	{
+		return false;
+	}
+
+	filter->parking.used = true;
+	filter->parking.key = filter->images_key;
+	filter->images_keyed = false;
+	store_size_buffers(filter, &filter->parking);
+
+	for (uint32_t i = 0; i < NV_POOL_SETS; ++i)
+	{
+		if (filter->pool[i].used && size_key_equal(&key, &filter->pool[i].key))
+		{
+			debug("start_size_swap: reusing the %ux%u set", key.width, key.height);
+
+			filter->restoring = filter->pool[i];
+			memset(&filter->pool[i], 0, sizeof(filter->pool[i]));
+			load_size_buffers(filter, &filter->restoring);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+
+/*
+* Parks the buffers replaced by start_size_swap with the output textures that were drawn meanwhile, and takes the output textures
+* of the set that was reused, unless the reconfiguration had to allocate its buffers after all. Must be called within the graphics context
+* 
+* param filter - our OBS filter structure
+*/
+static void finish_size_swap(struct nv_superresolution_data *filter)
+{
+	if (filter->parking.used)
+	{
+		memcpy(filter->parking.outputs, filter->live.outputs, sizeof(filter->parking.outputs));
+		filter->parking.output_count = filter->live.output_count;
+		memset(filter->live.outputs, 0, sizeof(filter->live.outputs));
+
+		park_size_set(filter, &filter->parking);
+	}
+
+	if (filter->pool_restored)
+	{
+		load_size_outputs(filter, &filter->restoring);
+	}
+
+	destroy_size_set(&filter->restoring);
+}
+
+
+
+/*
+* The real destroy method, destroys and frees all memory we've allocated to the Fx filters and image buffers
+* param data - The OBS supplied data, should be a pointer to our filter struct
+* 
+* NOTE: For no particular reason, this function can be called multiple times
+*/ 
+static void nv_superres_filter_actual_destroy(void *data)
+{
+	debug("nv_superres_filter_actual_destroy: entered");
+
+	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)data;
+
+	if (!nvvfx_loaded)
+	{
+		bfree(filter);
+		return;
+	}
+
+	/* A reconfiguration still running holds the live effects and buffers destroyed below */
+	join_reconfigure(filter);
+
+	/* A tier still being loaded holds its own, it has no output textures yet */
+	if (filter->warming)
+	{
+		pthread_join(filter->warm_thread, NULL);
+		destroy_tier_state(&filter->warming->state);
+
+		bfree(filter->warming);
+		filter->warming = NULL;
+	}
+
+	/* The batch mustn't run a frame of ours once our buffers are gone */
+	nv_batch_leave(filter->batch_member);
+	filter->batch_member = NULL;
+
+	if (filter->batch_staged)
+	{
+		cuEventDestroy(filter->batch_staged);
+		filter->batch_staged = NULL;
+	}
+
+	release_fx(&filter->live.ar_fx, &filter->live.ar_handle);
+	release_fx(&filter->live.sr_fx, &filter->live.sr_handle);
+	nv_destroy_fx_filter(NULL, &filter->live.gpu_ar_src_img, &filter->live.gpu_ar_dst_img);
+	nv_destroy_fx_filter(NULL, &filter->live.gpu_sr_src_img, &filter->live.gpu_sr_dst_img);
+	nv_destroy_fx_filter(NULL, &filter->live.gpu_staging_img, NULL);
+	nv_destroy_fx_filter(NULL, &filter->ingest_tmp, NULL);
+	destroy_planned_backings(filter->live.planned, 0);
+	destroy_tile_pass(&filter->live.tiles);
+
+	if (filter->stream)
+	{
+		release_stream(&filter->stream);
+	}
+
+	obs_enter_graphics();
+
+	unbind_texture_image(&filter->src_img, &filter->src_texture);
+
+	for (uint32_t i = 0; i < NV_OUTPUT_RING_SIZE; ++i)
+	{
+		destroy_output_slot(&filter->live.outputs[i]);
+	}
+
+	for (uint32_t i = 0; i < NV_TIER_MAX; ++i)
+	{
+		destroy_tier_state(&filter->tiers[i].state);
+	}
+
+	destroy_size_set(&filter->parking);
+	destroy_size_set(&filter->restoring);
+	trim_size_pool(filter, 0);
+
+	if (filter->render)
+	{
+		gs_texrender_destroy(filter->render);
+		filter->render = NULL;
+	}
+	if (filter->render_unorm)
+	{
+		gs_texrender_destroy(filter->render_unorm);
+		filter->render_unorm = NULL;
+	}
+	if (filter->render_planar)
+	{
+		gs_texrender_destroy(filter->render_planar);
+		filter->render_planar = NULL;
+	}
+
+	if (filter->fingerprint_partial)
+	{
+		gs_texrender_destroy(filter->fingerprint_partial);
+		filter->fingerprint_partial = NULL;
+	}
+
+	if (filter->fingerprint_render)
+	{
+		gs_texrender_destroy(filter->fingerprint_render);
+		filter->fingerprint_render = NULL;
+	}
+
+	if (filter->render_frame)
+	{
+		gs_texrender_destroy(filter->render_frame);
+		filter->render_frame = NULL;
+	}
+
+	for (uint32_t i = 0; i < NV_FINGERPRINT_STAGES; ++i)
+	{
+		if (filter->fingerprint_stages[i])
+		{
+			gs_stagesurface_destroy(filter->fingerprint_stages[i]);
+			filter->fingerprint_stages[i] = NULL;
+		}
+	}
+
+	if (filter->effect)
+	{
+		gs_effect_destroy(filter->effect);
+		filter->effect = NULL;
+	}
+
+	obs_leave_graphics();
+
+	/* Chunks only the images of this filter and its tiers were in go back to the driver */
+	if (gpu_arena)
+	{
+		nv_arena_trim(gpu_arena);
+	}
+
+	nv_snapshot_destroy(filter->settings);
+	pthread_mutex_destroy(&filter->settings_mutex);
+
+	bfree(filter);
+
+	debug("nv_superres_filter_actual_destroy: exiting");
+}
+
+
+
+/*
+* OBS function to properly queue our filter to be destroyed through OBS's task queue
+* param data - should be a pointer to our OBS filter struct
+*/
+static void nv_superres_filter_destroy(void *data)
+{
+	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)data;
+	if (os_atomic_set_long(&filter->lifecycle, NV_LIFECYCLE_DESTROYING) != NV_LIFECYCLE_DESTROYING)
+	{
+		/* A hotkey pressed from here on would request a tier of a filter that's gone */
+		for (uint32_t i = 0; i < NV_TIER_MAX; ++i)
+		{
+			if (filter->tiers[i].hotkey != OBS_INVALID_HOTKEY_ID)
+			{
+				obs_hotkey_unregister(filter->tiers[i].hotkey);
+				filter->tiers[i].hotkey = OBS_INVALID_HOTKEY_ID;
+			}
+		}
+
+		obs_queue_task(OBS_TASK_GRAPHICS, nv_superres_filter_actual_destroy, data, false);
+	}
+}
+
+
+
+/* Macro shenanigans to deal with variadic arguments to the error */
+#define kill_on_error(cnd, msg, filter, ...) {	\
+	if (!cnd) \
+	{\
+		obs_log(LOG_ERROR, msg, ##__VA_ARGS__);	\
+		stop_processing(filter); \
+		return false;	\
+	}\
+}
+
+/* Check the value of vfxErr, if it's anything other than NVCV_SUCCESS this macro will
+* log the error, stop processing on filter, and return false from whatever function it's in
+*/
+#define nv_error(vfxErr, msg, filter, destroy_filter, ...) {	\
+	if (NVCV_SUCCESS != vfxErr)\
+	{\
+		filter = (struct nv_superresolution_data*)filter;			\
+		const char *errString = NvCV_GetErrorStringFromCode(vfxErr);\
+		obs_log(LOG_ERROR, msg, ##__VA_ARGS__);						\
+		obs_log(LOG_ERROR, "NvVFX Error %i: %s", vfxErr, errString);\
+		if (destroy_filter) {nv_superres_filter_destroy(filter);}	\
+		else {stop_processing(filter);}\
+		return false;\
+	}\
+}
+
+/* no return variation of the above macro */
+#define nv_error_nr(vfxErr, msg, filter, destroy_filter, ...)\
+{															\
+	if (NVCV_SUCCESS != vfxErr) {                           \
+		filter = (struct nv_superresolution_data *)filter;	\
+		const char *errString =                             \
+			NvCV_GetErrorStringFromCode(vfxErr);			\
+		obs_log(LOG_ERROR, msg, ##__VA_ARGS__);             \
+		obs_log(LOG_ERROR, "NvVFX Error %i: %s", vfxErr,    \
+			errString);										\
+		if (destroy_filter) {                               \
+			nv_superres_filter_destroy(filter);				\
+		} else {                                            \
+			stop_processing(filter);							\
+		}                                                   \
+	}                                                       \
+}
+
+/* The variations of the macros above for loading a tier, see load_fx. The load records a fatal error rather than stopping the filter
+* from the loading thread, the filter stops once its live tier is handed back by join_reconfigure, and a tier loaded ahead just fails
+*/
+#define kill_load_on_error(cnd, msg, load, ...) {	\
+	if (!cnd) \
+	{\
+		obs_log(LOG_ERROR, msg, ##__VA_ARGS__);	\
+		(load)->stopped = true; \
+		return false;	\
+	}\
+}
+
+#define load_error(vfxErr, msg, load, ...) {	\
+	if (NVCV_SUCCESS != vfxErr)\
+	{\
+		const char *errString = NvCV_GetErrorStringFromCode(vfxErr);\
+		obs_log(LOG_ERROR, msg, ##__VA_ARGS__);						\
+		obs_log(LOG_ERROR, "NvVFX Error %i: %s", vfxErr, errString);\
+		(load)->stopped = true;\
+		return false;\
+	}\
+}
+
+#define load_error_nr(vfxErr, msg, load, ...)\
+{															\
+	if (NVCV_SUCCESS != vfxErr) {                           \
+		const char *errString =                             \
+			NvCV_GetErrorStringFromCode(vfxErr);			\
+		obs_log(LOG_ERROR, msg, ##__VA_ARGS__);             \
+		obs_log(LOG_ERROR, "NvVFX Error %i: %s", vfxErr,    \
+			errString);										\
+		(load)->stopped = true;								\
+	}                                                       \
+}
+
+
+
+/*
+* initializes the Fx Handle with the given FX selector, and optionally set the model directory parameter for the given FX
+* note: if the FX handle is initialized and exists, it will be destroyed and re-initizliaed
+* 
+* load - the tier being loaded, and everything loading it reads
+* handle - the fx handle to initialize
+* fx - the fx type to initialize, these are NV filter constants, prefixed with NVVFX_FX_
+*/
+static bool create_nvfx(struct nv_fx_load *load, NvVFX_Handle *handle, NvVFX_EffectSelector fx)
+{
+	if (*handle)
+	{
+		NvVFX_DestroyEffect(*handle);
+	}
+
+	NvCV_Status vfxErr = NvVFX_CreateEffect(fx, handle);
+	load_error(vfxErr, "Error creating nVidia RTX Upscaling FX", load);
+
+	bool set_model_dir =
+		(strncmp(fx, NVVFX_FX_ARTIFACT_REDUCTION, sizeof(NVVFX_FX_ARTIFACT_REDUCTION) / sizeof(char)) ==0) ||
+		(strncmp(fx, NVVFX_FX_SUPER_RES, sizeof(NVVFX_FX_SUPER_RES) / sizeof(char)) == 0);
+
+	if (set_model_dir)
+	{
+		char model_dir[MAX_PATH];
+		get_nvfx_sdk_path(model_dir, MAX_PATH);
+
+		vfxErr = NvVFX_SetString(*handle, NVVFX_MODEL_DIRECTORY, model_dir);
+		load_error(vfxErr, "Error seting Super Resolution model directory: [%s]", load, model_dir);
+	}
+
+	vfxErr = NvVFX_SetCudaStream(*handle, NVVFX_CUDA_STREAM, load->stream);
+	load_error(vfxErr, "Error seting Super Resolution CUDA stream", load);
+
+	return true;
+}
+
+
+
+/*
+* Creates an effect of our own, that is only shared once it has been loaded, see share_loaded_fx
+* 
+* param load - the tier being loaded, and everything loading it reads
+* param entry - receives the reference to the effect, the previous one is released
+* param handle - receives the handle of the effect
+* param fx - the fx type to create, these are NV filter constants, prefixed with NVVFX_FX_
+* return - False if there is an error, true otherwise
+*/
+static bool create_fx(struct nv_fx_load *load, struct nv_fx_entry **entry, NvVFX_Handle *handle, NvVFX_EffectSelector fx)
+{
+	release_fx(entry, handle);
+
+	struct nv_fx_entry *created = (struct nv_fx_entry *)bzalloc(sizeof(*created));
+	created->refs = 1;
+	created->effect = fx;
+	created->stream = load->stream;
+
+	if (!create_nvfx(load, &created->handle, fx))
+	{
+		bfree(created);
+		return false;
+	}
+
+	pthread_mutex_lock(&fx_cache_mutex);
+	created->next = fx_cache;
+	fx_cache = created;
+	pthread_mutex_unlock(&fx_cache_mutex);
+
+	*entry = created;
+	*handle = created->handle;
+
+	return true;
+}
+
+
+
+/*
+* Looks for an effect already loaded with the given configuration by another filter, and swaps our reference over to it.
+* When there isn't one we're left with an effect of our own to load, a new one if ours was shared with other filters.
+* 
+* param load - the tier being loaded, and everything loading it reads
+* param entry - our reference to the effect, replaced
+* param handle - the handle of the effect, replaced
+* param config - the configuration to load, only the fields up to the handle are used
+* return - True if we now share a loaded effect, False if the caller has to load the effect in entry and then call publish_fx
+*/
+static bool share_loaded_fx(struct nv_fx_load *load, struct nv_fx_entry **entry, NvVFX_Handle *handle,
+			    const struct nv_fx_entry *config)
+{
+	struct nv_fx_entry *found = NULL;
+
+	pthread_mutex_lock(&fx_cache_mutex);
+
+	for (struct nv_fx_entry *candidate = fx_cache; candidate && !found; candidate = candidate->next)
+	{
+		const bool matches = candidate->loaded && candidate != *entry && strcmp(candidate->effect, config->effect) == 0 &&
+				     candidate->mode == config->mode && candidate->width == config->width && candidate->height == config->height &&
+				     candidate->out_width == config->out_width && candidate->out_height == config->out_height &&
+				     candidate->comp_type == config->comp_type;
+
+		if (matches)
+		{
+			found = candidate;
+			found->refs++;
+
+			/* Our images are set before our first run, bind_fx changes them under the lock on the graphics thread */
+			found->input = NULL;
+			found->output = NULL;
+		}
+	}
+
+	const bool shared = *entry && (*entry)->refs > 1;
+
+	/* Nobody else may pick up our effect while it's being reloaded */
+	if (!found && !shared && *entry)
+	{
+		(*entry)->loaded = false;
+	}
+
+	pthread_mutex_unlock(&fx_cache_mutex);
+
+	if (found)
+	{
+		debug("share_loaded_fx: sharing loaded effect %s, %ld users", found->effect, found->refs);
+
+		release_fx(entry, handle);
+		*entry = found;
+		*handle = found->handle;
+
+		return true;
+	}
+
+	/* The filters we shared our effect with keep their configuration, load a new one of our own */
+	if (shared)
+	{
+		create_fx(load, entry, handle, config->effect);
+	}
+
+	return false;
+}
+
+
+
+/*
+* Makes an effect we've just loaded available to other filters with the same configuration
+* 
+* param entry - the effect, loaded with the images given
+* param config - the configuration it was loaded with
+* param input, output - the images it was loaded with
+*/
+static void publish_fx(struct nv_fx_entry *entry, const struct nv_fx_entry *config, NvCVImage *input, NvCVImage *output)
+{
+	pthread_mutex_lock(&fx_cache_mutex);
+
+	entry->mode = config->mode;
+	entry->strength = config->strength;
+	entry->width = config->width;
+	entry->height = config->height;
+	entry->out_width = config->out_width;
+	entry->out_height = config->out_height;
+	entry->comp_type = config->comp_type;
+	entry->input = input;
+	entry->output = output;
+	entry->loaded = true;
+
+	pthread_mutex_unlock(&fx_cache_mutex);
+}
+
+
+
+/*
+* Points an effect at our stream and our images before we run it, as it may have last been run by another filter
+* 
+* param filter - our OBS filter structure
+* param entry - the effect about to be run
+* param input, output - our images for the effect
+* return - False if there is an error, true otherwise
+*/
+static bool bind_fx(struct nv_superresolution_data *filter, struct nv_fx_entry *entry, NvCVImage *input, NvCVImage *output)
+{
+	NvCV_Status vfxErr = NVCV_SUCCESS;
+	const char *what = NULL;
+
+	/* The other filters sharing the effect bind it too, and share_loaded_fx resets its images on reconfiguration threads */
+	pthread_mutex_lock(&fx_cache_mutex);
+
+	if (entry->stream != filter->stream)
+	{
+		/* Wait for the last run on the other stream, falling back to blocking on it without events */
+		if (entry->ran && (!entry->done || cuStreamWaitEvent(filter->stream, entry->done, 0) != CUDA_SUCCESS) && entry->stream)
+		{
+			cuStreamSynchronize(entry->stream);
+		}
+
+		vfxErr = NvVFX_SetCudaStream(entry->handle, NVVFX_CUDA_STREAM, filter->stream);
+		what = "CUDA stream";
+
+		if (vfxErr == NVCV_SUCCESS)
+		{
+			entry->stream = filter->stream;
+		}
+	}
+
+	if (vfxErr == NVCV_SUCCESS && entry->input != input)
+	{
+		vfxErr = NvVFX_SetImage(entry->handle, NVVFX_INPUT_IMAGE, input);
+		what = "input image";
+
+		/* A failed binding isn't recorded, the next run sets the image again */
+		entry->input = vfxErr == NVCV_SUCCESS ? input : NULL;
+	}
+
+	if (vfxErr == NVCV_SUCCESS && entry->output != output)
+	{
+		vfxErr = NvVFX_SetImage(entry->handle, NVVFX_OUTPUT_IMAGE, output);
+		what = "output image";
+
+		entry->output = vfxErr == NVCV_SUCCESS ? output : NULL;
+	}
+
+	pthread_mutex_unlock(&fx_cache_mutex);
+
+	if (vfxErr != NVCV_SUCCESS)
+	{
+		error("Error setting the %s of a shared effect", what);
+		error("NvVFX Error %i: %s", vfxErr, NvCV_GetErrorStringFromCode(vfxErr));
+		stop_processing(filter);
+		return false;
+	}
+
+	return true;
+}
+
+
+
+/*
+* Sets the Upscaling strength of our effect before we run it, if it differs from ours. The strength is applied without reloading the effect,
+* so moving the sharpening slider takes effect on the next frame, and effects are shared whatever their strength
+* 
+* param filter - our OBS filter structure
+* param entry - the effect about to be run
+* return - False if there is an error, true otherwise
+*/
+static bool bind_strength(struct nv_superresolution_data *filter, struct nv_fx_entry *entry)
+{
+	if (filter->type != S_TYPE_UP || entry->strength == filter->strength)
+	{
+		return true;
+	}
+
+	const float strength = filter->strength;
+
+	NvCV_Status vfxErr = NvVFX_SetF32(entry->handle, NVVFX_STRENGTH, strength);
+	nv_error(vfxErr, "Error setting the upscaling sharpening strength", filter, false);
+
+	entry->strength = strength;
+	return true;
+}
+
+
+
+/*
+* Records that an effect has been run on our stream, for the next filter to run it from another stream to wait on
+* 
+* param filter - our OBS filter structure
+* param entry - the effect that was just run
+*/
+static void mark_fx_run(struct nv_superresolution_data *filter, struct nv_fx_entry *entry)
+{
+	if (!entry->done && cuEventCreate(&entry->done, CU_EVENT_DISABLE_TIMING) != CUDA_SUCCESS)
+	{
+		entry->done = NULL;
+	}
+
+	if (entry->done && cuEventRecord(entry->done, filter->stream) != CUDA_SUCCESS)
+	{
+		cuEventDestroy(entry->done);
+		entry->done = NULL;
+	}
+
+	entry->ran = true;
+}
+
+
+
+/*
+* Takes a reference to the least used stream of the pool, creating it if nobody uses it yet
+* 
+* param stream - receives the stream
+* return - the status of creating the stream
+*/
+static NvCV_Status acquire_stream(CUstream *stream)
+{
+	NvCV_Status vfxErr = NVCV_SUCCESS;
+	struct nv_stream_entry *least = &stream_pool[0];
+
+	pthread_mutex_lock(&fx_cache_mutex);
+
+	for (uint32_t i = 1; i < NV_STREAM_POOL_SIZE; ++i)
+	{
+		if (stream_pool[i].refs < least->refs)
+		{
+			least = &stream_pool[i];
+		}
+	}
+
+	if (!least->stream)
+	{
+		vfxErr = NvVFX_CudaStreamCreate(&least->stream);
+	}
+
+	if (vfxErr == NVCV_SUCCESS)
+	{
+		least->refs++;
+		*stream = least->stream;
+	}
+
+	pthread_mutex_unlock(&fx_cache_mutex);
+
+	return vfxErr;
+}
+
+
+
+/*
+* Falls back to F32 planar buffers after an effect failed to load on F16 ones, for every filter as the effects take the same buffers.
+* The failure isn't fatal, load_fx allocates the buffers again and loads the effects once more
+* 
+* param load - the tier being loaded, and everything loading it reads
+* param vfxErr - what NvVFX_Load failed with
+*/
+static void reject_f16(struct nv_fx_load *load, NvCV_Status vfxErr)
+{
+	if (!os_atomic_set_bool(&nvvfx_rejects_f16, true))
+	{
+		info("Half precision buffers aren't supported (%i: %s), using full precision ones", vfxErr, NvCV_GetErrorStringFromCode(vfxErr));
+	}
+
+	load->f16_rejected = true;
+}
+
+
+
+/* Loads the AR NVFX filter effect. Ensures any necessary parameters have been set.
+* 
+* returns: False if there is any error, true otherwise
+*/
+static bool load_ar_fx(struct nv_fx_load *load)
+{
+	debug("load_ar_fx: entering");
+
+	const struct nv_fx_entry config =
+	{
+		.effect = NVVFX_FX_ARTIFACT_REDUCTION,
+		.mode = (uint32_t)load->ar_mode,
+		.width = load->width,
+		.height = load->height,
+		.out_width = load->width,
+		.out_height = load->height,
+		.comp_type = load->state.gpu_ar_src_img->componentType
+	};
+
+	if (share_loaded_fx(load, &load->state.ar_fx, &load->state.ar_handle, &config))
+	{
+		load->invalid_ar_size = false;
+		load->reload_ar_fx = false;
+		return true;
+	}
+
+	kill_load_on_error(load->state.ar_handle, "Failed to create the AR effect", load);
+
+	if (known_rejected(&config))
+	{
+		debug("load_ar_fx: %ux%u was rejected before", config.width, config.height);
+		load->invalid_ar_size = true;
+		load->reload_ar_fx = false;
+		return false;
+	}
+
+	NvCV_Status vfxErr = NvVFX_SetU32(load->state.ar_handle, NVVFX_MODE, load->ar_mode);
+	load_error_nr(vfxErr, "Failed to set AR mode", load);
+
+	vfxErr = NvVFX_SetImage(load->state.ar_handle, NVVFX_INPUT_IMAGE, load->state.gpu_ar_src_img);
+	load_error(vfxErr, "Failed to set input image for Artifact Reduction filter", load);
+
+	vfxErr = NvVFX_SetImage(load->state.ar_handle, NVVFX_OUTPUT_IMAGE, load->state.gpu_ar_dst_img);
+	load_error(vfxErr, "Failed to set output image for Artifact Reduction filter", load);
+
+	vfxErr = NvVFX_Load(load->state.ar_handle);
+	record_load_result(&config, vfxErr);
+
+	bool success = NVCV_SUCCESS == vfxErr;
+
+	if (success)
+	{
+		publish_fx(load->state.ar_fx, &config, load->state.gpu_ar_src_img, load->state.gpu_ar_dst_img);
+	}
+
+	if (!success)
+	{
+		if (NVCV_ERR_RESOLUTION != vfxErr && config.comp_type == NVCV_F16)
+		{
+			reject_f16(load, vfxErr);
+		}
+		else if (NVCV_ERR_RESOLUTION != vfxErr)
+		{
+			const char *errString = NvCV_GetErrorStringFromCode(vfxErr);
+			error("Failed to load NvVFX AR effect %i: %s", vfxErr, errString);
+			load->stopped = true;
+		}
+	}
+	load->invalid_ar_size = !success;
+	load->reload_ar_fx = false;
+
+	debug("load_ar_fx: exiting");
+	return success;
+}
+
+
+/* Loads the SR NVFX filter effect. Ensures any necessary parameters have been set.
+* 
+* returns: False if there is any error, true otherwise
+*/
+static bool load_sr_fx(struct nv_fx_load *load)
+{
+	debug("load_sr_fx: entering");
+	NvCV_Status vfxErr;
+
+	NvCVImage *input = tier_reads_ar_output(&load->state, load->config.type) ? load->state.gpu_ar_dst_img : load->state.gpu_sr_src_img;
+
+	const struct nv_fx_entry config =
+	{
+		.effect = load->config.type == S_TYPE_SR ? NVVFX_FX_SUPER_RES : NVVFX_FX_SR_UPSCALE,
+		.mode = load->config.type == S_TYPE_SR ? (uint32_t)load->config.sr_mode : 0,
+		.strength = load->config.type == S_TYPE_UP ? load->config.strength : 0.0f,
+		.width = load->width,
+		.height = load->height,
+		.out_width = load->state.out_width,
+		.out_height = load->state.out_height,
+		.comp_type = input->componentType
+	};
+
+	if (share_loaded_fx(load, &load->state.sr_fx, &load->state.sr_handle, &config))
+	{
+		load->invalid_sr_size = false;
+		load->reload_sr_fx = false;
+		return true;
+	}
+
+	kill_load_on_error(load->state.sr_handle, "Failed to create the SR effect", load);
+
+	if (known_rejected(&config))
+	{
+		debug("load_sr_fx: %ux%u to %ux%u was rejected before", config.width, config.height, config.out_width, config.out_height);
+		load->invalid_sr_size = true;
+		load->reload_sr_fx = false;
+		return false;
+	}
+
+	if (load->config.type == S_TYPE_UP)
+	{
+		vfxErr = NvVFX_SetF32(load->state.sr_handle, NVVFX_STRENGTH, load->config.strength);
+		load_error_nr(vfxErr, "Failed to set upscaling sharpening strength", load);
+	}
+	else if (load->config.type == S_TYPE_SR)
+	{
+		vfxErr = NvVFX_SetU32(load->state.sr_handle, NVVFX_MODE, load->config.sr_mode);
+		load_error_nr(vfxErr, "Failed to set SR mode", load);
+	}
+
+	vfxErr = NvVFX_SetImage(load->state.sr_handle, NVVFX_INPUT_IMAGE, input);
+	load_error(vfxErr, "Error setting SuperRes input image", load);
+
+	vfxErr = NvVFX_SetImage(load->state.sr_handle, NVVFX_OUTPUT_IMAGE, load->state.gpu_sr_dst_img);
+	load_error(vfxErr, "Error setting SuperRes output image", load);
+
+	vfxErr = NvVFX_Load(load->state.sr_handle);
+	record_load_result(&config, vfxErr);
+
+	bool success = NVCV_SUCCESS == vfxErr;
+
+	if (success)
+	{
+		publish_fx(load->state.sr_fx, &config, input, load->state.gpu_sr_dst_img);
+	}
+
+	if (!success)
+	{
+		if (NVCV_ERR_RESOLUTION != vfxErr && config.comp_type == NVCV_F16)
+		{
+			reject_f16(load, vfxErr);
+		}
+		else if (NVCV_ERR_RESOLUTION != vfxErr)
+		{
+			const char *errString = NvCV_GetErrorStringFromCode(vfxErr);
+			error("Failed to load NvVFX SR effect %i: %s", vfxErr, errString);
+			load->stopped = true;
+		}
+	}
+
+	load->invalid_sr_size = !success;
+
+	load->reload_sr_fx = false;
+
+	debug("load_sr_fx: exiting");
+	return success;
+}
+
+
+
+/* Takes a CUDA stream for the filter from the stream pool, releasing the previous one if it exists.
+* returns: False if there is an error, true otherwise
+*/
+static bool create_cuda(struct nv_superresolution_data *filter)
+{
+	debug("create_cuda: entering");
+
+	if (filter->stream)
+	{
+		release_stream(&filter->stream);
+	}
+
+	NvCV_Status vfxErr = acquire_stream(&filter->stream);
+	nv_error(vfxErr, "Failed to create NvVFX CUDA Stream: %i", filter, true);
+
+	debug("create_cuda: exiting");
+	return true;
+}
+
+
+
+/* Creates the NvFX filters that are needed
+* This has the side consequence of requiring NvCVImage buffers to be created or reallocated
+* return - True if there are no errors or if nothing was created. False if there was an error.
+*/
+static bool initialize_fx(struct nv_fx_load *load)
+{
+	bool success = true;
+
+	if (success && load->apply_ar && !load->state.ar_handle)
+	{
+		debug("initialize_fx: creating AR fx");
+		success = create_fx(load, &load->state.ar_fx, &load->state.ar_handle, NVVFX_FX_ARTIFACT_REDUCTION);
+		load->are_images_allocated = false;
+	}
+
+	if (success && load->config.type != S_TYPE_NONE && !load->state.sr_handle)
+	{
+		debug("initialize_fx: creating SR fx");
+		const char *FX = load->config.type == S_TYPE_SR ? NVVFX_FX_SUPER_RES : NVVFX_FX_SR_UPSCALE;
+		success = create_fx(load, &load->state.sr_fx, &load->state.sr_handle, FX);
+		load->are_images_allocated = false;
+	}
+
+	return success;
+}
+
+
+
+/*
+* Holds back a change that reloads the effects until the settings have settled, restarting the wait
+* param filter - our OBS filter structure
+*/
+static inline void hold_change(struct nv_superresolution_data *filter)
+{
+	filter->changed_at = os_gettime_ns();
+	filter->settling = true;
+}
+
+
+
+/*
+* Sets the configuration of a quality tier, flagging it to be loaded again if it changed.
+* The main settings are applied to the live fields directly by apply_settings while tier 0 is live
+* param filter - our OBS filter structure
+* param index - the tier
+* param config - its configuration
+*/
+static void set_tier_config(struct nv_superresolution_data *filter, uint32_t index, const struct nv_tier_config *config)
+{
+	struct nv_tier *tier = &filter->tiers[index];
+
+	if (memcmp(&tier->config, config, sizeof(*config)) == 0)
+	{
+		return;
+	}
+
+	tier->config = *config;
+
+	if (index != 0 || filter->active_tier != 0)
+	{
+		/* A tier being edited would otherwise be loaded again on every step of a slider */
+		tier->stale = true;
+		hold_change(filter);
+	}
+}
+
+
+
+/*
+* Applies the changes held back by apply_settings, flagging the effects they need reloaded.
+* Must not be called while the filter is being reconfigured, the reconfiguration reads the settings applied here
+* param filter - our OBS filter structure
+*/
+static void apply_held_settings(struct nv_superresolution_data *filter)
+{
+	struct nv_tier_config main_config = filter->tiers[0].config;
+	main_config.sr_mode = filter->requested_sr_mode;
+	set_tier_config(filter, 0, &main_config);
+
+	if (filter->active_tier == 0 && filter->sr_mode != filter->requested_sr_mode)
+	{
+		filter->sr_mode = filter->requested_sr_mode;
+		filter->reload_sr_fx = true;
+	}
+
+	if (filter->ar_mode != filter->requested_ar_mode)
+	{
+		filter->ar_mode = filter->requested_ar_mode;
+		filter->reload_ar_fx = true;
+	}
+
+	/* A moved region of interest is picked up by the tick */
+	filter->roi_setting = filter->requested_roi;
+	filter->batch_strength = filter->strength;
+
+	/* Cleared last, a parked tier 0 flagged stale above is loaded again right away rather than held back once more */
+	filter->settling = false;
+}
+
+
+
+/*
+* Applies a generation of the settings to the filter, setting any necessary update/creation flags to be properly handled later.
+* Called by the tick on the graphics thread, never while the filter is being reconfigured, so a reconfiguration sees one generation throughout
+* 
+* param filter - our OBS filter structure
+* param settings - the settings, as published by nv_superres_filter_update
+*/
+static void apply_settings(struct nv_superresolution_data *filter, const struct nv_settings *settings)
+{
+	const int type = settings->type;
+	const int scale = settings->scale;
+	const bool apply_ar = settings->apply_ar;
+
+	/* While another quality tier is live the main settings are only kept for switching back to tier 0, see set_tier_config */
+	const bool main_live = filter->active_tier == 0;
+
+	if (main_live && filter->type != type)
+	{
+		filter->type = type;
+		filter->destroy_sr = true;
+		filter->reload_sr_fx = true;
+		debug("Update: Filter type changed");
+	}
+
+	if (main_live && filter->scale != scale)
+	{
+		filter->scale = scale;
+		debug("Update: Scale changed");
+	}
+
+	if (filter->requested_sr_mode != settings->sr_mode)
+	{
+		filter->requested_sr_mode = settings->sr_mode;
+		hold_change(filter);
+		debug("Update: Super Res mode changed");
+	}
+
+	if (filter->apply_ar != apply_ar)
+	{
+		filter->apply_ar = apply_ar;
+		debug("Update: AR changed");
+
+		if (!apply_ar)
+		{
+			debug("Update: AR disabled");
+			filter->destroy_ar = true;
+		}
+		else
+		{
+			debug("Update: AR enabled");
+		}
+
+		filter->reload_ar_fx = true;
+	}
+
+	if (filter->apply_ar && filter->requested_ar_mode != settings->ar_mode)
+	{
+			filter->requested_ar_mode = settings->ar_mode;
+			hold_change(filter);
+			debug("Update: AR mode changed");
+	}
+
+	if (filter->pipelined != settings->pipelined)
+	{
+		filter->pipelined = settings->pipelined;
+		filter->are_images_allocated = false;
+		debug("Update: Pipelining changed");
+
+		if (filter->pipelined)
+		{
+			info("Pipelined processing enabled, output is delayed by %d frame", NV_OUTPUT_RING_SIZE - 1);
+		}
+	}
+
+	if (filter->half_precision != settings->half_precision)
+	{
+		filter->half_precision = settings->half_precision;
+		filter->are_images_allocated = false;
+		debug("Update: Half precision changed");
+	}
+
+	if (filter->async_requested != settings->async_run)
+	{
+		filter->async_requested = settings->async_run;
+		filter->async_failed = false;
+		debug("Update: Asynchronous processing changed");
+	}
+
+	filter->async_run = filter->async_requested && !filter->async_failed;
+
+	filter->skip_unchanged = settings->skip_unchanged;
+
+	if (filter->tile_oversized != settings->tile_oversized)
+	{
+		filter->tile_oversized = settings->tile_oversized;
+		debug("Update: Tiling oversized sources changed");
+	}
+
+	/* A batch keeps the SR buffers live throughout the frame, so they can't share allocations with the AR source */
+	if (filter->batch != settings->batch)
+	{
+		filter->batch = settings->batch;
+		filter->are_images_allocated = false;
+	}
+
+	filter->batch_failed = false;
+
+	filter->background_reload = settings->background_reload;
+
+	/* The pool is trimmed to a lower cap the next time the filter is reconfigured */
+	filter->pool_cap = (uint64_t)settings->pool_vram << 20;
+
+	if (filter->roi_enabled != settings->roi_enabled)
+	{
+		filter->roi_enabled = settings->roi_enabled;
+		filter->are_images_allocated = false;
+		debug("Update: Region of interest toggled");
+	}
+
+	if (memcmp(&settings->roi, &filter->requested_roi, sizeof(settings->roi)) != 0)
+	{
+		filter->requested_roi = settings->roi;
+		hold_change(filter);
+		debug("Update: Region of interest moved");
+	}
+
+	if (filter->tiled_updates != settings->tiled_updates)
+	{
+		filter->tiled_updates = settings->tiled_updates;
+		filter->are_images_allocated = false;
+		debug("Update: Tiled updates changed");
+	}
+
+	if (main_live && type == S_TYPE_UP)
+	{
+		if (fabsf(settings->strength - filter->strength) > EPSILON)
+		{
+			/* Set on the effect before its next run without reloading it, only a batch has to be reloaded for it */
+			filter->strength = settings->strength;
+			hold_change(filter);
+			debug("Update: Upscaling strength changed");
+		}
+	}
+
+	struct nv_tier_config main_config = settings->tiers[0];
+	main_config.sr_mode = filter->tiers[0].config.sr_mode; // held back like the live mode, see apply_held_settings
+
+	set_tier_config(filter, 0, &main_config);
+	filter->tiers[0].enabled = true;
+	filter->tiers_enabled = settings->tiers_enabled;
+
+	for (uint32_t i = 1; i < NV_TIER_MAX; ++i)
+	{
+		filter->tiers[i].enabled = settings->tier_enabled[i];
+		set_tier_config(filter, i, &settings->tiers[i]);
+	}
+
+	/* Any setting can change the output for the same input */
+	filter->fingerprint_valid = false;
+}
+
+
+
+/* Called when the user changes any property in our OBS property window
+* Publishes the settings for the tick to apply, this runs on whichever thread updated the source and doesn't touch the filter itself
+*/
+static void nv_superres_filter_update(void *data, obs_data_t *settings)
+{
+	struct nv_superresolution_data *filter =(struct nv_superresolution_data *)data;
+
+	struct nv_settings values = {0};
+
+	values.type = (int)obs_data_get_int(settings, S_TYPE);
+	values.scale = (int)obs_data_get_int(settings, values.type == S_TYPE_UP ? S_UP_SCALE : S_SR_SCALE);
+	values.sr_mode = (int)obs_data_get_int(settings, S_MODE_SR);
+	values.apply_ar = obs_data_get_bool(settings, S_ENABLE_AR);
+	values.ar_mode = (int)obs_data_get_int(settings, S_MODE_AR);
+	values.strength = (float)obs_data_get_double(settings, S_STRENGTH);
+	values.pipelined = obs_data_get_bool(settings, S_PIPELINED);
+	values.half_precision = obs_data_get_bool(settings, S_HALF_PRECISION);
+	values.async_run = obs_data_get_bool(settings, S_ASYNC);
+	values.skip_unchanged = obs_data_get_bool(settings, S_SKIP_UNCHANGED);
+	values.tile_oversized = obs_data_get_bool(settings, S_TILE_OVERSIZED);
+	values.batch = obs_data_get_bool(settings, S_BATCH);
+	values.background_reload = obs_data_get_bool(settings, S_BACKGROUND_RELOAD);
+	values.pool_vram = (int)obs_data_get_int(settings, S_POOL_VRAM);
+	values.roi_enabled = obs_data_get_bool(settings, S_ROI);
+	values.roi.x = (uint32_t)obs_data_get_int(settings, S_ROI_LEFT);
+	values.roi.y = (uint32_t)obs_data_get_int(settings, S_ROI_TOP);
+	values.roi.width = (uint32_t)obs_data_get_int(settings, S_ROI_WIDTH);
+	values.roi.height = (uint32_t)obs_data_get_int(settings, S_ROI_HEIGHT);
+	values.tiled_updates = obs_data_get_bool(settings, S_TILED_UPDATES);
+	values.tiers_enabled = obs_data_get_bool(settings, S_TIERS);
+
+	values.tier_enabled[0] = true;
+	values.tiers[0].type = values.type;
+	values.tiers[0].scale = values.scale;
+	values.tiers[0].sr_mode = values.sr_mode;
+	values.tiers[0].strength = values.strength;
+
+	for (uint32_t i = 1; i < NV_TIER_MAX; ++i)
+	{
+		char name[32];
+
+		snprintf(name, sizeof(name), S_TIER, i);
+		values.tier_enabled[i] = obs_data_get_bool(settings, name);
+		snprintf(name, sizeof(name), S_TIER_TYPE, i);
+		values.tiers[i].type = (int)obs_data_get_int(settings, name);
+		snprintf(name, sizeof(name), S_TIER_SCALE, i);
+		values.tiers[i].scale = (int)obs_data_get_int(settings, name);
+		snprintf(name, sizeof(name), S_TIER_MODE, i);
+		values.tiers[i].sr_mode = (int)obs_data_get_int(settings, name);
+		snprintf(name, sizeof(name), S_TIER_STRENGTH, i);
+		values.tiers[i].strength = (float)obs_data_get_double(settings, name);
+	}
+
+	pthread_mutex_lock(&filter->settings_mutex);
+	nv_snapshot_publish(filter->settings, &values);
+	pthread_mutex_unlock(&filter->settings_mutex);
+}
+
+
+
+/*
+* Applies the settings published last, unless the filter is being reconfigured. Must be called on the graphics thread
+* param filter - our OBS filter structure
+*/
+static void acquire_settings(struct nv_superresolution_data *filter)
+{
+	if (is_reconfiguring(filter))
+	{
+		return;
+	}
+
+	uint64_t generation;
+	const struct nv_settings *settings = (const struct nv_settings *)nv_snapshot_acquire(filter->settings, &generation);
+
+	if (generation != filter->settings_generation)
+	{
+		apply_settings(filter, settings);
+		filter->settings_generation = generation;
+	}
+}
+
+
+
+/*
+* Returns true if our source is drawn into render and bound to src_img from there, skipping the ConvertUnorm pass into render_unorm.
+* That pass only copies 8 bit sRGB sources over, which render already holds as RGBA U8. Other spaces have to be converted,
+* planar input needs the f32 planes, and a region of interest only binds part of the render
+* 
+* param filter - our OBS filter structure
+* param source_space - the color space of our source
+*/
+static inline bool uses_fused_render(struct nv_superresolution_data *filter, enum gs_color_space source_space)
+{
+	return source_space == GS_CS_SRGB && !uses_planar_input(filter) && !filter->roi_enabled && !fused_render_unsupported;
+}
+
+
+
+/*
+* Registers a texture with CUDA by binding an image to it, unless the image already is bound to that very texture.
+* Registering serializes with the D3D11 device and is slow, while the textures mostly outlive rebinds: texrenders only recreate
+* theirs when their size or format changes. The parameters of the image follow from the size and format of its texture, so
+* the identity of the texture is all that is compared. The texture is referenced while the image is bound to it, so a texture
+* created after it's released can't take its address and be mistaken for it
+* 
+* param params - the image to bind
+* param texture - the texture to bind it to
+* param bound - the texture the image is bound to, updated
+* return - True if there is no error, False otherwise, the caller decides whether the error stops the filter
+*/
+static bool alloc_image_from_texture(img_create_params_t *params, gs_texture_t *texture, ID3D11Texture2D **bound)
+{
+	struct ID3D11Texture2D *d11texture = texture ? (struct ID3D11Texture2D *)gs_texture_get_obj(texture) : NULL;
+
+	if (!d11texture)
+	{
+		error("Couldn't retrieve d3d11texture2d from gs_texture");
+		return false;
+	}
+
+	if (*(params->buffer) != NULL && *bound == d11texture)
+	{
+		return true;
+	}
+
+	debug("alloc_image_from_texture: registering texture");
+
+	unbind_texture_image(params->buffer, bound);
+
+	NvCV_Status vfxErr = NvCVImage_Create(params->width, params->height,
+					params->pixel_fmt, params->comp_type,
+					params->layout, NVCV_GPU,
+					params->alignment, params->buffer);
+
+	if (vfxErr == NVCV_SUCCESS)
+	{
+		vfxErr = NvCVImage_InitFromD3D11Texture(*(params->buffer), d11texture);
+	}
+
+	if (vfxErr != NVCV_SUCCESS)
+	{
+		error("Error allocating NvCVImage from ID3D11Texture");
+		error("NvVFX Error %i: %s", vfxErr, NvCV_GetErrorStringFromCode(vfxErr));
+		return false;
+	}
+
+	ID3D11Texture2D_AddRef(d11texture);
+	*bound = d11texture;
+
+	return true;
+}
+
+
+
+/*
+* Simple wrapper method around alloc_image_from_texture to accept textrender parameter, binding src_img
+* 
+* param filter
+* param params - 
+* param texture - OBS texrender texture to bind to the buffer in params
+* 
+* return - True if there is no error, False otherwise, which stops the filter
+*/
+static bool alloc_image_from_texrender(struct nv_superresolution_data *filter, img_create_params_t *params, gs_texrender_t *texture)
+{
+	kill_on_error(alloc_image_from_texture(params, gs_texrender_get_texture(texture), &filter->src_texture),
+		      "Error binding src_img to the render of the source", filter);
+
+	return true;
+}
+
+
+
+/*
+* Binds src_img to render for uses_fused_render. Unlike alloc_image_from_texrender a failure isn't an error,
+* the render's texture may not be one NvCVImage can be bound to, in which case every filter falls back to render_unorm
+* 
+* param filter - our OBS filter structure
+* param params - the parameters of src_img
+* 
+* return - True if src_img is bound to render
+*/
+static bool bind_fused_render(struct nv_superresolution_data *filter, img_create_params_t *params)
+{
+	gs_texture_t *texture = gs_texrender_get_texture(filter->render);
+	struct ID3D11Texture2D *d11texture = texture ? (struct ID3D11Texture2D *)gs_texture_get_obj(texture) : NULL;
+
+	if (*(params->buffer) != NULL && d11texture && filter->src_texture == d11texture)
+	{
+		return true;
+	}
+
+	unbind_texture_image(params->buffer, &filter->src_texture);
+
+	NvCV_Status vfxErr = d11texture ? NvCVImage_Create(params->width, params->height, params->pixel_fmt, params->comp_type,
+							    params->layout, NVCV_GPU, params->alignment, params->buffer) : NVCV_ERR_PARAMETER;
+
+	if (vfxErr == NVCV_SUCCESS)
+	{
+		vfxErr = NvCVImage_InitFromD3D11Texture(*(params->buffer), d11texture);
+	}
+
+	if (vfxErr != NVCV_SUCCESS)
+	{
+		info("Couldn't bind the sRGB render of the source directly (%s), converting it first instead", NvCV_GetErrorStringFromCode(vfxErr));
+
+		unbind_texture_image(params->buffer, &filter->src_texture);
+
+		fused_render_unsupported = true;
+		return false;
+	}
+
+	ID3D11Texture2D_AddRef(d11texture);
+	filter->src_texture = d11texture;
+
+	return true;
+}
+
+
+
+/* Returns the bytes of a row of pixels of an image created with the given parameters, without any padding */
+static size_t image_row_bytes(const img_create_params_t *params)
+{
+	const size_t component = params->comp_type == NVCV_U8 ? 1 : params->comp_type == NVCV_F16 ? 2 : 4;
+	const size_t channels = params->layout == NVCV_PLANAR || params->pixel_fmt == NVCV_Y ? 1 : 4;
+
+	return (size_t)params->width * channels * component;
+}
+
+
+
+/*
+* Returns the bytes between the rows of an image created with the given parameters. Rows are aligned to the image's own alignment,
+* and to NV_ARENA_PITCH_ALIGN when the image is sub-allocated from the arena
+*/
+static size_t image_pitch(const img_create_params_t *params)
+{
+	const size_t alignment = params->alignment > 0 ? params->alignment : 1;
+	const size_t pitch = (image_row_bytes(params) + alignment - 1) / alignment * alignment;
+
+	return gpu_arena ? nv_arena_pitch(gpu_arena, pitch) : pitch;
+}
+
+
+
+/* Returns the bytes an image created with the given parameters takes */
+static size_t image_bytes(const img_create_params_t *params)
+{
+	const size_t planes = params->layout == NVCV_PLANAR ? NV_PLANAR_PLANES : 1;
+
+	return image_pitch(params) * params->height * planes;
+}
+
+
+
+/* Returns an image's block to the arena, the deleteProc of the images sub-allocated from it */
+static void free_arena_block(void *address)
+{
+	nv_arena_free(gpu_arena, (uint64_t)(uintptr_t)address);
+}
+
+
+
+/* Logs what the arena holds, after the images of a filter have been (re)allocated */
+static void log_arena_stats(void)
+{
+	if (!gpu_arena)
+	{
+		return;
+	}
+
+	struct nv_arena_stats stats;
+	nv_arena_get_stats(gpu_arena, &stats);
+
+	info("Image arena: %.1f MB reserved in %u chunks, %.1f MB used by %u images, %.1f MB of it wasted to padding, %llu reservations",
+	     (double)stats.reserved / (1024.0 * 1024.0), stats.chunks, (double)stats.used / (1024.0 * 1024.0), stats.blocks,
+	     (double)stats.wasted / (1024.0 * 1024.0), (unsigned long long)stats.reservations);
+}
+
+
+
+/*
+* Allocates or reallocates the NvCVImage buffer provided in the param struct from the arena. The image keeps its block when it still fits,
+* otherwise its block is returned to the arena once the new one has been handed out, so a resize is served by the memory freed by the last one.
+* Blocks may be handed to another image as soon as they're freed, images are only reallocated once the filter's stream has been synchronized
+* 
+* returns - True if the image was bound to a block of the arena. False if it has to be allocated on its own instead, because the arena
+* couldn't hand out a block or the image couldn't be bound to it
+*/
+static bool alloc_arena_image(img_create_params_t *params)
+{
+	img_create_params_t largest = *params;
+	largest.width = params->width2 > params->width ? params->width2 : params->width;
+	largest.height = params->height2 > params->height ? params->height2 : params->height;
+
+	const size_t planes = params->layout == NVCV_PLANAR ? NV_PLANAR_PLANES : 1;
+	const size_t bytes = image_bytes(&largest);
+	const size_t padding = bytes - image_row_bytes(&largest) * largest.height * planes;
+
+	NvCVImage *img = *(params->buffer);
+	NvCV_Status vfxErr;
+
+	void *pixels = img && img->deleteProc == free_arena_block && img->bufferBytes >= bytes ? img->deletePtr : NULL;
+	size_t capacity = img && pixels ? (size_t)img->bufferBytes : 0;
+
+	if (!pixels)
+	{
+		pixels = (void *)(uintptr_t)nv_arena_alloc(gpu_arena, bytes, padding, &capacity);
+
+		if (!pixels)
+		{
+			return false;
+		}
+
+		if (img)
+		{
+			NvCVImage_Dealloc(img);
+		}
+		else
+		{
+			/* Left empty, NvCVImage_Init points it at the block */
+			vfxErr = NvCVImage_Create(0, 0, params->pixel_fmt, params->comp_type, params->layout, NVCV_GPU, params->alignment,
+						  params->buffer);
+
+			if (vfxErr != NVCV_SUCCESS)
+			{
+				nv_arena_free(gpu_arena, (uint64_t)(uintptr_t)pixels);
+				warn("Failed to create an image buffer for the arena, allocating it on its own. NvVFX Error %i: %s", vfxErr,
+				     NvCV_GetErrorStringFromCode(vfxErr));
+				return false;
+			}
+
+			img = *(params->buffer);
+		}
+	}
+
+	vfxErr = NvCVImage_Init(img, params->width, params->height, (int)image_pitch(params), pixels, params->pixel_fmt,
+				params->comp_type, params->layout, NVCV_GPU);
+
+	/* The image owns the block, NvCVImage_Destroy and NvCVImage_Dealloc hand it back to the arena */
+	img->deletePtr = pixels;
+	img->deleteProc = free_arena_block;
+	img->bufferBytes = capacity;
+
+	if (vfxErr != NVCV_SUCCESS)
+	{
+		NvCVImage_Dealloc(img);
+		warn("Failed to bind an image buffer to its arena block, allocating it on its own. NvVFX Error %i: %s", vfxErr,
+		     NvCV_GetErrorStringFromCode(vfxErr));
+		return false;
+	}
+
+	debug("alloc_arena_image: %zu bytes at %p for buffer %X", bytes, pixels, img);
+
+	return true;
+}
+
+
+
+/* Allocates or reallocates the NvCVImage buffer provided in the param struct with NvCVImage, outside of the arena
+* If width2 or height2 are > 0, the image buffer will have memory allocated to fit the maximum size between 
+* but be sized to width X height. This is used to allocate intermediary staging buffers
+* 
+* returns - True if there is no error, False otherwise
+*/
+static bool alloc_driver_image(struct nv_fx_load *load, img_create_params_t *params)
+{
+	debug("alloc_driver_image: entered for buffer %X", *(params->buffer));
+
+	uint32_t create_width = params->width2 > 0 ? params->width2 : params->width;
+	uint32_t create_height = params->height2 > 0 ? params->height2 : params->height;
+	NvCV_Status vfx_err;
+
+	// If our NVFX Image exists, resize and reformat it
+	if (*(params->buffer) != NULL)
+	{
+		debug("alloc_driver_image: realloc buffer %X", *(params->buffer));
+
+		vfx_err = NvCVImage_Realloc(
+			     *(params->buffer), create_width, create_height,
+			     params->pixel_fmt, params->comp_type,
+			     params->layout, NVCV_GPU, params->alignment);
+
+		load_error(vfx_err, "Failed to re-allocate image buffer", load);
+	}
+	else
+	{
+		debug("alloc_driver_image: creating new NvCVImage buffer for %X", *(params->buffer));
+
+		vfx_err = NvCVImage_Create(
+			     create_width, create_height, params->pixel_fmt,
+			     params->comp_type, params->layout, NVCV_GPU,
+			     params->alignment, params->buffer);
+
+		load_error(vfx_err, "Failed to create image buffer", load);
+
+		debug("alloc_driver_image: alloc buffer %X", *(params->buffer));
+		vfx_err = NvCVImage_Alloc(
+			     *(params->buffer), create_width, create_height,
+			     params->pixel_fmt, params->comp_type,
+			     params->layout, NVCV_GPU, params->alignment);
+
+		load_error(vfx_err, "Failed to allocate image buffer", load);
+
+		// We create our image at the given secondary size, and then resize it down to the original size we want
+		// This is the recommended method from the nVidia video effects SDK for allocating staging buffers
+		if (create_height != params->height || create_width != params->width)
+		{
+			debug("alloc_driver_image: two-sized re-alloc buffer %X", *(params->buffer));
+
+			vfx_err = NvCVImage_Realloc(
+				     *(params->buffer), params->width,
+				     params->height,
+				     params->pixel_fmt, params->comp_type,
+				     params->layout, NVCV_GPU,
+				     params->alignment);
+
+			load_error(vfx_err, "Failed to resize image buffer", load);
+		}
+	}
+
+	debug("alloc_driver_image: exiting for buffer %X", *(params->buffer));
+
+	return true;
+}
+
+
+
+/* Allocates or reallocates the NvCVImage buffer provided in the param struct from the arena, or with NvCVImage when it can't be
+* returns - True if there is no error, False otherwise
+*/
+static bool alloc_image(struct nv_fx_load *load, img_create_params_t *params)
+{
+	if (gpu_arena && alloc_arena_image(params))
+	{
+		return true;
+	}
+
+	return alloc_driver_image(load, params);
+}
+
+
+
+/*
+* Keeps a texrender if it's wanted and has the given format, otherwise destroys it, and creates it if it's wanted. Must be called within the graphics context
+* param render - the texrender
+* param format - the format it has to have
+* param wanted - false to only destroy it
+* return - False if it's wanted and couldn't be created, True otherwise
+*/
+static bool keep_texrender(gs_texrender_t **render, enum gs_color_format format, bool wanted)
+{
+	if (*render && (!wanted || gs_texrender_get_format(*render) != format))
+	{
+		gs_texrender_destroy(*render);
+		*render = NULL;
+	}
+
+	if (wanted && !*render)
+	{
+		*render = gs_texrender_create(format, GS_ZS_NONE);
+	}
+
+	return !wanted || *render;
+}
+
+
+
+/*
+* Allocates required textures for the OBS source our filter is applied to
+* 
+* param filter - our OBS filter structure
+* return - True if there is no error, False otherwise
+*/
+static bool alloc_obs_textures(struct nv_superresolution_data* filter)
+{
+	debug("alloc_obs_textures: entering");
+
+	/* 3. create texrenders, those that already have the right format are kept along with their texture and its CUDA registration */
+	kill_on_error(keep_texrender(&filter->render, gs_get_format_from_space(filter->space), true), "Failed to create render texrenderer",
+		      filter);
+
+	/* 8 bit sRGB sources are bound straight from render, render_unorm is created if the source changes */
+	kill_on_error(keep_texrender(&filter->render_unorm, GS_BGRA_UNORM, !uses_fused_render(filter, filter->space)),
+		      "Failed to create render_unorm texrenderer", filter);
+
+	filter->src_render = NULL;
+
+	/* Only the effects taking planar input read render_planar, the Upscaling filter is fed from render_unorm */
+	filter->render_planar_format = planar_format(filter->live.planar_comp);
+	kill_on_error(keep_texrender(&filter->render_planar, filter->render_planar_format, uses_planar_input(filter)),
+		      "Failed to create render_planar texrenderer", filter);
+
+	kill_on_error(keep_texrender(&filter->render_frame, GS_BGRA_UNORM, filter->roi_enabled), "Failed to create render_frame texrenderer",
+		      filter);
+
+	/* The fingerprint is the same size for any source */
+	if (!filter->fingerprint_render)
+	{
+		debug("alloc_obs_textures: creating fingerprint texture");
+		filter->fingerprint_partial = gs_texrender_create(GS_RGBA32F, GS_ZS_NONE);
+		filter->fingerprint_render = gs_texrender_create(GS_RGBA32F, GS_ZS_NONE);
+
+		kill_on_error(filter->fingerprint_partial && filter->fingerprint_render, "Failed to create fingerprint texrenderer", filter);
+	}
+
+	/* The fingerprints staged before were taken of another source size, they can't be compared to */
+	for (uint32_t i = 0; i < NV_FINGERPRINT_STAGES; ++i)
+	{
+		if (!filter->fingerprint_stages[i])
+		{
+			filter->fingerprint_stages[i] = gs_stagesurface_create(NV_FINGERPRINT_GRID, NV_FINGERPRINT_GRID, GS_RGBA32F);
+
+			kill_on_error(filter->fingerprint_stages[i], "Failed to create fingerprint staging surface", filter);
+		}
+
+		filter->fingerprint_staged[i] = false;
+	}
+
+	filter->done_initial_render = false;
+	filter->fingerprint_valid = false;
+
+	debug("alloc_obs_textures: exiting");
+	return true;
+}
+
+
+
+/* Buffers of the NvVFX pipeline that are views into planned allocations are made this many bytes to a row, see alloc_planned_backing */
+#define NV_PLAN_ROW_BYTES 4096
+
+
+
+/*
+* Describes the intermediate buffers the effects of the filter run on, and the shape of the pipeline they make
+* A. AR: AR_src and AR_dst, BGR planar at the source size
+* B. SR or Upscaling: SR_src at the source size and SR_dst at the output size, BGR planar for SuperRes and RGBA U8 for Upscaling
+* C. Both: SuperRes reads AR_dst directly and has no SR_src, Upscaling is fed AR_dst converted into SR_src
+* 
+* param load - the tier being loaded, and everything loading it reads
+* param params - OUTPUT parameter, the creation parameters of each nv_plan_buffer, with a NULL buffer for those that aren't used
+* param shape - OUTPUT parameter, the shape of the pipeline for nv_plan_buffers
+*/
+static void describe_nvfx_images(struct nv_fx_load *load, img_create_params_t params[NV_PLAN_BUFFERS],
+				 struct nv_plan_shape *shape)
+{
+	memset(params, 0, sizeof(img_create_params_t) * NV_PLAN_BUFFERS);
+	memset(shape, 0, sizeof(*shape));
+
+	const img_create_params_t planar = {
+		.pixel_fmt = NVCV_BGR,
+		.comp_type = load->state.planar_comp,
+		.layout = NVCV_PLANAR,
+		.alignment = 1
+	};
+
+	const img_create_params_t chunky = {
+		.pixel_fmt = NVCV_RGBA,
+		.comp_type = NVCV_U8,
+		.layout = NVCV_CHUNKY,
+		.alignment = 32
+	};
+
+	if (load->state.ar_handle)
+	{
+		params[NV_PLAN_AR_SRC] = planar;
+		params[NV_PLAN_AR_SRC].buffer = &load->state.gpu_ar_src_img;
+		params[NV_PLAN_AR_SRC].width = load->width;
+		params[NV_PLAN_AR_SRC].height = load->height;
+
+		params[NV_PLAN_AR_DST] = params[NV_PLAN_AR_SRC];
+		params[NV_PLAN_AR_DST].buffer = &load->state.gpu_ar_dst_img;
+	}
+
+	if (load->state.sr_handle && load->is_target_valid && (load->config.type == S_TYPE_SR || load->config.type == S_TYPE_UP))
+	{
+		const img_create_params_t *format = load->config.type == S_TYPE_SR ? &planar : &chunky;
+
+		if (!tier_reads_ar_output(&load->state, load->config.type))
+		{
+			params[NV_PLAN_SR_SRC] = *format;
+			params[NV_PLAN_SR_SRC].buffer = &load->state.gpu_sr_src_img;
+			params[NV_PLAN_SR_SRC].width = load->width;
+			params[NV_PLAN_SR_SRC].height = load->height;
+		}
+
+		params[NV_PLAN_SR_DST] = *format;
+		params[NV_PLAN_SR_DST].buffer = &load->state.gpu_sr_dst_img;
+		params[NV_PLAN_SR_DST].width = load->state.out_width;
+		params[NV_PLAN_SR_DST].height = load->state.out_height;
+
+		shape->sr = true;
+	}
+
+	shape->ar = load->state.ar_handle != NULL;
+	shape->sr_reads_ar = tier_reads_ar_output(&load->state, load->config.type);
+	shape->batched = load->batch; // whether or not a group forms, a batch may run our SR pass until the next frame
+
+	for (uint32_t i = 0; i < NV_PLAN_BUFFERS; ++i)
+	{
+		shape->bytes[i] = params[i].buffer ? image_bytes(&params[i]) : 0;
+	}
+}
+
+
+
+/*
+* Makes an image a view of its planned backing allocation, creating the image header if it doesn't exist yet.
+* The image never owns its memory, destroying it leaves the backing allocation as it is
+* 
+* param load - the tier being loaded, and everything loading it reads
+* param params - the image to bind
+* param backing - the backing allocation, at least image_bytes(params) in size
+* return - True if there is no error, False otherwise
+*/
+static bool bind_planned_image(struct nv_fx_load *load, img_create_params_t *params, NvCVImage *backing)
+{
+	NvCV_Status vfxErr;
+
+	if (!*(params->buffer))
+	{
+		/* Left empty, NvCVImage_Init points it at the backing allocation */
+		vfxErr = NvCVImage_Create(0, 0, params->pixel_fmt, params->comp_type, params->layout, NVCV_GPU, params->alignment,
+					  params->buffer);
+		load_error(vfxErr, "Failed to create image buffer", load);
+	}
+
+	vfxErr = NvCVImage_Init(*(params->buffer), params->width, params->height, (int)image_pitch(params), backing->pixels,
+				params->pixel_fmt, params->comp_type, params->layout, NVCV_GPU);
+	load_error(vfxErr, "Failed to bind image buffer to its planned allocation", load);
+
+	return true;
+}
+
+
+
+/* Allocates the Upscaling staging buffer. It's allocated outside of the arena, as NvCVImage_Transfer grows it itself when it's too small */
+static bool alloc_staging_image(struct nv_fx_load *load)
+{
+	/* BGRf32 planar images are only ever copied to and from D3D textures without conversion, no staging buffer is required */
+	if (!load->state.sr_handle || !load->is_target_valid || load->config.type != S_TYPE_UP)
+	{
+		return true;
+	}
+
+	/* Allocated at the larger of the source and output sizes, then sized to the source */
+	img_create_params_t img = {
+		.buffer = &load->state.gpu_staging_img,
+		.width = load->width,
+		.height = load->height,
+		.width2 = load->state.out_width,
+		.height2 = load->state.out_height,
+		.pixel_fmt = NVCV_RGBA,
+		.comp_type = NVCV_U8,
+		.layout = NVCV_CHUNKY,
+		.alignment = 32
+	};
+
+	if (!alloc_driver_image(load, &img))
+	{
+		error("Failed to allocate NvCVImage FX staging buffer");
+		return false;
+	}
+
+	return true;
+}
+
+
+
+/*
+* (Re)allocates the buffers of the effects. Rather than each buffer getting an allocation of its own, the buffers that are
+* never live during the same step of a frame share one, as planned by nv_plan_buffers. In path C the AR source holds the
+* SuperRes output, or the Upscaling source, as the AR source has been read by the time either is written
+* 
+* return - false if there's any error, true otherwise
+*/
+static bool alloc_nvfx_images(struct nv_fx_load *load)
+{
+	debug("alloc_nvfx_images: entering");
+
+	load->state.planar_comp = planar_comp_type(&load->state, load->config.type, load->half_precision);
+
+	/* Oversized sources are only ever processed in tiles by the tile pass, the full size buffers would never be loaded */
+	if (load->oversized)
+	{
+		nv_destroy_fx_filter(NULL, &load->state.gpu_ar_src_img, &load->state.gpu_ar_dst_img);
+		nv_destroy_fx_filter(NULL, &load->state.gpu_sr_src_img, &load->state.gpu_sr_dst_img);
+		destroy_planned_backings(load->state.planned, 0);
+		return true;
+	}
+
+	img_create_params_t params[NV_PLAN_BUFFERS];
+	struct nv_plan_shape shape;
+	struct nv_plan plan;
+
+	describe_nvfx_images(load, params, &shape);
+	nv_plan_buffers(&shape, &plan);
+
+	for (uint32_t b = 0; b < plan.backing_count; ++b)
+	{
+		img_create_params_t backing = {
+			.buffer = &load->state.planned[b],
+			.width = NV_PLAN_ROW_BYTES,
+			.height = (uint32_t)((plan.backing_bytes[b] + NV_PLAN_ROW_BYTES - 1) / NV_PLAN_ROW_BYTES),
+			.pixel_fmt = NVCV_Y,
+			.comp_type = NVCV_U8,
+			.layout = NVCV_CHUNKY,
+			.alignment = 1
+		};
+
+		if (!alloc_image(load, &backing))
+		{
+			error("Failed to allocate the backing buffer of the NvVFX images");
+			return false;
+		}
+	}
+
+	/* The buffers the pipeline doesn't use, such as SR_src when SuperRes reads the AR output, are destroyed */
+	NvCVImage **buffers[NV_PLAN_BUFFERS] = {&load->state.gpu_ar_src_img, &load->state.gpu_ar_dst_img, &load->state.gpu_sr_src_img, &load->state.gpu_sr_dst_img};
+
+	for (uint32_t i = 0; i < NV_PLAN_BUFFERS; ++i)
+	{
+		if (plan.backing[i] < 0)
+		{
+			nv_destroy_fx_filter(NULL, buffers[i], NULL);
+		}
+		else if (!bind_planned_image(load, &params[i], load->state.planned[plan.backing[i]]))
+		{
+			return false;
+		}
+	}
+
+	destroy_planned_backings(load->state.planned, plan.backing_count);
+
+	if (!alloc_staging_image(load))
+	{
+		return false;
+	}
+
+	if (plan.backing_count > 0)
+	{
+		info("NvVFX buffers take %.1f MB in %u allocations, %.1f MB with an allocation each", (double)plan.planned_bytes / (1024.0 * 1024.0),
+		     plan.backing_count, (double)plan.separate_bytes / (1024.0 * 1024.0));
+	}
+
+	log_arena_stats();
+
+	load->reload_ar_fx = load->state.ar_handle != NULL;
+	load->reload_sr_fx = load->state.sr_handle != NULL;
+
+	debug("alloc_nvfx_images: exiting");
+
+	return true;
+}
+
+
+
+/*
+* Keeps a texture if it has the given size and format, destroying it otherwise. Must be called within the graphics context
+* param texture - the texture, nulled out if it's destroyed
+* param width, height, format - what the texture has to be, a width of 0 if it isn't wanted at all
+*/
+static void keep_texture(gs_texture_t **texture, uint32_t width, uint32_t height, enum gs_color_format format)
+{
+	if (*texture && (width == 0 || gs_texture_get_width(*texture) != width || gs_texture_get_height(*texture) != height ||
+			 gs_texture_get_color_format(*texture) != format))
+	{
+		gs_texture_destroy(*texture);
+		*texture = NULL;
+	}
+}
+
+
+
+/*
+* Initializes and binds the final destination NVFX Image of an output slot to the output texture intended for OBS
+* note: the textures are kept if they already have the right size and format, along with the registration of the one dst_img is bound to,
+* and recreated otherwise
+* param filter - Our OBS data structure
+* param tier, type - the tier the slot is drawn from, see tier_planar_input
+* param slot - the output slot to (re)create
+* return - False if there is an error, the caller decides whether it stops the filter
+*/
+static bool alloc_output_slot(struct nv_superresolution_data *filter, const struct nv_tier_state *tier, int type, struct nv_output_slot *slot)
+{
+	const bool planar = tier_planar_output(tier, type);
+	const enum gs_color_format planar_fmt = planar_format(tier->planar_comp);
+
+	slot->hdr = uses_hdr_path(filter, tier, type);
+	slot->ready = false;
+	slot->in_flight = false;
+	slot->needs_resolve = false;
+	slot->needs_compose = false;
+	slot->has_fingerprint = false;
+
+	keep_texture(&slot->scaled_texture, tier->out_width, tier->out_height, slot->hdr ? GS_RGBA16F : GS_RGBA_UNORM);
+	keep_texture(&slot->planar_texture, planar ? tier->out_width : 0, tier->out_height * NV_PLANAR_PLANES, planar_fmt);
+	keep_texture(&slot->frame_texture, filter->roi_enabled ? tier->frame_out_width : 0, tier->frame_out_height, GS_RGBA_UNORM);
+
+	if (!slot->scaled_texture)
+	{
+		slot->scaled_texture = gs_texture_create(tier->out_width, tier->out_height, slot->hdr ? GS_RGBA16F : GS_RGBA_UNORM, 1, NULL,
+							 GS_RENDER_TARGET);
+
+		if (!slot->scaled_texture)
+		{
+			error("Final output texture couldn't be created");
+			return false;
+		}
+	}
+
+	img_create_params_t params = {
+		.buffer = &slot->dst_img,
+		.width = tier->out_width,
+		.height = tier->out_height,
+		.pixel_fmt = NVCV_RGBA,
+		.comp_type = NVCV_U8,
+		.layout = NVCV_CHUNKY,
+		.alignment = 0
+	};
+
+	gs_texture_t *bound_texture = slot->scaled_texture;
+
+	if (planar)
+	{
+		if (!slot->planar_texture)
+		{
+			slot->planar_texture = gs_texture_create(tier->out_width, tier->out_height * NV_PLANAR_PLANES, planar_fmt, 1, NULL, 0);
+
+			if (!slot->planar_texture)
+			{
+				error("Planar output texture couldn't be created");
+				return false;
+			}
+		}
+
+		params.height = tier->out_height * NV_PLANAR_PLANES;
+		params.pixel_fmt = NVCV_Y;
+		params.comp_type = tier->planar_comp;
+		bound_texture = slot->planar_texture;
+	}
+
+	if (!alloc_image_from_texture(&params, bound_texture, &slot->dst_texture))
+	{
+		error("Failed to create dest NvCVImage from OBS output texture");
+		return false;
+	}
+
+	if (filter->roi_enabled && !slot->frame_texture)
+	{
+		slot->frame_texture = gs_texture_create(tier->frame_out_width, tier->frame_out_height, GS_RGBA_UNORM, 1, NULL, GS_RENDER_TARGET);
+
+		if (!slot->frame_texture)
+		{
+			error("Region of interest output texture couldn't be created");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+/*
+* (Re)creates the ring of output slots of a tier, one slot or NV_OUTPUT_RING_SIZE slots when pipelining
+* param filter - Our OBS data structure
+* param tier, type - the tier, the live one or one loaded ahead, see tier_planar_input
+* return - False if there is an error, the caller decides whether it stops the filter
+*/
+static bool alloc_destination_image(struct nv_superresolution_data *filter, struct nv_tier_state *tier, int type)
+{
+	tier->output_count = filter->pipelined ? NV_OUTPUT_RING_SIZE : 1;
+	tier->output_index = 0;
+	tier->draw_index = 0;
+
+	for (uint32_t i = 0; i < NV_OUTPUT_RING_SIZE; ++i)
+	{
+		if (i >= tier->output_count)
+		{
+			destroy_output_slot(&tier->outputs[i]);
+		}
+		else if (!alloc_output_slot(filter, tier, type, &tier->outputs[i]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+/*
+* Creates a matte ramping from 0 to 1 across one of its axes, uploaded from the CPU
+* 
+* param load - the tier being loaded, and everything loading it reads
+* param width - width of the matte
+* param height - height of the matte
+* param horizontal - True to ramp from left to right, False from top to bottom
+* param matte - receives the matte
+* return - False if there is an error, True otherwise
+*/
+static bool create_ramp_matte(struct nv_fx_load *load, uint32_t width, uint32_t height, bool horizontal, NvCVImage **matte)
+{
+	NvCVImage *cpu = NULL;
+	NvCV_Status vfxErr = NvCVImage_Create(width, height, NVCV_A, NVCV_F32, NVCV_CHUNKY, NVCV_CPU, 1, &cpu);
+
+	if (vfxErr == NVCV_SUCCESS)
+	{
+		const uint32_t ramp = horizontal ? width : height;
+
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			float *row = (float *)((uint8_t *)cpu->pixels + (size_t)y * cpu->pitch);
+
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				row[x] = nv_tile_ramp(horizontal ? x : y, ramp);
+			}
+		}
+
+		vfxErr = NvCVImage_Create(width, height, NVCV_A, NVCV_F32, NVCV_CHUNKY, NVCV_GPU, 1, matte);
+	}
+
+	if (vfxErr == NVCV_SUCCESS)
+	{
+		vfxErr = NvCVImage_Transfer(cpu, *matte, 1.0f, load->stream, NULL);
+		cuStreamSynchronize(load->stream);
+	}
+
+	NvCVImage_Destroy(cpu);
+	load_error(vfxErr, "Error creating a tile blending matte", load);
+
+	return true;
+}
+
+
+
+/*
+* Creates the mattes and the buffer the tile pass feathers its seams with, see nv_tile_blend_rects
+* 
+* param load - the tier being loaded, and everything loading it reads
+* return - False if there is an error, True otherwise
+*/
+static bool alloc_tile_blend(struct nv_fx_load *load)
+{
+	struct nv_tile_pass *pass = &load->state.tiles;
+
+	/* Aligned bands are the same number of output pixels across in every tile */
+	pass->ramp = (uint32_t)((uint64_t)pass->layout.feather * 2 * pass->out_width / pass->layout.tile_width);
+
+	if (pass->ramp == 0)
+	{
+		return true;
+	}
+
+	img_create_params_t img = {
+		.buffer = &pass->blend_img,
+		.width = pass->out_width,
+		.height = pass->out_height,
+		.pixel_fmt = NVCV_BGR,
+		.comp_type = load->state.planar_comp,
+		.layout = NVCV_PLANAR,
+		.alignment = 1
+	};
+
+	if (!alloc_image(load, &img))
+	{
+		error("Failed to allocate the tile blending buffer");
+		return false;
+	}
+
+	if (!create_ramp_matte(load, pass->ramp, pass->out_height, true, &pass->ramp_x_img) ||
+	    !create_ramp_matte(load, pass->out_width, pass->ramp, false, &pass->ramp_y_img))
+	{
+		return false;
+	}
+
+	pass->feather = true;
+	return true;
+}
+
+
+
+/*
+* (Re)creates the tile pass for the current pipeline and source size. The tile pass is left disabled if neither tiled updates are on
+* nor the source is oversized, the pipeline can't be tiled, or the source is smaller than a tile
+* param load - the tier being loaded, and everything loading it reads
+*/
+static bool alloc_tile_pass(struct nv_fx_load *load)
+{
+	struct nv_tile_pass *pass = &load->state.tiles;
+
+	destroy_tile_pass(pass);
+
+	if (!(load->tiled_updates || load->oversized) || !tier_supports_tiles(&load->state, load->config.type))
+	{
+		return true;
+	}
+
+	/* Oversized sources are split into the largest tiles the effects accept, which tiled updates then work with as well */
+	uint32_t tile_width = NV_TILE_SIZE;
+	uint32_t tile_height = NV_TILE_SIZE;
+
+	if (load->oversized)
+	{
+		get_tile_size(load->apply_ar, load->config.type, load->config.scale, load->width, load->height, &tile_width, &tile_height);
+	}
+
+	if (!nv_tile_layout_init(&pass->layout, load->width, load->height, tile_width, tile_height, NV_TILE_OVERLAP))
+	{
+		return true;
+	}
+
+	debug("alloc_tile_pass: %ux%u tiles", pass->layout.cols, pass->layout.rows);
+
+	pass->out_width = pass->layout.tile_width;
+	pass->out_height = pass->layout.tile_height;
+
+	if (load->state.sr_handle)
+	{
+		get_scale_factor(load->config.scale, pass->layout.tile_width, pass->layout.tile_height, &pass->out_width, &pass->out_height);
+	}
+
+	img_create_params_t img = {
+		.width = pass->layout.tile_width,
+		.height = pass->layout.tile_height,
+		.pixel_fmt = NVCV_BGR,
+		.comp_type = load->state.planar_comp,
+		.layout = NVCV_PLANAR,
+		.alignment = 1
+	};
+
+	if (load->state.ar_handle)
+	{
+		if (!create_nvfx(load, &pass->ar_handle, NVVFX_FX_ARTIFACT_REDUCTION))
+		{
+			return false;
+		}
+
+		img.buffer = &pass->ar_src_img;
+
+		if (!alloc_image(load, &img))
+		{
+			error("Failed to allocate AR tile source buffer");
+			return false;
+		}
+
+		img.buffer = &pass->ar_dst_img;
+
+		if (!alloc_image(load, &img))
+		{
+			error("Failed to allocate AR tile dest buffer");
+			return false;
+		}
+	}
+
+	if (load->state.sr_handle)
+	{
+		if (!create_nvfx(load, &pass->sr_handle, NVVFX_FX_SUPER_RES))
+		{
+			return false;
+		}
+
+		if (!load->state.ar_handle)
+		{
+			img.buffer = &pass->sr_src_img;
+
+			if (!alloc_image(load, &img))
+			{
+				error("Failed to allocate SuperRes tile source buffer");
+				return false;
+			}
+		}
+
+		img.buffer = &pass->sr_dst_img;
+		img.width = pass->out_width;
+		img.height = pass->out_height;
+
+		if (!alloc_image(load, &img))
+		{
+			error("Failed to allocate SuperRes tile dest buffer");
+			return false;
+		}
+	}
+
+	if (!alloc_tile_blend(load))
+	{
+		return false;
+	}
+
+	pass->enabled = true;
+	return true;
+}
+
+
+
+/*
+* Called when the source, or this filter itself needs to be reinitialized for some reason.
+*/
+static void nv_superres_filter_reset(void *data, calldata_t *calldata)
+{
+	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)data;
+
+	debug("nv_superres_filter_reset: Entering");
+
+	if (!filter)
+	{
+		error("Attempted to reset filter, but filter structure is invalid!");
+		return;
+	}
+
+	/* The stream and the effects belong to a reconfiguration until it's finished */
+	if (!set_lifecycle(filter, NV_LIFECYCLE_RUNNING, NV_LIFECYCLE_STOPPED) && get_lifecycle(filter) != NV_LIFECYCLE_STOPPED)
+	{
+		debug("nv_superres_filter_reset: the filter is being reconfigured or destroyed");
+		return;
+	}
+
+	debug("nv_superres_filter_reset: Source reset recreate CUDA stream");
+	if (!create_cuda(filter))
+	{
+		return;
+	}
+
+	filter->destroy_ar = true;
+	filter->destroy_sr = true;
+	filter->reload_ar_fx = true;
+	filter->reload_sr_fx = true;
+	filter->are_images_allocated = false;
+
+	set_lifecycle(filter, NV_LIFECYCLE_STOPPED, NV_LIFECYCLE_RUNNING);
+
+	debug("nv_superres_filter_reset: Entering");
+}
+
+
+
+/*
+* Wraps a BGR planar image as the single channel image that is the same memory viewed with its planes stacked vertically.
+* This is the layout our planar render textures use, and lets the mapped texture be moved in with a plain copy
+* 
+* param view - the image header to initialize, it does not own any memory
+* param planar - the BGR f32 or f16 planar image to view, the view has the same component type
+* return - True if there is no error, False otherwise
+*/
+static bool init_planar_view(NvCVImage *view, NvCVImage *planar)
+{
+	NvCV_Status vfxErr = NvCVImage_Init(view, planar->width, planar->height * NV_PLANAR_PLANES, planar->pitch, planar->pixels,
+					NVCV_Y, planar->componentType, NVCV_CHUNKY, NVCV_GPU);
+
+	return vfxErr == NVCV_SUCCESS;
+}
+
+
+
+/*
+* Converts the BGR f32 planar output in planar_texture into the RGBA U8 scaled_texture with the ResolvePlanar shader pass,
+* or decodes it into the RGBA 16F scaled_texture of an HDR slot with the ResolvePlanarPQ pass
+* 
+* param filter - our OBS filter structure
+* param slot - the output slot to resolve
+*/
+static void resolve_planar_output(struct nv_superresolution_data *filter, struct nv_output_slot *slot)
+{
+	gs_texture_t *previous_target = gs_get_render_target();
+	gs_zstencil_t *previous_zstencil = gs_get_zstencil_target();
+	const bool previous_srgb = gs_framebuffer_srgb_enabled();
+
+	gs_viewport_push();
+	gs_projection_push();
+	gs_matrix_push();
+	gs_matrix_identity();
+	gs_blend_state_push();
+
+	gs_set_render_target(slot->scaled_texture, NULL);
+	gs_set_viewport(0, 0, filter->live.out_width, filter->live.out_height);
+	gs_ortho(0.0f, (float)filter->live.out_width, 0.0f, (float)filter->live.out_height, -100.0f, 100.0f);
+	gs_enable_framebuffer_srgb(false);
+	gs_enable_blending(false);
+
+	gs_effect_set_texture(filter->image_param, slot->planar_texture);
+	gs_effect_set_int(filter->plane_height_param, (int)filter->live.out_height);
+	gs_effect_set_float(filter->planar_scale_param, planar_output_scale(filter));
+
+	/* Back from the fraction of 10000 nits PQ covers to GS_CS_709_EXTENDED, where 1 is the SDR white level */
+	gs_effect_set_float(filter->multiplier_param, 10000.0f / obs_get_video_sdr_white_level());
+
+	while (gs_effect_loop(filter->effect, slot->hdr ? "ResolvePlanarPQ" : "ResolvePlanar"))
+	{
+		gs_draw(GS_TRIS, 0, 3);
+	}
+
+	gs_enable_blending(true);
+	gs_enable_framebuffer_srgb(previous_srgb);
+	gs_set_render_target(previous_target, previous_zstencil);
+
+	gs_blend_state_pop();
+	gs_matrix_pop();
+	gs_projection_pop();
+	gs_viewport_pop();
+}
+
+
+
+/*
+* Records the completion event of an output slot on our CUDA stream, after all the work queued for its frame.
+* Falls back to synchronous processing if the CUDA driver API isn't usable, NvCVImage_UnmapResource still orders the D3D reads after it.
+* 
+* param filter - our OBS filter structure
+* param slot - the output slot the frame was just transferred into
+* return - True if the event was recorded and has to be waited on
+*/
+static bool record_output_event(struct nv_superresolution_data *filter, struct nv_output_slot *slot)
+{
+	CUresult cuErr = CUDA_SUCCESS;
+
+	/* Blocking sync lets the graphics thread sleep instead of spinning when it has to wait on the event */
+	if (!slot->done)
+	{
+		cuErr = cuEventCreate(&slot->done, CU_EVENT_BLOCKING_SYNC | CU_EVENT_DISABLE_TIMING);
+	}
+
+	if (cuErr == CUDA_SUCCESS)
+	{
+		cuErr = cuEventRecord(slot->done, filter->stream);
+	}
+
+	if (cuErr != CUDA_SUCCESS)
+	{
+		info("CUDA events unavailable (%i), falling back to synchronous processing", cuErr);
+
+		filter->async_run = false;
+		filter->async_failed = true;
+		slot->done = NULL;
+
+		return false;
+	}
+
+	return true;
+}
+
+
+
+/*
+* Draws a texture stretched over a rectangle of a render target with the Stretch pass, bilinearly filtered. Must be called within the graphics context
+* 
+* param filter - our OBS filter structure
+* param target - the render target to draw to
+* param texture - the texture to draw
+* param x, y, width, height - the rectangle of the target to draw the texture over
+*/
+static void draw_stretched(struct nv_superresolution_data *filter, gs_texture_t *target, gs_texture_t *texture, uint32_t x, uint32_t y,
+			   uint32_t width, uint32_t height)
+{
+	const uint32_t target_width = gs_texture_get_width(target);
+	const uint32_t target_height = gs_texture_get_height(target);
+	gs_texture_t *previous_target = gs_get_render_target();
+	gs_zstencil_t *previous_zstencil = gs_get_zstencil_target();
+	const bool previous_srgb = gs_framebuffer_srgb_enabled();
+
+	gs_viewport_push();
+	gs_projection_push();
+	gs_matrix_push();
+	gs_matrix_identity();
+	gs_blend_state_push();
+
+	gs_set_render_target(target, NULL);
+	gs_set_viewport(0, 0, target_width, target_height);
+	gs_ortho(0.0f, (float)target_width, 0.0f, (float)target_height, -100.0f, 100.0f);
+	gs_enable_framebuffer_srgb(false);
+	gs_enable_blending(false);
+	gs_matrix_translate3f((float)x, (float)y, 0.0f);
+
+	gs_effect_set_texture(filter->image_param, texture);
+
+	while (gs_effect_loop(filter->effect, "Stretch"))
+	{
+		gs_draw_sprite(texture, 0, width, height);
+	}
+
+	gs_enable_blending(true);
+	gs_enable_framebuffer_srgb(previous_srgb);
+	gs_set_render_target(previous_target, previous_zstencil);
+
+	gs_blend_state_pop();
+	gs_matrix_pop();
+	gs_projection_pop();
+	gs_viewport_pop();
+}
+
+
+
+/*
+* Waits for the GPU to finish the frame in an output slot, and resolves it into scaled_texture if the output is planar,
+* and into frame_texture with a region of interest.
+* Must be called within the graphics context, before the slot's scaled_texture is sampled
+* 
+* param filter - our OBS filter structure
+* param slot - the output slot about to be drawn
+*/
+static void finish_output_slot(struct nv_superresolution_data *filter, struct nv_output_slot *slot)
+{
+	if (slot->in_flight)
+	{
+		/* Most of the time a frame has passed since this was queued, only block when it really isn't done */
+		CUresult cuErr = cuEventQuery(slot->done);
+
+		if (cuErr == CUDA_ERROR_NOT_READY)
+		{
+			cuErr = cuEventSynchronize(slot->done);
+		}
+
+		if (cuErr != CUDA_SUCCESS)
+		{
+			error("Error %i waiting for the NvVFX effects to complete", cuErr);
+		}
+
+		slot->in_flight = false;
+	}
+
+	if (slot->needs_resolve && slot->planar_texture)
+	{
+		resolve_planar_output(filter, slot);
+		slot->needs_resolve = false;
+	}
+
+	/* Draw the region of interest over the rest of the stretched source, at the same place it's scaled to */
+	if (slot->needs_compose && slot->frame_texture)
+	{
+		const uint32_t x = (uint32_t)((uint64_t)filter->roi.x * filter->live.frame_out_width / filter->frame_width);
+		const uint32_t y = (uint32_t)((uint64_t)filter->roi.y * filter->live.frame_out_height / filter->frame_height);
+
+		draw_stretched(filter, slot->frame_texture, slot->scaled_texture, x, y, filter->live.out_width, filter->live.out_height);
+		slot->needs_compose = false;
+	}
+}
+
+
+
+/*
+* Stretches the whole source in render_frame into the frame_texture of an output slot, for the region of interest to be composed over
+* by finish_output_slot. Does nothing without a region of interest. Must be called within the graphics context
+* 
+* param filter - our OBS filter structure
+* param slot - the output slot to stretch the source into
+*/
+static void stretch_surround(struct nv_superresolution_data *filter, struct nv_output_slot *slot)
+{
+	if (slot->frame_texture)
+	{
+		draw_stretched(filter, slot->frame_texture, gs_texrender_get_texture(filter->render_frame), 0, 0, filter->live.frame_out_width,
+			       filter->live.frame_out_height);
+		slot->needs_compose = true;
+	}
+}
+
+
+
+/*
+* Marks an output slot as holding the frame just processed into it, and makes it the latest output
+* 
+* param filter - our OBS filter structure
+* param slot_index - the output slot the frame was processed into
+* param planar - True if the slot's planar_texture has to be resolved into scaled_texture
+*/
+static void complete_output_slot(struct nv_superresolution_data *filter, uint32_t slot_index, bool planar)
+{
+	struct nv_output_slot *slot = &filter->live.outputs[slot_index];
+
+	/* Mark the point the GPU is done with this frame, the resolve and the wait are left until the slot is drawn a frame later.
+	* Without pipelining the slot is drawn right away, waiting on it then would block the graphics thread on our stream and serialize
+	* every filter. NvCVImage_UnmapResource already orders the D3D reads of the slot after the effects, so there's nothing to wait on
+	*/
+	slot->in_flight = filter->async_run && filter->pipelined && record_output_event(filter, slot);
+	slot->needs_resolve = planar;
+	slot->ready = true;
+
+	slot->fingerprint = filter->fingerprint;
+	slot->has_fingerprint = filter->tiled_updates && filter->fingerprint_valid;
+
+	/* Stretch the source around the region of interest now, while render_frame still holds the frame the effects ran on */
+	stretch_surround(filter, slot);
+
+	filter->live.output_index = slot_index;
+}
+
+
+
+/*
+* Sets the images of, and loads, one of the tile pass effects
+* 
+* return - the status of the first NvVFX call to fail, or NVCV_SUCCESS
+*/
+static NvCV_Status load_tile_fx(NvVFX_Handle handle, unsigned int mode, NvCVImage *input, NvCVImage *output)
+{
+	NvCV_Status vfxErr = NvVFX_SetU32(handle, NVVFX_MODE, mode);
+
+	if (vfxErr == NVCV_SUCCESS)
+	{
+		vfxErr = NvVFX_SetImage(handle, NVVFX_INPUT_IMAGE, input);
+	}
+
+	if (vfxErr == NVCV_SUCCESS)
+	{
+		vfxErr = NvVFX_SetImage(handle, NVVFX_OUTPUT_IMAGE, output);
+	}
+
+	if (vfxErr == NVCV_SUCCESS)
+	{
+		vfxErr = NvVFX_Load(handle);
+	}
+
+	return vfxErr;
+}
+
+
+
+/*
+* Loads the tile pass effects with the current settings. A failure only disables tiled updates, full frames are still processed
+* 
+* param pass - the tile pass
+* param ar_mode - the mode of the AR pass, one of S_MODE_AR
+* param sr_mode - the mode of the SuperRes pass, one of S_MODE_SR
+* return - True if the tile pass is ready to run
+*/
+static bool load_tile_pass(struct nv_tile_pass *pass, int ar_mode, int sr_mode)
+{
+	NvCV_Status vfxErr = NVCV_SUCCESS;
+
+	if (pass->ar_handle)
 	{
-		debug("nv_destroy_fx_filter: destorying dst %X", *dst);
-		NvCVImage_Destroy(*dst);
-		*dst = NULL;
+		vfxErr = load_tile_fx(pass->ar_handle, ar_mode, pass->ar_src_img, pass->ar_dst_img);
 	}
 
-	if (fx && *fx)
+	if (vfxErr == NVCV_SUCCESS && pass->sr_handle)
 	{
-		debug("nv_destroy_fx_filter: destorying fx %X", *fx);
-		NvVFX_DestroyEffect(*fx);
-		*fx = NULL;
+		NvCVImage *input = pass->ar_handle ? pass->ar_dst_img : pass->sr_src_img;
+		vfxErr = load_tile_fx(pass->sr_handle, sr_mode, input, pass->sr_dst_img);
+	}
+
+	if (vfxErr != NVCV_SUCCESS)
+	{
+		info("Tiled updates disabled, failed to load the tile effects %i: %s", vfxErr, NvCV_GetErrorStringFromCode(vfxErr));
+		pass->enabled = false;
+		return false;
 	}
+
+	pass->loaded = true;
+	return true;
 }
 
 
 
 /*
-* The real destroy method, destroys and frees all memory we've allocated to the Fx filters and image buffers
-* param data - The OBS supplied data, should be a pointer to our filter struct
+* Finds the tiles of the source that changed since the frame held by an output slot
 * 
-* NOTE: For no particular reason, this function can be called multiple times
-*/ 
-static void nv_superres_filter_actual_destroy(void *data)
+* param filter - our OBS filter structure
+* param slot - the output slot the frame will be processed into
+* param tiles - receives up to NV_TILE_MAX tiles
+* return - the number of tiles to process, or -1 if the whole frame has to be processed
+*/
+static int plan_dirty_tiles(struct nv_superresolution_data *filter, struct nv_output_slot *slot, struct nv_tile *tiles)
 {
-	debug("nv_superres_filter_actual_destroy: entered");
+	struct nv_tile_pass *pass = &filter->live.tiles;
 
-	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)data;
+	if (!pass->enabled || !filter->fingerprint_valid || !slot->has_fingerprint)
+	{
+		return -1;
+	}
 
-	if (!nvvfx_loaded)
+	if (!pass->loaded && !load_tile_pass(pass, filter->ar_mode, filter->sr_mode))
 	{
-		bfree(filter);
-		return;
+		return -1;
 	}
 
-	os_atomic_set_bool(&filter->processing_stopped, true);
+	if (slot->tiled_frames >= NV_TILE_REFRESH_FRAMES)
+	{
+		return -1;
+	}
 
-	nv_destroy_fx_filter(&filter->ar_handle, &filter->gpu_ar_src_img, &filter->gpu_ar_dst_img);
-	nv_destroy_fx_filter(&filter->sr_handle, &filter->gpu_sr_src_img, &filter->gpu_sr_dst_img);
-	nv_destroy_fx_filter(NULL, &filter->src_img, &filter->dst_img);
-	nv_destroy_fx_filter(NULL, &filter->gpu_dst_tmp_img, &filter->gpu_staging_img);
+	bool changed[NV_FINGERPRINT_CELLS];
 
-	if (filter->stream)
+	if (nv_fingerprint_diff(&filter->fingerprint, &slot->fingerprint, changed) == 0)
 	{
-		NvVFX_CudaStreamDestroy(filter->stream);
-		filter->stream = NULL;
+		return 0;
 	}
 
-	obs_enter_graphics();
+	const uint32_t count = nv_tile_plan_dirty(&pass->layout, changed, tiles, NV_TILE_MAX);
+	const uint64_t tile_area = (uint64_t)count * pass->layout.tile_width * pass->layout.tile_height;
 
-	if (filter->scaled_texture)
+	/* Once the tiles cover half of the frame, with their overlap, a single full frame run is cheaper */
+	if (count > NV_TILE_MAX || tile_area * 2 > (uint64_t)filter->width * filter->height)
 	{
-		gs_texture_destroy(filter->scaled_texture);
-		filter->scaled_texture = NULL;
+		return -1;
 	}
-	if (filter->render)
+
+	/* The edge tiles of a source whose size isn't aligned would be off by a fraction of an output pixel from the rest of the frame */
+	for (uint32_t i = 0; i < count; ++i)
 	{
-		gs_texrender_destroy(filter->render);
-		filter->render = NULL;
+		if (!nv_tile_aligned(&tiles[i]))
+		{
+			return -1;
+		}
 	}
-	if (filter->render_unorm)
+
+	return (int)count;
+}
+
+
+
+/*
+* Lists every tile of the source, for oversized sources that can't be processed as a whole
+* 
+* param filter - our OBS filter structure
+* param tiles - receives the tiles, at most NV_TILE_MAX
+* return - the number of tiles, or -1 if the tile pass can't be run
+*/
+static int plan_all_tiles(struct nv_superresolution_data *filter, struct nv_tile *tiles)
+{
+	struct nv_tile_pass *pass = &filter->live.tiles;
+
+	if (!pass->enabled || (!pass->loaded && !load_tile_pass(pass, filter->ar_mode, filter->sr_mode)))
 	{
-		gs_texrender_destroy(filter->render_unorm);
-		filter->render_unorm = NULL;
+		error("The source is larger than the effects accept, and could not be split into tiles");
+		stop_processing(filter);
+		return -1;
 	}
 
-	if (filter->effect)
+	uint32_t count = 0;
+
+	for (uint32_t row = 0; row < pass->layout.rows; ++row)
 	{
-		gs_effect_destroy(filter->effect);
-		filter->effect = NULL;
+		for (uint32_t col = 0; col < pass->layout.cols && count < NV_TILE_MAX; ++col)
+		{
+			nv_tile_at(&pass->layout, col, row, &tiles[count++]);
+		}
 	}
 
-	obs_leave_graphics();
+	return (int)count;
+}
 
-	bfree(filter);
 
-	debug("nv_superres_filter_actual_destroy: exiting");
+
+/*
+* Runs the tile pass effects on whatever tile is currently in its source image
+* 
+* return - the status of the first effect to fail, or NVCV_SUCCESS
+*/
+static NvCV_Status run_tile_pass(struct nv_superresolution_data *filter)
+{
+	const int async = filter->async_run ? 1 : 0;
+	NvCV_Status vfxErr = NVCV_SUCCESS;
+
+	if (filter->live.tiles.ar_handle)
+	{
+		vfxErr = NvVFX_Run(filter->live.tiles.ar_handle, async);
+	}
+
+	if (vfxErr == NVCV_SUCCESS && filter->live.tiles.sr_handle)
+	{
+		vfxErr = NvVFX_Run(filter->live.tiles.sr_handle, async);
+	}
+
+	return vfxErr;
 }
 
 
 
 /*
-* OBS function to properly queue our filter to be destroyed through OBS's task queue
-* param data - should be a pointer to our OBS filter struct
+* Blends the output of a tile over what the output slot holds along the left and top bands of the region it's written to,
+* so the tile ramps in from its neighbors' output instead of meeting it at a hard seam. The blend is done in place in the tile output,
+* which is then copied into the slot as a whole. Feathering is turned off if NvCVImage_CompositeRect doesn't take our images
+* 
+* param filter - our OBS filter structure
+* param slot - the output slot the tile is written to, mapped
+* param output - the BGR planar output of the tile pass
+* param blend_view - the single channel view of the tile pass's blend_img
+* param src - the region of the tile output written back, see nv_tile_blend_rects
+* param dst - the region of the slot it's written to
+* param ramp_left - width of the band blended along the left of the region, or 0
+* param ramp_top - height of the band blended along the top of the region, or 0
+* return - the status of the transfers, a rejected blend is not an error
 */
-static void nv_superres_filter_destroy(void *data)
+static NvCV_Status blend_tile_output(struct nv_superresolution_data *filter, struct nv_output_slot *slot, NvCVImage *output,
+				     NvCVImage *blend_view, const struct nv_rect *src, const struct nv_rect *dst, uint32_t ramp_left,
+				     uint32_t ramp_top)
 {
-	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)data;
-	if (!filter->destroying)
+	struct nv_tile_pass *pass = &filter->live.tiles;
+	NvCV_Status vfxErr = NVCV_SUCCESS;
+
+	/* What the slot holds under the region, at the same place the tile output has it */
+	for (uint32_t plane = 0; plane < NV_PLANAR_PLANES && vfxErr == NVCV_SUCCESS; ++plane)
 	{
-		filter->destroying = true;
-		obs_queue_task(OBS_TASK_GRAPHICS, nv_superres_filter_actual_destroy, data, false);
+		const NvCVRect2i rect = {
+			(int)dst->x, (int)(dst->y + plane * filter->live.out_height),
+			(int)dst->width, (int)dst->height
+		};
+		const NvCVPoint2i point = {(int)src->x, (int)(src->y + plane * pass->out_height)};
+
+		vfxErr = NvCVImage_TransferRect(slot->dst_img, &rect, blend_view, &point, 1.0f, filter->stream, NULL);
+	}
+
+	const NvCVPoint2i origin = {(int)src->x, (int)src->y};
+	NvCVImage matte;
+
+	/* The top band is blended over the left one, the corner ends up weighted by both ramps */
+	if (vfxErr == NVCV_SUCCESS && ramp_left)
+	{
+		NvCVImage_InitView(&matte, pass->ramp_x_img, 0, 0, ramp_left < pass->ramp ? ramp_left : pass->ramp, src->height);
+		vfxErr = NvCVImage_CompositeRect(output, &origin, pass->blend_img, &origin, &matte, 0, output, &origin, filter->stream);
+	}
+
+	if (vfxErr == NVCV_SUCCESS && ramp_top)
+	{
+		NvCVImage_InitView(&matte, pass->ramp_y_img, 0, 0, src->width, ramp_top < pass->ramp ? ramp_top : pass->ramp);
+		vfxErr = NvCVImage_CompositeRect(output, &origin, pass->blend_img, &origin, &matte, 0, output, &origin, filter->stream);
+	}
+
+	if (vfxErr == NVCV_ERR_PIXELFORMAT || vfxErr == NVCV_ERR_MISMATCH)
+	{
+		info("Couldn't blend the seams between tiles (%s), they're cut at the edge of each tile instead", NvCV_GetErrorStringFromCode(vfxErr));
+
+		pass->feather = false;
+		vfxErr = NVCV_SUCCESS;
 	}
+
+	return vfxErr;
 }
 
 
 
-/* Macro shenanigans to deal with variadic arguments to the error */
-#define kill_on_error(cnd, msg, filter, ...) {	\
-	if (!cnd) \
-	{\
-		obs_log(LOG_ERROR, msg, ##__VA_ARGS__);	\
-		os_atomic_set_bool(&filter->processing_stopped, true); \
-		return false;	\
-	}\
+/*
+* Runs the tile pass on the given tiles of the source, compositing the core of each into the output slot.
+* The slot must hold the processed output of an earlier frame, everything outside of the tiles is left as it is.
+* Both the source and the output are BGR f32 planar stacked into a single channel, so every tile is copied plane by plane
+* 
+* param filter - our OBS filter structure
+* param slot - the output slot to composite into
+* param tiles - the tiles to process
+* param count - the number of tiles
+* return - False if there was an error. True otherwise.
+*/
+static bool process_dirty_tiles(struct nv_superresolution_data *filter, struct nv_output_slot *slot, const struct nv_tile *tiles,
+				uint32_t count)
+{
+	struct nv_tile_pass *pass = &filter->live.tiles;
+	const struct nv_tile_layout *layout = &pass->layout;
+	NvCVImage *output = pass->sr_handle ? pass->sr_dst_img : pass->ar_dst_img;
+	NvCVImage input_view;
+	NvCVImage output_view;
+	NvCVImage blend_view;
+
+	kill_on_error(init_planar_view(&input_view, pass->ar_handle ? pass->ar_src_img : pass->sr_src_img),
+		      "Error creating planar view of the tile input", filter);
+	kill_on_error(init_planar_view(&output_view, output), "Error creating planar view of the tile output", filter);
+	kill_on_error(!pass->feather || init_planar_view(&blend_view, pass->blend_img), "Error creating planar view of the tile blend buffer",
+		      filter);
+
+	NvCV_Status vfxErr = NvCVImage_MapResource(filter->src_img, filter->stream);
+	nv_error(vfxErr, "Error mapping resource for source texture", filter, false);
+
+	vfxErr = NvCVImage_MapResource(slot->dst_img, filter->stream);
+	nv_error(vfxErr, "Error mapping resource for dst texture", filter, false);
+
+	for (uint32_t i = 0; i < count && vfxErr == NVCV_SUCCESS; ++i)
+	{
+		const struct nv_tile *tile = &tiles[i];
+		struct nv_rect src, dst;
+		uint32_t ramp_left = 0;
+		uint32_t ramp_top = 0;
+
+		/* Without feathering only the core is copied, cut at the boundary */
+		if (pass->feather)
+		{
+			nv_tile_blend_rects(layout, tile, filter->live.out_width, filter->live.out_height, pass->out_width, pass->out_height, &src, &dst,
+					    &ramp_left, &ramp_top);
+		}
+		else
+		{
+			nv_tile_composite_rects(layout, tile, filter->live.out_width, filter->live.out_height, pass->out_width, pass->out_height, &src, &dst);
+		}
+
+		for (uint32_t plane = 0; plane < NV_PLANAR_PLANES && vfxErr == NVCV_SUCCESS; ++plane)
+		{
+			const NvCVRect2i rect = {
+				(int)tile->input.x, (int)(tile->input.y + plane * filter->height),
+				(int)tile->input.width, (int)tile->input.height
+			};
+			const NvCVPoint2i point = {0, (int)(plane * layout->tile_height)};
+
+			vfxErr = NvCVImage_TransferRect(filter->src_img, &rect, &input_view, &point, 1.0f, filter->stream, NULL);
+		}
+
+		if (vfxErr == NVCV_SUCCESS)
+		{
+			vfxErr = run_tile_pass(filter);
+		}
+
+		if (vfxErr == NVCV_SUCCESS && (ramp_left || ramp_top))
+		{
+			vfxErr = blend_tile_output(filter, slot, output, &blend_view, &src, &dst, ramp_left, ramp_top);
+		}
+
+		for (uint32_t plane = 0; plane < NV_PLANAR_PLANES && vfxErr == NVCV_SUCCESS; ++plane)
+		{
+			const NvCVRect2i rect = {
+				(int)src.x, (int)(src.y + plane * pass->out_height),
+				(int)src.width, (int)src.height
+			};
+			const NvCVPoint2i point = {(int)dst.x, (int)(dst.y + plane * filter->live.out_height)};
+
+			vfxErr = NvCVImage_TransferRect(&output_view, &rect, slot->dst_img, &point, 1.0f, filter->stream, NULL);
+		}
+	}
+
+	/* Unmap before handling any error, a reset recreates the stream the resources are mapped on */
+	NvCVImage_UnmapResource(slot->dst_img, filter->stream);
+	NvCVImage_UnmapResource(filter->src_img, filter->stream);
+
+	if (vfxErr == NVCV_ERR_CUDA)
+	{
+		nv_superres_filter_reset(filter, NULL);
+		return false;
+	}
+
+	nv_error(vfxErr, "Error processing the changed tiles", filter, false);
+
+	return true;
 }
 
-/* Check the value of vfxErr, if it's anything other than NVCV_SUCCESS this macro will
-* log the error, set the processing_stopped flag on filter, and return false from whatever function it's in
+
+
+/*
+* Runs the passes of the pipeline that come before the SuperRes or Upscaling pass, steps 1 and 2 in process_texture_superres
+* 
+* param filter - our OBS filter structure
+* return - False if there was an error. True otherwise.
 */
-#define nv_error(vfxErr, msg, filter, destroy_filter, ...) {	\
-	if (NVCV_SUCCESS != vfxErr)\
-	{\
-		filter = (struct nv_superresolution_data*)filter;			\
-		const char *errString = NvCV_GetErrorStringFromCode(vfxErr);\
-		obs_log(LOG_ERROR, msg, ##__VA_ARGS__);						\
-		obs_log(LOG_ERROR, "NvVFX Error %i: %s", vfxErr, errString);\
-		if (destroy_filter) {nv_superres_filter_destroy(filter);}	\
-		else {os_atomic_set_bool(&filter->processing_stopped, true);}\
-		return false;\
-	}\
+static bool run_first_passes(struct nv_superresolution_data *filter)
+{
+	NvCVImage *destination = filter->live.ar_handle ? filter->live.gpu_ar_src_img : filter->live.gpu_sr_src_img;
+	NvCVImage planar_view;
+	NvCVImage *staging = filter->live.gpu_staging_img;
+
+	if (uses_planar_input(filter))
+	{
+		kill_on_error(init_planar_view(&planar_view, destination), "Error creating planar view of the first filter pass input", filter);
+		destination = &planar_view;
+		staging = NULL;
+	}
+
+	NvCV_Status vfxErr;
+
+	/* An ingested async frame is already in the input, converted straight from its planes */
+	if (filter->ingested_img == (filter->live.ar_handle ? filter->live.gpu_ar_src_img : filter->live.gpu_sr_src_img))
+	{
+		filter->ingested_img = NULL;
+	}
+	else
+	{
+		/* Have to map the D3D buffers before your manipulate them, and unmap before D3D is allowed to take over again */
+		vfxErr = NvCVImage_MapResource(filter->src_img, filter->stream);
+		nv_error(vfxErr, "Error mapping resource for source texture", filter, false);
+
+		vfxErr = NvCVImage_Transfer(filter->src_img, destination, 1.0f, filter->stream, staging);
+		nv_error(vfxErr, "Error converting src img for first filter pass", filter, false);
+
+		vfxErr = NvCVImage_UnmapResource(filter->src_img, filter->stream);
+		nv_error(vfxErr, "Error unmapping resource for src texture", filter, false);
+	}
+
+	/* 2. process artifact reduction fx pass, and transfer to the upscaling pass */
+	if (filter->live.ar_handle)
+	{
+		if (!bind_fx(filter, filter->live.ar_fx, filter->live.gpu_ar_src_img, filter->live.gpu_ar_dst_img))
+		{
+			return false;
+		}
+
+		vfxErr = NvVFX_Run(filter->live.ar_handle, filter->async_run ? 1 : 0);
+		mark_fx_run(filter, filter->live.ar_fx);
+
+		if (vfxErr == NVCV_ERR_CUDA)
+		{
+			nv_superres_filter_reset(filter, NULL);
+			return false;
+		}
+
+		nv_error(vfxErr, "Error running the AR FX", filter, false);
+
+		/* SuperRes reads gpu_ar_dst_img directly, only the Upscaling filter needs it converted to RGBA */
+		if (filter->live.sr_handle && !sr_reads_ar_output(filter))
+		{
+			vfxErr = NvCVImage_Transfer(filter->live.gpu_ar_dst_img, filter->live.gpu_sr_src_img, 255.0f, filter->stream, filter->live.gpu_staging_img);
+			nv_error(vfxErr, "Error converting AR output to RGBA img for the Upscaling pass", filter, false);
+		}
+	}
+
+	return true;
 }
 
-/* no return variation of the above macro */
-#define nv_error_nr(vfxErr, msg, filter, destroy_filter, ...)\
-{															\
-	if (NVCV_SUCCESS != vfxErr) {                           \
-		filter = (struct nv_superresolution_data *)filter;	\
-		const char *errString =                             \
-			NvCV_GetErrorStringFromCode(vfxErr);			\
-		obs_log(LOG_ERROR, msg, ##__VA_ARGS__);             \
-		obs_log(LOG_ERROR, "NvVFX Error %i: %s", vfxErr,    \
-			errString);										\
-		if (destroy_filter) {                               \
-			nv_superres_filter_destroy(filter);				\
-		} else {                                            \
-			os_atomic_set_bool(								\
-				&filter->processing_stopped, true);			\
-		}                                                   \
-	}                                                       \
+
+
+/*
+* Moves the output of the last pass of the pipeline into an output slot, step 4 in process_texture_superres
+* 
+* param filter - our OBS filter structure
+* param slot_index - the output slot to move the output into
+* return - False if there was an error. True otherwise.
+*/
+static bool transfer_output(struct nv_superresolution_data *filter, uint32_t slot_index)
+{
+	struct nv_output_slot *slot = &filter->live.outputs[slot_index];
+	NvCVImage planar_view;
+
+	/*
+	* 4. Move the output of the last pass into the texture bound to dst_img
+	* BGR f32 planar output is copied as is into planar_texture, and converted to RGBA by the ResolvePlanar pass.
+	* GPU->CUDA_ARRAY transfers of BGR/Planar to a D3D11 RGBA texture are not supported by NvCVImage_Transfer
+	*/
+	NvCVImage *output = filter->live.sr_handle ? filter->live.gpu_sr_dst_img : filter->live.gpu_ar_dst_img;
+	const bool planar = uses_planar_output(filter);
+	NvCVImage *staging = filter->live.gpu_staging_img;
+
+	if (planar)
+	{
+		kill_on_error(init_planar_view(&planar_view, output), "Error creating planar view of the last filter pass output", filter);
+		output = &planar_view;
+		staging = NULL;
+	}
+
+	/* Have to map the D3D buffers before your manipulate them, and unmap before D3D is allowed to take over again */
+	NvCV_Status vfxErr = NvCVImage_MapResource(slot->dst_img, filter->stream);
+	nv_error(vfxErr, "Error mapping resource for dst texture", filter, false);
+
+	vfxErr = NvCVImage_Transfer(output, slot->dst_img, 1.0f, filter->stream, staging);
+	nv_error(vfxErr, "Error transfering the processed image to the destination texture", filter, false);
+
+	vfxErr = NvCVImage_UnmapResource(slot->dst_img, filter->stream);
+	nv_error(vfxErr, "Error unmapping resource for dst texture", filter, false);
+
+	complete_output_slot(filter, slot_index, planar);
+
+	return true;
+}
+
+
+
+/*
+* Called once the batch a frame of ours was submitted to has run, the batch has already made our stream wait on its output
+* 
+* param user - our OBS filter structure
+* param success - false if the batch failed to run
+*/
+static void batch_complete(void *user, bool success)
+{
+	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)user;
+
+	if (!success)
+	{
+		error("Failed to run the batched SuperRes pass, processing the source on its own");
+
+		filter->batch_failed = true;
+		filter->fingerprint_valid = false;
+		return;
+	}
+
+	if (!transfer_output(filter, filter->batch_slot))
+	{
+		filter->fingerprint_valid = false;
+	}
 }
 
 
 
 /*
-* initializes the Fx Handle with the given FX selector, and optionally set the model directory parameter for the given FX
-* note: if the FX handle is initialized and exists, it will be destroyed and re-initizliaed
+* Submits the input of our SuperRes or Upscaling pass to our batch, instead of running our own effect on it
 * 
-* filter - Our OBS filter structure
-* handle - the fx handle to initialize
-* fx - the fx type to initialize, these are NV filter constants, prefixed with NVVFX_FX_
+* param filter - our OBS filter structure
+* param slot_index - the output slot the frame goes to
+* return - True if the frame was submitted, False if the filter has to run its own effect
 */
-static bool create_nvfx(struct nv_superresolution_data *filter, NvVFX_Handle *handle, NvVFX_EffectSelector fx)
+static bool submit_to_batch(struct nv_superresolution_data *filter, uint32_t slot_index)
 {
-	if (*handle)
+	CUresult cuErr = CUDA_SUCCESS;
+
+	if (!filter->batch_staged)
 	{
-		NvVFX_DestroyEffect(*handle);
+		cuErr = cuEventCreate(&filter->batch_staged, CU_EVENT_DISABLE_TIMING);
 	}
 
-	NvCV_Status vfxErr = NvVFX_CreateEffect(fx, handle);
-	nv_error(vfxErr, "Error creating nVidia RTX Upscaling FX", filter, true);
-
-	bool set_model_dir =
-		(strncmp(fx, NVVFX_FX_ARTIFACT_REDUCTION, sizeof(NVVFX_FX_ARTIFACT_REDUCTION) / sizeof(char)) ==0) ||
-		(strncmp(fx, NVVFX_FX_SUPER_RES, sizeof(NVVFX_FX_SUPER_RES) / sizeof(char)) == 0);
+	/* The batch runs on a stream of its own, it waits on this before reading our input */
+	if (cuErr == CUDA_SUCCESS)
+	{
+		cuErr = cuEventRecord(filter->batch_staged, filter->stream);
+	}
 
-	if (set_model_dir)
+	if (cuErr != CUDA_SUCCESS)
 	{
-		char model_dir[MAX_PATH];
-		get_nvfx_sdk_path(model_dir, MAX_PATH);
+		info("CUDA events unavailable (%i), processing the source without batching", cuErr);
 
-		vfxErr = NvVFX_SetString(*handle, NVVFX_MODEL_DIRECTORY, model_dir);
-		nv_error(vfxErr, "Error seting Super Resolution model directory: [%s]", filter, true, model_dir);
+		filter->batch_failed = true;
+		return false;
 	}
 
-	vfxErr = NvVFX_SetCudaStream(*handle, NVVFX_CUDA_STREAM, filter->stream);
-	nv_error(vfxErr, "Error seting Super Resolution CUDA stream", filter, true);
+	const struct nv_batch_io io =
+	{
+		.input = sr_reads_ar_output(filter) ? filter->live.gpu_ar_dst_img : filter->live.gpu_sr_src_img,
+		.output = filter->live.gpu_sr_dst_img,
+		.user = filter
+	};
+
+	filter->batch_slot = slot_index;
 
-	return true;
+	return nv_batch_submit(filter->batch_member, &io, obs_get_video_frame_time());
 }
 
 
 
-/* Loads the AR NVFX filter effect. Ensures any necessary parameters have been set.
-* 
-* returns: False if there is any error, true otherwise
-*/
-static bool load_ar_fx(struct nv_superresolution_data *filter)
+/* A batch of the NvVFX batching backend, an effect loaded with NVVFX_MODEL_BATCH that runs the frames of several filters at once */
+struct nv_batch_fx
 {
-	debug("load_ar_fx: entering");
-
-	NvCV_Status vfxErr = NvVFX_SetU32(filter->ar_handle, NVVFX_MODE, filter->ar_mode);
-	nv_error_nr(vfxErr, "Failed to set AR mode", filter, false);
-
-	vfxErr = NvVFX_SetImage(filter->ar_handle, NVVFX_INPUT_IMAGE, filter->gpu_ar_src_img);
-	nv_error(vfxErr, "Failed to set input image for Artifact Reduction filter", filter, false);
-
-	vfxErr = NvVFX_SetImage(filter->ar_handle, NVVFX_OUTPUT_IMAGE, filter->gpu_ar_dst_img);
-	nv_error(vfxErr, "Failed to set output image for Artifact Reduction filter", filter, false);
+	NvVFX_Handle handle;
+	CUstream stream;
+	CUevent done; // recorded once the outputs have been copied out of dst_img, the streams of the members wait on it
+	NvCVImage *src_img; // the inputs of up to capacity frames stacked one after the other, viewed as single channel when planar
+	NvCVImage *dst_img; // the outputs, stacked the same way
+	bool planar; // BGR f32 or f16 planar frames for SuperRes, otherwise RGBA U8 chunky for Upscaling
+	uint32_t width;
+	uint32_t height;
+	uint32_t out_width;
+	uint32_t out_height;
+};
 
-	vfxErr = NvVFX_Load(filter->ar_handle);
 
-	bool success = NVCV_SUCCESS == vfxErr;
 
-	if (!success)
+/* Logs a failed NvVFX call of the batching backend, which isn't tied to a single filter
+* return - True if vfxErr is NVCV_SUCCESS
+*/
+static bool batch_fx_ok(NvCV_Status vfxErr, const char *msg)
+{
+	if (vfxErr != NVCV_SUCCESS)
 	{
-		if (NVCV_ERR_RESOLUTION != vfxErr)
-		{
-			const char *errString = NvCV_GetErrorStringFromCode(vfxErr);
-			error("Failed to load NvVFX AR effect %i: %s", vfxErr, errString);
-			os_atomic_set_bool(&filter->processing_stopped, true);
-		}
+		error("%s %i: %s", msg, vfxErr, NvCV_GetErrorStringFromCode(vfxErr));
+		return false;
 	}
-	filter->invalid_ar_size = !success;
-	filter->reload_ar_fx = false;
 
-	debug("load_ar_fx: exiting");
-	return success;
+	return true;
 }
 
 
-/* Loads the SR NVFX filter effect. Ensures any necessary parameters have been set.
+
+/*
+* Initializes an image header that views one of the frames stacked in a batch buffer.
+* Batched images are laid out one whole image after another, so a BGR f32 planar frame is its three planes in a row
 * 
-* returns: False if there is any error, true otherwise
+* param view - the image header to initialize, it does not own any memory
+* param stack - the batch buffer
+* param planar - true for BGR f32 planar frames, false for RGBA U8 chunky
+* param width, height - size of a single frame
+* param index - the frame to view
+* return - True if there is no error, False otherwise
 */
-static bool load_sr_fx(struct nv_superresolution_data *filter)
+static bool init_batch_view(NvCVImage *view, NvCVImage *stack, bool planar, uint32_t width, uint32_t height, uint32_t index)
 {
-	debug("load_sr_fx: entering");
+	const uint32_t rows = planar ? height * NV_PLANAR_PLANES : height;
+	void *pixels = (uint8_t *)stack->pixels + (size_t)index * rows * stack->pitch;
 	NvCV_Status vfxErr;
 
-	if (filter->type == S_TYPE_UP)
+	if (planar)
 	{
-		vfxErr = NvVFX_SetF32(filter->sr_handle, NVVFX_STRENGTH, filter->strength);
-		nv_error_nr(vfxErr, "Failed to set upscaling sharpening strength", filter, false);
+		vfxErr = NvCVImage_Init(view, width, height, stack->pitch, pixels, NVCV_BGR, stack->componentType, NVCV_PLANAR, NVCV_GPU);
 	}
-	else if (filter->type == S_TYPE_SR)
+	else
 	{
-		vfxErr = NvVFX_SetU32(filter->sr_handle, NVVFX_MODE, filter->sr_mode);
-		nv_error_nr(vfxErr, "Failed to set SR mode", filter, false);
+		vfxErr = NvCVImage_Init(view, width, height, stack->pitch, pixels, NVCV_RGBA, NVCV_U8, NVCV_CHUNKY, NVCV_GPU);
 	}
 
-	vfxErr = NvVFX_SetImage(filter->sr_handle, NVVFX_INPUT_IMAGE, filter->gpu_sr_src_img);
-	nv_error(vfxErr, "Error setting SuperRes input image", filter, false);
+	return vfxErr == NVCV_SUCCESS;
+}
 
-	vfxErr = NvVFX_SetImage(filter->sr_handle, NVVFX_OUTPUT_IMAGE, filter->gpu_sr_dst_img);
-	nv_error(vfxErr, "Error setting SuperRes output image", filter, false);
 
-	vfxErr = NvVFX_Load(filter->sr_handle);
 
-	bool success = NVCV_SUCCESS == vfxErr;
+static void batch_fx_destroy(void *context, void *data)
+{
+	struct nv_batch_fx *batch = (struct nv_batch_fx *)data;
 
-	if (!success)
+	if (batch->handle)
 	{
-		if (NVCV_ERR_RESOLUTION != vfxErr)
-		{
-			const char *errString = NvCV_GetErrorStringFromCode(vfxErr);
-			error("Failed to load NvVFX SR effect %i: %s", vfxErr, errString);
-			os_atomic_set_bool(&filter->processing_stopped, true);
-		}
+		NvVFX_DestroyEffect(batch->handle);
+	}
+
+	if (batch->src_img)
+	{
+		NvCVImage_Destroy(batch->src_img);
 	}
 
-	filter->invalid_sr_size = !success;
+	if (batch->dst_img)
+	{
+		NvCVImage_Destroy(batch->dst_img);
+	}
 
-	filter->reload_sr_fx = false;
+	if (batch->done)
+	{
+		cuEventDestroy(batch->done);
+	}
 
-	debug("load_sr_fx: exiting");
-	return success;
+	if (batch->stream)
+	{
+		NvVFX_CudaStreamDestroy(batch->stream);
+	}
+
+	bfree(batch);
 }
 
 
 
-/* Creates a new CUDA stream for the filter, desytroying the previous one if it exists.
-* returns: False if there is an error, true otherwise
+/*
+* Creates and loads the effect of a batch, see struct nv_batch_backend
+* Stacked buffers are allocated as a single image tall enough for capacity frames, as single channel f32 when the frames are planar
 */
-static bool create_cuda(struct nv_superresolution_data *filter)
+static void *batch_fx_create(void *context, const struct nv_batch_key *key, uint32_t capacity)
 {
-	debug("create_cuda: entering");
+	struct nv_batch_fx *batch = (struct nv_batch_fx *)bzalloc(sizeof(*batch));
+	batch->planar = strcmp(key->effect, NVVFX_FX_SUPER_RES) == 0;
+	batch->width = key->width;
+	batch->height = key->height;
+	batch->out_width = key->out_width;
+	batch->out_height = key->out_height;
+
+	const uint32_t planes = batch->planar ? NV_PLANAR_PLANES : 1;
+	const NvCVImage_PixelFormat format = batch->planar ? NVCV_Y : NVCV_RGBA;
+	const NvCVImage_ComponentType type = batch->planar ? ((key->variant & NV_BATCH_VARIANT_F16) ? NVCV_F16 : NVCV_F32) : NVCV_U8;
+	const unsigned alignment = batch->planar ? 1 : 32;
+
+	char model_dir[MAX_PATH];
+	get_nvfx_sdk_path(model_dir, MAX_PATH);
+
+	NvCVImage src_view;
+	NvCVImage dst_view;
+
+	bool success =
+		batch_fx_ok(NvVFX_CreateEffect(key->effect, &batch->handle), "Error creating batched NvVFX effect") &&
+		batch_fx_ok(NvVFX_SetString(batch->handle, NVVFX_MODEL_DIRECTORY, model_dir), "Error setting batched model directory") &&
+		batch_fx_ok(NvVFX_CudaStreamCreate(&batch->stream), "Error creating batch CUDA stream") &&
+		batch_fx_ok(NvVFX_SetCudaStream(batch->handle, NVVFX_CUDA_STREAM, batch->stream), "Error setting batch CUDA stream") &&
+		batch_fx_ok(NvCVImage_Create(key->width, key->height * planes * capacity, format, type, NVCV_CHUNKY, NVCV_GPU, alignment,
+					     &batch->src_img), "Error creating batch source buffer") &&
+		batch_fx_ok(NvCVImage_Create(key->out_width, key->out_height * planes * capacity, format, type, NVCV_CHUNKY, NVCV_GPU,
+					     alignment, &batch->dst_img), "Error creating batch destination buffer") &&
+		init_batch_view(&src_view, batch->src_img, batch->planar, key->width, key->height, 0) &&
+		init_batch_view(&dst_view, batch->dst_img, batch->planar, key->out_width, key->out_height, 0) &&
+		batch_fx_ok(NvVFX_SetImage(batch->handle, NVVFX_INPUT_IMAGE, &src_view), "Error setting batch input image") &&
+		batch_fx_ok(NvVFX_SetImage(batch->handle, NVVFX_OUTPUT_IMAGE, &dst_view), "Error setting batch output image") &&
+		batch_fx_ok(NvVFX_SetU32(batch->handle, NVVFX_MODEL_BATCH, capacity), "Error setting the batched model size");
+
+	if (success && batch->planar)
+	{
+		success = batch_fx_ok(NvVFX_SetU32(batch->handle, NVVFX_MODE, key->mode), "Error setting batched SR mode");
+	}
+	else if (success)
+	{
+		success = batch_fx_ok(NvVFX_SetF32(batch->handle, NVVFX_STRENGTH, key->strength), "Error setting batched upscaling strength");
+	}
 
-	if (filter->stream)
+	success = success && batch_fx_ok(NvVFX_Load(batch->handle), "Error loading batched NvVFX effect") &&
+		  cuEventCreate(&batch->done, CU_EVENT_DISABLE_TIMING) == CUDA_SUCCESS;
+
+	if (!success)
 	{
-		NvVFX_CudaStreamDestroy(filter->stream);
-		filter->stream = NULL;
+		batch_fx_destroy(context, batch);
+		return NULL;
 	}
 
-	NvCV_Status vfxErr = NvVFX_CudaStreamCreate(&filter->stream);
-	nv_error(vfxErr, "Failed to create NvVFX CUDA Stream: %i", filter, true);
+	info("Batching %s for up to %u sources of %ux%u", key->effect, capacity, key->width, key->height);
 
-	debug("create_cuda: exiting");
-	return true;
+	return batch;
 }
 
 
 
-/* Creates the NvFX filters that are needed
-* This has the side consequence of requiring NvCVImage buffers to be created or reallocated
-* return - True if there are no errors or if nothing was created. False if there was an error.
+/*
+* Runs the frames of several filters through a batch, see struct nv_batch_backend
+* The batch stream waits on each filter's batch_staged before copying its input in, and each filter's stream waits on done
+* before using its output, so none of the streams involved are ever blocked on by the render thread
 */
-static bool initialize_fx(struct nv_superresolution_data *filter)
+static bool batch_fx_run(void *context, void *data, const struct nv_batch_io *items, uint32_t count)
 {
-	bool success = true;
+	struct nv_batch_fx *batch = (struct nv_batch_fx *)data;
+	NvCVImage view;
 
-	if (success && filter->apply_ar && !filter->ar_handle)
+	for (uint32_t i = 0; i < count; ++i)
 	{
-		debug("initialize_fx: creating AR fx");
-		success = create_nvfx(filter, &filter->ar_handle, NVVFX_FX_ARTIFACT_REDUCTION);
-		filter->are_images_allocated = false;
+		struct nv_superresolution_data *filter = (struct nv_superresolution_data *)items[i].user;
+
+		if (cuStreamWaitEvent(batch->stream, filter->batch_staged, 0) != CUDA_SUCCESS ||
+		    !init_batch_view(&view, batch->src_img, batch->planar, batch->width, batch->height, i) ||
+		    !batch_fx_ok(NvCVImage_Transfer((NvCVImage *)items[i].input, &view, 1.0f, batch->stream, NULL),
+				 "Error copying a frame into the batch"))
+		{
+			return false;
+		}
 	}
 
-	if (success && filter->type != S_TYPE_NONE && !filter->sr_handle)
+	if (!batch_fx_ok(NvVFX_SetU32(batch->handle, NVVFX_BATCH_SIZE, count), "Error setting the batch size") ||
+	    !batch_fx_ok(NvVFX_Run(batch->handle, 1), "Error running the batch"))
 	{
-		debug("initialize_fx: creating SR fx");
-		const char *FX = filter->type == S_TYPE_SR ? NVVFX_FX_SUPER_RES : NVVFX_FX_SR_UPSCALE;
-		success = create_nvfx(filter, &filter->sr_handle, FX);
-		filter->are_images_allocated = false;
+		return false;
 	}
 
-	return success;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (!init_batch_view(&view, batch->dst_img, batch->planar, batch->out_width, batch->out_height, i) ||
+		    !batch_fx_ok(NvCVImage_Transfer(&view, (NvCVImage *)items[i].output, 1.0f, batch->stream, NULL),
+				 "Error copying a frame out of the batch"))
+		{
+			return false;
+		}
+	}
+
+	if (cuEventRecord(batch->done, batch->stream) != CUDA_SUCCESS)
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		struct nv_superresolution_data *filter = (struct nv_superresolution_data *)items[i].user;
+
+		if (cuStreamWaitEvent(filter->stream, batch->done, 0) != CUDA_SUCCESS)
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
 
 
-/* Called when the user changes any property in our OBS property window
-* Applies user settings changes to the filter, setting any necessary update/creation flags to be properly handled later.
+/*
+* Fills in the batching key of the filter's SuperRes or Upscaling pass
+* 
+* param filter - our OBS filter structure
+* param key - receives the key
+* return - False if the filter can't batch its current configuration, the tile pass and oversized sources are never batched
 */
-static void nv_superres_filter_update(void *data, obs_data_t *settings)
+static bool get_batch_key(struct nv_superresolution_data *filter, struct nv_batch_key *key)
 {
-	struct nv_superresolution_data *filter =(struct nv_superresolution_data *)data;
+	if (!filter->live.sr_handle || filter->type == S_TYPE_NONE || filter->oversized || filter->tiled_updates || filter->invalid_sr_size)
+	{
+		return false;
+	}
 
-	int type = (int)obs_data_get_int(settings, S_TYPE);
-	int sr_mode = (int)obs_data_get_int(settings, S_MODE_SR);
-	bool apply_ar = obs_data_get_bool(settings, S_ENABLE_AR);
-	filter->scale = (int)obs_data_get_int(settings, S_SR_SCALE);
+	key->effect = filter->type == S_TYPE_SR ? NVVFX_FX_SUPER_RES : NVVFX_FX_SR_UPSCALE;
+	key->mode = filter->type == S_TYPE_SR ? (uint32_t)filter->sr_mode : 0;
+	key->strength = filter->type == S_TYPE_UP ? filter->batch_strength : 0.0f;
+	key->variant = sr_reads_ar_output(filter) ? NV_BATCH_VARIANT_AR : 0;
+	key->variant |= filter->live.planar_comp == NVCV_F16 ? NV_BATCH_VARIANT_F16 : 0;
+	key->width = filter->width;
+	key->height = filter->height;
+	key->out_width = filter->live.out_width;
+	key->out_height = filter->live.out_height;
+
+	return true;
+}
+
+
+
+/*
+* Joins or leaves the batch group matching the filter's current configuration. Must be called within the graphics context
+* 
+* param filter - our OBS filter structure
+*/
+static void update_batch_member(struct nv_superresolution_data *filter)
+{
+	struct nv_batch_key key;
+	const bool eligible = filter->batch && !filter->batch_failed && get_batch_key(filter, &key);
 
-	if (filter->type != type)
+	if (filter->batch_member && (!eligible || !nv_batch_member_matches(filter->batch_member, &key)))
 	{
-		filter->type = type;
-		filter->destroy_sr = true;
-		filter->reload_sr_fx = true;
-		debug("Update: Filter type changed");
+		nv_batch_leave(filter->batch_member);
+		filter->batch_member = NULL;
 	}
 
-	if (filter->type == S_TYPE_SR)
+	if (!eligible || filter->batch_member)
 	{
-		filter->scale = (int)obs_data_get_int(settings, S_SR_SCALE);
+		return;
 	}
 
-	if (filter->sr_mode != sr_mode)
+	if (!batch_service)
 	{
-		filter->sr_mode = sr_mode;
-		filter->reload_sr_fx = true;
-		debug("Update: Super Res mode changed");
+		const struct nv_batch_backend backend =
+		{
+			.create = batch_fx_create,
+			.run = batch_fx_run,
+			.destroy = batch_fx_destroy,
+			.context = NULL
+		};
+
+		batch_service = nv_batch_service_create(&backend);
 	}
 
-	if (filter->apply_ar != apply_ar)
+	if (batch_service)
 	{
-		filter->apply_ar = apply_ar;
-		debug("Update: AR changed");
+		filter->batch_member = nv_batch_join(batch_service, &key, batch_complete);
+	}
+}
 
-		if (!apply_ar)
+
+
+/*
+* Runs the NVFX filter pipeline on the current source frame.
+* The final destination NVFX buffer in fitler will be updated with the output from this pipeline
+* 
+* param filter - our OBS filter structure
+* return - False if there was an error. True otherwise.
+*/
+static bool process_texture_superres(struct nv_superresolution_data *filter)
+{
+	/* From nVidias recommendations here https://docs.nvidia.com/deeplearning/maxine/vfx-sdk-programming-guide/index.html#upscale-filter
+	* We have 3 main paths to take
+	* A. AR pass only
+	* B. Upscaling Pass Only
+	* C. AR Pass -> Upscaling Pass
+	* So the effect pipeline is
+	*	A: src_img -> AR_src -> Run FX -> AR_dst -> dst_img -> ResolvePlanar -> scaled_texture
+	*	B: src_img -> (staging) -> SR_src -> Run FX -> SR_dst -> (staging) -> dst_img (-> ResolvePlanar -> scaled_texture)
+	*	C: src_img -> AR_src -> Run FX -> AR_dst (-> SR_src) -> Run FX -> SR_dst -> (staging) -> dst_img (-> ResolvePlanar -> scaled_texture)
+	* 
+	* With asynchronous processing the effects are queued on our CUDA stream without blocking the render thread. Unmapping dst_img
+	* orders the D3D reads of the slot after them, so the graphics thread never waits on our stream when the slot is drawn the same frame.
+	* With pipelining, the output goes to the next slot of the output ring so the slot finished last frame can be drawn meanwhile,
+	* a completion event is recorded after the final transfer and waited on by finish_output_slot if it isn't done when it's drawn.
+	* When the first pass takes BGR f32 planar, src_img is already the planar conversion of our source made by the ConvertPlanar shader,
+	* and when the last pass outputs BGR f32 planar, dst_img is a planar texture that the ResolvePlanar shader converts into scaled_texture.
+	* Both of those hops are plain copies to or from the mapped textures, only the Upscaling filter goes through the staging buffer
+	* In path C the SuperRes filter takes AR_dst as its input, SR_src is only used when converting to RGBA for the Upscaling filter
+	* 
+	* With tiled updates, only the tiles of the source that changed since the frame the slot holds go through the tile pass,
+	* a copy of the pipeline loaded at the size of a single tile, and their cores are composited over the slot's planar output.
+	* Sources larger than the effects accept always go through the tile pass, split into the largest tiles that are accepted.
+	* 
+	* With batching, the input of the SuperRes or Upscaling pass is submitted to the batch of every filter sharing our configuration,
+	* and the batch runs them all with a single NvVFX_Run once the last of them has submitted. Our output is moved into the slot
+	* then, which may be after we've been drawn, in which case the previous output is drawn this time around.
+	*/
+
+	/* A frame still waiting on the rest of its batch is run now, it was written to buffers this frame is about to reuse */
+	if (filter->batch_member && nv_batch_member_pending(filter->batch_member))
+	{
+		nv_batch_flush(batch_service);
+	}
+
+	const uint32_t slot_index = (filter->live.output_index + 1) % filter->live.output_count;
+	struct nv_output_slot *slot = &filter->live.outputs[slot_index];
+
+	struct nv_tile tiles[NV_TILE_MAX];
+	int tile_count = filter->tiled_updates ? plan_dirty_tiles(filter, slot, tiles) : -1;
+
+	/* Every tiled update brings the slot closer to its next full refresh */
+	slot->tiled_frames = tile_count >= 0 ? slot->tiled_frames + 1 : 0;
+
+	/* Oversized sources can only be processed in tiles, all of them unless there's an incremental update to do */
+	if (tile_count < 0 && filter->oversized)
+	{
+		tile_count = plan_all_tiles(filter, tiles);
+
+		if (tile_count < 0)
 		{
-			debug("Update: AR disabled");
-			filter->destroy_ar = true;
+			return false;
 		}
-		else
+	}
+
+	/* The slot only holds a known frame again once it has been processed in full */
+	slot->has_fingerprint = false;
+
+	if (tile_count >= 0)
+	{
+		if (tile_count > 0 && !process_dirty_tiles(filter, slot, tiles, (uint32_t)tile_count))
 		{
-			debug("Update: AR enabled");
+			return false;
 		}
 
-		filter->reload_ar_fx = true;
+		complete_output_slot(filter, slot_index, true);
+		return true;
 	}
 
-	int ar_mode = (int)obs_data_get_int(settings, S_MODE_AR);
+	if (!run_first_passes(filter))
+	{
+		return false;
+	}
 
-	if (filter->apply_ar && filter->ar_mode != ar_mode)
+	/* Once the batch has run, our output is transferred into the slot by batch_complete */
+	if (filter->batch_member && nv_batch_group_size(filter->batch_member) > 1 && submit_to_batch(filter, slot_index))
 	{
-			filter->ar_mode = ar_mode;
-			filter->reload_ar_fx = true;
-			debug("Update: AR mode changed");
+		return filter->live.outputs[filter->live.output_index].ready;
 	}
 
-	if (type == S_TYPE_UP)
+	/* 3. Run the image through the upscaling pass */
+	if (filter->live.sr_handle)
 	{
-		float strength = (float)obs_data_get_double(settings, S_STRENGTH);
-		filter->scale = (int)obs_data_get_int(settings, S_UP_SCALE);
-		if (fabsf(strength - filter->strength) > EPSILON)
+		NvCVImage *input = sr_reads_ar_output(filter) ? filter->live.gpu_ar_dst_img : filter->live.gpu_sr_src_img;
+
+		if (!bind_fx(filter, filter->live.sr_fx, input, filter->live.gpu_sr_dst_img) || !bind_strength(filter, filter->live.sr_fx))
 		{
-			filter->strength = strength;
-			filter->reload_sr_fx = true;
-			debug("Update: Upscaling strength changed");
+			return false;
+		}
+
+		NvCV_Status vfxErr = NvVFX_Run(filter->live.sr_handle, filter->async_run ? 1 : 0);
+		mark_fx_run(filter, filter->live.sr_fx);
+
+		if (vfxErr == NVCV_ERR_CUDA)
+		{
+			nv_superres_filter_reset(filter, NULL);
+			return false;
 		}
+
+		nv_error(vfxErr, "Error running the NvVFX Super Resolution stage.", filter, false);
 	}
+
+	return transfer_output(filter, slot_index);
 }
 
 
 
-static bool alloc_image_from_texture(struct nv_superresolution_data *filter, img_create_params_t *params, gs_texture_t *texture)
+/* Reload the NVFX filter effects, the filter ar_handle and sr_handle must be allocated
+* param load - the tier being loaded, and everything loading it reads
+*/
+static bool reload_fx(struct nv_fx_load *load)
 {
-	debug("alloc_image_from_texture: entered");
+	/* The tile pass is loaded the next time it's used */
+	if (load->reload_ar_fx || load->reload_sr_fx)
+	{
+		load->state.tiles.loaded = false;
+	}
 
-	struct ID3D11Texture2D *d11texture = (struct ID3D11Texture2D *)gs_texture_get_obj(texture);
+	/* The effects would reject an oversized source, only the tile pass is used for it */
+	if (load->oversized)
+	{
+		load->reload_ar_fx = false;
+		load->reload_sr_fx = false;
+		return true;
+	}
 
-	if (!d11texture)
+	if (nvvfx_supports_ar && load->state.ar_handle && load->reload_ar_fx && !load_ar_fx(load))
 	{
-		error("Couldn't retrieve d3d11texture2d from gs_texture");
+		error("Failed to load the artifact reduction NvVFX");
 		return false;
 	}
 
-	NvCV_Status vfxErr;
+	if ((nvvfx_supports_sr || nvvfx_supports_up) && load->reload_sr_fx && load->state.sr_handle && !load_sr_fx(load))
+	{
+		error("Failed to load the selected NvVFX %d", load->config.type);
+		return false;
+	}
 
-	if (*(params->buffer) != NULL)
+	return true;
+}
+
+
+/*
+* Destroys the effects, and the buffers they run on, that have been flagged for destruction by a settings change
+* param load - the tier being loaded, and everything loading it reads
+*/
+static void destroy_flagged_fx(struct nv_fx_load *load)
+{
+	if (load->destroy_ar)
+	{
+		debug("destroy_flagged_fx: Destroying AR");
+
+		release_fx(&load->state.ar_fx, &load->state.ar_handle);
+		nv_destroy_fx_filter(NULL, &load->state.gpu_ar_src_img, &load->state.gpu_ar_dst_img);
+		destroy_tile_pass(&load->state.tiles);
+		load->destroy_ar = false;
+
+		/* SuperRes may have been reading the AR output directly, it needs its own source buffer again */
+		load->are_images_allocated = false;
+	}
+
+	if (load->destroy_sr)
+	{
+		debug("destroy_flagged_fx: Destroying SR");
+
+		if (load->state.gpu_staging_img)
+		{
+			debug("destroy_flagged_fx: Destroying Upscale staging buffer");
+
+			NvCVImage_Destroy(load->state.gpu_staging_img);
+			load->state.gpu_staging_img = NULL;
+		}
+
+		release_fx(&load->state.sr_fx, &load->state.sr_handle);
+		nv_destroy_fx_filter(NULL, &load->state.gpu_sr_src_img, &load->state.gpu_sr_dst_img);
+		destroy_tile_pass(&load->state.tiles);
+		load->destroy_sr = false;
+	}
+
+	/* The buffers of an effect left are views into the backing allocations, they're only freed with the last effect */
+	if (!load->state.ar_handle && !load->state.sr_handle)
 	{
-		NvCVImage_Destroy(*(params->buffer));
+		destroy_planned_backings(load->state.planned, 0);
+
+		if (gpu_arena)
+		{
+			nv_arena_trim(gpu_arena);
+		}
 	}
+}
 
-	vfxErr = NvCVImage_Create(params->width, params->height,
-					params->pixel_fmt, params->comp_type,
-					params->layout, NVCV_GPU,
-					params->alignment, params->buffer);
-	nv_error(vfxErr, "Error creating source NvCVImage", filter, false);
 
-	vfxErr = NvCVImage_InitFromD3D11Texture(*(params->buffer), d11texture);
-	nv_error(vfxErr, "Error allocating NvCVImage from ID3D11Texture", filter, false);
 
-	debug("alloc_image_from_texture: exiting");
-	return true;
+/*
+* Checks if the effects, or the buffers and textures they run on, have to be recreated or reloaded before the next frame is processed
+* 
+* param filter - our OBS filter structure
+* param source_space - the color space of the source about to be rendered
+* return - True if the filter has to be reconfigured
+*/
+static bool needs_reconfigure(struct nv_superresolution_data *filter, enum gs_color_space source_space)
+{
+	return filter->destroy_ar || filter->destroy_sr || filter->reload_ar_fx || filter->reload_sr_fx || !filter->are_images_allocated ||
+	       filter->space != source_space || (filter->apply_ar && !filter->live.ar_handle) || (filter->type != S_TYPE_NONE && !filter->live.sr_handle);
 }
 
 
 
 /*
-* Simple wrapper method around alloc_image_from_texture to accept textrender parameter
-* 
-* param filter
-* param params - 
-* param texture - OBS texrender texture to bind to the buffer in params
-* 
-* return - True if there is no error, False otherwise
+* Sets up loading a tier with everything loading it reads besides the tier itself, taken from the filter. Must be called within the graphics context
+* param filter - our OBS filter structure
+* param load - OUTPUT parameter, the load of the live tier's configuration, with an empty tier
 */
-static bool alloc_image_from_texrender(struct nv_superresolution_data *filter, img_create_params_t *params, gs_texrender_t *texture)
+static void init_fx_load(struct nv_superresolution_data *filter, struct nv_fx_load *load)
 {
-	debug("alloc_image_from_texrender");
-	return alloc_image_from_texture(filter, params, gs_texrender_get_texture(texture));
+	memset(load, 0, sizeof(*load));
+
+	load->config.type = filter->type;
+	load->config.scale = filter->scale;
+	load->config.sr_mode = filter->sr_mode;
+	load->config.strength = filter->strength;
+	load->stream = filter->stream;
+	load->width = filter->width;
+	load->height = filter->height;
+	load->ar_mode = filter->ar_mode;
+	load->apply_ar = filter->apply_ar;
+	load->half_precision = filter->half_precision;
+	load->is_target_valid = filter->is_target_valid;
+	load->oversized = filter->oversized;
+	load->tiled_updates = filter->tiled_updates;
+	load->batch = filter->batch;
 }
 
 
 
-/* Allocates or reallocates the NvCVImage buffer provided in the param struct
-* If width2 or height2 are > 0, the image buffer will have memory allocated to fit the maximum size between 
-* but be sized to width X height. This is used to allocate intermediary staging buffers
+/*
+* The part of loading a tier that doesn't need the graphics context, and that takes long enough to drop frames:
+* destroying and creating the effects, (re)allocating their NvCVImage buffers, and NvVFX_Load.
+* Runs on reconfig_thread or warm_thread, or on the graphics thread when reloading in the background is off or the thread couldn't be started
 * 
-* returns - True if there is no error, False otherwise
+* param load - the tier to load, and everything loading it reads. Nothing else is touched, the load is only handed back once done is set
 */
-static bool alloc_image(struct nv_superresolution_data* filter, img_create_params_t *params)
+static void load_fx(struct nv_fx_load *load)
 {
-	debug("alloc_image: entered for buffer %X", *(params->buffer));
+	debug("load_fx: entering");
 
-	uint32_t create_width = params->width2 > 0 ? params->width2 : params->width;
-	uint32_t create_height = params->height2 > 0 ? params->height2 : params->height;
-	NvCV_Status vfx_err;
+	destroy_flagged_fx(load);
 
-	// If our NVFX Image exists, resize and reformat it
-	if (*(params->buffer) != NULL)
-	{
-		debug("alloc_image: realloc buffer %X", *(params->buffer));
+	load->success = initialize_fx(load);
+	load->loaded = false;
 
-		vfx_err = NvCVImage_Realloc(
-			     *(params->buffer), create_width, create_height,
-			     params->pixel_fmt, params->comp_type,
-			     params->layout, NVCV_GPU, params->alignment);
+	/* Creating an effect flags the images for allocation */
+	load->images = load->images || !load->are_images_allocated;
 
-		nv_error(vfx_err, "Failed to re-allocate image buffer", filter, false);
-	}
-	else
+	if (load->success && (load->state.ar_handle || load->state.sr_handle))
 	{
-		debug("alloc_image: creating new NvCVImage buffer for %X", *(params->buffer));
+		/* Buffers taken from the size pool are already allocated for the source, the effects only have to be loaded with them */
+		if (load->images && load->pool_restored)
+		{
+			load->reload_ar_fx = load->state.ar_handle != NULL;
+			load->reload_sr_fx = load->state.sr_handle != NULL;
+			load->success = alloc_tile_pass(load);
+		}
+		else if (load->images)
+		{
+			load->success = alloc_nvfx_images(load) && alloc_tile_pass(load);
+		}
 
-		vfx_err = NvCVImage_Create(
-			     create_width, create_height, params->pixel_fmt,
-			     params->comp_type, params->layout, NVCV_GPU,
-			     params->alignment, params->buffer);
+		load->loaded = load->success && reload_fx(load);
 
-		nv_error(vfx_err, "Failed to create image buffer", filter, false);
+		/* The effects didn't take half precision buffers, allocate full precision ones and load them again */
+		if (!load->loaded && load->f16_rejected)
+		{
+			load->f16_rejected = false;
+			load->images = true;
+			load->pool_restored = false;
+			load->success = alloc_nvfx_images(load) && alloc_tile_pass(load);
+			load->loaded = load->success && reload_fx(load);
+		}
 
-		debug("alloc_image: alloc buffer %X", *(params->buffer));
-		vfx_err = NvCVImage_Alloc(
-			     *(params->buffer), create_width, create_height,
-			     params->pixel_fmt, params->comp_type,
-			     params->layout, NVCV_GPU, params->alignment);
+		/* Rather than on the first frame that is tiled */
+		if (load->loaded && load->state.tiles.enabled && !load->state.tiles.loaded)
+		{
+			load_tile_pass(&load->state.tiles, load->ar_mode, load->config.sr_mode);
+		}
+	}
 
-		nv_error(vfx_err, "Failed to allocate image buffer", filter, false);
+	/* The effects that aren't there have nothing to reload, they're flagged again when they're created */
+	load->reload_ar_fx = false;
+	load->reload_sr_fx = false;
 
-		// We create our image at the given secondary size, and then resize it down to the original size we want
-		// This is the recommended method from the nVidia video effects SDK for allocating staging buffers
-		if (create_height != params->height || create_width != params->width)
-		{
-			debug("alloc_image: two-sized re-alloc buffer %X", *(params->buffer));
+	os_atomic_set_bool(&load->done, true);
 
-			vfx_err = NvCVImage_Realloc(
-				     *(params->buffer), params->width,
-				     params->height,
-				     params->pixel_fmt, params->comp_type,
-				     params->layout, NVCV_GPU,
-				     params->alignment);
+	debug("load_fx: exiting");
+}
 
-			nv_error(vfx_err, "Failed to resize image buffer", filter, false);
-		}
-	}
 
-	debug("alloc_image: exiting for buffer %X", *(params->buffer));
 
-	return true;
+static void *reconfigure_thread(void *data)
+{
+	os_set_thread_name("nv_superres_reconfigure");
+
+	load_fx((struct nv_fx_load *)data);
+
+	return NULL;
 }
 
 
 
 /*
-* Allocates and binds Artifact Reduction images, the source and destination images required for this NVFX Filter to work
+* Finishes a reconfiguration once reconfig.done is set, (re)creating the textures that match the new buffers. Must be called within the graphics context
 * 
 * param filter - our OBS filter structure
-* returns - True if there were no errors, False otherwise
+* return - True if the filter is ready to process frames again, or a new reconfiguration has to be started. False if there was an error
 */
-static bool alloc_ar_images(struct nv_superresolution_data* filter)
+static bool finish_reconfigure(struct nv_superresolution_data *filter)
 {
-	debug("alloc_ar_images: entering");
+	debug("finish_reconfigure: entering");
 
-	img_create_params_t ar_img =
-	{
-		.buffer = &filter->gpu_ar_src_img,
-		.width = filter->width,
-		.height = filter->height,
-		.pixel_fmt = NVCV_BGR,
-		.comp_type = NVCV_F32,
-		.layout = NVCV_PLANAR,
-		.alignment = 1,
-	};
+	join_reconfigure(filter);
 
-	if (!alloc_image(filter, &ar_img))
+	/* A fatal error during the reconfiguration leaves the filter stopped */
+	if (!set_lifecycle(filter, NV_LIFECYCLE_RECONFIGURING, NV_LIFECYCLE_RUNNING) || !filter->reconfig.success)
 	{
-		error("Failed to allocate AR source buffer");
 		return false;
 	}
 
-	ar_img.buffer = &filter->gpu_ar_dst_img;
-
-	if (!alloc_image(filter, &ar_img))
+	if (filter->reconfig_images)
 	{
-		error("Failed to allocate AR dest buffer");
-		return false;
+		filter->space = filter->reconfig_space;
+
+		finish_size_swap(filter);
+
+		if (filter->live.ar_handle || filter->live.sr_handle)
+		{
+			if (!alloc_obs_textures(filter))
+			{
+				return false;
+			}
+
+			if (!filter->pool_restored && !alloc_destination_image(filter, &filter->live, filter->type))
+			{
+				stop_processing(filter);
+				return false;
+			}
+		}
+
+		filter->images_keyed = filter->live.ar_handle || filter->live.sr_handle;
+
+		if (filter->images_keyed)
+		{
+			get_size_key(filter, &filter->images_key);
+		}
+
+		filter->are_images_allocated = true;
+		filter->pool_restored = false;
 	}
 
-	filter->reload_ar_fx = true;
+	debug("finish_reconfigure: exiting");
 
-	debug("alloc_ar_images: entering");
-	return true;
+	return filter->reconfig.loaded || (!filter->live.ar_handle && !filter->live.sr_handle);
 }
 
 
 
 /*
-* Allocates required textures for the OBS source our filter is applied to
+* Starts reconfiguring the filter for the current settings and source. In the background, the last output keeps being drawn
+* until reconfig.done is set and finish_reconfigure is called, otherwise the whole reconfiguration is done before returning.
+* Must be called within the graphics context
 * 
 * param filter - our OBS filter structure
-* return - True if there is no error, False otherwise
+* param source_space - the color space of the source about to be rendered
+* return - False if there was an error, True otherwise
 */
-static bool alloc_obs_textures(struct nv_superresolution_data* filter)
+static bool start_reconfigure(struct nv_superresolution_data *filter, enum gs_color_space source_space)
 {
-	debug("alloc_obs_textures: entering");
+	debug("start_reconfigure: entering");
 
-	/* 3. create texrenders */
-	if (filter->render)
+	/* A reconfiguration that stopped the filter before it was reset hasn't been joined */
+	join_reconfigure(filter);
+
+	if (!set_lifecycle(filter, NV_LIFECYCLE_RUNNING, NV_LIFECYCLE_RECONFIGURING))
 	{
-		debug("alloc_obs_textures: destroying existing render texture");
-		gs_texrender_destroy(filter->render);
+		return false;
 	}
 
-	debug("alloc_obs_textures: creating render texture");
-	filter->render = gs_texrender_create(gs_get_format_from_space(filter->space), GS_ZS_NONE);
-
-	kill_on_error(filter->render, "Failed to create render texrenderer", filter);
-
-	if (filter->render_unorm)
+	/* The buffers about to be destroyed or reallocated may still be in use by frames queued on our stream */
+	if (filter->stream)
 	{
-		debug("alloc_obs_textures: destroying existing render unorm texture");
-		gs_texrender_destroy(filter->render_unorm);
+		cuStreamSynchronize(filter->stream);
 	}
 
-	debug("alloc_obs_textures: creating render unorm texture");
-	filter->render_unorm = gs_texrender_create(GS_BGRA_UNORM, GS_ZS_NONE);
+	filter->reconfig_images = filter->space != source_space || !filter->are_images_allocated;
+	filter->reconfig_space = source_space;
+	filter->pool_restored = filter->reconfig_images && start_size_swap(filter);
+
+	struct nv_fx_load *load = &filter->reconfig;
+	init_fx_load(filter, load);
+
+	/* The live tier and what's to be done with it belong to the reconfiguration until join_reconfigure hands them back */
+	load->state = filter->live;
+	load->destroy_ar = filter->destroy_ar;
+	load->destroy_sr = filter->destroy_sr;
+	load->reload_ar_fx = filter->reload_ar_fx;
+	load->reload_sr_fx = filter->reload_sr_fx;
+	load->are_images_allocated = filter->are_images_allocated;
+	load->images = filter->reconfig_images;
+	load->pool_restored = filter->pool_restored;
+	load->invalid_ar_size = filter->invalid_ar_size;
+	load->invalid_sr_size = filter->invalid_sr_size;
+
+	filter->destroy_ar = false;
+	filter->destroy_sr = false;
+	filter->reload_ar_fx = false;
+	filter->reload_sr_fx = false;
+	filter->reconfig_pending = true;
 
-	kill_on_error(filter->render_unorm, "Failed to create render_unorm texrenderer", filter);
+	filter->reconfig_threaded = filter->background_reload &&
+				    pthread_create(&filter->reconfig_thread, NULL, reconfigure_thread, load) == 0;
 
-	filter->done_initial_render = false;
+	if (filter->reconfig_threaded)
+	{
+		return true;
+	}
 
-	debug("alloc_obs_textures: exiting");
-	return true;
+	load_fx(load);
+	return finish_reconfigure(filter);
 }
 
 
 
-/* Allocates the Super Resolution source images, these are allocated anytime the target is resized, or the filter type changed */
-static bool alloc_sr_source_images(struct nv_superresolution_data *filter)
+/*
+* Gets what the live tier is loaded for besides its own configuration
+* param filter - our OBS filter structure
+* param base - OUTPUT parameter
+*/
+static void get_tier_base(const struct nv_superresolution_data *filter, struct nv_tier_base *base)
 {
-	debug("alloc_sr_source_images: entering");
-
-	if (!filter->is_target_valid)
-	{
-		return true;
-	}
-
-	img_create_params_t img = {
-		.buffer = &filter->gpu_sr_src_img,
-		.width = filter->width,
-		.height = filter->height
-	};
-
-	if (filter->type == S_TYPE_SR)
-	{
-		img.pixel_fmt = NVCV_BGR;
-		img.comp_type = NVCV_F32;
-		img.layout = NVCV_PLANAR;
-		img.alignment = 1;
-	}
-	else if (filter->type == S_TYPE_UP)
-	{
-		img.pixel_fmt = NVCV_RGBA;
-		img.comp_type = NVCV_U8;
-		img.layout = NVCV_CHUNKY;
-		img.alignment = 32;
-	}
-	else
-	{
-		error("Attempted to allocate source image buffer for No Upscaler");
-	}
+	base->width = filter->width;
+	base->height = filter->height;
+	base->frame_width = filter->frame_width;
+	base->frame_height = filter->frame_height;
+	base->roi = filter->roi;
+	base->space = filter->space;
+	base->ar_mode = filter->ar_mode;
+	base->apply_ar = filter->apply_ar;
+	base->pipelined = filter->pipelined;
+	base->tiled_updates = filter->tiled_updates;
+	base->roi_enabled = filter->roi_enabled;
+	base->half_precision = filter->half_precision;
+}
 
-	if (!alloc_image(filter, &img))
-	{
-		error("Failed to allocate SuperRes source buffer");
-		return false;
-	}
 
-	filter->reload_sr_fx = true;
 
-	debug("alloc_sr_source_images: exiting");
-	return true;
+static bool tier_base_equal(const struct nv_tier_base *a, const struct nv_tier_base *b)
+{
+	return a->width == b->width && a->height == b->height && a->frame_width == b->frame_width && a->frame_height == b->frame_height &&
+	       a->roi.x == b->roi.x && a->roi.y == b->roi.y && a->roi.width == b->roi.width && a->roi.height == b->roi.height &&
+	       a->space == b->space && a->ar_mode == b->ar_mode && a->apply_ar == b->apply_ar && a->pipelined == b->pipelined &&
+	       a->tiled_updates == b->tiled_updates && a->roi_enabled == b->roi_enabled && a->half_precision == b->half_precision;
 }
 
 
 
-/* Allocates the Super Resolution source images, these are allocated anytime the target is resized, the filter type changed, or the sr_scale changed */
-static bool alloc_sr_dest_images(struct nv_superresolution_data* filter)
+/*
+* Destroys a parked tier. Must be called within the graphics context
+* param filter - our OBS filter structure
+* param tier - the tier, it's loaded again the next time it's warmed or switched to
+*/
+static void discard_tier(struct nv_superresolution_data *filter, struct nv_tier *tier)
 {
-	debug("alloc_sr_dest_images: entering");
+	debug("discard_tier: entering");
 
-	if (!filter->is_target_valid)
+	/* Frames the tier processed before it was parked may still be queued on our stream */
+	if (filter->stream)
 	{
-		return true;
+		cuStreamSynchronize(filter->stream);
 	}
 
-	img_create_params_t img = {
-		.buffer = &filter->gpu_sr_dst_img,
-		.width = filter->out_width,
-		.height = filter->out_height
-	};
+	destroy_tier_state(&tier->state);
+	tier->parked = false;
+}
 
-	if (filter->type == S_TYPE_SR)
-	{
-		img.pixel_fmt = NVCV_BGR;
-		img.comp_type = NVCV_F32;
-		img.layout = NVCV_PLANAR;
-		img.alignment = 1;
-	}
-	else if (filter->type == S_TYPE_UP)
-	{
-		img.pixel_fmt = NVCV_RGBA;
-		img.comp_type = NVCV_U8;
-		img.layout = NVCV_CHUNKY;
-		img.alignment = 32;
-	}
-	else
-	{
-		error("Attempted to allocate destination image buffer for No Upscaler");
-	}
 
-	if (!alloc_image(filter, &img))
+
+/*
+* Makes the live tier run the given configuration, flagging the effects it needs reloaded as apply_settings does.
+* Must not be called while the filter is being reconfigured
+* param filter - our OBS filter structure
+* param config - the configuration of the live tier
+*/
+static void apply_tier_config(struct nv_superresolution_data *filter, const struct nv_tier_config *config)
+{
+	if (filter->type != config->type)
 	{
-		error("Failed to allocate NvCVImage SR dest buffer");
-		return false;
+		filter->destroy_sr = true;
+		filter->reload_sr_fx = true;
 	}
 
-	/* Allocate the staging buffer next to set it's size */
-	img.buffer = &filter->gpu_staging_img;
-	img.width = filter->width;
-	img.height = filter->height;
-	img.width2 = filter->out_width;
-	img.height2 = filter->out_height;
-
-	if (!alloc_image(filter, &img))
+	if (filter->sr_mode != config->sr_mode)
 	{
-		error("Failed to allocate NvCVImage FX staging buffer");
-		return false;
+		filter->reload_sr_fx = true;
 	}
 
-	filter->reload_sr_fx = true;
-	debug("alloc_sr_dest_images: exiting");
-	return true;
+	filter->type = config->type;
+	filter->scale = config->scale;
+	filter->sr_mode = config->sr_mode;
+	filter->strength = config->strength;
+	filter->batch_strength = config->strength;
+	filter->fingerprint_valid = false;
 }
 
 
 
-/* (Re)allocates any images that are pending (re)allocation
-/* @return - false if there's any error, true otherwise */
-static bool alloc_nvfx_images(struct nv_superresolution_data *filter)
+/*
+* Switches the live tier. A parked tier is swapped in as it is and runs on the frame being rendered, any other is created
+* by the next reconfiguration as if the settings had changed. The tier switched from is parked in its place.
+* Must be called within the graphics context, while the filter isn't being reconfigured
+* 
+* param filter - our OBS filter structure
+* param index - the tier to switch to
+*/
+static void switch_tier(struct nv_superresolution_data *filter, uint32_t index)
 {
-	debug("alloc_nvfx_images: entering");
+	struct nv_tier *current = &filter->tiers[filter->active_tier];
+	struct nv_tier *target = &filter->tiers[index];
 
-	if (filter->ar_handle)
-	{
-		if (!alloc_ar_images(filter))
-		{
-			error("Failed to allocate AR NvFXImages");
-			return false;
-		}
-	}
+	struct nv_tier_base base;
+	get_tier_base(filter, &base);
 
-	if (filter->sr_handle)
+	/* The next frame would go to the batch of the other configuration, update_batch_member joins the right one */
+	if (filter->batch_member)
 	{
-		if (!alloc_sr_source_images(filter))
+		if (nv_batch_member_pending(filter->batch_member))
 		{
-			error("Failed to allocate SR Source NvFXImages");
-			return false;
+			nv_batch_flush(batch_service);
 		}
 
-		if (!alloc_sr_dest_images(filter))
-		{
-			error("Failed to allocate SR Dest NvFXImages");
-			return false;
-		}
+		nv_batch_leave(filter->batch_member);
+		filter->batch_member = NULL;
 	}
 
-	// This temporary image is not required if using Upscaling.
-	// If using only AR, or using SR at all this IS required as an intermediate step for BGRf32 -> D3D11 RGBAu8 conversion
-	if (filter->type != S_TYPE_UP)
+	current->state = filter->live;
+	current->base = base;
+	current->parked = true;
+
+	/* Half allocated, it isn't worth keeping */
+	if (!filter->are_images_allocated)
 	{
-		debug("alloc_nvfx_images: creaing dst_tmp_img");
-		img_create_params_t img = {
-			.buffer = &filter->gpu_dst_tmp_img,
-			.pixel_fmt = NVCV_RGBA,
-			.comp_type = NVCV_U8,
-			.layout = NVCV_CHUNKY,
-			.alignment = 0,
-			.width = filter->out_width,
-			.height = filter->out_height,
-			.width2 = 0,
-			.height2 = 0
-		};
+		discard_tier(filter, current);
+	}
 
-		if (!alloc_image(filter, &img))
-		{
-			error("Failed to allocate conversion buffer for AR or SR pass");
-			return false;
-		}
+	if (target->parked && (target->stale || !tier_base_equal(&target->base, &base)))
+	{
+		discard_tier(filter, target);
 	}
 
-	debug("alloc_nvfx_images: exiting");
+	const bool planar = uses_planar_input(filter);
+	const bool warm = target->parked;
+	const struct nv_tier_state empty = {0};
 
-	return true;
-}
+	filter->live = warm ? target->state : empty;
+	memset(&target->state, 0, sizeof(target->state));
 
+	/* The live buffers are now the tier's, which the size pool doesn't know the key of */
+	filter->images_keyed = false;
+	target->parked = false;
+	target->stale = false;
 
+	filter->type = target->config.type;
+	filter->scale = target->config.scale;
+	filter->sr_mode = target->config.sr_mode;
+	filter->strength = target->config.strength;
+	filter->batch_strength = target->config.strength;
+	filter->active_tier = index;
+	filter->fingerprint_valid = false;
 
-/*
-* Initializes and binds the final destination NVFX Image to the output texture intended for OBS
-* note: the internal texture, and nvfx image will be destroyed and recreated if they already exist
-* param filter - Our OBS data structure
-*/
-static bool alloc_destination_image(struct nv_superresolution_data* filter)
-{
-	if (filter->scaled_texture)
+	if (!warm)
 	{
-		gs_texture_destroy(filter->scaled_texture);
+		filter->reload_ar_fx = true;
+		filter->reload_sr_fx = true;
+		filter->are_images_allocated = false;
 	}
 
-	filter->scaled_texture = gs_texture_create(filter->out_width, filter->out_height, GS_RGBA_UNORM, 1, NULL, 0);
-
-	kill_on_error(filter->scaled_texture, "Final output texture couldn't be created", filter);
-
-	img_create_params_t params = {
-		.buffer = &filter->dst_img,
-		.width = filter->out_width,
-		.height = filter->out_height,
-		.pixel_fmt = NVCV_RGBA,
-		.comp_type = NVCV_U8,
-		.layout = NVCV_CHUNKY,
-		.alignment = 0
-	};
-
-	if (!alloc_image_from_texture(filter, &params, filter->scaled_texture))
+	/* Our source is bound to the render the first effect of the tier takes */
+	if (uses_planar_input(filter) != planar)
 	{
-		error("Failed to create dest NvCVImage from OBS output texture");
-		return false;
+		filter->done_initial_render = false;
 	}
 
-	return true;
+	info("Switched to quality tier %u%s", index, warm ? "" : ", loading it");
 }
 
 
 
-/* Allocates any textures or images that have been flagged for allocation
-* Used in both initialization and render tick to ensure things are created before use */
-static bool init_images(struct nv_superresolution_data* filter)
+/*
+* Starts loading the first tier that's enabled and not parked on warm_thread, into a copy of the filter so the live tier keeps
+* running meanwhile. Sources a tier would have to tile are left to switching to it. Must be called while the filter isn't being reconfigured
+* 
+* param filter - our OBS filter structure
+*/
+static void start_warming(struct nv_superresolution_data *filter)
 {
-	debug("init_images: entering");
-
-	if (!alloc_obs_textures(filter))
+	if (!filter->tiers_enabled || !filter->background_reload || filter->warming || filter->settling || filter->resizing || filter->oversized ||
+	    !filter->are_images_allocated)
 	{
-		return false;
+		return;
 	}
 
-	if (!alloc_nvfx_images(filter))
-	{
-		return false;
-	}
+	struct nv_tier_base base;
+	get_tier_base(filter, &base);
 
-	if ((filter->apply_ar || filter->type != S_TYPE_NONE) && !alloc_destination_image(filter))
+	for (uint32_t i = 0; i < NV_TIER_MAX; ++i)
 	{
-		return false;
-	}
-
-	filter->are_images_allocated = true;
-
-	debug("init_images: exiting");
-
-	return true;
-}
+		struct nv_tier *tier = &filter->tiers[i];
 
+		if (i == filter->active_tier || !tier->enabled || tier->parked || (tier->failed && tier_base_equal(&tier->base, &base)))
+		{
+			continue;
+		}
 
+		tier->base = base;
+		tier->failed = true;
+		tier->stale = false;
 
-/*
-* Called when the source, or this filter itself needs to be reinitialized for some reason.
-*/
-static void nv_superres_filter_reset(void *data, calldata_t *calldata)
-{
-	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)data;
+		const struct nv_tier_config *config = &tier->config;
+		uint32_t out_width = filter->width;
+		uint32_t out_height = filter->height;
+		uint32_t frame_out_width = filter->frame_width;
+		uint32_t frame_out_height = filter->frame_height;
 
-	debug("nv_superres_filter_reset: Entering");
+		/* Sized as the tick sizes the live tier */
+		if (config->type != S_TYPE_NONE)
+		{
+			get_scale_factor(config->scale, filter->width, filter->height, &out_width, &out_height);
+			get_scale_factor(config->scale, filter->frame_width, filter->frame_height, &frame_out_width, &frame_out_height);
 
-	if (!filter)
-	{
-		error("Attempted to reset filter, but filter structure is invalid!");
-		return;
-	}
+			if (!validate_scaling_aspect(filter->width, filter->height, out_width, out_height) ||
+			    (config->type == S_TYPE_SR && !validate_source_size(config->scale, filter->width, filter->height, out_width, out_height)))
+			{
+				debug("start_warming: tier %u doesn't fit the source", i);
+				continue;
+			}
+		}
 
-	os_atomic_set_bool(&filter->processing_stopped, true);
+		struct nv_fx_load *load = bzalloc(sizeof(*load));
+		init_fx_load(filter, load);
 
-	debug("nv_superres_filter_reset: Source reset recreate CUDA stream");
-	if (!create_cuda(filter))
-	{
-		return;
-	}
+		/* A tier of its own, nothing of the live one is shared */
+		load->config = *config;
+		load->state.out_width = out_width;
+		load->state.out_height = out_height;
+		load->state.frame_out_width = frame_out_width;
+		load->state.frame_out_height = frame_out_height;
+		load->reload_ar_fx = true;
+		load->reload_sr_fx = true;
+		load->images = true;
 
-	filter->destroy_ar = true;
-	filter->destroy_sr = true;
-	filter->reload_ar_fx = true;
-	filter->reload_sr_fx = true;
-	filter->are_images_allocated = false;
+		if (pthread_create(&filter->warm_thread, NULL, reconfigure_thread, load) != 0)
+		{
+			bfree(load);
+			return;
+		}
 
-	os_atomic_set_bool(&filter->processing_stopped, false);
+		debug("start_warming: loading tier %u", i);
 
-	debug("nv_superres_filter_reset: Entering");
+		tier->failed = false;
+		filter->warming = load;
+		filter->warming_tier = i;
+		return;
+	}
 }
 
 
 
 /*
-* Runs the NVFX filter pipeline on the current source frame.
-* The final destination NVFX buffer in fitler will be updated with the output from this pipeline
+* Parks the tier loaded on warm_thread once it's done, creating its output textures. It's dropped if the filter changed meanwhile.
+* Must be called within the graphics context
 * 
 * param filter - our OBS filter structure
-* return - False if there was an error. True otherwise.
 */
-static bool process_texture_superres(struct nv_superresolution_data *filter)
+static void finish_warming(struct nv_superresolution_data *filter)
 {
-	/* From nVidias recommendations here https://docs.nvidia.com/deeplearning/maxine/vfx-sdk-programming-guide/index.html#upscale-filter
-	* We have 3 main paths to take
-	* A. AR pass only
-	* B. Upscaling Pass Only
-	* C. AR Pass -> Upscaling Pass
-	* So the effect pipeline is
-	*	A: src_img -> staging -> AR_src -> Run FX -> AR_dst -> staging -> dst_tmp_img -> staging -> dst_img
-	*	B: src_img -> staging -> SR_src -> Run FX -> SR_dst -> staging -> dst_tmp_img -> staging -> dst_img
-	*	C: src_img -> staging -> AR_src -> Run FX -> AR_dst -> staging -> SR_src -> Run FX -> SR_dst -> staging -> dst_tmp_img -> staging -> dst_img
-	* 
-	* The staging -> dst_tmp_img stage is skipped if the AR is not selected, and the upscaling method is standard upscaling
-	*/
-
-	NvCVImage *destination = filter->dst_img;
+	struct nv_fx_load *load = filter->warming;
 
-	if (filter->ar_handle)
+	if (!load || !os_atomic_load_bool(&load->done))
 	{
-		destination = filter->gpu_ar_src_img;
-	}
-	else if (filter->sr_handle)
-	{
-		destination = filter->gpu_sr_src_img;
+		return;
 	}
 
-	/* Have to map the D3D buffers before your manipulate them, and unmap before D3D is allowed to take over again */
-	NvCV_Status vfxErr = NvCVImage_MapResource(filter->src_img, filter->stream);
-	nv_error(vfxErr, "Error mapping resource for source texture", filter, false);
+	pthread_join(filter->warm_thread, NULL);
+	filter->warming = NULL;
 
-	vfxErr = NvCVImage_Transfer(filter->src_img, destination, filter->ar_handle ? 1.0f/255.0f : 1.0f, filter->stream, filter->gpu_staging_img);
-	nv_error(vfxErr, "Error converting src img for first filter pass", filter, false);
+	struct nv_tier *tier = &filter->tiers[filter->warming_tier];
+	const bool passthrough = !load->state.ar_handle && !load->state.sr_handle;
+	const bool loaded = load->success && (load->loaded || passthrough) &&
+			    (passthrough || alloc_destination_image(filter, &load->state, load->config.type));
 
-	vfxErr = NvCVImage_UnmapResource(filter->src_img, filter->stream);
-	nv_error(vfxErr, "Error unmapping resource for src texture", filter, false);
+	tier->state = load->state;
+	tier->parked = true;
+	bfree(load);
 
-	/* 2. process artifact reduction fx pass, and transfer to upscaling pass, or to final dst_tmp_img */
-	if (filter->ar_handle)
+	struct nv_tier_base base;
+	get_tier_base(filter, &base);
+
+	if (!loaded)
+	{
+		warn("Failed to load quality tier %u, it's loaded when it's switched to instead", filter->warming_tier);
+		discard_tier(filter, tier);
+		tier->failed = true;
+	}
+	else if (tier->stale || !tier_base_equal(&tier->base, &base))
+	{
+		debug("finish_warming: the filter changed while tier %u was loading", filter->warming_tier);
+		discard_tier(filter, tier);
+	}
+	else
 	{
-		vfxErr = NvVFX_Run(filter->ar_handle, 0);
+		debug("finish_warming: tier %u is ready", filter->warming_tier);
+	}
+}
 
-		if (vfxErr == NVCV_ERR_CUDA)
-		{
-			nv_superres_filter_reset(filter, NULL);
-			return false;
-		}
 
-		nv_error(vfxErr, "Error running the AR FX", filter, false);
 
-		destination = (filter->type == S_TYPE_NONE) ? filter->gpu_dst_tmp_img : filter->gpu_sr_src_img;
+/*
+* Keeps the quality tiers loaded, and switches to the one the hotkeys requested.
+* Must be called within the graphics context, while the filter isn't being reconfigured
+* 
+* param filter - our OBS filter structure
+*/
+static void update_tiers(struct nv_superresolution_data *filter)
+{
+	finish_warming(filter);
 
-		vfxErr = NvCVImage_Transfer(filter->gpu_ar_dst_img, destination, 255.0f, filter->stream, filter->gpu_staging_img);
-		nv_error(vfxErr, "Error converting src to BGR img for SR pass", filter, false);
-	}
+	struct nv_tier_base base;
+	get_tier_base(filter, &base);
 
-	/* 3. Run the image through the upscaling pass */
-	if (filter->sr_handle)
+	for (uint32_t i = 0; i < NV_TIER_MAX; ++i)
 	{
-		vfxErr = NvVFX_Run(filter->sr_handle, 0);
+		struct nv_tier *tier = &filter->tiers[i];
 
-		if (vfxErr == NVCV_ERR_CUDA)
+		/* A tier being loaded is dropped by finish_warming if it changed */
+		if (!filter->settling && !(filter->warming && filter->warming_tier == i) && tier->stale)
 		{
-			nv_superres_filter_reset(filter, NULL);
-			return false;
-		}
-
-		nv_error(vfxErr, "Error running the NvVFX Super Resolution stage.", filter, false);
+			if (i == filter->active_tier)
+			{
+				apply_tier_config(filter, &tier->config);
+			}
+			else if (tier->parked)
+			{
+				discard_tier(filter, tier);
+			}
 
-		if (!filter->gpu_dst_tmp_img)
-		{
-			/* Have to map the D3D buffers before your manipulate them, and unmap before D3D is allowed to take over again */
-			destination = filter->dst_img;
-			vfxErr = NvCVImage_MapResource(filter->dst_img, filter->stream);
-			nv_error(vfxErr, "Error mapping resource for dst texture", filter, false);
-		}
-		else
-		{
-			destination = filter->gpu_dst_tmp_img;
+			tier->failed = false;
+			tier->stale = false;
 		}
 
-		/* 3.5 move to a temp buffer, not tied to a bound D3D11 gs_texture_t, or used as an input/output NvCVImage to an effect */
-		// This temporary buffer should not be required, but it is
-		// see https://forums.developer.nvidia.com/t/no-transfer-conversion-from-planar-ncv-bgr-nvcv-f32-to-dx11-textures/183964/2
-		vfxErr = NvCVImage_Transfer(filter->gpu_sr_dst_img, destination, filter->ar_handle && filter->type == S_TYPE_SR ? 255.0f : 1.0f, filter->stream, filter->gpu_staging_img);
-		nv_error(vfxErr, "Error transfering super resolution upscaled texture to destination buffer", filter, false);
-
-		if (!filter->gpu_dst_tmp_img)
+		if (tier->parked && (!filter->tiers_enabled || !tier->enabled || !tier_base_equal(&tier->base, &base)))
 		{
-			vfxErr = NvCVImage_UnmapResource(filter->dst_img, filter->stream);
-			nv_error(vfxErr, "Error unmapping resource for dst texture", filter, false);
+			discard_tier(filter, tier);
 		}
 	}
 
-	/*
-	* 4. Do the final dst_tmp_img -> staging -> dst_img transfer
-	* This stage is only required when doing BGR/Planar to a D3D11 texture, as GPU->CUDA_ARRAY transfers in that format are not supported
-	*/
-	if (filter->gpu_dst_tmp_img)
-	{
-		/* Have to map the D3D buffers before your manipulate them, and unmap before D3D is allowed to take over again */
-		vfxErr = NvCVImage_MapResource(filter->dst_img, filter->stream);
-		nv_error(vfxErr, "Error mapping resource for dst texture", filter, false);
+	/* The main settings stand in for a tier that's disabled */
+	uint32_t index = (uint32_t)os_atomic_load_long(&filter->requested_tier);
 
-		vfxErr = NvCVImage_Transfer(filter->gpu_dst_tmp_img, filter->dst_img, 1.0f, filter->stream, filter->gpu_staging_img);
-		nv_error(vfxErr, "Error transferring temporary image buffer to final dest buffer", filter, false);
+	if (index >= NV_TIER_MAX || !filter->tiers_enabled || !filter->tiers[index].enabled)
+	{
+		index = 0;
+	}
 
-		vfxErr = NvCVImage_UnmapResource(filter->dst_img, filter->stream);
-		nv_error(vfxErr, "Error unmapping resource for dst texture", filter, false);
+	/* A tier being loaded is switched to once it's ready */
+	if (index != filter->active_tier && !(filter->warming && filter->warming_tier == index))
+	{
+		switch_tier(filter, index);
 	}
 
-	return true;
+	start_warming(filter);
 }
 
 
 
-/* Reload the NVFX filter effects, the filter ar_handle and sr_handle must be allocated
-* param filter - the filter structure to validate
-*/
-static bool reload_fx(struct nv_superresolution_data* filter)
+/* Hotkey callback, requests the tier of the hotkey, it's switched to on the next frame rendered */
+static void tier_hotkey_pressed(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
 {
-	if (nvvfx_supports_ar && filter->ar_handle && filter->reload_ar_fx && !load_ar_fx(filter))
+	UNUSED_PARAMETER(hotkey);
+
+	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)data;
+
+	if (!pressed)
 	{
-		error("Failed to load the artifact reduction NvVFX");
-		return false;
+		return;
 	}
 
-	if ((nvvfx_supports_sr || nvvfx_supports_up) && filter->reload_sr_fx && filter->sr_handle && !load_sr_fx(filter))
+	for (uint32_t i = 0; i < NV_TIER_MAX; ++i)
 	{
-		error("Failed to load the selected NvVFX %d", filter->type);
-		return false;
+		if (filter->tiers[i].hotkey == id)
+		{
+			os_atomic_set_long(&filter->requested_tier, (long)i);
+		}
 	}
-
-	return true;
 }
 
 
 
+
 static void* nv_superres_filter_create(obs_data_t* settings, obs_source_t* context)
 {
 	struct nv_superresolution_data* filter = (struct nv_superresolution_data*)bzalloc(sizeof(*filter));
 
 	debug("nv_superres_filter_create: Entering");
 
+	for (uint32_t i = 0; i < NV_TIER_MAX; ++i)
+	{
+		filter->tiers[i].hotkey = OBS_INVALID_HOTKEY_ID;
+	}
+
 	/* Does this filter exist already on a source, but the vfx sdk libraries weren't found? Let's leave. */
 	if (!nvvfx_loaded)
 	{
@@ -1391,11 +6108,23 @@ static void* nv_superres_filter_create(obs_data_t* settings, obs_source_t* conte
 
 	filter->context = context;
 	filter->sr_mode = S_MODE_DEFAULT;
+	filter->requested_sr_mode = S_MODE_DEFAULT;
 	filter->type = S_TYPE_DEFAULT;
 	filter->show_size_error = true;
 	filter->scale = S_SCALE_15x;
 	filter->strength = S_STRENGTH_DEFAULT;
-	os_atomic_set_bool(&filter->processing_stopped, false);
+	os_atomic_set_long(&filter->lifecycle, NV_LIFECYCLE_RUNNING);
+
+	const struct nv_settings initial = {0};
+	pthread_mutex_init(&filter->settings_mutex, NULL);
+	filter->settings = nv_snapshot_create(sizeof(initial), &initial);
+
+	if (!filter->settings)
+	{
+		error("Failed to allocate the settings of the filter");
+		nv_superres_filter_destroy(filter);
+		return NULL;
+	}
 
 	/* Load the effect file */
 	char* effect_path = obs_module_file("rtx_superresolution.effect");
@@ -1410,6 +6139,11 @@ static void* nv_superres_filter_create(obs_data_t* settings, obs_source_t* conte
 		filter->image_param = gs_effect_get_param_by_name(filter->effect, "image");
 		filter->upscaled_param = gs_effect_get_param_by_name(filter->effect, "image_upcsaled");
 		filter->multiplier_param = gs_effect_get_param_by_name(filter->effect, "multiplier");
+		filter->plane_height_param = gs_effect_get_param_by_name(filter->effect, "plane_height");
+		filter->planar_scale_param = gs_effect_get_param_by_name(filter->effect, "planar_scale");
+		filter->source_width_param = gs_effect_get_param_by_name(filter->effect, "source_width");
+		filter->source_height_param = gs_effect_get_param_by_name(filter->effect, "source_height");
+		filter->source_offset_param = gs_effect_get_param_by_name(filter->effect, "source_offset");
 	}
 
 	obs_leave_graphics();
@@ -1427,7 +6161,30 @@ static void* nv_superres_filter_create(obs_data_t* settings, obs_source_t* conte
 		return NULL;
 	}
 
+	for (uint32_t i = 0; i < NV_TIER_MAX; ++i)
+	{
+		char name[32];
+		char description[256];
+
+		snprintf(name, sizeof(name), S_TIER_HOTKEY, i);
+
+		if (i == 0)
+		{
+			snprintf(description, sizeof(description), "%s", TEXT_TIER_HOTKEY_MAIN);
+		}
+		else
+		{
+			snprintf(description, sizeof(description), TEXT_TIER_HOTKEY, i);
+		}
+
+		filter->tiers[i].hotkey = obs_hotkey_register_source(context, name, description, tier_hotkey_pressed, filter);
+	}
+
 	nv_superres_filter_update(filter, settings);
+	acquire_settings(filter);
+
+	/* There's nothing loaded to hold the initial settings back from */
+	apply_held_settings(filter);
 
 	if (!create_cuda(filter))
 	{
@@ -1435,67 +6192,422 @@ static void* nv_superres_filter_create(obs_data_t* settings, obs_source_t* conte
 		return NULL;
 	}
 
-	debug("nv_superres_filter_create: exiting");
+	debug("nv_superres_filter_create: exiting");
+
+	return filter;
+}
+
+
+
+static bool nv_filter_type_modified(obs_properties_t *ppts, obs_property_t *p, obs_data_t *settings)
+{
+	int type = (int)obs_data_get_int(settings, S_TYPE);
+
+	obs_property_t *p_str = obs_properties_get(ppts, S_STRENGTH);
+	obs_property_t *p_mode = obs_properties_get(ppts, S_MODE_SR);
+	obs_property_t *p_sr_scale = obs_properties_get(ppts, S_SR_SCALE);
+	obs_property_t *p_up_scale = obs_properties_get(ppts, S_UP_SCALE);
+
+	obs_property_set_visible(p_sr_scale, type == S_TYPE_SR);
+	obs_property_set_visible(p_up_scale, type == S_TYPE_UP);
+	obs_property_set_visible(p_str, type == S_TYPE_UP);
+	obs_property_set_visible(p_mode, type == S_TYPE_SR);
+
+	return true;
+}
+
+
+
+static bool ar_pass_toggled(obs_properties_t *ppts, obs_property_t *p,obs_data_t *settings)
+{
+	p = obs_properties_get(ppts, S_MODE_AR);
+	obs_property_set_visible(p, obs_data_get_bool(settings, S_ENABLE_AR));
+
+	return true;
+}
+
+
+
+static bool pipelined_toggled(obs_properties_t *ppts, obs_property_t *p, obs_data_t *settings)
+{
+	p = obs_properties_get(ppts, S_PIPELINED_LATENCY);
+	obs_property_set_visible(p, obs_data_get_bool(settings, S_PIPELINED));
+
+	return true;
+}
+
+
+
+static bool roi_toggled(obs_properties_t *ppts, obs_property_t *p, obs_data_t *settings)
+{
+	const bool enabled = obs_data_get_bool(settings, S_ROI);
+
+	obs_property_set_visible(obs_properties_get(ppts, S_ROI_LEFT), enabled);
+	obs_property_set_visible(obs_properties_get(ppts, S_ROI_TOP), enabled);
+	obs_property_set_visible(obs_properties_get(ppts, S_ROI_WIDTH), enabled);
+	obs_property_set_visible(obs_properties_get(ppts, S_ROI_HEIGHT), enabled);
+
+	return true;
+}
+
+
+
+/*
+* Formats the latency added by pipelining, in frames and in milliseconds at the current OBS frame rate
+* param buffer - output string buffer
+* param len - size of buffer
+*/
+static void pipelined_latency_text(char *buffer, size_t len)
+{
+	const int frames = NV_OUTPUT_RING_SIZE - 1;
+	double frame_ms = 0.0;
+	struct obs_video_info ovi;
+
+	if (obs_get_video_info(&ovi) && ovi.fps_num > 0)
+	{
+		frame_ms = 1000.0 * (double)ovi.fps_den / (double)ovi.fps_num;
+	}
+
+	snprintf(buffer, len, TEXT_PIPELINED_LATENCY, frames, frames * frame_ms);
+}
+
+
+
+void update_validation_messages(obs_properties_t* ppts, struct nv_superresolution_data* filter)
+{
+		bool activateSRWarning = filter->type != S_TYPE_NONE && filter->invalid_sr_size;
+		bool activateARWarning =  filter->apply_ar && filter->invalid_ar_size;
+		bool fatal = is_stopped(filter);
+
+		obs_property_set_visible(obs_properties_get(ppts, S_VALID_TARGET), !fatal && !activateSRWarning && !activateARWarning);
+		obs_property_set_visible(obs_properties_get(ppts, S_FATAL_ERROR), fatal);
+		obs_property_set_visible(obs_properties_get(ppts, S_INVALID_ERROR), !fatal && (activateSRWarning || activateARWarning));
+		obs_property_set_visible(obs_properties_get(ppts, S_INVALID_WARNING_SR), !fatal && activateSRWarning);
+		obs_property_set_visible(obs_properties_get(ppts, S_INVALID_WARNING_AR), !fatal && activateARWarning);
+}
+
+
+
+bool on_verify_clicked(obs_properties_t* ppts, obs_property_t* p, void* data)
+{
+	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)obs_properties_get_param(ppts);
+
+	if (filter)
+	{
+		update_validation_messages(ppts, filter);
+	}
+
+	return true;
+}
+
+
+
+/* The configuration of the effect benchmarked by on_benchmark_clicked, copied so the thread doesn't touch the filter */
+struct nv_benchmark
+{
+	NvVFX_EffectSelector effect;
+	uint32_t mode;
+	uint32_t width;
+	uint32_t height;
+	uint32_t out_width;
+	uint32_t out_height;
+	float range; // the range the effect is fed in, [0, 1] for AR and [0, 255] for SuperRes
+};
+
+/* Only one benchmark runs at a time, they'd skew each other's timings */
+static volatile bool benchmark_running = false;
+
+/* The last benchmark's thread, joined by the next benchmark or when the module unloads, as it uses the SDK to the end */
+static pthread_t benchmark_handle;
+static bool benchmark_joinable = false;
+
+/* Frames timed for each precision, after NV_BENCHMARK_WARMUP untimed ones */
+#define NV_BENCHMARK_FRAMES 60
+#define NV_BENCHMARK_WARMUP 5
+
+
+
+/*
+* Loads the benchmarked effect on buffers of the given precision, runs the pattern through it and times NV_BENCHMARK_FRAMES runs of it.
+* The output is downloaded as f32 into output, for it to be compared between precisions
+* 
+* param bench - the benchmarked effect
+* param comp_type - NVCV_F32 or NVCV_F16, the precision of the effect's input and output
+* param pattern - the synthetic input, BGR f32 planar on the CPU
+* param output - BGR f32 planar on the CPU, set to the effect's output
+* param fps - set to the frames per second the effect ran at
+* return - True if there is no error, False otherwise
+*/
+static bool benchmark_precision(const struct nv_benchmark *bench, NvCVImage_ComponentType comp_type, NvCVImage *pattern, NvCVImage *output,
+				double *fps)
+{
+	NvVFX_Handle handle = NULL;
+	CUstream stream = NULL;
+	NvCVImage *src = NULL;
+	NvCVImage *dst = NULL;
+	NvCVImage *tmp = NULL;
+
+	char model_dir[MAX_PATH];
+	get_nvfx_sdk_path(model_dir, MAX_PATH);
+
+	NvCV_Status vfxErr = NvVFX_CreateEffect(bench->effect, &handle);
+
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvVFX_SetString(handle, NVVFX_MODEL_DIRECTORY, model_dir);
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvVFX_CudaStreamCreate(&stream);
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvVFX_SetCudaStream(handle, NVVFX_CUDA_STREAM, stream);
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvCVImage_Create(bench->width, bench->height, NVCV_BGR, comp_type, NVCV_PLANAR, NVCV_GPU, 1, &src);
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvCVImage_Create(bench->out_width, bench->out_height, NVCV_BGR, comp_type, NVCV_PLANAR, NVCV_GPU, 1, &dst);
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvCVImage_Create(0, 0, NVCV_BGR, NVCV_F32, NVCV_PLANAR, NVCV_GPU, 1, &tmp);
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvVFX_SetImage(handle, NVVFX_INPUT_IMAGE, src);
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvVFX_SetImage(handle, NVVFX_OUTPUT_IMAGE, dst);
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvVFX_SetU32(handle, NVVFX_MODE, bench->mode);
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvVFX_Load(handle);
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvCVImage_Transfer(pattern, src, 1.0f, stream, tmp);
+
+	for (uint32_t i = 0; i < NV_BENCHMARK_WARMUP && NVCV_SUCCESS == vfxErr; ++i)
+	{
+		vfxErr = NvVFX_Run(handle, 1);
+	}
+
+	if (NVCV_SUCCESS == vfxErr && cuStreamSynchronize(stream) != CUDA_SUCCESS)
+	{
+		vfxErr = NVCV_ERR_CUDA;
+	}
+
+	const uint64_t start = os_gettime_ns();
+
+	for (uint32_t i = 0; i < NV_BENCHMARK_FRAMES && NVCV_SUCCESS == vfxErr; ++i)
+	{
+		vfxErr = NvVFX_Run(handle, 1);
+	}
+
+	if (NVCV_SUCCESS == vfxErr && cuStreamSynchronize(stream) != CUDA_SUCCESS)
+	{
+		vfxErr = NVCV_ERR_CUDA;
+	}
+
+	const uint64_t elapsed = os_gettime_ns() - start;
+	*fps = elapsed > 0 ? (double)NV_BENCHMARK_FRAMES * 1000000000.0 / (double)elapsed : 0.0;
+
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvCVImage_Transfer(dst, output, 1.0f, stream, tmp);
+	if (NVCV_SUCCESS == vfxErr && cuStreamSynchronize(stream) != CUDA_SUCCESS)
+		vfxErr = NVCV_ERR_CUDA;
+
+	if (NVCV_SUCCESS != vfxErr)
+	{
+		info("Benchmark: %s failed at %s precision %i: %s", bench->effect, comp_type == NVCV_F16 ? "half" : "full", vfxErr,
+		     NvCV_GetErrorStringFromCode(vfxErr));
+	}
+
+	NvCVImage_Destroy(tmp);
+	NvCVImage_Destroy(dst);
+	NvCVImage_Destroy(src);
+
+	if (handle)
+		NvVFX_DestroyEffect(handle);
+	if (stream)
+		NvVFX_CudaStreamDestroy(stream);
+
+	return NVCV_SUCCESS == vfxErr;
+}
+
+
+
+/*
+* Runs the first planar effect of a filter on full and half precision buffers, and logs the throughput of each and
+* how far apart their outputs are, for the user to judge whether half precision is worth it on their GPU
+*/
+static void *benchmark_thread(void *data)
+{
+	os_set_thread_name("nv_superres_benchmark");
+
+	struct nv_benchmark *bench = (struct nv_benchmark *)data;
+	NvCVImage *pattern = NULL;
+	NvCVImage *out_f32 = NULL;
+	NvCVImage *out_f16 = NULL;
+
+	NvCV_Status vfxErr = NvCVImage_Create(bench->width, bench->height, NVCV_BGR, NVCV_F32, NVCV_PLANAR, NVCV_CPU, 1, &pattern);
+
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvCVImage_Create(bench->out_width, bench->out_height, NVCV_BGR, NVCV_F32, NVCV_PLANAR, NVCV_CPU, 1, &out_f32);
+	if (NVCV_SUCCESS == vfxErr)
+		vfxErr = NvCVImage_Create(bench->out_width, bench->out_height, NVCV_BGR, NVCV_F32, NVCV_PLANAR, NVCV_CPU, 1, &out_f16);
+
+	double fps_f32 = 0.0;
+	double fps_f16 = 0.0;
+
+	if (NVCV_SUCCESS != vfxErr)
+	{
+		error("Benchmark: failed to allocate its images %i: %s", vfxErr, NvCV_GetErrorStringFromCode(vfxErr));
+	}
+	else
+	{
+		nv_fill_planar_pattern((float *)pattern->pixels, (uint32_t)pattern->pitch, bench->width, bench->height, bench->range);
+
+		const bool ran_f32 = benchmark_precision(bench, NVCV_F32, pattern, out_f32, &fps_f32);
+		const bool ran_f16 = ran_f32 && benchmark_precision(bench, NVCV_F16, pattern, out_f16, &fps_f16);
+
+		if (ran_f16)
+		{
+			float max_error;
+			float mean_error;
+			nv_compare_planar((const float *)out_f32->pixels, (uint32_t)out_f32->pitch, (const float *)out_f16->pixels,
+					  (uint32_t)out_f16->pitch, bench->out_width, bench->out_height, &max_error, &mean_error);
+
+			info("Benchmark: %s %ux%u -> %ux%u, full precision %.1f fps, half precision %.1f fps (%.2fx), "
+			     "max error %.5f, mean error %.6f of the [0, %.0f] range",
+			     bench->effect, bench->width, bench->height, bench->out_width, bench->out_height, fps_f32, fps_f16,
+			     fps_f32 > 0.0 ? fps_f16 / fps_f32 : 0.0, max_error, mean_error, bench->range);
+		}
+		else if (ran_f32)
+		{
+			info("Benchmark: %s at full precision %.1f fps, half precision isn't supported", bench->effect, fps_f32);
+		}
+	}
+
+	NvCVImage_Destroy(out_f16);
+	NvCVImage_Destroy(out_f32);
+	NvCVImage_Destroy(pattern);
+	bfree(bench);
 
-	return filter;
+	os_atomic_set_bool(&benchmark_running, false);
+
+	return NULL;
 }
 
 
 
-static bool nv_filter_type_modified(obs_properties_t *ppts, obs_property_t *p, obs_data_t *settings)
+/*
+* Starts a benchmark of the filter's first planar effect at full and half precision, on a thread of its own as it
+* loads the effect twice. Its results are logged
+*/
+static bool on_benchmark_clicked(obs_properties_t *ppts, obs_property_t *p, void *data)
 {
-	int type = (int)obs_data_get_int(settings, S_TYPE);
+	UNUSED_PARAMETER(p);
+	UNUSED_PARAMETER(data);
 
-	obs_property_t *p_str = obs_properties_get(ppts, S_STRENGTH);
-	obs_property_t *p_mode = obs_properties_get(ppts, S_MODE_SR);
-	obs_property_t *p_sr_scale = obs_properties_get(ppts, S_SR_SCALE);
-	obs_property_t *p_up_scale = obs_properties_get(ppts, S_UP_SCALE);
+	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)obs_properties_get_param(ppts);
 
-	obs_property_set_visible(p_sr_scale, type == S_TYPE_SR);
-	obs_property_set_visible(p_up_scale, type == S_TYPE_UP);
-	obs_property_set_visible(p_str, type == S_TYPE_UP);
-	obs_property_set_visible(p_mode, type == S_TYPE_SR);
+	if (!filter || !supports_tiles(filter) || filter->width == 0 || filter->height == 0)
+	{
+		info("Benchmark: half precision only applies to Super Resolution and Artifact Reduction on a valid source");
+		return false;
+	}
 
-	return true;
-}
+	if (os_atomic_set_bool(&benchmark_running, true))
+	{
+		info("Benchmark: already running");
+		return false;
+	}
 
+	/* The last benchmark is done with, or about to return from its thread */
+	if (benchmark_joinable)
+	{
+		pthread_join(benchmark_handle, NULL);
+		benchmark_joinable = false;
+	}
 
+	struct nv_benchmark *bench = (struct nv_benchmark *)bzalloc(sizeof(*bench));
+	bench->width = filter->width;
+	bench->height = filter->height;
 
-static bool ar_pass_toggled(obs_properties_t *ppts, obs_property_t *p,obs_data_t *settings)
-{
-	p = obs_properties_get(ppts, S_MODE_AR);
-	obs_property_set_visible(p, obs_data_get_bool(settings, S_ENABLE_AR));
+	if (filter->apply_ar)
+	{
+		bench->effect = NVVFX_FX_ARTIFACT_REDUCTION;
+		bench->mode = (uint32_t)filter->ar_mode;
+		bench->out_width = filter->width;
+		bench->out_height = filter->height;
+		bench->range = 1.0f;
+	}
+	else
+	{
+		bench->effect = NVVFX_FX_SUPER_RES;
+		bench->mode = (uint32_t)filter->sr_mode;
+		bench->out_width = filter->live.out_width;
+		bench->out_height = filter->live.out_height;
+		bench->range = 255.0f;
+	}
 
-	return true;
+	/* The thread frees the benchmark once it's done, possibly before pthread_create returns */
+	info("Benchmark: running %s at full and half precision", bench->effect);
+
+	if (pthread_create(&benchmark_handle, NULL, benchmark_thread, bench) != 0)
+	{
+		error("Benchmark: failed to start its thread");
+		bfree(bench);
+		os_atomic_set_bool(&benchmark_running, false);
+		return false;
+	}
+
+	benchmark_joinable = true;
+
+	return false;
 }
 
 
 
-void update_validation_messages(obs_properties_t* ppts, struct nv_superresolution_data* filter)
+/*
+* Adds the settings of a quality tier as a group of their own, that's checked when the tier is enabled
+* param properties - the Quality Tiers group
+* param index - the tier, from 1 as tier 0 is the main settings
+*/
+static void add_tier_properties(obs_properties_t *properties, uint32_t index)
 {
-		bool activateSRWarning = filter->type != S_TYPE_NONE && filter->invalid_sr_size;
-		bool activateARWarning =  filter->apply_ar && filter->invalid_ar_size;
-		bool fatal = filter->processing_stopped;
+	obs_properties_t *group = obs_properties_create();
+	char name[32];
 
-		obs_property_set_visible(obs_properties_get(ppts, S_VALID_TARGET), !fatal && !activateSRWarning && !activateARWarning);
-		obs_property_set_visible(obs_properties_get(ppts, S_FATAL_ERROR), fatal);
-		obs_property_set_visible(obs_properties_get(ppts, S_INVALID_ERROR), !fatal && (activateSRWarning || activateARWarning));
-		obs_property_set_visible(obs_properties_get(ppts, S_INVALID_WARNING_SR), !fatal && activateSRWarning);
-		obs_property_set_visible(obs_properties_get(ppts, S_INVALID_WARNING_AR), !fatal && activateARWarning);
-}
+	snprintf(name, sizeof(name), S_TIER_TYPE, index);
+	obs_property_t *type = obs_properties_add_list(group, name, TEXT_FILTER, OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(type, TEXT_FILTER_NONE, S_TYPE_NONE);
 
+	if (nvvfx_supports_sr)
+	{
+		obs_property_list_add_int(type, TEXT_FILTER_SR, S_TYPE_SR);
+	}
+	if (nvvfx_supports_up)
+	{
+		obs_property_list_add_int(type, TEXT_FILTER_UP, S_TYPE_UP);
+	}
 
+	snprintf(name, sizeof(name), S_TIER_SCALE, index);
+	obs_property_t *scale = obs_properties_add_list(group, name, TEXT_SCALE, OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_set_long_description(scale, TEXT_SCALE_DESC);
+	obs_property_list_add_int(scale, TEXT_UPSCALE_SIZE_15x, S_SCALE_15x);
+	obs_property_list_add_int(scale, TEXT_UPSCALE_SIZE_2x, S_SCALE_2x);
+	obs_property_list_add_int(scale, TEXT_UPSCALE_SIZE_3x, S_SCALE_3x);
+	obs_property_list_add_int(scale, TEXT_UPSCALE_SIZE_4x, S_SCALE_4x);
 
-bool on_verify_clicked(obs_properties_t* ppts, obs_property_t* p, void* data)
-{
-	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)obs_properties_get_param(ppts);
+	if (nvvfx_supports_sr)
+	{
+		snprintf(name, sizeof(name), S_TIER_MODE, index);
+		obs_property_t *sr_mode = obs_properties_add_list(group, name, TEXT_SR_MODE, OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+		obs_property_list_add_int(sr_mode, TEXT_SR_MODE_WEAK, S_MODE_WEAK);
+		obs_property_list_add_int(sr_mode, TEXT_SR_MODE_STRONG, S_MODE_STRONG);
+		obs_property_set_long_description(sr_mode, TEXT_UPSCALE_MODE_DESC);
+	}
 
-	if (filter)
+	if (nvvfx_supports_up)
 	{
-		update_validation_messages(ppts, filter);
+		snprintf(name, sizeof(name), S_TIER_STRENGTH, index);
+		obs_properties_add_float_slider(group, name, TEXT_UP_STRENGTH, 0.0, 1.0, 0.05);
 	}
 
-	return true;
+	char description[64];
+	snprintf(description, sizeof(description), TEXT_TIER, index);
+	snprintf(name, sizeof(name), S_TIER, index);
+	obs_properties_add_group(properties, name, description, OBS_GROUP_CHECKABLE, group);
 }
 
 
@@ -1564,6 +6676,59 @@ static obs_properties_t *nv_superres_filter_properties(void *data)
 		obs_property_list_add_int(ar_modes, TEXT_AR_MODE_STRONG, S_MODE_STRONG);
 	}
 
+	obs_property_t *async_run = obs_properties_add_bool(properties, S_ASYNC, TEXT_ASYNC);
+	obs_property_set_long_description(async_run, TEXT_ASYNC_DESC);
+
+	obs_property_t *skip_unchanged = obs_properties_add_bool(properties, S_SKIP_UNCHANGED, TEXT_SKIP_UNCHANGED);
+	obs_property_set_long_description(skip_unchanged, TEXT_SKIP_UNCHANGED_DESC);
+
+	obs_property_t *tiled_updates = obs_properties_add_bool(properties, S_TILED_UPDATES, TEXT_TILED_UPDATES);
+	obs_property_set_long_description(tiled_updates, TEXT_TILED_UPDATES_DESC);
+
+	obs_property_t *tile_oversized = obs_properties_add_bool(properties, S_TILE_OVERSIZED, TEXT_TILE_OVERSIZED);
+	obs_property_set_long_description(tile_oversized, TEXT_TILE_OVERSIZED_DESC);
+
+	obs_property_t *roi = obs_properties_add_bool(properties, S_ROI, TEXT_ROI);
+	obs_property_set_long_description(roi, TEXT_ROI_DESC);
+	obs_property_set_modified_callback(roi, roi_toggled);
+
+	obs_properties_add_int(properties, S_ROI_LEFT, TEXT_ROI_LEFT, 0, S_ROI_MAX, 1);
+	obs_properties_add_int(properties, S_ROI_TOP, TEXT_ROI_TOP, 0, S_ROI_MAX, 1);
+	obs_properties_add_int(properties, S_ROI_WIDTH, TEXT_ROI_WIDTH, 0, S_ROI_MAX, 1);
+	obs_properties_add_int(properties, S_ROI_HEIGHT, TEXT_ROI_HEIGHT, 0, S_ROI_MAX, 1);
+
+	obs_property_t *batch = obs_properties_add_bool(properties, S_BATCH, TEXT_BATCH);
+	obs_property_set_long_description(batch, TEXT_BATCH_DESC);
+
+	obs_property_t *background_reload = obs_properties_add_bool(properties, S_BACKGROUND_RELOAD, TEXT_BACKGROUND_RELOAD);
+	obs_property_set_long_description(background_reload, TEXT_BACKGROUND_RELOAD_DESC);
+
+	obs_property_t *pool_vram = obs_properties_add_int(properties, S_POOL_VRAM, TEXT_POOL_VRAM, 0, S_POOL_VRAM_MAX, 64);
+	obs_property_int_set_suffix(pool_vram, " MB");
+	obs_property_set_long_description(pool_vram, TEXT_POOL_VRAM_DESC);
+
+	obs_properties_t *tier_properties = obs_properties_create();
+
+	for (uint32_t i = 1; i < NV_TIER_MAX; ++i)
+	{
+		add_tier_properties(tier_properties, i);
+	}
+
+	obs_property_t *tiers = obs_properties_add_group(properties, S_TIERS, TEXT_TIERS, OBS_GROUP_CHECKABLE, tier_properties);
+	obs_property_set_long_description(tiers, TEXT_TIERS_DESC);
+
+	obs_property_t *pipelined = obs_properties_add_bool(properties, S_PIPELINED, TEXT_PIPELINED);
+	obs_property_set_long_description(pipelined, TEXT_PIPELINED_DESC);
+	obs_property_set_modified_callback(pipelined, pipelined_toggled);
+
+	char latency_text[256];
+	pipelined_latency_text(latency_text, sizeof(latency_text));
+	obs_properties_add_text(properties, S_PIPELINED_LATENCY, latency_text, OBS_TEXT_INFO);
+
+	obs_property_t *half_precision = obs_properties_add_bool(properties, S_HALF_PRECISION, TEXT_HALF_PRECISION);
+	obs_property_set_long_description(half_precision, TEXT_HALF_PRECISION_DESC);
+	obs_properties_add_button(properties, S_PROPS_BENCHMARK, TEXT_BUTTON_BENCHMARK, on_benchmark_clicked);
+
 	obs_properties_add_button(properties, S_PROPS_VERIFY, TEXT_BUTTON_VERIFY, on_verify_clicked);
 
 	obs_property_t *prop_source_valid_sr = obs_properties_add_text(properties, S_VALID_TARGET, TEXT_VALID_TARGET, OBS_TEXT_INFO);
@@ -1608,21 +6773,206 @@ static void nv_superres_filter_defaults(obs_data_t *settings)
 		obs_data_set_default_double(settings, S_STRENGTH, S_STRENGTH_DEFAULT);
 		obs_data_set_default_int(settings, S_UP_SCALE, S_SCALE_DEFAULT);
 	}
+
+	obs_data_set_default_bool(settings, S_PIPELINED, false);
+	obs_data_set_default_bool(settings, S_HALF_PRECISION, false);
+	obs_data_set_default_bool(settings, S_ASYNC, true);
+	obs_data_set_default_bool(settings, S_SKIP_UNCHANGED, true);
+	obs_data_set_default_bool(settings, S_TILED_UPDATES, false);
+	obs_data_set_default_bool(settings, S_TILE_OVERSIZED, true);
+	obs_data_set_default_bool(settings, S_ROI, false);
+	obs_data_set_default_bool(settings, S_BATCH, false);
+	obs_data_set_default_bool(settings, S_BACKGROUND_RELOAD, true);
+	obs_data_set_default_int(settings, S_POOL_VRAM, S_POOL_VRAM_DEFAULT);
+	obs_data_set_default_bool(settings, S_TIERS, false);
+
+	for (uint32_t i = 1; i < NV_TIER_MAX; ++i)
+	{
+		char name[32];
+
+		snprintf(name, sizeof(name), S_TIER, i);
+		obs_data_set_default_bool(settings, name, false);
+		snprintf(name, sizeof(name), S_TIER_TYPE, i);
+		obs_data_set_default_int(settings, name, nvvfx_supports_up ? S_TYPE_UP : S_TYPE_NONE);
+		snprintf(name, sizeof(name), S_TIER_SCALE, i);
+		obs_data_set_default_int(settings, name, S_SCALE_DEFAULT);
+		snprintf(name, sizeof(name), S_TIER_MODE, i);
+		obs_data_set_default_int(settings, name, S_MODE_DEFAULT);
+		snprintf(name, sizeof(name), S_TIER_STRENGTH, i);
+		obs_data_set_default_double(settings, name, S_STRENGTH_DEFAULT);
+	}
+
+	obs_data_set_default_int(settings, S_ROI_LEFT, 0);
+	obs_data_set_default_int(settings, S_ROI_TOP, 0);
+	obs_data_set_default_int(settings, S_ROI_WIDTH, 0);
+	obs_data_set_default_int(settings, S_ROI_HEIGHT, 0);
+}
+
+
+
+/*
+* Finds the NvCVImage YUV colorspace of an async frame, by matching its color matrix against the ones OBS builds for each colorspace
+* 
+* param frame - the async frame
+* param colorspace - set to the NVCV_ colorspace, range and chroma location flags of the frame
+* return - False if the frame isn't in a colorspace NvCVImage converts from, such as Rec.2100
+*/
+static bool get_frame_yuv_colorspace(const struct obs_source_frame *frame, unsigned *colorspace)
+{
+	const enum video_colorspace spaces[] = { VIDEO_CS_709, VIDEO_CS_601 };
+	const unsigned nv_spaces[] = { NVCV_709, NVCV_601 };
+	const enum video_range_type range = frame->full_range ? VIDEO_RANGE_FULL : VIDEO_RANGE_PARTIAL;
+
+	for (size_t i = 0; i < OBS_COUNTOF(spaces); ++i)
+	{
+		float matrix[16];
+		float range_min[3];
+		float range_max[3];
+
+		if (!video_format_get_parameters_for_format(spaces[i], range, frame->format, matrix, range_min, range_max))
+		{
+			continue;
+		}
+
+		bool equal = true;
+
+		for (size_t j = 0; j < 16 && equal; ++j)
+		{
+			equal = fabsf(matrix[j] - frame->color_matrix[j]) < 1e-4f;
+		}
+
+		if (equal)
+		{
+			*colorspace = nv_spaces[i] | (frame->full_range ? NVCV_FULL_RANGE : NVCV_VIDEO_RANGE) | NVCV_CHROMA_COSITED;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+
+/*
+* Returns true if an async frame can go straight from its planes into the first effect input, rather than through OBS's render
+* of it and our conversion of that render. The first effect has to take BGR f32 planar, which ingest writes without an alpha channel
+* to fill, the frame has to reach us as OBS would draw it, and the input has to be the whole frame in a single pass
+* 
+* param filter - our OBS filter structure
+* param frame - the async frame
+*/
+static bool can_ingest_frame(struct nv_superresolution_data *filter, const struct obs_source_frame *frame)
+{
+	/* TransferFromYUV converts to f32 or u8, half precision inputs take the render route */
+	if (is_stopped(filter) || is_reconfiguring(filter) || !filter->are_images_allocated || !uses_planar_input(filter) ||
+	    filter->live.planar_comp != NVCV_F32)
+	{
+		return false;
+	}
+
+	if (filter->space != GS_CS_SRGB || filter->roi_enabled || filter->tiled_updates || filter->oversized)
+	{
+		return false;
+	}
+
+	/* NvCVImage_TransferFromYUV only takes 8 bit samples, P010 and the other formats are drawn by OBS first */
+	if ((frame->format != VIDEO_FORMAT_NV12 && frame->format != VIDEO_FORMAT_I420) || frame->flip ||
+	    (frame->trc != VIDEO_TRC_DEFAULT && frame->trc != VIDEO_TRC_SRGB))
+	{
+		return false;
+	}
+
+	if (frame->width != filter->width || frame->height != filter->height)
+	{
+		return false;
+	}
+
+	/* Any video filter before us, or deinterlacing, changes the frame from what's drawn to us */
+	obs_source_t *const parent = obs_filter_get_parent(filter->context);
+
+	return parent && obs_filter_get_target(filter->context) == parent &&
+	       obs_source_get_deinterlace_mode(parent) == OBS_DEINTERLACE_MODE_DISABLE;
+}
+
+
+
+/*
+* Copies the planes of an NV12 or I420 async frame to the GPU and converts them into the first effect input in a single
+* NvCVImage_TransferFromYUV, skipping both the render of the source and its ConvertPlanar pass. Our render uses the input as it is
+* when it sees ingested_img is the current first effect input, anything that swaps the input in between, such as a tier switch,
+* makes it render the source instead.
+* Called from nv_superres_filter_video, which OBS calls on the graphics thread right before rendering the source
+* 
+* param filter - our OBS filter structure
+* param frame - the async frame
+* return - True if the frame was converted into the input
+*/
+static bool ingest_frame(struct nv_superresolution_data *filter, const struct obs_source_frame *frame)
+{
+	unsigned colorspace;
+
+	if (!can_ingest_frame(filter, frame) || !get_frame_yuv_colorspace(frame, &colorspace))
+	{
+		return false;
+	}
+
+	/* A frame still waiting on the rest of its batch reads the input we're about to write */
+	if (filter->batch_member && nv_batch_member_pending(filter->batch_member))
+	{
+		nv_batch_flush(batch_service);
+	}
+
+	NvCV_Status vfxErr = NVCV_SUCCESS;
+
+	if (!filter->ingest_tmp)
+	{
+		/* Left empty, the transfer grows it to fit the planes */
+		vfxErr = NvCVImage_Create(0, 0, NVCV_YUV420, NVCV_U8, NVCV_NV12, NVCV_GPU, 0, &filter->ingest_tmp);
+	}
+
+	const bool nv12 = frame->format == VIDEO_FORMAT_NV12;
+	const uint8_t *u = frame->data[1];
+	const uint8_t *v = nv12 ? frame->data[1] + 1 : frame->data[2];
+	NvCVImage *destination = filter->live.ar_handle ? filter->live.gpu_ar_src_img : filter->live.gpu_sr_src_img;
+
+	if (vfxErr == NVCV_SUCCESS)
+	{
+		vfxErr = NvCVImage_TransferFromYUV(frame->data[0], 1, (int)frame->linesize[0], u, v, nv12 ? 2 : 1, (int)frame->linesize[1],
+						   NVCV_YUV420, NVCV_U8, colorspace, NVCV_CPU, destination, NULL,
+						   filter->live.ar_handle ? NV_PLANAR_SCALE_UNIT : NV_PLANAR_SCALE_BYTE, filter->stream, filter->ingest_tmp);
+	}
+
+	/* The render of the source still works, so drop back to it for the rest of this frame rather than failing */
+	if (vfxErr != NVCV_SUCCESS)
+	{
+		debug("ingest_frame: falling back to rendering the source, %s", NvCV_GetErrorStringFromCode(vfxErr));
+		return false;
+	}
+
+	filter->ingested_img = destination;
+	return true;
 }
 
 
 
 /*
 * Called when a video frame available to be processed by the filter
-* We don't do our processing here, as this would require copying this raw data from this frame to the NVFX image buffer every single frame
-* We instead bind an internal texture to an NVFX image allowing its data to be updated by the OBS rendering process automatically
+* 8 bit YUV frames of async sources are converted into the first effect input here when ingest_frame can, as that's a single transfer.
+* Otherwise we don't do our processing here, we instead bind an internal texture to an NVFX image allowing its data to be
+* updated by the OBS rendering process automatically
 * 
-* This function is purely used to inform us that we have a new frame available to process and our old previously processed frame is now invalid
+* This function also informs us that we have a new frame available to process and our old previously processed frame is now invalid
 */
 static struct obs_source_frame *nv_superres_filter_video(void *data, struct obs_source_frame *frame)
 {
 	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)data;
-	filter->got_new_frame = true;
+
+	if (!ingest_frame(filter, frame))
+	{
+		filter->ingested_img = NULL;
+	}
+
+	os_atomic_set_bool(&filter->got_new_frame, true);
 	return frame;
 }
 
@@ -1638,11 +6988,20 @@ static void nv_superres_filter_tick(void *data, float t)
 
 	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)data;
 
-	if (filter->processing_stopped)
+	if (is_stopped(filter))
 	{
 		return;
 	}
 
+	/* The rest of the frame works with this generation of the settings, the render runs after the tick */
+	acquire_settings(filter);
+
+	if (filter->settling && !is_reconfiguring(filter) && os_gettime_ns() - filter->changed_at >= NV_SETTLE_NS)
+	{
+		debug("nv_superres_filter_tick: settings settled");
+		apply_held_settings(filter);
+	}
+
 	obs_source_t *target = obs_filter_get_target(filter->context);
 
 	if (!target)
@@ -1663,14 +7022,34 @@ static void nv_superres_filter_tick(void *data, float t)
 		return;
 	}
 
+	/* With a region of interest, the effects only ever see that part of the source */
+	struct nv_rect roi = {0, 0, cx, cy};
+
+	if (filter->roi_enabled)
+	{
+		get_roi(&filter->roi_setting, cx, cy, &roi);
+	}
+
+	const uint32_t in_cx = roi.width;
+	const uint32_t in_cy = roi.height;
+
 	uint32_t cx_out;
 	uint32_t cy_out;
 
+	/* Sources too large for the effects can be processed in tiles, as long as the pipeline is planar throughout */
+	const bool can_tile = filter->tile_oversized && filter->type != S_TYPE_UP;
+	uint32_t tile_width;
+	uint32_t tile_height;
+	get_tile_size(filter->apply_ar, filter->type, filter->scale, in_cx, in_cy, &tile_width, &tile_height);
+
+	const bool oversized = can_tile && (tile_width < in_cx || tile_height < in_cy);
+
 	if (filter->apply_ar)
 	{
-		get_scale_factor(S_SCALE_AR, cx, cy, &cx_out, &cy_out);
-		filter->is_target_valid = validate_scaling_aspect(cx, cy, cx_out, cy_out);
-		filter->is_target_valid = filter->is_target_valid && validate_source_size(S_SCALE_AR, cx, cy, cx_out, cy_out);
+		get_scale_factor(S_SCALE_AR, in_cx, in_cy, &cx_out, &cy_out);
+		filter->is_target_valid = validate_scaling_aspect(in_cx, in_cy, cx_out, cy_out);
+		filter->is_target_valid = filter->is_target_valid && (validate_source_size(S_SCALE_AR, in_cx, in_cy, cx_out, cy_out) ||
+			(can_tile && validate_tiled_source_size(filter, S_SCALE_AR, in_cx, in_cy)));
 		filter->invalid_ar_size = !filter->is_target_valid;
 	}
 
@@ -1678,16 +7057,45 @@ static void nv_superres_filter_tick(void *data, float t)
 	{
 		if (filter->type != S_TYPE_NONE)
 		{
-			get_scale_factor(filter->scale, cx, cy, &cx_out, &cy_out);
-			filter->is_target_valid = validate_scaling_aspect(cx, cy, cx_out, cy_out);
+			get_scale_factor(filter->scale, in_cx, in_cy, &cx_out, &cy_out);
+			filter->is_target_valid = validate_scaling_aspect(in_cx, in_cy, cx_out, cy_out);
 			if (filter->is_target_valid && filter->type != S_TYPE_UP)
 			{
-				filter->is_target_valid = validate_source_size(filter->scale, cx, cy, cx_out, cy_out);
+				filter->is_target_valid = validate_source_size(filter->scale, in_cx, in_cy, cx_out, cy_out) ||
+					(can_tile && validate_tiled_source_size(filter, filter->scale, in_cx, in_cy));
 			}
 			filter->invalid_sr_size = !filter->is_target_valid;
 		}
 	}
 
+	/* Sizes the effects have rejected before aren't loaded again, the tile pass of an oversized source has sizes of its own */
+	if (filter->is_target_valid && !oversized)
+	{
+		const struct nv_fx_entry ar_config =
+		{
+			.effect = NVVFX_FX_ARTIFACT_REDUCTION,
+			.mode = (uint32_t)filter->ar_mode,
+			.width = in_cx,
+			.height = in_cy,
+			.out_width = in_cx,
+			.out_height = in_cy
+		};
+
+		const struct nv_fx_entry sr_config =
+		{
+			.effect = filter->type == S_TYPE_SR ? NVVFX_FX_SUPER_RES : NVVFX_FX_SR_UPSCALE,
+			.mode = filter->type == S_TYPE_SR ? (uint32_t)filter->sr_mode : 0,
+			.width = in_cx,
+			.height = in_cy,
+			.out_width = cx_out,
+			.out_height = cy_out
+		};
+
+		filter->invalid_ar_size = filter->apply_ar && known_rejected(&ar_config);
+		filter->invalid_sr_size = filter->type != S_TYPE_NONE && known_rejected(&sr_config);
+		filter->is_target_valid = !filter->invalid_ar_size && !filter->invalid_sr_size;
+	}
+
 	if (!filter->is_target_valid)
 	{
 		if (filter->show_size_error)
@@ -1702,14 +7110,70 @@ static void nv_superres_filter_tick(void *data, float t)
 		filter->show_size_error = true;
 	}
 
-	if (cx != filter->width || cy != filter->height || cx_out != filter->out_width || cy_out != filter->out_height)
+	/* The sizes are in use by a reconfiguration, a change is picked up on the first tick after it's done */
+	if (is_reconfiguring(filter))
+	{
+		filter->processed_frame = false;
+		return;
+	}
+
+	/* The output is always the whole source scaled, the region of interest scaled by the effects and the rest stretched */
+	uint32_t frame_cx_out = cx;
+	uint32_t frame_cy_out = cy;
+
+	if (filter->type != S_TYPE_NONE)
+	{
+		get_scale_factor(filter->scale, cx, cy, &frame_cx_out, &frame_cy_out);
+	}
+
+	/* Rather than reloading the effects for every size a source is dragged through, wait for it to settle on one */
+	if (filter->are_images_allocated && (cx != filter->frame_width || cy != filter->frame_height))
+	{
+		if (!filter->resizing || cx != filter->resize_width || cy != filter->resize_height)
+		{
+			filter->resizing = true;
+			filter->resize_width = cx;
+			filter->resize_height = cy;
+			filter->resize_frames = 0;
+		}
+
+		filter->resize_out_width = frame_cx_out;
+		filter->resize_out_height = frame_cy_out;
+
+		if (++filter->resize_frames < NV_RESIZE_SETTLE_FRAMES)
+		{
+			filter->processed_frame = false;
+			return;
+		}
+
+		debug("nv_superres_filter_tick: source settled on %ux%u", cx, cy);
+	}
+
+	filter->resizing = false;
+
+	if (oversized != filter->oversized)
 	{
-		debug("nv_superres_filter_tick: source size changed, or scale changed");
+		debug("nv_superres_filter_tick: source %s tiled", oversized ? "is now" : "is no longer");
+
+		filter->oversized = oversized;
+		filter->are_images_allocated = false;
+	}
 
-		filter->width = cx;
-		filter->height = cy;
-		filter->out_width = cx_out;
-		filter->out_height = cy_out;
+	if (in_cx != filter->width || in_cy != filter->height || cx_out != filter->live.out_width || cy_out != filter->live.out_height ||
+	    cx != filter->frame_width || cy != filter->frame_height || frame_cx_out != filter->live.frame_out_width ||
+	    frame_cy_out != filter->live.frame_out_height || roi.x != filter->roi.x || roi.y != filter->roi.y)
+	{
+		debug("nv_superres_filter_tick: source size changed, scale changed, or region of interest changed");
+
+		filter->width = in_cx;
+		filter->height = in_cy;
+		filter->live.out_width = cx_out;
+		filter->live.out_height = cy_out;
+		filter->frame_width = cx;
+		filter->frame_height = cy;
+		filter->live.frame_out_width = frame_cx_out;
+		filter->live.frame_out_height = frame_cy_out;
+		filter->roi = roi;
 		filter->are_images_allocated = false;
 	}
 
@@ -1771,46 +7235,133 @@ static const char *get_tech_name_and_multiplier(enum gs_color_space current_spac
 		}
 	}
 
-	return tech_name;
+	return tech_name;
+}
+
+
+
+/*
+* Draws our final processed texture to the scene
+* 
+* param - our OBS filter structure
+*/
+static bool draw_superresolution(struct nv_superresolution_data *filter)
+{
+	struct nv_output_slot *slot = &filter->live.outputs[filter->live.draw_index];
+	const enum gs_color_space source_space = slot->hdr ? GS_CS_709_EXTENDED : filter->space;
+	float multiplier;
+	const char *technique = get_tech_name_and_multiplier(gs_get_color_space(), source_space, &multiplier);
+	const enum gs_color_format format = gs_get_format_from_space(source_space);
+	gs_texture_t *scaled_texture = slot->frame_texture ? slot->frame_texture : slot->scaled_texture;
+
+	/* An HDR slot is already linear, unlike the sRGB encoded output the Draw technique expects */
+	if (slot->hdr && strcmp(technique, "Draw") == 0)
+	{
+		technique = "DrawMultiply";
+		multiplier = 1.0f;
+	}
+
+	finish_output_slot(filter, slot);
+
+	if (obs_source_process_filter_begin_with_color_space(filter->context, format, source_space, OBS_ALLOW_DIRECT_RENDERING))
+	{
+		if (source_space != GS_CS_SRGB)
+		{
+			gs_effect_set_texture(filter->upscaled_param, scaled_texture);
+		}
+		else
+		{
+			gs_effect_set_texture_srgb(filter->upscaled_param, scaled_texture);
+		}
+
+		gs_effect_set_float(filter->multiplier_param, multiplier);
+
+		gs_blend_state_push();
+		gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+		/* Stretched to the size the source is settling on while it's being resized */
+		const uint32_t width = filter->resizing ? filter->resize_out_width : filter->live.frame_out_width;
+		const uint32_t height = filter->resizing ? filter->resize_out_height : filter->live.frame_out_height;
+
+		obs_source_process_filter_tech_end(filter->context, filter->effect, width, height, technique);
+
+		gs_blend_state_pop();
+		return true;
+	}
+
+	return false;
 }
 
 
 
 /*
-* Draws our final processed texture to the scene
+* Converts the source render into the format an effect consumes, either BGR f32 planar or RGBA U8 chunky. Must be called within the graphics context
 * 
-* param - our OBS filter structure
+* param filter - our OBS filter structure, filter->render must hold the source render
+* param converted - the texrender to convert into
+* param source_space - the color space of the source render
+* param planar - true to convert into BGR f32 planar, false for RGBA U8 chunky
+* param width - width of the converted image
+* param height - height of the converted image, or of a single plane of it when planar
+* param offset_x, offset_y - position within the source render that pixel (0, 0) of the converted image is loaded from
 */
-static bool draw_superresolution(struct nv_superresolution_data *filter)
+static void convert_source_render(struct nv_superresolution_data *filter, gs_texrender_t *converted, enum gs_color_space source_space,
+				  bool planar, uint32_t width, uint32_t height, uint32_t offset_x, uint32_t offset_y)
 {
-	const enum gs_color_space source_space = filter->space;
-	float multiplier;
-	const char *technique = get_tech_name_and_multiplier(gs_get_color_space(), source_space, &multiplier);
-	const enum gs_color_format format = gs_get_format_from_space(source_space);
+	const uint32_t converted_height = planar ? height * NV_PLANAR_PLANES : height;
+	gs_texrender_reset(converted);
 
-	if (obs_source_process_filter_begin_with_color_space(filter->context, format, source_space, OBS_ALLOW_DIRECT_RENDERING))
+	if (gs_texrender_begin_with_color_space(converted, width, converted_height, GS_CS_SRGB))
 	{
-		if (source_space != GS_CS_SRGB)
+		const bool previous = gs_framebuffer_srgb_enabled();
+		gs_enable_framebuffer_srgb(!planar);
+		gs_enable_blending(false);
+
+		gs_ortho(0.0f, (float)width, 0.0f, (float)converted_height, -100.0f, 100.0f);
+
+		const char *tech_name = planar ? "ConvertPlanar" : "ConvertUnorm";
+		float multiplier = 1.f;
+
+		/* HDR sources are PQ encoded rather than tonemapped, the multiplier brings them to the fraction of 10000 nits PQ covers */
+		if (planar && uses_hdr_path(filter, &filter->live, filter->type))
 		{
-			gs_effect_set_texture(filter->upscaled_param, filter->scaled_texture);
+			tech_name = "ConvertPlanarPQ";
+			multiplier = (source_space == GS_CS_709_SCRGB ? 80.0f : obs_get_video_sdr_white_level()) / 10000.0f;
 		}
-		else
+		else if (source_space == GS_CS_709_EXTENDED)
+		{
+			tech_name = planar ? "ConvertPlanarTonemap" : "ConvertUnormTonemap";
+		}
+		else if (source_space == GS_CS_709_SCRGB)
 		{
-			gs_effect_set_texture_srgb(filter->upscaled_param, filter->scaled_texture);
+			tech_name = planar ? "ConvertPlanarMultiplyTonemap" : "ConvertUnormMultiplyTonemap";
+			multiplier = 80.0f / obs_get_video_sdr_white_level();
 		}
 
+		struct vec2 offset;
+		vec2_set(&offset, (float)offset_x, (float)offset_y);
+
+		gs_effect_set_texture_srgb(filter->image_param, gs_texrender_get_texture(filter->render));
 		gs_effect_set_float(filter->multiplier_param, multiplier);
+		gs_effect_set_vec2(filter->source_offset_param, &offset);
 
-		gs_blend_state_push();
-		gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+		if (planar)
+		{
+			/* The AR pass works on the [0, 1] range, the SuperRes filter on its own is fed [0, 255] */
+			gs_effect_set_int(filter->plane_height_param, (int)height);
+			gs_effect_set_float(filter->planar_scale_param, filter->live.ar_handle ? NV_PLANAR_SCALE_UNIT : NV_PLANAR_SCALE_BYTE);
+		}
 
-		obs_source_process_filter_tech_end(filter->context, filter->effect, filter->out_width, filter->out_height, technique);
+		while (gs_effect_loop(filter->effect, tech_name))
+		{
+			gs_draw(GS_TRIS, 0, 3);
+		}
 
-		gs_blend_state_pop();
-		return true;
-	}
+		gs_texrender_end(converted);
 
-	return false;
+		gs_enable_blending(true);
+		gs_enable_framebuffer_srgb(previous);
+	}
 }
 
 
@@ -1837,13 +7388,13 @@ static void render_source_to_render_tex(struct nv_superresolution_data *filter,
 	gs_blend_state_push();
 	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
 
-	if (gs_texrender_begin_with_color_space(render, filter->width, filter->height, source_space))
+	if (gs_texrender_begin_with_color_space(render, filter->frame_width, filter->frame_height, source_space))
 	{
 		struct vec4 clear_color;
 		vec4_zero(&clear_color);
 		gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
 
-		gs_ortho(0.0f, (float)filter->width, 0.0f, (float)filter->height, -100.0f, 100.0f);
+		gs_ortho(0.0f, (float)filter->frame_width, 0.0f, (float)filter->frame_height, -100.0f, 100.0f);
 
 		if (target == parent && !custom_draw && !async)
 		{
@@ -1856,48 +7407,68 @@ static void render_source_to_render_tex(struct nv_superresolution_data *filter,
 
 		gs_texrender_end(render);
 
-		gs_texrender_t *const render_unorm = filter->render_unorm;
-		gs_texrender_reset(render_unorm);
+		const bool planar = uses_planar_input(filter);
 
-		if (gs_texrender_begin_with_color_space(render_unorm, filter->width, filter->height, GS_CS_SRGB))
+		/* The first effect takes either BGR f32 planar or RGBA U8 chunky, convert our render straight to whichever it is.
+		* 8 bit sRGB sources already are RGBA U8, and are bound from render as they are
+		*/
+		if (!uses_fused_render(filter, source_space))
 		{
-			const bool previous = gs_framebuffer_srgb_enabled();
-			gs_enable_framebuffer_srgb(true);
-			gs_enable_blending(false);
-
-			gs_ortho(0.0f, (float)filter->width, 0.0f, (float)filter->height, -100.0f, 100.0f);
-
-			const char *tech_name = "ConvertUnorm";
-			float multiplier = 1.f;
-
-			if (source_space == GS_CS_709_EXTENDED)
-			{
-				tech_name = "ConvertUnormTonemap";
-			}
-			else if (source_space == GS_CS_709_SCRGB)
+			if (!planar && !filter->render_unorm)
 			{
-				tech_name = "ConvertUnormMultiplyTonemap";
-				multiplier = 80.0f / obs_get_video_sdr_white_level();
+				filter->render_unorm = gs_texrender_create(GS_BGRA_UNORM, GS_ZS_NONE);
+
+				if (!filter->render_unorm)
+				{
+					error("Failed to create render_unorm texrenderer");
+					stop_processing(filter);
+					gs_blend_state_pop();
+					return;
+				}
 			}
 
-			gs_effect_set_texture_srgb(filter->image_param, gs_texrender_get_texture(render));
-			gs_effect_set_float(filter->multiplier_param, multiplier);
-
-			while (gs_effect_loop(filter->effect, tech_name))
+			/* A tier switch can change the precision of the planar buffers, or switch from the Upscaling filter to a planar effect,
+			* render_planar follows it so src_img stays a plain copy
+			*/
+			if (planar && (!filter->render_planar || filter->render_planar_format != planar_format(filter->live.planar_comp)))
 			{
-				gs_draw(GS_TRIS, 0, 3);
+				gs_texrender_destroy(filter->render_planar);
+				filter->render_planar_format = planar_format(filter->live.planar_comp);
+				filter->render_planar = gs_texrender_create(filter->render_planar_format, GS_ZS_NONE);
+				filter->done_initial_render = false;
+
+				if (!filter->render_planar)
+				{
+					error("Failed to create render_planar texrenderer");
+					stop_processing(filter);
+					gs_blend_state_pop();
+					return;
+				}
 			}
 
-			gs_texrender_end(render_unorm);
+			gs_texrender_t *const render_converted = planar ? filter->render_planar : filter->render_unorm;
+			convert_source_render(filter, render_converted, source_space, planar, filter->width, filter->height, filter->roi.x, filter->roi.y);
+		}
 
-			gs_enable_blending(true);
-			gs_enable_framebuffer_srgb(previous);
+		/* With a region of interest only that part is converted for the effects, the rest of the frame is stretched from render_frame */
+		if (filter->render_frame)
+		{
+			convert_source_render(filter, filter->render_frame, source_space, false, filter->frame_width, filter->frame_height, 0, 0);
 		}
 	}
 
 	gs_blend_state_pop();
 
-	if (!filter->done_initial_render)
+	const bool fused = uses_fused_render(filter, source_space);
+	gs_texrender_t *bound_render = fused ? filter->render : uses_planar_input(filter) ? filter->render_planar : filter->render_unorm;
+
+	/* src_img is rebound whenever the source changes between the fused and converted routes, or the texrender recreated its texture.
+	* Rebinding to the texture src_img is already bound to doesn't register it again, see alloc_image_from_texture
+	*/
+	gs_texture_t *const bound_texture = gs_texrender_get_texture(bound_render);
+	const bool texture_changed = bound_texture && (struct ID3D11Texture2D *)gs_texture_get_obj(bound_texture) != filter->src_texture;
+
+	if (!filter->done_initial_render || bound_render != filter->src_render || texture_changed)
 	{
 		debug("render_source_to_render_tex: doing initial texture render");
 
@@ -1911,8 +7482,188 @@ static void render_source_to_render_tex(struct nv_superresolution_data *filter,
 			.alignment = 1
 		};
 
-		filter->done_initial_render = alloc_image_from_texrender(filter, &params, filter->render_unorm);
+		if (uses_planar_input(filter))
+		{
+			params.height = filter->height * NV_PLANAR_PLANES;
+			params.pixel_fmt = NVCV_Y;
+			params.comp_type = filter->live.planar_comp;
+		}
+
+		/* Nothing was converted for this frame if the fused route fails, the next one takes the converted route */
+		filter->done_initial_render = fused ? bind_fused_render(filter, &params) : alloc_image_from_texrender(filter, &params, bound_render);
+		filter->src_render = filter->done_initial_render ? bound_render : NULL;
+	}
+}
+
+
+
+/*
+* Runs a pass of the fingerprint reduction into a texrender. Must be called within the graphics context
+* 
+* param filter - our OBS filter structure
+* param render - the texrender to reduce into
+* param size - the size of the square render, in cells
+* param technique - FingerprintPartial or Fingerprint
+* return - True if the pass was drawn
+*/
+static bool reduce_fingerprint(struct nv_superresolution_data *filter, gs_texrender_t *render, uint32_t size, const char *technique)
+{
+	gs_texrender_reset(render);
+
+	if (!gs_texrender_begin(render, size, size))
+	{
+		return false;
+	}
+
+	gs_ortho(0.0f, (float)size, 0.0f, (float)size, -100.0f, 100.0f);
+
+	while (gs_effect_loop(filter->effect, technique))
+	{
+		gs_draw(GS_TRIS, 0, 3);
+	}
+
+	gs_texrender_end(render);
+
+	return true;
+}
+
+
+
+/*
+* Takes the fingerprint of the converted render of our source with the FingerprintPartial and Fingerprint shader passes, and compares
+* the one taken on the previous frame to the one before it. The readback lags a frame behind so it's never waited on, a change is
+* only seen a frame after it happened, and an unchanged frame is only skipped once its predecessor is known to be the same.
+* The readback is only NV_FINGERPRINT_GRID squared pixels
+* 
+* param filter - our OBS filter structure
+* return - True if the source changed between the last two frames read back, or there is no fingerprint to compare to
+*/
+static bool source_frame_changed(struct nv_superresolution_data *filter)
+{
+	const bool planar = uses_planar_input(filter);
+	gs_texrender_t *const converted = filter->src_render;
+
+	/* The fingerprints kept for the output slots were taken with other settings */
+	const bool had_fingerprint = filter->fingerprint_valid;
+
+	if (!had_fingerprint)
+	{
+		for (uint32_t i = 0; i < NV_OUTPUT_RING_SIZE; ++i)
+		{
+			filter->live.outputs[i].has_fingerprint = false;
+		}
+	}
+
+	filter->fingerprint_valid = false;
+
+	gs_blend_state_push();
+	gs_enable_blending(false);
+
+	gs_effect_set_texture(filter->image_param, gs_texrender_get_texture(converted));
+	gs_effect_set_int(filter->plane_height_param, planar ? (int)filter->height : 0);
+	gs_effect_set_float(filter->planar_scale_param, filter->live.ar_handle ? NV_PLANAR_SCALE_UNIT : NV_PLANAR_SCALE_BYTE);
+	gs_effect_set_int(filter->source_width_param, (int)filter->width);
+	gs_effect_set_int(filter->source_height_param, (int)filter->height);
+
+	bool reduced = reduce_fingerprint(filter, filter->fingerprint_partial, NV_FINGERPRINT_GRID * NV_FINGERPRINT_SPLIT, "FingerprintPartial");
+
+	if (reduced)
+	{
+		gs_effect_set_texture(filter->image_param, gs_texrender_get_texture(filter->fingerprint_partial));
+		reduced = reduce_fingerprint(filter, filter->fingerprint_render, NV_FINGERPRINT_GRID, "Fingerprint");
+	}
+
+	gs_blend_state_pop();
+
+	if (!reduced)
+	{
+		return true;
+	}
+
+	const uint32_t staged = filter->fingerprint_stage;
+	const uint32_t previous = (staged + 1) % NV_FINGERPRINT_STAGES;
+
+	gs_stage_texture(filter->fingerprint_stages[staged], gs_texrender_get_texture(filter->fingerprint_render));
+	filter->fingerprint_staged[staged] = true;
+	filter->fingerprint_stage = previous;
+
+	uint8_t *data;
+	uint32_t linesize;
+
+	if (!filter->fingerprint_staged[previous] || !gs_stagesurface_map(filter->fingerprint_stages[previous], &data, &linesize))
+	{
+		return true;
+	}
+
+	struct nv_fingerprint current;
+	const size_t row_size = sizeof(current.cells[0]) * NV_FINGERPRINT_GRID;
+
+	for (uint32_t y = 0; y < NV_FINGERPRINT_GRID; ++y)
+	{
+		memcpy(current.cells[y * NV_FINGERPRINT_GRID], data + (size_t)y * linesize, row_size);
+	}
+
+	gs_stagesurface_unmap(filter->fingerprint_stages[previous]);
+	filter->fingerprint_staged[previous] = false;
+
+	const bool changed = !had_fingerprint || !nv_fingerprint_equal(&current, &filter->fingerprint);
+
+	filter->fingerprint = current;
+	filter->fingerprint_valid = true;
+
+	return changed;
+}
+
+
+
+/*
+* Draws the source stretched to the current output size with the Stretch pass, bilinearly filtered, for when there's no processed frame to stretch.
+* Rendered in the color space of the canvas, so the source is converted to it by OBS rather than by the pass
+* 
+* param filter - our OBS filter structure
+*/
+static void draw_stretched_source(struct nv_superresolution_data *filter)
+{
+	const enum gs_color_space space = gs_get_color_space();
+	const uint32_t width = filter->resizing ? filter->resize_out_width : filter->live.frame_out_width;
+	const uint32_t height = filter->resizing ? filter->resize_out_height : filter->live.frame_out_height;
+
+	/* Without an upscale the output is the size of the source, which is passed through. Direct rendering would draw it at its own size */
+	if (filter->type == S_TYPE_NONE ||
+	    !obs_source_process_filter_begin_with_color_space(filter->context, gs_get_format_from_space(space), space, OBS_NO_DIRECT_RENDERING))
+	{
+		obs_source_skip_video_filter(filter->context);
+		return;
+	}
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+	obs_source_process_filter_tech_end(filter->context, filter->effect, width, height, "Stretch");
+
+	gs_blend_state_pop();
+}
+
+
+
+/*
+* Draws the last frame processed, stretched to the current output size, while the filter is being reconfigured or the source is being resized.
+* The source is stretched instead if there isn't a frame that's ready to be drawn as it is
+* 
+* param filter - our OBS filter structure
+*/
+static void draw_previous_output(struct nv_superresolution_data *filter)
+{
+	const struct nv_output_slot *slot = &filter->live.outputs[filter->live.draw_index];
+
+	/* Finishing the slot would use the new sizes during a reconfiguration, only a slot that's already been drawn is used then */
+	if (!slot->ready || (is_reconfiguring(filter) && (slot->in_flight || slot->needs_resolve || slot->needs_compose)))
+	{
+		draw_stretched_source(filter);
+		return;
 	}
+
+	draw_superresolution(filter);
 }
 
 
@@ -1924,7 +7675,7 @@ static void nv_superres_filter_render(void *data, gs_effect_t *effect)
 
 	struct nv_superresolution_data *filter = (struct nv_superresolution_data *)data;
 
-	if (filter->processing_stopped)
+	if (is_stopped(filter))
 	{
 		obs_source_skip_video_filter(filter->context);
 		return;
@@ -1954,70 +7705,55 @@ static void nv_superres_filter_render(void *data, gs_effect_t *effect)
 	//	signal_handler_connect(filter->handler, "update", nv_superres_filter_reset, filter);
 	//}
 
-	if (filter->destroy_ar)
+	/* A frame waiting on the rest of its batch still points at buffers that may be destroyed or reallocated below */
+	if (filter->batch_member && nv_batch_member_pending(filter->batch_member))
 	{
-		debug("nv_superres_filter_render: Destroying AR");
-
-		nv_destroy_fx_filter(&filter->ar_handle, &filter->gpu_ar_src_img, &filter->gpu_ar_dst_img);
-		filter->destroy_ar = false;
+		nv_batch_flush(batch_service);
 	}
 
-	if (filter->destroy_sr)
+	const enum gs_color_space preferred_spaces[] =
 	{
-		debug("nv_superres_filter_render: Destroying SR");
-
-		if (filter->gpu_dst_tmp_img)
-		{
-			debug("nv_superres_filter_render: Destroying Upscale texture");
-
-			NvCVImage_Destroy(filter->gpu_dst_tmp_img);
-			filter->gpu_dst_tmp_img = NULL;
-		}
+		GS_CS_SRGB,
+		GS_CS_SRGB_16F,
+		GS_CS_709_EXTENDED,
+	};
 
-		nv_destroy_fx_filter(&filter->sr_handle, &filter->gpu_sr_src_img, &filter->gpu_sr_dst_img);
-		filter->destroy_sr = false;
-	}
+	const enum gs_color_space source_space = obs_source_get_color_space(target, OBS_COUNTOF(preferred_spaces), preferred_spaces);
 
-	if (!initialize_fx(filter))
+	if (is_reconfiguring(filter) && os_atomic_load_bool(&filter->reconfig.done) && !finish_reconfigure(filter))
 	{
 		obs_source_skip_video_filter(filter->context);
 		return;
 	}
 
-	/* Skip drawing if the user has turned everything off */
-	if (!filter->ar_handle && !filter->sr_handle)
+	/* Before deciding on a reconfiguration, switching to a parked tier doesn't need one */
+	if (!is_reconfiguring(filter))
 	{
-		obs_source_skip_video_filter(filter->context);
-		return;
+		update_tiers(filter);
 	}
 
-	const enum gs_color_space preferred_spaces[] =
+	if (!is_reconfiguring(filter) && needs_reconfigure(filter, source_space) && !start_reconfigure(filter, source_space))
 	{
-		GS_CS_SRGB,
-		GS_CS_SRGB_16F,
-		GS_CS_709_EXTENDED,
-	};
-
-	const enum gs_color_space source_space = obs_source_get_color_space(target, OBS_COUNTOF(preferred_spaces), preferred_spaces);
+		obs_source_skip_video_filter(filter->context);
+		return;
+	}
 
-	if (filter->space != source_space || !filter->are_images_allocated)
+	/* Keep showing the last frame until the effects are ready again, or the source has settled on a size */
+	if (is_reconfiguring(filter) || filter->resizing)
 	{
-		debug("nv_superres_filter_render: Initializing Images");
-
-		filter->space = source_space;
-		if (!init_images(filter))
-		{
-			obs_source_skip_video_filter(filter->context);
-			return;
-		}
+		draw_previous_output(filter);
+		return;
 	}
 
-	if (!reload_fx(filter))
+	/* Skip drawing if the user has turned everything off */
+	if (!filter->live.ar_handle && !filter->live.sr_handle)
 	{
 		obs_source_skip_video_filter(filter->context);
 		return;
 	}
 
+	update_batch_member(filter);
+
 		/* We're waiting for the source to report a valid size for the render textures to be ready. We cannot continue until they are. */
 	if (!filter->render)
 	{
@@ -2028,19 +7764,56 @@ static void nv_superres_filter_render(void *data, gs_effect_t *effect)
 	const uint32_t target_flags = obs_source_get_output_flags(target);
 	bool async = (target_flags & OBS_SOURCE_ASYNC) != 0;
 
+	/* An ingested frame is only used if it went into the input the effects still take, it's rendered again otherwise */
+	const bool ingested = filter->ingested_img && filter->ingested_img == (filter->live.ar_handle ? filter->live.gpu_ar_src_img : filter->live.gpu_sr_src_img);
+
 	/* Render our source out to the render texture, getting it ready for the pipeline */
-	render_source_to_render_tex(filter, target, parent);
+	if (!ingested)
+	{
+		filter->ingested_img = NULL;
+		render_source_to_render_tex(filter, target, parent);
+	}
 
 	/* If we actually have a valid texture to render, process it and draw it */
-	if (filter->done_initial_render && filter->are_images_allocated)
+	if ((ingested || filter->done_initial_render) && filter->are_images_allocated)
 	{
 		bool draw = true;
 
 		/* limit processing of the video frames to the main source instance, and only when there's actually a new frame */
-		if (!async || filter->got_new_frame)
+		const bool new_frame = os_atomic_set_bool(&filter->got_new_frame, false);
+
+		if (!async || new_frame)
+		{
+			/* Non async sources are rendered every tick, only run the effects again when what they rendered actually changed.
+			* Tiled updates need the fingerprint of every frame to find the parts of it that changed */
+			const bool skip = !async && filter->skip_unchanged;
+			const bool changed = (skip || filter->tiled_updates) ? source_frame_changed(filter) : true;
+
+			if (skip && !changed && filter->live.outputs[filter->live.output_index].ready)
+			{
+				filter->live.draw_index = filter->live.output_index;
+
+				/* The fingerprint only covers the region of interest, the rest of the source is stretched from the current frame */
+				stretch_surround(filter, &filter->live.outputs[filter->live.draw_index]);
+			}
+			else
+			{
+				const uint32_t previous = filter->live.output_index;
+				draw = process_texture_superres(filter);
+
+				/* When pipelining, draw the frame finished last time rather than the one that was just submitted */
+				filter->live.draw_index = filter->pipelined && filter->live.outputs[previous].ready ? previous : filter->live.output_index;
+
+				if (!draw)
+				{
+					filter->fingerprint_valid = false;
+				}
+			}
+		}
+		else
 		{
-			filter->got_new_frame = false;
-			draw = process_texture_superres(filter);
+			/* No new frame, the last one processed has had a whole frame to finish */
+			filter->live.draw_index = filter->live.output_index;
 		}
 
 		if (draw)
@@ -2068,7 +7841,9 @@ static enum gs_color_space nv_superres_filter_get_color_space(void *data, size_t
 
 	struct nv_superresolution_data *const filter = (struct nv_superresolution_data *)data;
 
-	const enum gs_color_space source_space = obs_source_get_color_space(obs_filter_get_target(filter->context), OBS_COUNTOF(potential_spaces), potential_spaces);
+	/* HDR output is drawn as GS_CS_709_EXTENDED whichever HDR space the source renders in, see uses_hdr_path */
+	const enum gs_color_space source_space = filter->live.outputs[filter->live.draw_index].hdr ? GS_CS_709_EXTENDED :
+		obs_source_get_color_space(obs_filter_get_target(filter->context), OBS_COUNTOF(potential_spaces), potential_spaces);
 
 	enum gs_color_space space = source_space;
 
@@ -2091,7 +7866,12 @@ static uint32_t nv_superres_filter_width(void *data)
 {
 	struct nv_superresolution_data *const filter = (struct nv_superresolution_data *)data;
 
-	return (filter->type != S_TYPE_NONE && filter->is_target_valid && !filter->processing_stopped) ? filter->out_width : filter->target_width;
+	if (filter->type == S_TYPE_NONE || !filter->is_target_valid || is_stopped(filter))
+	{
+		return filter->target_width;
+	}
+
+	return filter->resizing ? filter->resize_out_width : filter->live.frame_out_width;
 }
 
 
@@ -2100,7 +7880,12 @@ static uint32_t nv_superres_filter_height(void *data)
 {
 	struct nv_superresolution_data *const filter = (struct nv_superresolution_data *)data;
 	
-	return (filter->type != S_TYPE_NONE && filter->is_target_valid && !filter->processing_stopped) ? filter->out_height : filter->target_height;
+	if (filter->type == S_TYPE_NONE || !filter->is_target_valid || is_stopped(filter))
+	{
+		return filter->target_height;
+	}
+
+	return filter->resizing ? filter->resize_out_height : filter->live.frame_out_height;
 }
 
 
@@ -2118,7 +7903,7 @@ static void nv_superres_filter_activate(void *data)
 	struct nv_superresolution_data *const filter = (struct nv_superresolution_data *)data;
 
 	filter->processed_frame = false;
-	filter->got_new_frame = true;
+	os_atomic_set_bool(&filter->got_new_frame, true);
 }
 
 
@@ -2145,6 +7930,62 @@ struct obs_source_info nvidia_superresolution_filter_info = {
 
 
 
+/*
+* Makes the device's primary context, which the CUDA runtime and so NvVFX run in, current on the calling thread.
+* Only needed on threads the runtime hasn't run on yet, called with the arena's lock held
+* return - True if the context is current
+*/
+static bool make_arena_context_current(void)
+{
+	if (!arena_context && (cuDeviceGet(&arena_device, 0) != CUDA_SUCCESS || cuDevicePrimaryCtxRetain(&arena_context, arena_device) != CUDA_SUCCESS))
+	{
+		arena_context = NULL;
+		return false;
+	}
+
+	return cuCtxSetCurrent(arena_context) == CUDA_SUCCESS;
+}
+
+
+
+/* Reserves a chunk of device memory for the arena, see struct nv_arena_backend */
+static uint64_t reserve_arena_chunk(void *context, size_t bytes)
+{
+	UNUSED_PARAMETER(context);
+
+	CUdeviceptr address = 0;
+	CUresult cuErr = cuMemAlloc(&address, bytes);
+
+	if (cuErr == CUDA_ERROR_INVALID_CONTEXT && make_arena_context_current())
+	{
+		cuErr = cuMemAlloc(&address, bytes);
+	}
+
+	/* The image is allocated by NvCVImage on its own instead */
+	if (cuErr != CUDA_SUCCESS)
+	{
+		info("Failed to reserve %zu bytes for the image arena (%i)", bytes, cuErr);
+		return 0;
+	}
+
+	return address;
+}
+
+
+
+/* Releases a chunk of device memory reserved for the arena, see struct nv_arena_backend */
+static void release_arena_chunk(void *context, uint64_t address)
+{
+	UNUSED_PARAMETER(context);
+
+	if (cuMemFree(address) == CUDA_ERROR_INVALID_CONTEXT && make_arena_context_current())
+	{
+		cuMemFree(address);
+	}
+}
+
+
+
 bool load_nv_superresolution_filter(void)
 {
 	debug("load_nv_superresolution_filter: Entering");
@@ -2155,12 +7996,27 @@ bool load_nv_superresolution_filter(void)
 
 	if (nvvfx_loaded)
 	{
+		pthread_mutex_init(&fx_cache_mutex, NULL);
+		pthread_mutex_init(&caps_mutex, NULL);
+
 		if (cstr != NULL && strnlen_s(cstr, 3) > 1)
 		{
 			nvvfx_supports_ar = strstr(cstr, NVVFX_FX_ARTIFACT_REDUCTION) != NULL;
 			nvvfx_supports_sr = strstr(cstr, NVVFX_FX_SUPER_RES) != NULL;
 			nvvfx_supports_up = strstr(cstr, NVVFX_FX_SR_UPSCALE) != NULL;
 		}
+
+		load_capabilities();
+
+		const struct nv_arena_backend arena_backend = {reserve_arena_chunk, release_arena_chunk, NULL};
+		gpu_arena = nv_arena_create(&arena_backend, NV_ARENA_CHUNK_BYTES, NV_ARENA_PITCH_ALIGN);
+
+		/* The chunks are reserved when the images need them instead */
+		if (gpu_arena)
+		{
+			nv_arena_reserve(gpu_arena, NV_ARENA_CHUNK_BYTES);
+		}
+
 		obs_register_source(&nvidia_superresolution_filter_info);
 	}
 	else
@@ -2182,3 +8038,38 @@ bool load_nv_superresolution_filter(void)
 	debug("load_nv_superresolution_filter: exiting");
 	return nvvfx_loaded;
 }
+
+
+
+void unload_nv_superresolution_filter(void)
+{
+	/* A running benchmark still uses the SDK and the CUDA driver */
+	if (benchmark_joinable)
+	{
+		pthread_join(benchmark_handle, NULL);
+		benchmark_joinable = false;
+	}
+
+	/* Every filter has left its batch group by now, which destroyed the groups' effects with them */
+	nv_batch_service_destroy(batch_service);
+	batch_service = NULL;
+
+	/* Likewise every effect and stream has been released by its last filter */
+	if (nvvfx_loaded)
+	{
+		pthread_mutex_destroy(&fx_cache_mutex);
+
+		save_capabilities();
+		pthread_mutex_destroy(&caps_mutex);
+
+		/* Every image has been destroyed with its filter */
+		nv_arena_destroy(gpu_arena);
+		gpu_arena = NULL;
+
+		if (arena_context)
+		{
+			cuDevicePrimaryCtxRelease(arena_device);
+			arena_context = NULL;
+		}
+	}
+}
@@ -25,6 +25,7 @@ OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE(PLUGIN_NAME, "en-US")
 
 extern bool load_nv_superresolution_filter(void);
+extern void unload_nv_superresolution_filter(void);
 
 bool obs_module_load(void)
 {
@@ -40,5 +41,6 @@ bool obs_module_load(void)
 
 void obs_module_unload(void)
 {
+	unload_nv_superresolution_filter();
 	obs_log(LOG_INFO, "plugin unloaded");
 }
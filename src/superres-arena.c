@@ -0,0 +1,368 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <stdlib.h>
+#include <util/threading.h>
+#include "superres-arena.h"
+
+/* A range of a chunk, either a block handed out or free. The ranges of a chunk cover it end to end, in address order */
+struct arena_range
+{
+	uint64_t offset;
+	uint64_t size;
+	uint64_t wasted; // of a block, the bytes that are only padding or rounding
+	bool used;
+	struct arena_range *prev;
+	struct arena_range *next;
+};
+
+struct arena_chunk
+{
+	uint64_t address;
+	uint64_t size;
+	uint32_t blocks; // ranges handed out
+	bool kept; // reserved by nv_arena_reserve, never trimmed
+	struct arena_range *ranges;
+	struct arena_chunk *next;
+};
+
+struct nv_arena
+{
+	struct nv_arena_backend backend;
+	size_t chunk_bytes;
+	size_t pitch_alignment;
+	pthread_mutex_t mutex;
+	struct arena_chunk *chunks; // in the order they were reserved, earlier chunks are filled first
+	struct nv_arena_stats stats;
+};
+
+
+
+/* Rounds a size up to a multiple of a power of 2 */
+static inline uint64_t round_up(uint64_t size, uint64_t alignment)
+{
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+
+
+struct nv_arena *nv_arena_create(const struct nv_arena_backend *backend, size_t chunk_bytes, uint32_t pitch_alignment)
+{
+	struct nv_arena *arena = (struct nv_arena *)calloc(1, sizeof(*arena));
+
+	if (!arena)
+	{
+		return NULL;
+	}
+
+	arena->backend = *backend;
+	arena->chunk_bytes = (size_t)round_up(chunk_bytes, NV_ARENA_BLOCK_ALIGN);
+	arena->pitch_alignment = pitch_alignment > 0 ? pitch_alignment : 1;
+	pthread_mutex_init(&arena->mutex, NULL);
+
+	return arena;
+}
+
+
+
+/* Releases a chunk back to the backend and frees its ranges, the chunk must already be unlinked */
+static void release_chunk(struct nv_arena *arena, struct arena_chunk *chunk)
+{
+	arena->backend.release(arena->backend.context, chunk->address);
+	arena->stats.reserved -= chunk->size;
+	arena->stats.chunks--;
+
+	for (struct arena_range *range = chunk->ranges; range;)
+	{
+		struct arena_range *next = range->next;
+		free(range);
+		range = next;
+	}
+
+	free(chunk);
+}
+
+
+
+void nv_arena_destroy(struct nv_arena *arena)
+{
+	if (!arena)
+	{
+		return;
+	}
+
+	while (arena->chunks)
+	{
+		struct arena_chunk *chunk = arena->chunks;
+		arena->chunks = chunk->next;
+		release_chunk(arena, chunk);
+	}
+
+	pthread_mutex_destroy(&arena->mutex);
+	free(arena);
+}
+
+
+
+size_t nv_arena_pitch(const struct nv_arena *arena, size_t row_bytes)
+{
+	return (size_t)round_up(row_bytes, arena->pitch_alignment);
+}
+
+
+
+/* Reserves a chunk of at least size bytes and appends it to the arena, returns NULL if the backend couldn't */
+static struct arena_chunk *reserve_chunk(struct nv_arena *arena, uint64_t size)
+{
+	struct arena_chunk *chunk = (struct arena_chunk *)calloc(1, sizeof(*chunk));
+	struct arena_range *range = (struct arena_range *)calloc(1, sizeof(*range));
+	const uint64_t address = chunk && range ? arena->backend.reserve(arena->backend.context, (size_t)size) : 0;
+
+	if (!address)
+	{
+		free(range);
+		free(chunk);
+		return NULL;
+	}
+
+	range->size = size;
+	chunk->address = address;
+	chunk->size = size;
+	chunk->ranges = range;
+
+	struct arena_chunk **tail = &arena->chunks;
+
+	while (*tail)
+	{
+		tail = &(*tail)->next;
+	}
+
+	*tail = chunk;
+
+	arena->stats.reserved += size;
+	arena->stats.chunks++;
+	arena->stats.reservations++;
+
+	return chunk;
+}
+
+
+
+uint64_t nv_arena_alloc(struct nv_arena *arena, size_t bytes, size_t padding, size_t *capacity)
+{
+	const uint64_t size = round_up(bytes > 0 ? bytes : 1, NV_ARENA_BLOCK_ALIGN);
+	uint64_t address = 0;
+
+	pthread_mutex_lock(&arena->mutex);
+
+	struct arena_chunk *chunk;
+	struct arena_range *range = NULL;
+
+	for (chunk = arena->chunks; chunk; chunk = chunk->next)
+	{
+		for (range = chunk->ranges; range; range = range->next)
+		{
+			if (!range->used && range->size >= size)
+			{
+				break;
+			}
+		}
+
+		if (range)
+		{
+			break;
+		}
+	}
+
+	if (!range)
+	{
+		chunk = reserve_chunk(arena, size > arena->chunk_bytes ? size : arena->chunk_bytes);
+		range = chunk ? chunk->ranges : NULL;
+	}
+
+	if (range)
+	{
+		/* What's left of the range stays free after the block */
+		if (range->size > size)
+		{
+			struct arena_range *rest = (struct arena_range *)calloc(1, sizeof(*rest));
+
+			if (rest)
+			{
+				rest->offset = range->offset + size;
+				rest->size = range->size - size;
+				rest->prev = range;
+				rest->next = range->next;
+
+				if (range->next)
+				{
+					range->next->prev = rest;
+				}
+
+				range->next = rest;
+				range->size = size;
+			}
+		}
+
+		range->used = true;
+		range->wasted = range->size - bytes + padding;
+		chunk->blocks++;
+
+		arena->stats.used += range->size;
+		arena->stats.wasted += range->wasted;
+		arena->stats.blocks++;
+
+		address = chunk->address + range->offset;
+
+		if (capacity)
+		{
+			*capacity = (size_t)range->size;
+		}
+	}
+
+	pthread_mutex_unlock(&arena->mutex);
+
+	return address;
+}
+
+
+
+/* Merges a free range with the free range following it */
+static void merge_next(struct arena_range *range)
+{
+	struct arena_range *next = range->next;
+
+	range->size += next->size;
+	range->next = next->next;
+
+	if (next->next)
+	{
+		next->next->prev = range;
+	}
+
+	free(next);
+}
+
+
+
+void nv_arena_free(struct nv_arena *arena, uint64_t address)
+{
+	if (!address)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&arena->mutex);
+
+	for (struct arena_chunk *chunk = arena->chunks; chunk; chunk = chunk->next)
+	{
+		if (address < chunk->address || address >= chunk->address + chunk->size)
+		{
+			continue;
+		}
+
+		struct arena_range *range = chunk->ranges;
+
+		while (range && range->offset != address - chunk->address)
+		{
+			range = range->next;
+		}
+
+		if (range && range->used)
+		{
+			range->used = false;
+			chunk->blocks--;
+
+			arena->stats.used -= range->size;
+			arena->stats.wasted -= range->wasted;
+			arena->stats.blocks--;
+
+			if (range->next && !range->next->used)
+			{
+				merge_next(range);
+			}
+
+			if (range->prev && !range->prev->used)
+			{
+				merge_next(range->prev);
+			}
+		}
+
+		break;
+	}
+
+	pthread_mutex_unlock(&arena->mutex);
+}
+
+
+
+bool nv_arena_reserve(struct nv_arena *arena, size_t bytes)
+{
+	bool success = true;
+
+	pthread_mutex_lock(&arena->mutex);
+
+	for (uint64_t reserved = 0; reserved < bytes && success; reserved += arena->chunk_bytes)
+	{
+		struct arena_chunk *chunk = reserve_chunk(arena, arena->chunk_bytes);
+
+		if (chunk)
+		{
+			chunk->kept = true;
+		}
+
+		success = chunk != NULL;
+	}
+
+	pthread_mutex_unlock(&arena->mutex);
+
+	return success;
+}
+
+
+
+void nv_arena_trim(struct nv_arena *arena)
+{
+	pthread_mutex_lock(&arena->mutex);
+
+	for (struct arena_chunk **link = &arena->chunks; *link;)
+	{
+		struct arena_chunk *chunk = *link;
+
+		if (chunk->blocks == 0 && !chunk->kept)
+		{
+			*link = chunk->next;
+			release_chunk(arena, chunk);
+		}
+		else
+		{
+			link = &chunk->next;
+		}
+	}
+
+	pthread_mutex_unlock(&arena->mutex);
+}
+
+
+
+void nv_arena_get_stats(struct nv_arena *arena, struct nv_arena_stats *stats)
+{
+	pthread_mutex_lock(&arena->mutex);
+	*stats = arena->stats;
+	pthread_mutex_unlock(&arena->mutex);
+}
@@ -0,0 +1,103 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Blocks start on, and are sized in, multiples of this, as cudaMalloc aligns its allocations */
+#define NV_ARENA_BLOCK_ALIGN 256
+
+/* Reserves and releases the device memory an arena sub-allocates from, the plugin provides one on top of cuMemAlloc */
+struct nv_arena_backend
+{
+	/* Reserves bytes of device memory, returns its address or 0 on failure */
+	uint64_t (*reserve)(void *context, size_t bytes);
+	void (*release)(void *context, uint64_t address);
+	void *context;
+};
+
+/* What an arena holds, for logging */
+struct nv_arena_stats
+{
+	uint64_t reserved; // bytes reserved from the backend
+	uint64_t used; // bytes of the blocks handed out
+	uint64_t wasted; // bytes of the used ones that are only row padding or block rounding
+	uint32_t chunks; // reservations currently held
+	uint32_t blocks; // blocks currently handed out
+	uint64_t reservations; // times the arena went to the backend since it was created
+};
+
+struct nv_arena;
+
+/*
+* Creates an arena, which reserves device memory from its backend in chunks and hands blocks of them out.
+* Freed blocks are merged with their free neighbours and handed out again, chunks are only released by nv_arena_trim.
+* The nv_arena_ functions are thread safe
+*
+* param backend - the backend the memory comes from, copied into the arena
+* param chunk_bytes - the size of the chunks reserved, larger blocks get a chunk of their own
+* param pitch_alignment - what nv_arena_pitch rounds rows up to, a power of 2
+* return - the arena, or NULL if it couldn't be allocated
+*/
+struct nv_arena *nv_arena_create(const struct nv_arena_backend *backend, size_t chunk_bytes, uint32_t pitch_alignment);
+
+/* Releases every chunk of an arena and destroys it, none of its blocks may be used anymore */
+void nv_arena_destroy(struct nv_arena *arena);
+
+/* return - the pitch of a row of row_bytes, rounded up to the pitch alignment of the arena */
+size_t nv_arena_pitch(const struct nv_arena *arena, size_t row_bytes);
+
+/*
+* Hands out a block of at least bytes, from the first free range large enough or a new chunk if none is
+*
+* param arena - the arena
+* param bytes - the size of the block
+* param padding - how many of bytes are only row padding, counted as wasted along with the rounding of the block
+* param capacity - OUTPUT parameter, the size of the block handed out, may be NULL
+* return - the address of the block, or 0 if the backend couldn't reserve a chunk for it
+*/
+uint64_t nv_arena_alloc(struct nv_arena *arena, size_t bytes, size_t padding, size_t *capacity);
+
+/* Returns a block to the arena, its memory is handed out again rather than released */
+void nv_arena_free(struct nv_arena *arena, uint64_t address);
+
+/*
+* Reserves chunks up front for at least bytes, which are kept by nv_arena_trim until the arena is destroyed
+*
+* param arena - the arena
+* param bytes - how much to reserve, in chunks of the arena's chunk size
+* return - false if the backend couldn't reserve all of it, what it did reserve is kept
+*/
+bool nv_arena_reserve(struct nv_arena *arena, size_t bytes);
+
+/* Releases the chunks none of whose blocks are handed out, other than those reserved by nv_arena_reserve */
+void nv_arena_trim(struct nv_arena *arena);
+
+/* Copies out the counters of an arena */
+void nv_arena_get_stats(struct nv_arena *arena, struct nv_arena_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,383 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "superres-batch.h"
+
+
+
+struct nv_batch_member
+{
+	struct nv_batch_group *group;
+	struct nv_batch_member *next;
+	nv_batch_complete_t complete;
+	struct nv_batch_io io; // the pending frame
+	uint64_t frame; // the frame the member last submitted for
+	bool submitted; // the member has submitted a frame since it joined
+	bool pending; // io hasn't been run yet
+};
+
+struct nv_batch_group
+{
+	struct nv_batch_service *service;
+	struct nv_batch_group *next;
+	struct nv_batch_key key;
+	struct nv_batch_member *members;
+	uint32_t member_count;
+	void *batch; // created by the backend on the first run, and again when the group outgrows it
+	uint32_t capacity;
+	uint64_t frame; // the frame members are submitting for
+	uint64_t previous_frame; // the frame before it, members that last submitted for it are still expected to submit
+	bool has_frame;
+};
+
+struct nv_batch_service
+{
+	struct nv_batch_backend backend;
+	struct nv_batch_group *groups;
+};
+
+
+
+static bool keys_equal(const struct nv_batch_key *a, const struct nv_batch_key *b)
+{
+	return strcmp(a->effect, b->effect) == 0 && a->mode == b->mode && a->strength == b->strength && a->variant == b->variant &&
+	       a->width == b->width && a->height == b->height && a->out_width == b->out_width && a->out_height == b->out_height;
+}
+
+
+
+static void destroy_group(struct nv_batch_group *group)
+{
+	struct nv_batch_service *service = group->service;
+
+	if (group->batch)
+	{
+		service->backend.destroy(service->backend.context, group->batch);
+	}
+
+	while (group->members)
+	{
+		struct nv_batch_member *member = group->members;
+		group->members = member->next;
+		free(member);
+	}
+
+	free(group);
+}
+
+
+
+/*
+* Runs some of the pending frames of a group through the backend, and completes them
+*
+* param group - the group to run
+* param members - the members whose frames are run, at most NV_BATCH_MAX
+* param count - the number of members
+*/
+static void run_batch(struct nv_batch_group *group, struct nv_batch_member **members, uint32_t count)
+{
+	struct nv_batch_backend *backend = &group->service->backend;
+	const uint32_t capacity = group->member_count < NV_BATCH_MAX ? group->member_count : NV_BATCH_MAX;
+
+	if (!group->batch || group->capacity < capacity)
+	{
+		if (group->batch)
+		{
+			backend->destroy(backend->context, group->batch);
+		}
+
+		group->batch = backend->create(backend->context, &group->key, capacity);
+		group->capacity = group->batch ? capacity : 0;
+	}
+
+	struct nv_batch_io items[NV_BATCH_MAX];
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		items[i] = members[i]->io;
+		members[i]->pending = false;
+	}
+
+	const bool success = group->batch && backend->run(backend->context, group->batch, items, count);
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		members[i]->complete(items[i].user, success);
+	}
+}
+
+
+
+/* Runs every pending frame of a group, NV_BATCH_MAX at a time */
+static void run_group(struct nv_batch_group *group)
+{
+	struct nv_batch_member *members[NV_BATCH_MAX];
+	uint32_t count = 0;
+
+	for (struct nv_batch_member *member = group->members; member; member = member->next)
+	{
+		if (!member->pending)
+		{
+			continue;
+		}
+
+		members[count++] = member;
+
+		if (count == NV_BATCH_MAX)
+		{
+			run_batch(group, members, count);
+			count = 0;
+		}
+	}
+
+	if (count > 0)
+	{
+		run_batch(group, members, count);
+	}
+}
+
+
+
+static bool group_pending(const struct nv_batch_group *group)
+{
+	for (const struct nv_batch_member *member = group->members; member; member = member->next)
+	{
+		if (member->pending)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+
+/* return - true if every member that submitted for this frame or the previous one has a frame pending */
+static bool group_ready(const struct nv_batch_group *group)
+{
+	for (const struct nv_batch_member *member = group->members; member; member = member->next)
+	{
+		const bool active = member->submitted && (member->frame == group->frame || member->frame == group->previous_frame);
+
+		if (active && !member->pending)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+struct nv_batch_service *nv_batch_service_create(const struct nv_batch_backend *backend)
+{
+	struct nv_batch_service *service = calloc(1, sizeof(*service));
+
+	if (service)
+	{
+		service->backend = *backend;
+	}
+
+	return service;
+}
+
+
+
+void nv_batch_service_destroy(struct nv_batch_service *service)
+{
+	if (!service)
+	{
+		return;
+	}
+
+	while (service->groups)
+	{
+		struct nv_batch_group *group = service->groups;
+		service->groups = group->next;
+		destroy_group(group);
+	}
+
+	free(service);
+}
+
+
+
+struct nv_batch_member *nv_batch_join(struct nv_batch_service *service, const struct nv_batch_key *key, nv_batch_complete_t complete)
+{
+	struct nv_batch_group *group = service->groups;
+
+	while (group && !keys_equal(&group->key, key))
+	{
+		group = group->next;
+	}
+
+	if (!group)
+	{
+		group = calloc(1, sizeof(*group));
+
+		if (!group)
+		{
+			return NULL;
+		}
+
+		group->service = service;
+		group->key = *key;
+		group->next = service->groups;
+		service->groups = group;
+	}
+
+	struct nv_batch_member *member = calloc(1, sizeof(*member));
+
+	if (!member)
+	{
+		if (!group->members)
+		{
+			service->groups = group->next;
+			free(group);
+		}
+
+		return NULL;
+	}
+
+	member->group = group;
+	member->complete = complete;
+
+	/* Appended, so frames are batched in the order the members joined */
+	struct nv_batch_member **tail = &group->members;
+
+	while (*tail)
+	{
+		tail = &(*tail)->next;
+	}
+
+	*tail = member;
+	group->member_count++;
+
+	return member;
+}
+
+
+
+void nv_batch_leave(struct nv_batch_member *member)
+{
+	if (!member)
+	{
+		return;
+	}
+
+	struct nv_batch_group *group = member->group;
+	struct nv_batch_member **link = &group->members;
+
+	while (*link != member)
+	{
+		link = &(*link)->next;
+	}
+
+	*link = member->next;
+	group->member_count--;
+	free(member);
+
+	if (group->member_count == 0)
+	{
+		struct nv_batch_group **group_link = &group->service->groups;
+
+		while (*group_link != group)
+		{
+			group_link = &(*group_link)->next;
+		}
+
+		*group_link = group->next;
+		destroy_group(group);
+	}
+}
+
+
+
+uint32_t nv_batch_group_size(const struct nv_batch_member *member)
+{
+	return member->group->member_count;
+}
+
+
+
+bool nv_batch_member_matches(const struct nv_batch_member *member, const struct nv_batch_key *key)
+{
+	return keys_equal(&member->group->key, key);
+}
+
+
+
+bool nv_batch_member_pending(const struct nv_batch_member *member)
+{
+	return member->pending;
+}
+
+
+
+bool nv_batch_submit(struct nv_batch_member *member, const struct nv_batch_io *io, uint64_t frame)
+{
+	struct nv_batch_group *group = member->group;
+
+	/* A new frame, whoever didn't make it into the last one is run on their own */
+	if (!group->has_frame || group->frame != frame)
+	{
+		if (group_pending(group))
+		{
+			run_group(group);
+		}
+
+		group->previous_frame = group->has_frame ? group->frame : frame;
+		group->frame = frame;
+		group->has_frame = true;
+	}
+
+	/* The member is rendered more than once a frame, its last frame can't wait for the others any longer */
+	if (member->pending)
+	{
+		run_group(group);
+	}
+
+	member->io = *io;
+	member->frame = frame;
+	member->submitted = true;
+	member->pending = true;
+
+	if (group_ready(group))
+	{
+		run_group(group);
+	}
+
+	return true;
+}
+
+
+
+void nv_batch_flush(struct nv_batch_service *service)
+{
+	for (struct nv_batch_group *group = service->groups; group; group = group->next)
+	{
+		if (group_pending(group))
+		{
+			run_group(group);
+		}
+	}
+}
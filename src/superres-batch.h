@@ -0,0 +1,124 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Most frames run through a backend in one go, groups with more members submitting are run in several batches */
+#define NV_BATCH_MAX 8
+
+/* Filter instances only share a batch when everything the effect is loaded with matches */
+struct nv_batch_key
+{
+	const char *effect; // one of the NVVFX_FX_ selectors
+	uint32_t mode;
+	float strength;
+	uint32_t variant; // anything else the inputs of the members have to agree on, such as their value range
+	uint32_t width; // size of a single input
+	uint32_t height;
+	uint32_t out_width; // size of a single output
+	uint32_t out_height;
+};
+
+/* A frame submitted by a member, the backend stacks the inputs into its batch and hands each output back to where it belongs */
+struct nv_batch_io
+{
+	void *input;
+	void *output;
+	void *user; // the member's own data, also passed to its completion callback
+};
+
+/* Runs batches, the plugin provides one on top of NvVFX and superres-tests one on the CPU */
+struct nv_batch_backend
+{
+	/* Creates a batch able to run up to capacity frames of the given configuration at once, returns NULL on failure */
+	void *(*create)(void *context, const struct nv_batch_key *key, uint32_t capacity);
+	/* Runs count frames through the batch, item i is at index i of the batch, returns false on failure */
+	bool (*run)(void *context, void *batch, const struct nv_batch_io *items, uint32_t count);
+	void (*destroy)(void *context, void *batch);
+	void *context;
+};
+
+/* Called for every frame of a batch once it has run, success is false if the backend failed to run it.
+* It must not join, leave or submit to the service it's called from.
+*/
+typedef void (*nv_batch_complete_t)(void *user, bool success);
+
+struct nv_batch_service;
+struct nv_batch_member;
+
+/*
+* Creates a batching service, which groups its members by their key and runs each group through the backend together.
+* None of the nv_batch_ functions are thread safe, the plugin only calls them from the graphics thread.
+*
+* param backend - the backend that runs the batches, copied into the service
+* return - the service, or NULL if it couldn't be allocated
+*/
+struct nv_batch_service *nv_batch_service_create(const struct nv_batch_backend *backend);
+
+/* Destroys a service and the batches of its groups, all members must have left it beforehand */
+void nv_batch_service_destroy(struct nv_batch_service *service);
+
+/*
+* Adds a member to the group of its key, creating the group if it's the first one with that key
+*
+* param service - the batching service
+* param key - the configuration of the member, copied. The effect string must outlive the member
+* param complete - called for each frame the member submitted once its batch has run
+* return - the member, or NULL if it couldn't be allocated
+*/
+struct nv_batch_member *nv_batch_join(struct nv_batch_service *service, const struct nv_batch_key *key, nv_batch_complete_t complete);
+
+/* Removes a member from its group, dropping any frame it has pending without completing it */
+void nv_batch_leave(struct nv_batch_member *member);
+
+/* return - the number of members in the member's group, including itself */
+uint32_t nv_batch_group_size(const struct nv_batch_member *member);
+
+/* return - true if the member's key matches the given key */
+bool nv_batch_member_matches(const struct nv_batch_member *member, const struct nv_batch_key *key);
+
+/* return - true if the member has submitted a frame that hasn't run yet */
+bool nv_batch_member_pending(const struct nv_batch_member *member);
+
+/*
+* Submits the next frame of a member. The group runs as soon as every active member has submitted a frame, where active members are
+* those that submitted for this frame or the one before it, so a member that stops being rendered doesn't hold the others back.
+* A member submitting again, or the first submission of a new frame, runs whatever is still pending from before first.
+* The completion callback may be called from within this call, for this member or any other of the group.
+*
+* param member - the member submitting
+* param io - the frame, copied
+* param frame - identifies the frame being rendered, such as its timestamp, the same for every member during a frame
+* return - true if the frame was queued
+*/
+bool nv_batch_submit(struct nv_batch_member *member, const struct nv_batch_io *io, uint64_t frame);
+
+/* Runs every group that has frames pending, whether or not all of their members have submitted */
+void nv_batch_flush(struct nv_batch_service *service);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,465 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "superres-caps.h"
+
+#define CAPS_HEADER "nv-superres-caps 1"
+#define CAPS_DEVICE_LEN 256
+#define CAPS_LINE_LEN 512
+
+/* The outcome of loading an effect for a configuration */
+struct caps_load
+{
+	char effect[NV_CAPS_EFFECT_LEN];
+	uint32_t mode;
+	uint32_t width;
+	uint32_t height;
+	uint32_t out_width;
+	uint32_t out_height;
+	enum nv_caps_result result;
+};
+
+/* The largest input of an effect */
+struct caps_max
+{
+	char effect[NV_CAPS_EFFECT_LEN];
+	uint32_t width;
+	uint32_t height;
+};
+
+struct nv_caps
+{
+	char device[CAPS_DEVICE_LEN];
+	struct caps_load *loads;
+	size_t load_count;
+	size_t load_capacity;
+	struct caps_max *maxes;
+	size_t max_count;
+	size_t max_capacity;
+	bool modified;
+};
+
+
+
+/* Effect selectors are written out as a single word, anything else couldn't be read back */
+static bool valid_effect(const char *effect)
+{
+	const size_t len = effect ? strlen(effect) : 0;
+
+	if (len == 0 || len >= NV_CAPS_EFFECT_LEN)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < len; ++i)
+	{
+		if (effect[i] <= ' ')
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+static struct caps_load *find_load(const struct nv_caps *caps, const struct nv_caps_key *key)
+{
+	for (size_t i = 0; i < caps->load_count; ++i)
+	{
+		struct caps_load *load = &caps->loads[i];
+
+		if (strcmp(load->effect, key->effect) == 0 && load->mode == key->mode && load->width == key->width &&
+		    load->height == key->height && load->out_width == key->out_width && load->out_height == key->out_height)
+		{
+			return load;
+		}
+	}
+
+	return NULL;
+}
+
+
+
+static struct caps_max *find_max(const struct nv_caps *caps, const char *effect)
+{
+	for (size_t i = 0; i < caps->max_count; ++i)
+	{
+		if (strcmp(caps->maxes[i].effect, effect) == 0)
+		{
+			return &caps->maxes[i];
+		}
+	}
+
+	return NULL;
+}
+
+
+
+/* Grows an array of the table to hold at least one more item, return - false if it couldn't be */
+static bool reserve(void **items, size_t *capacity, size_t count, size_t item_size)
+{
+	if (count < *capacity)
+	{
+		return true;
+	}
+
+	const size_t grown = *capacity ? *capacity * 2 : 16;
+	void *reallocated = realloc(*items, grown * item_size);
+
+	if (!reallocated)
+	{
+		return false;
+	}
+
+	*items = reallocated;
+	*capacity = grown;
+	return true;
+}
+
+
+
+static bool store_load(struct nv_caps *caps, const struct nv_caps_key *key, enum nv_caps_result result)
+{
+	if (!valid_effect(key->effect) || (result != NV_CAPS_ACCEPTED && result != NV_CAPS_REJECTED))
+	{
+		return false;
+	}
+
+	struct caps_load *load = find_load(caps, key);
+
+	if (!load)
+	{
+		if (!reserve((void **)&caps->loads, &caps->load_capacity, caps->load_count, sizeof(*caps->loads)))
+		{
+			return false;
+		}
+
+		load = &caps->loads[caps->load_count++];
+		strcpy(load->effect, key->effect);
+		load->mode = key->mode;
+		load->width = key->width;
+		load->height = key->height;
+		load->out_width = key->out_width;
+		load->out_height = key->out_height;
+	}
+
+	load->result = result;
+	return true;
+}
+
+
+
+static bool store_max(struct nv_caps *caps, const char *effect, uint32_t width, uint32_t height)
+{
+	if (!valid_effect(effect))
+	{
+		return false;
+	}
+
+	struct caps_max *max = find_max(caps, effect);
+
+	if (!max)
+	{
+		if (!reserve((void **)&caps->maxes, &caps->max_capacity, caps->max_count, sizeof(*caps->maxes)))
+		{
+			return false;
+		}
+
+		max = &caps->maxes[caps->max_count++];
+		strcpy(max->effect, effect);
+	}
+
+	max->width = width;
+	max->height = height;
+	return true;
+}
+
+
+
+struct nv_caps *nv_caps_create(const char *device)
+{
+	struct nv_caps *caps = (struct nv_caps *)calloc(1, sizeof(*caps));
+
+	if (!caps)
+	{
+		return NULL;
+	}
+
+	snprintf(caps->device, sizeof(caps->device), "%s", device ? device : "");
+
+	for (char *c = caps->device; *c; ++c)
+	{
+		if (*c == '\n' || *c == '\r')
+		{
+			*c = ' ';
+		}
+	}
+
+	return caps;
+}
+
+
+
+void nv_caps_destroy(struct nv_caps *caps)
+{
+	if (!caps)
+	{
+		return;
+	}
+
+	free(caps->loads);
+	free(caps->maxes);
+	free(caps);
+}
+
+
+
+void nv_caps_set_max_input(struct nv_caps *caps, const char *effect, uint32_t width, uint32_t height)
+{
+	if (store_max(caps, effect, width, height))
+	{
+		caps->modified = true;
+	}
+}
+
+
+
+bool nv_caps_max_input(const struct nv_caps *caps, const char *effect, uint32_t *width, uint32_t *height)
+{
+	const struct caps_max *max = find_max(caps, effect);
+
+	if (!max)
+	{
+		return false;
+	}
+
+	*width = max->width;
+	*height = max->height;
+	return true;
+}
+
+
+
+enum nv_caps_result nv_caps_lookup(const struct nv_caps *caps, const struct nv_caps_key *key)
+{
+	const struct caps_load *load = find_load(caps, key);
+
+	return load ? load->result : NV_CAPS_UNKNOWN;
+}
+
+
+
+void nv_caps_record(struct nv_caps *caps, const struct nv_caps_key *key, enum nv_caps_result result)
+{
+	const struct caps_load *load = find_load(caps, key);
+
+	if ((!load || load->result != result) && store_load(caps, key, result))
+	{
+		caps->modified = true;
+	}
+}
+
+
+
+enum nv_caps_result nv_caps_probe(struct nv_caps *caps, const struct nv_caps_key *key, nv_caps_probe_t probe, void *context)
+{
+	enum nv_caps_result result = nv_caps_lookup(caps, key);
+
+	if (result == NV_CAPS_UNKNOWN)
+	{
+		result = probe(context, key);
+		nv_caps_record(caps, key, result);
+	}
+
+	return result;
+}
+
+
+
+bool nv_caps_modified(const struct nv_caps *caps)
+{
+	return caps->modified;
+}
+
+
+
+/* snprintf onto the end of the text, keeping track of its whole length even once the buffer is full */
+static void append(char *buffer, size_t size, size_t *len, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+
+	const int written = vsnprintf(buffer && *len < size ? buffer + *len : NULL, buffer && *len < size ? size - *len : 0, format, args);
+
+	va_end(args);
+
+	if (written > 0)
+	{
+		*len += (size_t)written;
+	}
+}
+
+
+
+size_t nv_caps_serialize(struct nv_caps *caps, char *buffer, size_t size)
+{
+	size_t len = 0;
+
+	if (buffer && size)
+	{
+		buffer[0] = '\0';
+	}
+
+	append(buffer, size, &len, "%s\ndevice %s\n", CAPS_HEADER, caps->device);
+
+	for (size_t i = 0; i < caps->max_count; ++i)
+	{
+		const struct caps_max *max = &caps->maxes[i];
+		append(buffer, size, &len, "max %s %u %u\n", max->effect, max->width, max->height);
+	}
+
+	for (size_t i = 0; i < caps->load_count; ++i)
+	{
+		const struct caps_load *load = &caps->loads[i];
+		append(buffer, size, &len, "load %s %u %u %u %u %u %s\n", load->effect, load->mode, load->width, load->height,
+		       load->out_width, load->out_height, load->result == NV_CAPS_ACCEPTED ? "accepted" : "rejected");
+	}
+
+	if (buffer && len < size)
+	{
+		caps->modified = false;
+	}
+
+	return len;
+}
+
+
+
+/* Reads a line of a saved table into the table, return - false if it's malformed */
+static bool parse_line(struct nv_caps *caps, const char *line)
+{
+	char effect[NV_CAPS_EFFECT_LEN];
+	char result[16];
+	struct nv_caps_key key = {.effect = effect};
+	uint32_t width;
+	uint32_t height;
+	int end = 0;
+
+	if (sscanf(line, "max %31s %u %u %n", effect, &width, &height, &end) == 3 && line[end] == '\0')
+	{
+		return store_max(caps, effect, width, height);
+	}
+
+	end = 0;
+
+	if (sscanf(line, "load %31s %u %u %u %u %u %15s %n", effect, &key.mode, &key.width, &key.height, &key.out_width,
+		   &key.out_height, result, &end) == 7 && line[end] == '\0')
+	{
+		if (strcmp(result, "accepted") == 0)
+		{
+			return store_load(caps, &key, NV_CAPS_ACCEPTED);
+		}
+
+		if (strcmp(result, "rejected") == 0)
+		{
+			return store_load(caps, &key, NV_CAPS_REJECTED);
+		}
+	}
+
+	return false;
+}
+
+
+
+bool nv_caps_parse(struct nv_caps *caps, const char *text)
+{
+	/* Parsed on its own first, so nothing is read from a malformed text */
+	struct nv_caps *parsed = nv_caps_create(caps->device);
+
+	if (!parsed || !text)
+	{
+		nv_caps_destroy(parsed);
+		return false;
+	}
+
+	char line[CAPS_LINE_LEN];
+	char device_line[CAPS_LINE_LEN];
+	snprintf(device_line, sizeof(device_line), "device %s", caps->device);
+
+	bool success = true;
+	uint32_t index = 0;
+
+	for (const char *start = text; *start && success; ++index)
+	{
+		const char *newline = strchr(start, '\n');
+		size_t len = newline ? (size_t)(newline - start) : strlen(start);
+
+		if (len > 0 && start[len - 1] == '\r')
+		{
+			--len;
+		}
+
+		if (len >= sizeof(line))
+		{
+			success = false;
+			break;
+		}
+
+		memcpy(line, start, len);
+		line[len] = '\0';
+
+		if (index == 0)
+		{
+			success = strcmp(line, CAPS_HEADER) == 0;
+		}
+		else if (index == 1)
+		{
+			success = strcmp(line, device_line) == 0;
+		}
+		else if (len > 0)
+		{
+			success = parse_line(parsed, line);
+		}
+
+		start = newline ? newline + 1 : start + strlen(start);
+	}
+
+	success = success && index >= 2;
+
+	for (size_t i = 0; i < parsed->max_count && success; ++i)
+	{
+		const struct caps_max *max = &parsed->maxes[i];
+		success = store_max(caps, max->effect, max->width, max->height);
+	}
+
+	for (size_t i = 0; i < parsed->load_count && success; ++i)
+	{
+		const struct caps_load *load = &parsed->loads[i];
+		const struct nv_caps_key key = {load->effect, load->mode, load->width, load->height, load->out_width, load->out_height};
+		success = store_load(caps, &key, load->result);
+	}
+
+	nv_caps_destroy(parsed);
+	return success;
+}
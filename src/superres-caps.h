@@ -0,0 +1,110 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Longest effect selector the table holds, including the terminator */
+#define NV_CAPS_EFFECT_LEN 32
+
+/* What loading an effect for a configuration came to, as far as the table knows */
+enum nv_caps_result
+{
+	NV_CAPS_UNKNOWN,
+	NV_CAPS_ACCEPTED,
+	NV_CAPS_REJECTED, // NvVFX_Load failed with NVCV_ERR_RESOLUTION
+};
+
+/* A configuration an effect is loaded with, only what decides whether the effect accepts it */
+struct nv_caps_key
+{
+	const char *effect; // one of the NVVFX_FX_ selectors
+	uint32_t mode;
+	uint32_t width; // size of the input
+	uint32_t height;
+	uint32_t out_width; // size of the output
+	uint32_t out_height;
+};
+
+/* Finds out what loading an effect for a configuration comes to, by loading it or by standing in for NvVFX */
+typedef enum nv_caps_result (*nv_caps_probe_t)(void *context, const struct nv_caps_key *key);
+
+struct nv_caps;
+
+/*
+* Creates an empty capability table for a device. The outcomes of loading the effects only hold for the GPU, driver and
+* SDK they were found with, a table saved for any other device is discarded when it's parsed.
+* None of the nv_caps_ functions are thread safe, the plugin guards its table with a mutex of its own.
+*
+* param device - identifies the GPU, driver and SDK, copied. Line breaks are replaced by spaces
+* return - the table, or NULL if it couldn't be allocated
+*/
+struct nv_caps *nv_caps_create(const char *device);
+
+void nv_caps_destroy(struct nv_caps *caps);
+
+/* Records the largest input an effect accepts, as reported by NVVFX_MAX_INPUT_WIDTH and NVVFX_MAX_INPUT_HEIGHT */
+void nv_caps_set_max_input(struct nv_caps *caps, const char *effect, uint32_t width, uint32_t height);
+
+/* return - true if the largest input of the effect is known, in which case width and height receive it */
+bool nv_caps_max_input(const struct nv_caps *caps, const char *effect, uint32_t *width, uint32_t *height);
+
+/* return - what loading the effect for the configuration came to last time, NV_CAPS_UNKNOWN if it hasn't been loaded for it */
+enum nv_caps_result nv_caps_lookup(const struct nv_caps *caps, const struct nv_caps_key *key);
+
+/* Records what loading the effect for the configuration came to, replacing what was known before */
+void nv_caps_record(struct nv_caps *caps, const struct nv_caps_key *key, enum nv_caps_result result);
+
+/*
+* Looks the configuration up, probing and recording it if it isn't known yet
+*
+* param probe - called when the configuration isn't known, its NV_CAPS_UNKNOWN results aren't recorded
+* return - what loading the effect for the configuration comes to
+*/
+enum nv_caps_result nv_caps_probe(struct nv_caps *caps, const struct nv_caps_key *key, nv_caps_probe_t probe, void *context);
+
+/* return - true if anything was recorded since the table was created, or last serialized in full */
+bool nv_caps_modified(const struct nv_caps *caps);
+
+/*
+* Writes the table out as text, for it to be saved to a file
+*
+* param buffer - receives the text and its terminator, may be NULL to find out the size needed
+* param size - size of the buffer
+* return - the length of the whole text, without its terminator. The text was truncated if this is size or more
+*/
+size_t nv_caps_serialize(struct nv_caps *caps, char *buffer, size_t size);
+
+/*
+* Reads a table written by nv_caps_serialize into the table, on top of what it already holds
+*
+* param text - the saved table
+* return - false if the text is malformed or was saved for another device, in which case nothing is read from it
+*/
+bool nv_caps_parse(struct nv_caps *caps, const char *text);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,167 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "superres-convert.h"
+
+#include <math.h>
+
+
+
+/* Returns a pointer to the start of the given row in the given plane of a planar image */
+static inline float *planar_row(float *base, uint32_t pitch, uint32_t height, uint32_t plane, uint32_t y)
+{
+	return (float *)((uint8_t *)base + ((size_t)plane * height + y) * pitch);
+}
+
+
+
+/* Clamps a [0, 1] float to an 8 bit unorm value, rounding to nearest as the GPU does when writing unorm render targets */
+static inline uint8_t unorm8(float value)
+{
+	if (!(value > 0.0f))
+		return 0;
+	if (value >= 1.0f)
+		return 255;
+
+	return (uint8_t)(value * 255.0f + 0.5f);
+}
+
+
+
+void nv_convert_rgba8_to_planar_f32(const uint8_t *src, uint32_t src_pitch, uint32_t width, uint32_t height, bool bgra,
+				    float scale, float *dst, uint32_t dst_pitch)
+{
+	/* component offsets of B, G and R within a source pixel, in plane order */
+	const uint32_t offsets[NV_PLANAR_PLANES] =
+	{
+		bgra ? 0 : 2,
+		1,
+		bgra ? 2 : 0
+	};
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		const uint8_t *row = src + (size_t)y * src_pitch;
+
+		for (uint32_t plane = 0; plane < NV_PLANAR_PLANES; ++plane)
+		{
+			float *out = planar_row(dst, dst_pitch, height, plane, y);
+
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				out[x] = (float)row[x * 4 + offsets[plane]] * scale;
+			}
+		}
+	}
+}
+
+
+
+void nv_convert_planar_f32_to_rgba8(const float *src, uint32_t src_pitch, uint32_t width, uint32_t height, float scale,
+				    bool bgra, uint8_t *dst, uint32_t dst_pitch)
+{
+	/* component offsets of B, G and R within a destination pixel, in plane order */
+	const uint32_t offsets[NV_PLANAR_PLANES] =
+	{
+		bgra ? 0 : 2,
+		1,
+		bgra ? 2 : 0
+	};
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		uint8_t *row = dst + (size_t)y * dst_pitch;
+
+		for (uint32_t plane = 0; plane < NV_PLANAR_PLANES; ++plane)
+		{
+			const float *in = planar_row((float *)src, src_pitch, height, plane, y);
+
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				row[x * 4 + offsets[plane]] = unorm8(in[x] * scale);
+			}
+		}
+
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			row[x * 4 + 3] = 255;
+		}
+	}
+}
+
+
+
+void nv_fill_planar_pattern(float *dst, uint32_t dst_pitch, uint32_t width, uint32_t height, float range)
+{
+	uint32_t seed = 0x2545F491u;
+
+	for (uint32_t plane = 0; plane < NV_PLANAR_PLANES; ++plane)
+	{
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			float *out = planar_row(dst, dst_pitch, height, plane, y);
+
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				/* a gradient running a different way in each plane, with a checkerboard of hard edges over the top half */
+				const float gradient = plane == 0 ? (float)x / (float)width : plane == 1 ? (float)y / (float)height
+										: (float)(x + y) / (float)(width + height);
+				const bool checker = y < height / 2 && (((x / 16) ^ (y / 16)) & 1);
+
+				seed = seed * 1664525u + 1013904223u;
+				const float noise = (float)(seed >> 24) / 255.0f * 0.1f - 0.05f;
+
+				float value = (checker ? 1.0f - gradient : gradient) + noise;
+				value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+
+				out[x] = value * range;
+			}
+		}
+	}
+}
+
+
+
+void nv_compare_planar(const float *a, uint32_t a_pitch, const float *b, uint32_t b_pitch, uint32_t width, uint32_t height,
+		       float *max_error, float *mean_error)
+{
+	double total = 0.0;
+	float largest = 0.0f;
+
+	for (uint32_t plane = 0; plane < NV_PLANAR_PLANES; ++plane)
+	{
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			const float *row_a = planar_row((float *)a, a_pitch, height, plane, y);
+			const float *row_b = planar_row((float *)b, b_pitch, height, plane, y);
+
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				const float error = fabsf(row_a[x] - row_b[x]);
+
+				largest = error > largest ? error : largest;
+				total += error;
+			}
+		}
+	}
+
+	const double count = (double)width * height * NV_PLANAR_PLANES;
+
+	*max_error = largest;
+	*mean_error = count > 0.0 ? (float)(total / count) : 0.0f;
+}
@@ -0,0 +1,104 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The NvVFX AR and SR effects consume BGR f32 planar images, which are laid out as three full planes stacked on top of each other
+* in the order B, G, R. Viewed as a single channel image that is width x (height * NV_PLANAR_PLANES) in size, which is what our
+* planar conversion render targets are, so the GPU side conversion is a single shader pass followed by a plain copy.
+*/
+#define NV_PLANAR_PLANES 3
+
+/* Value scales applied to 8 bit components when they are packed into a planar f32 image
+* Artifact Reduction expects its input in the range [0, 1], Super Resolution is fed the [0, 255] range
+*/
+#define NV_PLANAR_SCALE_UNIT (1.0f / 255.0f)
+#define NV_PLANAR_SCALE_BYTE 1.0f
+
+/*
+* CPU reference of the ConvertPlanar techniques in rtx_superresolution.effect
+* Converts an 8 bit RGBA (or BGRA) chunky image into a BGR f32 planar image, multiplying every component by scale.
+* The shader quantizes to 8 bits before scaling, so the output of both is bit exact for the same 8 bit input.
+*
+* param src - pointer to pixel (0, 0) of the chunky source image
+* param src_pitch - byte stride between rows of src
+* param width - width of both images
+* param height - height of both images, the height of a single plane of dst
+* param bgra - true if src is BGRA ordered, false if RGBA
+* param scale - value each component is multiplied by, one of NV_PLANAR_SCALE_
+* param dst - pointer to pixel (0, 0) of the B plane of the destination image
+* param dst_pitch - byte stride between rows of dst, planes follow each other every dst_pitch * height bytes
+*/
+void nv_convert_rgba8_to_planar_f32(const uint8_t *src, uint32_t src_pitch, uint32_t width, uint32_t height, bool bgra,
+				    float scale, float *dst, uint32_t dst_pitch);
+
+/*
+* CPU reference of the ResolvePlanar technique in rtx_superresolution.effect
+* Converts a BGR f32 planar image into an 8 bit RGBA (or BGRA) chunky image, multiplying every component by scale,
+* clamping to [0, 1] and rounding to the nearest 8 bit value. Alpha is always written as opaque.
+*
+* param src - pointer to pixel (0, 0) of the B plane of the planar source image
+* param src_pitch - byte stride between rows of src, planes follow each other every src_pitch * height bytes
+* param width - width of both images
+* param height - height of both images, the height of a single plane of src
+* param scale - value each component is multiplied by to bring it into the [0, 1] range
+* param bgra - true if dst is BGRA ordered, false if RGBA
+* param dst - pointer to pixel (0, 0) of the chunky destination image
+* param dst_pitch - byte stride between rows of dst
+*/
+void nv_convert_planar_f32_to_rgba8(const float *src, uint32_t src_pitch, uint32_t width, uint32_t height, float scale,
+				    bool bgra, uint8_t *dst, uint32_t dst_pitch);
+
+/*
+* Fills a BGR f32 planar image with the synthetic pattern the precision benchmark runs the effects on. Gradients, hard edges and
+* fine noise, so the effects have both smooth areas and detail to work on. The same size always gives the same pattern.
+*
+* param dst - pointer to pixel (0, 0) of the B plane of the image
+* param dst_pitch - byte stride between rows of dst, planes follow each other every dst_pitch * height bytes
+* param width - width of the image
+* param height - height of the image, the height of a single plane
+* param range - the largest value written, 1 for an Artifact Reduction input or 255 for a Super Resolution one
+*/
+void nv_fill_planar_pattern(float *dst, uint32_t dst_pitch, uint32_t width, uint32_t height, float range);
+
+/*
+* Compares two BGR f32 planar images of the same size, such as the outputs of an effect run at two precisions
+*
+* param a - pointer to pixel (0, 0) of the B plane of the first image
+* param a_pitch - byte stride between rows of a
+* param b - pointer to pixel (0, 0) of the B plane of the second image
+* param b_pitch - byte stride between rows of b
+* param width - width of both images
+* param height - height of both images, the height of a single plane
+* param max_error - set to the largest absolute difference between two components
+* param mean_error - set to the mean absolute difference over every component
+*/
+void nv_compare_planar(const float *a, uint32_t a_pitch, const float *b, uint32_t b_pitch, uint32_t width, uint32_t height,
+		       float *max_error, float *mean_error);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,161 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <math.h>
+#include <string.h>
+#include "superres-fingerprint.h"
+
+
+
+/* Adds a pixel to the sums of its cell, see struct nv_fingerprint */
+static inline void accumulate(uint32_t *sums, uint32_t x, uint32_t y, uint32_t r, uint32_t g, uint32_t b)
+{
+	uint32_t weights[4];
+	nv_fingerprint_weights(x, y, weights);
+
+	sums[0] += weights[0] * r;
+	sums[1] += weights[1] * g;
+	sums[2] += weights[2] * b;
+	sums[3] += weights[3] * (r + g * 2 + b * 4);
+}
+
+
+
+/* Stores the sums of a cell, modulo 2^23 */
+static inline void store_cell(float *cell, const uint32_t *sums)
+{
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		cell[c] = (float)(sums[c] & NV_FINGERPRINT_MASK);
+	}
+}
+
+
+
+void nv_fingerprint_rgba8(const uint8_t *src, uint32_t src_pitch, uint32_t width, uint32_t height, bool bgra,
+			  struct nv_fingerprint *fingerprint)
+{
+	const uint32_t r_offset = bgra ? 2 : 0;
+	const uint32_t b_offset = bgra ? 0 : 2;
+
+	memset(fingerprint, 0, sizeof(*fingerprint));
+
+	for (uint32_t cy = 0; cy < NV_FINGERPRINT_GRID; ++cy)
+	{
+		uint32_t y0, y1;
+		nv_fingerprint_cell_bounds(cy, height, &y0, &y1);
+
+		for (uint32_t cx = 0; cx < NV_FINGERPRINT_GRID; ++cx)
+		{
+			uint32_t x0, x1;
+			nv_fingerprint_cell_bounds(cx, width, &x0, &x1);
+
+			uint32_t sums[4] = {0, 0, 0, 0};
+
+			for (uint32_t y = y0; y < y1; ++y)
+			{
+				const uint8_t *row = src + (size_t)y * src_pitch;
+
+				for (uint32_t x = x0; x < x1; ++x)
+				{
+					const uint8_t *pixel = row + x * 4;
+					accumulate(sums, x, y, pixel[r_offset], pixel[1], pixel[b_offset]);
+				}
+			}
+
+			store_cell(fingerprint->cells[cy * NV_FINGERPRINT_GRID + cx], sums);
+		}
+	}
+}
+
+
+
+void nv_fingerprint_planar_f32(const float *src, uint32_t src_pitch, uint32_t width, uint32_t height, float scale,
+			       struct nv_fingerprint *fingerprint)
+{
+	const size_t plane_size = (size_t)src_pitch * height;
+
+	memset(fingerprint, 0, sizeof(*fingerprint));
+
+	for (uint32_t cy = 0; cy < NV_FINGERPRINT_GRID; ++cy)
+	{
+		uint32_t y0, y1;
+		nv_fingerprint_cell_bounds(cy, height, &y0, &y1);
+
+		for (uint32_t cx = 0; cx < NV_FINGERPRINT_GRID; ++cx)
+		{
+			uint32_t x0, x1;
+			nv_fingerprint_cell_bounds(cx, width, &x0, &x1);
+
+			uint32_t sums[4] = {0, 0, 0, 0};
+
+			for (uint32_t y = y0; y < y1; ++y)
+			{
+				const float *b = (const float *)((const uint8_t *)src + (size_t)y * src_pitch);
+				const float *g = (const float *)((const uint8_t *)b + plane_size);
+				const float *r = (const float *)((const uint8_t *)g + plane_size);
+
+				for (uint32_t x = x0; x < x1; ++x)
+				{
+					accumulate(sums, x, y, (uint32_t)floorf(r[x] / scale + 0.5f), (uint32_t)floorf(g[x] / scale + 0.5f),
+						   (uint32_t)floorf(b[x] / scale + 0.5f));
+				}
+			}
+
+			store_cell(fingerprint->cells[cy * NV_FINGERPRINT_GRID + cx], sums);
+		}
+	}
+}
+
+
+
+bool nv_fingerprint_equal(const struct nv_fingerprint *a, const struct nv_fingerprint *b)
+{
+	for (uint32_t i = 0; i < NV_FINGERPRINT_CELLS; ++i)
+	{
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			if (a->cells[i][c] != b->cells[i][c])
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+
+uint32_t nv_fingerprint_diff(const struct nv_fingerprint *a, const struct nv_fingerprint *b, bool changed[NV_FINGERPRINT_CELLS])
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < NV_FINGERPRINT_CELLS; ++i)
+	{
+		changed[i] = a->cells[i][0] != b->cells[i][0] || a->cells[i][1] != b->cells[i][1] ||
+			     a->cells[i][2] != b->cells[i][2] || a->cells[i][3] != b->cells[i][3];
+
+		if (changed[i])
+		{
+			++count;
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,122 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The fingerprint of a frame is a grid of NV_FINGERPRINT_GRID x NV_FINGERPRINT_GRID cells, each cell covering an even share of the
+* frame. It's reduced in two passes, FingerprintPartial sums sub-cells of a grid NV_FINGERPRINT_SPLIT times finer and Fingerprint
+* adds them up per cell. Both must match the grid sizes hardcoded in rtx_superresolution.effect
+*/
+#define NV_FINGERPRINT_GRID 16
+#define NV_FINGERPRINT_SPLIT 8
+#define NV_FINGERPRINT_CELLS (NV_FINGERPRINT_GRID * NV_FINGERPRINT_GRID)
+
+/* The sums of a cell are kept modulo 2^23 */
+#define NV_FINGERPRINT_MASK 0x7FFFFFu
+
+/*
+* Every cell holds 4 sums over its pixels of the 8 bit R, G, B and R + 2G + 4B values, each multiplied by a weight from 1 to 64
+* that is a hash of the pixel's position. Swapping two pixels or moving one by any distance changes the sums unless the weights
+* happen to match on every component that differs.
+* The sums are integers computed modulo 2^23, in integer arithmetic on the GPU as well, so they are exact in the float cells whatever
+* the size of the frame and the order they're added in. The GPU and CPU fingerprints of the same frame compare equal.
+*/
+struct nv_fingerprint
+{
+	float cells[NV_FINGERPRINT_CELLS][4];
+};
+
+/*
+* Returns the first and one past the last pixel of the given cell along an axis of length size, as the Fingerprint shader computes them
+*/
+static inline void nv_fingerprint_cell_bounds(uint32_t cell, uint32_t size, uint32_t *begin, uint32_t *end)
+{
+	*begin = cell * size / NV_FINGERPRINT_GRID;
+	*end = (cell + 1) * size / NV_FINGERPRINT_GRID;
+}
+
+/*
+* Returns the weights of the 4 sums for the pixel at x, y, as FingerprintWeights in rtx_superresolution.effect computes them
+*/
+static inline void nv_fingerprint_weights(uint32_t x, uint32_t y, uint32_t weights[4])
+{
+	uint32_t h = (x * 0x9E3779B1u) ^ (y * 0x85EBCA77u);
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 12;
+
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		weights[i] = ((h >> (i * 6)) & 63u) + 1;
+	}
+}
+
+/*
+* CPU reference of the Fingerprint technique in rtx_superresolution.effect for an RGBA U8 chunky source, ie. render_unorm
+*
+* param src - pointer to pixel (0, 0) of the chunky source image
+* param src_pitch - byte stride between rows of src
+* param width - width of the image
+* param height - height of the image
+* param bgra - true if src is BGRA ordered, false if RGBA
+* param fingerprint - receives the fingerprint of the image
+*/
+void nv_fingerprint_rgba8(const uint8_t *src, uint32_t src_pitch, uint32_t width, uint32_t height, bool bgra,
+			  struct nv_fingerprint *fingerprint);
+
+/*
+* CPU reference of the Fingerprint technique in rtx_superresolution.effect for a BGR f32 planar source, ie. render_planar
+* Components are brought back to 8 bit values by dividing them by scale and rounding, undoing the ConvertPlanar quantization.
+*
+* param src - pointer to pixel (0, 0) of the B plane of the planar source image
+* param src_pitch - byte stride between rows of src, planes follow each other every src_pitch * height bytes
+* param width - width of the image
+* param height - height of the image, the height of a single plane of src
+* param scale - the scale the image was converted with, one of NV_PLANAR_SCALE_
+* param fingerprint - receives the fingerprint of the image
+*/
+void nv_fingerprint_planar_f32(const float *src, uint32_t src_pitch, uint32_t width, uint32_t height, float scale,
+			       struct nv_fingerprint *fingerprint);
+
+/*
+* Compares two fingerprints
+* return - True if every cell of both fingerprints is identical, ie. the frames they were taken from are considered unchanged
+*/
+bool nv_fingerprint_equal(const struct nv_fingerprint *a, const struct nv_fingerprint *b);
+
+/*
+* Finds the cells that differ between two fingerprints
+*
+* param a - the first fingerprint
+* param b - the second fingerprint
+* param changed - receives true for every cell that differs
+* return - the number of cells that differ
+*/
+uint32_t nv_fingerprint_diff(const struct nv_fingerprint *a, const struct nv_fingerprint *b, bool changed[NV_FINGERPRINT_CELLS]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,174 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <string.h>
+#include "superres-plan.h"
+
+#define PLAN_ALL_STEPS ((1u << NV_PLAN_STEPS) - 1)
+
+/* The groups being tried by plan_groups, and the best grouping found so far */
+struct plan_search
+{
+	const struct nv_plan_shape *shape;
+	enum nv_plan_buffer used[NV_PLAN_BUFFERS];
+	uint32_t used_count;
+	uint32_t live[NV_PLAN_BUFFERS];
+	int group[NV_PLAN_BUFFERS];
+	uint32_t group_live[NV_PLAN_BUFFERS];
+	size_t group_bytes[NV_PLAN_BUFFERS];
+	uint32_t group_count;
+	struct nv_plan *best;
+};
+
+
+
+/* Returns the mask of the steps from first to last, inclusive */
+static inline uint32_t step_span(enum nv_plan_step first, enum nv_plan_step last)
+{
+	return ((1u << (last + 1)) - 1) & ~((1u << first) - 1);
+}
+
+
+
+uint32_t nv_plan_live_steps(const struct nv_plan_shape *shape, enum nv_plan_buffer buffer)
+{
+	/* A batch reads the SR input and writes the SR output whenever the rest of its group has submitted, the next frame flushes it */
+	const bool batched = shape->sr && shape->batched;
+
+	switch (buffer)
+	{
+	case NV_PLAN_AR_SRC:
+		return shape->ar ? step_span(NV_PLAN_STEP_INPUT, NV_PLAN_STEP_AR) : 0;
+	case NV_PLAN_AR_DST:
+		if (!shape->ar)
+			return 0;
+		if (!shape->sr)
+			return step_span(NV_PLAN_STEP_AR, NV_PLAN_STEP_OUTPUT);
+		if (shape->sr_reads_ar)
+			return batched ? PLAN_ALL_STEPS : step_span(NV_PLAN_STEP_AR, NV_PLAN_STEP_SR);
+
+		return step_span(NV_PLAN_STEP_AR, NV_PLAN_STEP_CONVERT);
+	case NV_PLAN_SR_SRC:
+		if (!shape->sr || (shape->ar && shape->sr_reads_ar))
+			return 0;
+
+		return batched ? PLAN_ALL_STEPS : step_span(shape->ar ? NV_PLAN_STEP_CONVERT : NV_PLAN_STEP_INPUT, NV_PLAN_STEP_SR);
+	case NV_PLAN_SR_DST:
+		if (!shape->sr)
+			return 0;
+
+		return batched ? PLAN_ALL_STEPS : step_span(NV_PLAN_STEP_SR, NV_PLAN_STEP_OUTPUT);
+	default:
+		return 0;
+	}
+}
+
+
+
+/* Tries every grouping of the used buffers from the index-th one on, keeping the one taking the least memory in search->best */
+static void plan_groups(struct plan_search *search, uint32_t index)
+{
+	if (index == search->used_count)
+	{
+		size_t total = 0;
+
+		for (uint32_t i = 0; i < search->group_count; ++i)
+		{
+			total += search->group_bytes[i];
+		}
+
+		/* Fewer allocations break ties */
+		struct nv_plan *best = search->best;
+
+		if (best->backing_count == 0 || total < best->planned_bytes ||
+		    (total == best->planned_bytes && search->group_count < best->backing_count))
+		{
+			for (uint32_t i = 0; i < search->used_count; ++i)
+			{
+				best->backing[search->used[i]] = search->group[i];
+			}
+
+			memcpy(best->backing_bytes, search->group_bytes, sizeof(best->backing_bytes));
+			best->backing_count = search->group_count;
+			best->planned_bytes = total;
+		}
+
+		return;
+	}
+
+	const uint32_t live = search->live[index];
+	const size_t bytes = search->shape->bytes[search->used[index]];
+
+	/* Into any group none of whose buffers are live at the same time, or a group of its own */
+	for (uint32_t g = 0; g <= search->group_count && g < NV_PLAN_BUFFERS; ++g)
+	{
+		const bool new_group = g == search->group_count;
+
+		if (!new_group && (search->group_live[g] & live))
+		{
+			continue;
+		}
+
+		const uint32_t saved_live = new_group ? 0 : search->group_live[g];
+		const size_t saved_bytes = new_group ? 0 : search->group_bytes[g];
+
+		search->group[index] = (int)g;
+		search->group_live[g] = saved_live | live;
+		search->group_bytes[g] = saved_bytes > bytes ? saved_bytes : bytes;
+		search->group_count += new_group ? 1 : 0;
+
+		plan_groups(search, index + 1);
+
+		search->group_count -= new_group ? 1 : 0;
+		search->group_live[g] = saved_live;
+		search->group_bytes[g] = saved_bytes;
+	}
+}
+
+
+
+void nv_plan_buffers(const struct nv_plan_shape *shape, struct nv_plan *plan)
+{
+	struct plan_search search;
+	memset(&search, 0, sizeof(search));
+	memset(plan, 0, sizeof(*plan));
+
+	search.shape = shape;
+	search.best = plan;
+
+	for (uint32_t i = 0; i < NV_PLAN_BUFFERS; ++i)
+	{
+		plan->backing[i] = -1;
+
+		const uint32_t live = nv_plan_live_steps(shape, (enum nv_plan_buffer)i);
+
+		if (live)
+		{
+			search.used[search.used_count] = (enum nv_plan_buffer)i;
+			search.live[search.used_count] = live;
+			search.used_count++;
+			plan->separate_bytes += shape->bytes[i];
+		}
+	}
+
+	/* There are only 15 ways to group 4 buffers, so every one of them is tried */
+	if (search.used_count > 0)
+	{
+		plan_groups(&search, 0);
+	}
+}
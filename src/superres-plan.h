@@ -0,0 +1,90 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The intermediate buffers of the effect pipeline, see process_texture_superres */
+enum nv_plan_buffer
+{
+	NV_PLAN_AR_SRC,
+	NV_PLAN_AR_DST,
+	NV_PLAN_SR_SRC,
+	NV_PLAN_SR_DST,
+	NV_PLAN_BUFFERS
+};
+
+/* The steps of a frame, in the order they're queued on the filter's stream */
+enum nv_plan_step
+{
+	NV_PLAN_STEP_INPUT, // the source is moved into the first effect input
+	NV_PLAN_STEP_AR, // the AR effect runs
+	NV_PLAN_STEP_CONVERT, // the AR output is converted into the Upscaling input
+	NV_PLAN_STEP_SR, // the SuperRes or Upscaling effect runs
+	NV_PLAN_STEP_OUTPUT, // the last effect output is moved into an output slot
+	NV_PLAN_STEPS
+};
+
+/* The shape of a pipeline, which of paths A, B and C it takes and the size of each buffer it uses */
+struct nv_plan_shape
+{
+	bool ar; // the AR pass runs
+	bool sr; // the SuperRes or Upscaling pass runs
+	bool sr_reads_ar; // SuperRes takes the AR output as its input, there is no SR source buffer
+	bool batched; // the SR pass may be run by a batch at any time until the next frame, with its input and output
+	size_t bytes[NV_PLAN_BUFFERS]; // size each buffer needs, those the shape doesn't use are ignored
+};
+
+/* Where each buffer of a pipeline lives. Buffers sharing a backing allocation are never live during the same step */
+struct nv_plan
+{
+	int backing[NV_PLAN_BUFFERS]; // index of the backing allocation of each buffer, -1 for the buffers the shape doesn't use
+	size_t backing_bytes[NV_PLAN_BUFFERS]; // size of each backing allocation, the largest of the buffers it holds
+	uint32_t backing_count;
+	size_t separate_bytes; // what the buffers take with an allocation each
+	size_t planned_bytes; // what the backing allocations take
+};
+
+/*
+* Returns the steps during which a buffer holds something a later step reads, as a mask of 1 << nv_plan_step
+*
+* param shape - the pipeline
+* param buffer - the buffer
+* return - the live steps, 0 if the shape doesn't use the buffer
+*/
+uint32_t nv_plan_live_steps(const struct nv_plan_shape *shape, enum nv_plan_buffer buffer);
+
+/*
+* Groups the buffers of a pipeline into backing allocations, buffers only sharing one if none of them are live during the same step.
+* Of the groupings their lifetimes allow, the one taking the least memory is kept, and of those the one with the fewest allocations
+*
+* param shape - the pipeline
+* param plan - OUTPUT parameter, the plan
+*/
+void nv_plan_buffers(const struct nv_plan_shape *shape, struct nv_plan *plan);
+
+#ifdef __cplusplus
+}
+#endif
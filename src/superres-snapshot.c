@@ -0,0 +1,128 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <util/threading.h>
+#include "superres-snapshot.h"
+
+#define SNAPSHOT_BUFFERS 3
+#define SNAPSHOT_INDEX_MASK 3L
+#define SNAPSHOT_FRESH 4L // the waiting buffer was published since the reader last acquired
+
+struct snapshot_buffer
+{
+	uint64_t generation;
+	void *value;
+};
+
+struct nv_snapshot
+{
+	size_t size;
+	struct snapshot_buffer buffers[SNAPSHOT_BUFFERS];
+	volatile long waiting; // index of the buffer waiting between the writer and the reader, and SNAPSHOT_FRESH
+	long back; // only touched by the writer, the buffer it fills next
+	long front; // only touched by the reader, the buffer it holds
+	uint64_t generation; // only touched by the writer, the generation last published
+};
+
+
+
+struct nv_snapshot *nv_snapshot_create(size_t size, const void *initial)
+{
+	struct nv_snapshot *snapshot = (struct nv_snapshot *)calloc(1, sizeof(*snapshot));
+
+	if (!snapshot)
+	{
+		return NULL;
+	}
+
+	snapshot->size = size;
+
+	for (uint32_t i = 0; i < SNAPSHOT_BUFFERS; ++i)
+	{
+		snapshot->buffers[i].value = malloc(size ? size : 1);
+
+		if (!snapshot->buffers[i].value)
+		{
+			nv_snapshot_destroy(snapshot);
+			return NULL;
+		}
+
+		memcpy(snapshot->buffers[i].value, initial, size);
+	}
+
+	snapshot->front = 0;
+	snapshot->waiting = 1;
+	snapshot->back = 2;
+
+	return snapshot;
+}
+
+
+
+void nv_snapshot_destroy(struct nv_snapshot *snapshot)
+{
+	if (!snapshot)
+	{
+		return;
+	}
+
+	for (uint32_t i = 0; i < SNAPSHOT_BUFFERS; ++i)
+	{
+		free(snapshot->buffers[i].value);
+	}
+
+	free(snapshot);
+}
+
+
+
+uint64_t nv_snapshot_publish(struct nv_snapshot *snapshot, const void *value)
+{
+	struct snapshot_buffer *buffer = &snapshot->buffers[snapshot->back];
+
+	buffer->generation = ++snapshot->generation;
+	memcpy(buffer->value, value, snapshot->size);
+
+	/* The exchange is a full barrier, the reader sees the whole buffer once it sees its index */
+	const long previous = os_atomic_set_long(&snapshot->waiting, snapshot->back | SNAPSHOT_FRESH);
+	snapshot->back = previous & SNAPSHOT_INDEX_MASK;
+
+	return snapshot->generation;
+}
+
+
+
+const void *nv_snapshot_acquire(struct nv_snapshot *snapshot, uint64_t *generation)
+{
+	if (os_atomic_load_long(&snapshot->waiting) & SNAPSHOT_FRESH)
+	{
+		const long previous = os_atomic_set_long(&snapshot->waiting, snapshot->front);
+		snapshot->front = previous & SNAPSHOT_INDEX_MASK;
+	}
+
+	const struct snapshot_buffer *buffer = &snapshot->buffers[snapshot->front];
+
+	if (generation)
+	{
+		*generation = buffer->generation;
+	}
+
+	return buffer->value;
+}
@@ -0,0 +1,70 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+* Hands fixed size values from a writer thread to a reader thread without either of them locking or waiting on the other.
+* There are three buffers: the one the writer fills, the one the reader reads, and the latest value published waiting between them.
+* Publishing fills the writer's buffer and swaps it with the waiting one, acquiring swaps the reader's buffer with the waiting one
+* if something was published since, so the reader always holds a whole value, the latest when it acquired it.
+*/
+struct nv_snapshot;
+
+/*
+* Creates a snapshot holding an initial value, of generation 0.
+* There may only be one writer and one reader at a time, the plugin serializes the writers itself
+*
+* param size - size of the values
+* param initial - the value the reader acquires until something is published, copied
+* return - the snapshot, or NULL if it couldn't be allocated
+*/
+struct nv_snapshot *nv_snapshot_create(size_t size, const void *initial);
+
+/* Destroys a snapshot, neither the writer nor the reader may use it anymore */
+void nv_snapshot_destroy(struct nv_snapshot *snapshot);
+
+/*
+* Writer side, publishes a value
+*
+* param snapshot - the snapshot
+* param value - the value, copied
+* return - the generation of the value, one more than the last one published
+*/
+uint64_t nv_snapshot_publish(struct nv_snapshot *snapshot, const void *value);
+
+/*
+* Reader side, gets the latest value published
+*
+* param snapshot - the snapshot
+* param generation - OUTPUT parameter, the generation of the value, may be NULL
+* return - the value, which doesn't change until the reader acquires again
+*/
+const void *nv_snapshot_acquire(struct nv_snapshot *snapshot, uint64_t *generation);
+
+#ifdef __cplusplus
+}
+#endif
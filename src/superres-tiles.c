@@ -0,0 +1,274 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "superres-tiles.h"
+
+
+
+/* Places a tile input of the given size around a core along one axis, keeping it within the source and aligned when possible */
+static uint32_t place_input(uint32_t core, uint32_t core_end, uint32_t overlap, uint32_t tile, uint32_t size)
+{
+	const uint32_t last = size - tile;
+
+	if (core <= overlap)
+	{
+		return 0;
+	}
+
+	const uint32_t origin = core - overlap > last ? last : core - overlap;
+
+	/* Moving the origin back to the alignment only adds context before the core, unless the input then stops short of its end.
+	* That only happens to the last tile of a source whose size isn't aligned, which stays flush with its edge
+	*/
+	const uint32_t aligned = origin / NV_TILE_ALIGN * NV_TILE_ALIGN;
+	return aligned + tile >= core_end ? aligned : origin;
+}
+
+
+
+static inline bool rects_intersect(const struct nv_rect *a, const struct nv_rect *b)
+{
+	return a->x < b->x + b->width && b->x < a->x + a->width && a->y < b->y + b->height && b->y < a->y + a->height;
+}
+
+
+
+static inline uint32_t scale_coord(uint32_t value, uint32_t size, uint32_t out_size)
+{
+	return (uint32_t)((uint64_t)value * out_size / size);
+}
+
+
+
+bool nv_tile_layout_init(struct nv_tile_layout *layout, uint32_t width, uint32_t height, uint32_t tile_width, uint32_t tile_height,
+			 uint32_t overlap)
+{
+	memset(layout, 0, sizeof(*layout));
+
+	if (width < tile_width || height < tile_height || tile_width <= overlap * 2 + NV_TILE_ALIGN ||
+	    tile_height <= overlap * 2 + NV_TILE_ALIGN)
+	{
+		return false;
+	}
+
+	layout->width = width;
+	layout->height = height;
+	layout->tile_width = tile_width;
+	layout->tile_height = tile_height;
+	layout->overlap = overlap;
+	layout->feather = overlap / 2 / NV_TILE_ALIGN * NV_TILE_ALIGN;
+	/* A tile spanning the whole source along an axis needs no overlap along it */
+	layout->core_width = tile_width == width ? width : (tile_width - overlap * 2) / NV_TILE_ALIGN * NV_TILE_ALIGN;
+	layout->core_height = tile_height == height ? height : (tile_height - overlap * 2) / NV_TILE_ALIGN * NV_TILE_ALIGN;
+	layout->cols = (width + layout->core_width - 1) / layout->core_width;
+	layout->rows = (height + layout->core_height - 1) / layout->core_height;
+
+	return true;
+}
+
+
+
+void nv_tile_at(const struct nv_tile_layout *layout, uint32_t col, uint32_t row, struct nv_tile *tile)
+{
+	tile->core.x = col * layout->core_width;
+	tile->core.y = row * layout->core_height;
+	tile->core.width = layout->width - tile->core.x < layout->core_width ? layout->width - tile->core.x : layout->core_width;
+	tile->core.height = layout->height - tile->core.y < layout->core_height ? layout->height - tile->core.y : layout->core_height;
+
+	tile->input.x = place_input(tile->core.x, tile->core.x + tile->core.width, layout->overlap, layout->tile_width, layout->width);
+	tile->input.y = place_input(tile->core.y, tile->core.y + tile->core.height, layout->overlap, layout->tile_height, layout->height);
+	tile->input.width = layout->tile_width;
+	tile->input.height = layout->tile_height;
+}
+
+
+
+uint32_t nv_tile_plan_dirty(const struct nv_tile_layout *layout, const bool changed[NV_FINGERPRINT_CELLS], struct nv_tile *tiles,
+			    uint32_t max_tiles)
+{
+	uint32_t count = 0;
+
+	for (uint32_t row = 0; row < layout->rows; ++row)
+	{
+		for (uint32_t col = 0; col < layout->cols; ++col)
+		{
+			struct nv_tile tile;
+			nv_tile_at(layout, col, row, &tile);
+
+			bool dirty = false;
+
+			for (uint32_t i = 0; i < NV_FINGERPRINT_CELLS && !dirty; ++i)
+			{
+				if (!changed[i])
+				{
+					continue;
+				}
+
+				uint32_t x1, y1;
+				struct nv_rect cell;
+				nv_fingerprint_cell_bounds(i % NV_FINGERPRINT_GRID, layout->width, &cell.x, &x1);
+				nv_fingerprint_cell_bounds(i / NV_FINGERPRINT_GRID, layout->height, &cell.y, &y1);
+				cell.width = x1 - cell.x;
+				cell.height = y1 - cell.y;
+
+				dirty = rects_intersect(&tile.input, &cell);
+			}
+
+			if (dirty)
+			{
+				if (count < max_tiles)
+				{
+					tiles[count] = tile;
+				}
+
+				++count;
+			}
+		}
+	}
+
+	return count;
+}
+
+
+
+void nv_tile_scale_rect(const struct nv_rect *rect, uint32_t width, uint32_t height, uint32_t out_width, uint32_t out_height,
+			struct nv_rect *scaled)
+{
+	scaled->x = scale_coord(rect->x, width, out_width);
+	scaled->y = scale_coord(rect->y, height, out_height);
+	scaled->width = scale_coord(rect->x + rect->width, width, out_width) - scaled->x;
+	scaled->height = scale_coord(rect->y + rect->height, height, out_height) - scaled->y;
+}
+
+
+
+void nv_tile_composite_rects(const struct nv_tile_layout *layout, const struct nv_tile *tile, uint32_t out_width, uint32_t out_height,
+			     uint32_t tile_out_width, uint32_t tile_out_height, struct nv_rect *src, struct nv_rect *dst)
+{
+	nv_tile_scale_rect(&tile->core, layout->width, layout->height, out_width, out_height, dst);
+
+	src->x = scale_coord(tile->core.x - tile->input.x, layout->tile_width, tile_out_width);
+	src->y = scale_coord(tile->core.y - tile->input.y, layout->tile_height, tile_out_height);
+
+	/* Unaligned edge tiles can be off by a rounded pixel, never read past the tile output */
+	if (src->x + dst->width > tile_out_width)
+	{
+		src->x = tile_out_width - dst->width;
+	}
+
+	if (src->y + dst->height > tile_out_height)
+	{
+		src->y = tile_out_height - dst->height;
+	}
+
+	src->width = dst->width;
+	src->height = dst->height;
+}
+
+
+
+/* Extends a core along one axis by the feather on the sides that have a neighbor, within the input of the tile */
+static void extend_core(uint32_t core, uint32_t core_size, uint32_t input, uint32_t input_size, uint32_t size, uint32_t feather,
+			uint32_t *begin, uint32_t *end)
+{
+	*begin = core > 0 ? core - feather : 0;
+	*end = core + core_size < size ? core + core_size + feather : size;
+
+	*begin = *begin < input ? input : *begin;
+	*end = *end > input + input_size ? input + input_size : *end;
+}
+
+
+
+void nv_tile_blend_rects(const struct nv_tile_layout *layout, const struct nv_tile *tile, uint32_t out_width, uint32_t out_height,
+			 uint32_t tile_out_width, uint32_t tile_out_height, struct nv_rect *src, struct nv_rect *dst, uint32_t *ramp_left,
+			 uint32_t *ramp_top)
+{
+	uint32_t x0, x1, y0, y1;
+	extend_core(tile->core.x, tile->core.width, tile->input.x, tile->input.width, layout->width, layout->feather, &x0, &x1);
+	extend_core(tile->core.y, tile->core.height, tile->input.y, tile->input.height, layout->height, layout->feather, &y0, &y1);
+
+	struct nv_tile region = *tile;
+	region.core.x = x0;
+	region.core.y = y0;
+	region.core.width = x1 - x0;
+	region.core.height = y1 - y0;
+
+	nv_tile_composite_rects(layout, &region, out_width, out_height, tile_out_width, tile_out_height, src, dst);
+
+	/* The band is centered on the boundary, so it ends as far past the start of the core as it starts before it */
+	*ramp_left = tile->core.x > 0 ? scale_coord(tile->core.x * 2 - x0, layout->width, out_width) - dst->x : 0;
+	*ramp_top = tile->core.y > 0 ? scale_coord(tile->core.y * 2 - y0, layout->height, out_height) - dst->y : 0;
+
+	*ramp_left = *ramp_left > dst->width ? dst->width : *ramp_left;
+	*ramp_top = *ramp_top > dst->height ? dst->height : *ramp_top;
+}
+
+
+
+bool nv_tile_simulate_rgba8(const struct nv_tile_layout *layout, const struct nv_tile *tiles, uint32_t count, const uint8_t *src,
+			    uint32_t src_pitch, uint8_t *frame, uint32_t frame_pitch, uint32_t out_width, uint32_t out_height,
+			    uint32_t tile_out_width, uint32_t tile_out_height, nv_tile_process_rgba8_t process, void *param)
+{
+	const uint32_t in_pitch = layout->tile_width * 4;
+	const uint32_t out_pitch = tile_out_width * 4;
+	uint8_t *tile_in = malloc((size_t)in_pitch * layout->tile_height);
+	uint8_t *tile_out = malloc((size_t)out_pitch * tile_out_height);
+
+	if (!tile_in || !tile_out)
+	{
+		free(tile_in);
+		free(tile_out);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const struct nv_tile *tile = &tiles[i];
+
+		for (uint32_t y = 0; y < layout->tile_height; ++y)
+		{
+			memcpy(tile_in + (size_t)y * in_pitch, src + (size_t)(tile->input.y + y) * src_pitch + tile->input.x * 4, in_pitch);
+		}
+
+		process(tile_in, in_pitch, layout->tile_width, layout->tile_height, tile_out, out_pitch, tile_out_width, tile_out_height, param);
+
+		struct nv_rect from, to;
+		uint32_t ramp_left, ramp_top;
+		nv_tile_blend_rects(layout, tile, out_width, out_height, tile_out_width, tile_out_height, &from, &to, &ramp_left, &ramp_top);
+
+		for (uint32_t y = 0; y < to.height; ++y)
+		{
+			uint8_t *dst = frame + (size_t)(to.y + y) * frame_pitch + to.x * 4;
+			const uint8_t *pixel = tile_out + (size_t)(from.y + y) * out_pitch + from.x * 4;
+			const float weight_y = ramp_top ? nv_tile_ramp(y, ramp_top) : 1.0f;
+
+			for (uint32_t x = 0; x < to.width * 4; ++x)
+			{
+				const float weight = weight_y * (ramp_left ? nv_tile_ramp(x / 4, ramp_left) : 1.0f);
+				dst[x] = (uint8_t)(pixel[x] * weight + dst[x] * (1.0f - weight) + 0.5f);
+			}
+		}
+	}
+
+	free(tile_in);
+	free(tile_out);
+	return true;
+}
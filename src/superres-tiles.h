@@ -0,0 +1,189 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "superres-fingerprint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Tile origins and core sizes are kept multiples of this where the frame allows it, so every supported scale
+* (1.33x, 1.5x, 2x, 3x and 4x) maps tile boundaries onto whole output pixels. Only the last column or row of a source whose size
+* isn't a multiple of it can't be, see nv_tile_aligned
+*/
+#define NV_TILE_ALIGN 6
+
+struct nv_rect
+{
+	uint32_t x, y;
+	uint32_t width, height;
+};
+
+/*
+* A tile of the source. The effects are run on the whole of input, which is always tile_width x tile_height of the layout,
+* but only the core and the feather band around it are written back to the output. The overlap around the core gives the effects
+* context to work with, but networks with a receptive field wider than it still output different pixels at the edge of a core than
+* they would have on the full frame, which is why the output is feathered across the boundary rather than cut, see nv_tile_blend_rects.
+*/
+struct nv_tile
+{
+	struct nv_rect input; // region of the source fed to the effects
+	struct nv_rect core; // region of the source this tile is responsible for, always within input
+};
+
+/* Splits a source into a grid of cores, each expanded into a fixed size tile with the given overlap on every side */
+struct nv_tile_layout
+{
+	uint32_t width, height; // size of the source
+	uint32_t tile_width, tile_height; // size of the input of every tile
+	uint32_t overlap; // source pixels of context kept around each core
+	uint32_t feather; // source pixels on either side of the boundary between two cores that their outputs are blended over
+	uint32_t core_width, core_height; // size of every core except the last column and row, which may be smaller
+	uint32_t cols, rows;
+};
+
+/*
+* Initializes a tile layout
+*
+* param layout - the layout to initialize
+* param width - width of the source
+* param height - height of the source
+* param tile_width - width of the input of every tile
+* param tile_height - height of the input of every tile
+* param overlap - pixels of context around each core, the core of a tile is tile size - 2 * overlap rounded down to NV_TILE_ALIGN,
+*	or the whole source along an axis the tile spans completely
+* return - False if the source is smaller than a tile, or the tile too small for the overlap, True otherwise
+*/
+bool nv_tile_layout_init(struct nv_tile_layout *layout, uint32_t width, uint32_t height, uint32_t tile_width, uint32_t tile_height,
+			 uint32_t overlap);
+
+/*
+* Returns the tile at the given column and row of a layout
+*/
+void nv_tile_at(const struct nv_tile_layout *layout, uint32_t col, uint32_t row, struct nv_tile *tile);
+
+/*
+* Returns true if the input of a tile starts on NV_TILE_ALIGN, so its output lines up with the output of the whole frame
+*/
+static inline bool nv_tile_aligned(const struct nv_tile *tile)
+{
+	return tile->input.x % NV_TILE_ALIGN == 0 && tile->input.y % NV_TILE_ALIGN == 0;
+}
+
+/*
+* Plans the tiles that have to be processed again for the changed cells of a fingerprint comparison.
+* A tile is included when any changed cell overlaps its input, as changes in the overlap affect the core through the effects' context.
+*
+* param layout - the tile layout of the source
+* param changed - cells of the fingerprint grid that changed, see nv_fingerprint_diff
+* param tiles - receives up to max_tiles tiles, in row order
+* param max_tiles - size of tiles
+* return - the number of tiles that have to be processed, which may be larger than max_tiles
+*/
+uint32_t nv_tile_plan_dirty(const struct nv_tile_layout *layout, const bool changed[NV_FINGERPRINT_CELLS], struct nv_tile *tiles,
+			    uint32_t max_tiles);
+
+/*
+* Maps a rectangle of a source onto the output the source is scaled to, rounding both edges down
+*/
+void nv_tile_scale_rect(const struct nv_rect *rect, uint32_t width, uint32_t height, uint32_t out_width, uint32_t out_height,
+			struct nv_rect *scaled);
+
+/*
+* Computes where the core of a processed tile is copied from and to
+*
+* param layout - the tile layout of the source
+* param tile - the tile that was processed
+* param out_width - width of the whole output
+* param out_height - height of the whole output
+* param tile_out_width - width of the output of a tile
+* param tile_out_height - height of the output of a tile
+* param src - receives the rectangle of the tile output holding the core
+* param dst - receives the rectangle of the whole output the core is copied to, the same size as src
+*/
+void nv_tile_composite_rects(const struct nv_tile_layout *layout, const struct nv_tile *tile, uint32_t out_width, uint32_t out_height,
+			     uint32_t tile_out_width, uint32_t tile_out_height, struct nv_rect *src, struct nv_rect *dst);
+
+/*
+* Computes the region of a processed tile that is written back to the output, its core extended by the layout's feather on every side
+* that has a neighboring tile. The output is blended over what's already there along the left and top sides, ramping from the
+* neighbor's output to the tile's across 2 * feather source pixels, and copied as is everywhere else. Tiles have to be written in row
+* order for every band to be blended from a neighbor written before it
+*
+* param layout - the tile layout of the source
+* param tile - the tile that was processed
+* param out_width - width of the whole output
+* param out_height - height of the whole output
+* param tile_out_width - width of the output of a tile
+* param tile_out_height - height of the output of a tile
+* param src - receives the rectangle of the tile output that is written back
+* param dst - receives the rectangle of the whole output it is written to, the same size as src
+* param ramp_left - receives the width of the band blended along the left of src, 0 if there's no tile to the left
+* param ramp_top - receives the height of the band blended along the top of src, 0 if there's no tile above
+*/
+void nv_tile_blend_rects(const struct nv_tile_layout *layout, const struct nv_tile *tile, uint32_t out_width, uint32_t out_height,
+			 uint32_t tile_out_width, uint32_t tile_out_height, struct nv_rect *src, struct nv_rect *dst, uint32_t *ramp_left,
+			 uint32_t *ramp_top);
+
+/*
+* Returns the weight of the tile output at the given position within a blended band, see nv_tile_blend_rects
+*/
+static inline float nv_tile_ramp(uint32_t position, uint32_t ramp)
+{
+	return position < ramp ? ((float)position + 0.5f) / (float)ramp : 1.0f;
+}
+
+/*
+* An effect applied to a single chunky RGBA U8 tile by nv_tile_simulate_rgba8
+*/
+typedef void (*nv_tile_process_rgba8_t)(const uint8_t *src, uint32_t src_pitch, uint32_t width, uint32_t height, uint8_t *dst,
+					uint32_t dst_pitch, uint32_t out_width, uint32_t out_height, void *param);
+
+/*
+* CPU simulation of the tiled processing done on the GPU by the filter, on chunky RGBA U8 images.
+* Each tile's input is cropped from src, run through process, and written into the retained output frame as in nv_tile_blend_rects,
+* leaving everything outside the given tiles untouched. Used to check the coverage and placement of tiles without a GPU, it can't
+* tell how visible the seams of an actual network are.
+*
+* param layout - the tile layout of src
+* param tiles - the tiles to process
+* param count - the number of tiles
+* param src - pointer to pixel (0, 0) of the source
+* param src_pitch - byte stride between rows of src
+* param frame - pointer to pixel (0, 0) of the retained output, out_width x out_height
+* param frame_pitch - byte stride between rows of frame
+* param out_width - width of the whole output
+* param out_height - height of the whole output
+* param tile_out_width - width process scales a tile to
+* param tile_out_height - height process scales a tile to
+* param process - the effect to run on every tile
+* param param - passed through to process
+* return - False if the scratch buffers could not be allocated, True otherwise
+*/
+bool nv_tile_simulate_rgba8(const struct nv_tile_layout *layout, const struct nv_tile *tiles, uint32_t count, const uint8_t *src,
+			    uint32_t src_pitch, uint8_t *frame, uint32_t frame_pitch, uint32_t out_width, uint32_t out_height,
+			    uint32_t tile_out_width, uint32_t tile_out_height, nv_tile_process_rgba8_t process, void *param);
+
+#ifdef __cplusplus
+}
+#endif
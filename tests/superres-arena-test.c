@@ -0,0 +1,184 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include "superres-arena.h"
+#include "superres-tests.h"
+
+
+
+/* Hands out addresses 1 GB apart, so chunks never touch, and counts what's reserved */
+struct stub_backend
+{
+	uint64_t next;
+	int64_t live;
+};
+
+static uint64_t stub_reserve(void *context, size_t bytes)
+{
+	struct stub_backend *stub = (struct stub_backend *)context;
+
+	if (bytes > (1ull << 30))
+	{
+		return 0;
+	}
+
+	stub->next += 1ull << 30;
+	stub->live++;
+
+	return stub->next;
+}
+
+static void stub_release(void *context, uint64_t address)
+{
+	(void)address;
+	((struct stub_backend *)context)->live--;
+}
+
+
+
+/* Checks the blocks handed out are aligned and don't overlap each other */
+static bool stub_blocks_disjoint(const uint64_t *addresses, const size_t *sizes, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (!addresses[i] || addresses[i] % NV_ARENA_BLOCK_ALIGN)
+		{
+			return false;
+		}
+
+		for (uint32_t j = i + 1; j < count; ++j)
+		{
+			if (addresses[j] < addresses[i] + sizes[i] && addresses[i] < addresses[j] + sizes[j])
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+
+bool nv_arena_stub_check(void)
+{
+	struct stub_backend stub = {0};
+	const struct nv_arena_backend backend = {stub_reserve, stub_release, &stub};
+	const size_t chunk = 64ull << 20;
+
+	struct nv_arena *arena = nv_arena_create(&backend, chunk, 256);
+
+	if (!arena)
+	{
+		return false;
+	}
+
+	bool success = nv_arena_pitch(arena, 1) == 256 && nv_arena_pitch(arena, 256) == 256 && nv_arena_pitch(arena, 7681) == 7936;
+
+	/* A chunk reserved up front, as the plugin does when it's loaded, which trim keeps */
+	struct nv_arena_stats stats;
+	success = success && nv_arena_reserve(arena, chunk);
+	nv_arena_trim(arena);
+	nv_arena_get_stats(arena, &stats);
+	success = success && stats.chunks == 1 && stats.reserved == chunk && stats.reservations == 1 && stats.blocks == 0;
+
+	/* The buffers of a pipeline at 720p -> 1440p, then at 1080p -> 2160p, then back */
+	const size_t sizes[][4] =
+	{
+		{1280 * 720 * 12, 1280 * 720 * 12, 2560 * 1440 * 4, 1000},
+		{1920 * 1080 * 12, 1920 * 1080 * 12, 3840 * 2160 * 4, 3000},
+		{1280 * 720 * 12, 1280 * 720 * 12, 2560 * 1440 * 4, 1000},
+	};
+
+	uint64_t addresses[4] = {0};
+	size_t capacities[4] = {0};
+	uint64_t reservations = stats.reservations;
+
+	for (uint32_t s = 0; s < 3 && success; ++s)
+	{
+		/* Freed from the first buffer on or from the last one, so ranges are merged on both sides */
+		for (uint32_t k = 0; k < 4; ++k)
+		{
+			const uint32_t i = s % 2 ? 3 - k : k;
+			nv_arena_free(arena, addresses[i]);
+			addresses[i] = nv_arena_alloc(arena, sizes[s][i], sizes[s][i] / 16, &capacities[i]);
+			success = success && capacities[i] >= sizes[s][i];
+		}
+
+		success = success && stub_blocks_disjoint(addresses, capacities, 4);
+
+		nv_arena_get_stats(arena, &stats);
+
+		uint64_t used = 0;
+
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			used += capacities[i];
+		}
+
+		success = success && stats.blocks == 4 && stats.used == used && stats.used <= stats.reserved &&
+			  stats.wasted >= (sizes[s][0] + sizes[s][1] + sizes[s][2] + sizes[s][3]) / 16 && stats.wasted < stats.used &&
+			  stats.chunks == (uint32_t)stub.live;
+
+		/* Going back to a size held before reuses the memory reserved for it */
+		if (s == 2)
+		{
+			success = success && stats.reservations == reservations;
+		}
+
+		reservations = stats.reservations;
+	}
+
+	/* A block larger than a chunk gets one of its own, which trim releases once it's freed */
+	const uint64_t large = nv_arena_alloc(arena, chunk * 2, 0, NULL);
+	nv_arena_get_stats(arena, &stats);
+	success = success && large && stats.reservations == reservations + 1;
+
+	nv_arena_free(arena, large);
+	nv_arena_trim(arena);
+	nv_arena_get_stats(arena, &stats);
+	success = success && stats.reservations == reservations + 1 && stats.chunks == (uint32_t)stub.live && stats.blocks == 4;
+
+	/* A freed block is merged back, so the whole chunk can be handed out again */
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		nv_arena_free(arena, addresses[i]);
+	}
+
+	nv_arena_get_stats(arena, &stats);
+	success = success && stats.used == 0 && stats.wasted == 0 && stats.blocks == 0;
+
+	const uint64_t whole = nv_arena_alloc(arena, chunk, 0, NULL);
+	nv_arena_get_stats(arena, &stats);
+	success = success && whole && stats.reservations == reservations + 1;
+	nv_arena_free(arena, whole);
+
+	/* Failing to reserve fails the block, and freeing something the arena never handed out does nothing */
+	success = success && nv_arena_alloc(arena, 2ull << 30, 0, NULL) == 0;
+	nv_arena_free(arena, 12345);
+
+	/* Trim releases everything but the chunk reserved up front, which only goes with the arena */
+	nv_arena_trim(arena);
+	nv_arena_get_stats(arena, &stats);
+	success = success && stats.chunks == 1 && stats.reserved == chunk && stub.live == 1;
+
+	nv_arena_destroy(arena);
+
+	return success && stub.live == 0;
+}
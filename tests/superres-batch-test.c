@@ -0,0 +1,262 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <util/c99defs.h>
+#include "superres-batch.h"
+#include "superres-tests.h"
+
+
+
+/* return - the byte the stub backend outputs for a byte of an input, at the given offset within the frame */
+static uint8_t stub_expected(uint8_t input, size_t offset)
+{
+	return (uint8_t)(input * 31u + offset * 7u + 1u);
+}
+
+
+
+/* The stub backend's batch, the stacked inputs and outputs of up to capacity frames */
+struct stub_batch
+{
+	uint32_t capacity;
+	size_t frame_size;
+	uint8_t *src;
+	uint8_t *dst;
+};
+
+
+
+static void *stub_create(void *context, const struct nv_batch_key *key, uint32_t capacity)
+{
+	UNUSED_PARAMETER(context);
+
+	struct stub_batch *batch = calloc(1, sizeof(*batch));
+
+	if (!batch)
+	{
+		return NULL;
+	}
+
+	batch->capacity = capacity;
+	batch->frame_size = (size_t)key->width * key->height;
+	batch->src = malloc(batch->frame_size * capacity);
+	batch->dst = malloc(batch->frame_size * capacity);
+
+	if (!batch->src || !batch->dst)
+	{
+		free(batch->src);
+		free(batch->dst);
+		free(batch);
+		return NULL;
+	}
+
+	return batch;
+}
+
+
+
+static bool stub_run(void *context, void *data, const struct nv_batch_io *items, uint32_t count)
+{
+	UNUSED_PARAMETER(context);
+
+	struct stub_batch *batch = data;
+
+	if (count > batch->capacity)
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		memcpy(batch->src + i * batch->frame_size, items[i].input, batch->frame_size);
+	}
+
+	/* Like the effect, the stub works on the whole stacked buffer without knowing where one frame ends and the next begins */
+	for (size_t offset = 0; offset < batch->frame_size * count; ++offset)
+	{
+		batch->dst[offset] = stub_expected(batch->src[offset], offset % batch->frame_size);
+	}
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		memcpy(items[i].output, batch->dst + i * batch->frame_size, batch->frame_size);
+	}
+
+	return true;
+}
+
+
+
+static void stub_destroy(void *context, void *data)
+{
+	UNUSED_PARAMETER(context);
+
+	struct stub_batch *batch = data;
+
+	free(batch->src);
+	free(batch->dst);
+	free(batch);
+}
+
+
+
+/*
+* A backend that stands in for NvVFX to check the batching itself. The inputs and outputs of its frames are arrays of
+* key->width * key->height bytes, it stacks the inputs into a single buffer the way NvVFX expects batched images,
+* then writes each output from the frame at the same index of the stacked buffer as stub_expected would from the member's own input
+*/
+static void stub_backend(struct nv_batch_backend *backend)
+{
+	backend->create = stub_create;
+	backend->run = stub_run;
+	backend->destroy = stub_destroy;
+	backend->context = NULL;
+}
+
+
+
+#define STUB_FRAMES 8
+#define STUB_FRAME_SIZE 64
+
+struct stub_member
+{
+	struct nv_batch_member *member;
+	size_t size;
+	uint8_t input[STUB_FRAME_SIZE];
+	uint8_t output[STUB_FRAME_SIZE];
+	uint32_t submitted; // frames submitted and not dropped
+	uint32_t completed; // frames completed with the right output
+	bool failed; // a frame was completed with the wrong output, or unsuccessfully
+};
+
+
+
+static void stub_complete(void *user, bool success)
+{
+	struct stub_member *stub = user;
+
+	for (size_t offset = 0; offset < stub->size; ++offset)
+	{
+		if (stub->output[offset] != stub_expected(stub->input[offset], offset))
+		{
+			success = false;
+		}
+	}
+
+	if (success)
+	{
+		stub->completed++;
+	}
+	else
+	{
+		stub->failed = true;
+	}
+}
+
+
+
+bool nv_batch_stub_check(uint32_t members)
+{
+	struct stub_member stubs[2 * NV_BATCH_MAX];
+
+	/* Every third member has a configuration of its own */
+	const struct nv_batch_key keys[2] =
+	{
+		{"SuperRes", 1, 0.0f, 0, 16, 4, 32, 8},
+		{"SuperRes", 1, 0.0f, 0, 8, 8, 16, 16},
+	};
+
+	if (members > 2 * NV_BATCH_MAX)
+	{
+		return false;
+	}
+
+	struct nv_batch_backend backend;
+	stub_backend(&backend);
+
+	struct nv_batch_service *service = nv_batch_service_create(&backend);
+
+	if (!service)
+	{
+		return false;
+	}
+
+	bool success = true;
+	memset(stubs, 0, sizeof(stubs));
+
+	for (uint32_t i = 0; i < members && success; ++i)
+	{
+		const struct nv_batch_key *key = &keys[i % 3 == 2];
+		stubs[i].size = (size_t)key->width * key->height;
+		stubs[i].member = nv_batch_join(service, key, stub_complete);
+		success = stubs[i].member != NULL;
+	}
+
+	for (uint64_t frame = 0; frame < STUB_FRAMES && success; ++frame)
+	{
+		/* The first member is removed for a couple of frames, dropping whatever it had pending */
+		if (frame == 3 && members > 0)
+		{
+			if (nv_batch_member_pending(stubs[0].member))
+			{
+				stubs[0].submitted--;
+			}
+
+			nv_batch_leave(stubs[0].member);
+			stubs[0].member = NULL;
+		}
+		else if (frame == 5 && members > 0)
+		{
+			stubs[0].member = nv_batch_join(service, &keys[0], stub_complete);
+			success = stubs[0].member != NULL;
+		}
+
+		for (uint32_t i = 0; i < members && success; ++i)
+		{
+			/* Members skip frames now and then, as sources that aren't visible do */
+			if (!stubs[i].member || (i + frame) % 5 == 4)
+			{
+				continue;
+			}
+
+			for (size_t offset = 0; offset < stubs[i].size; ++offset)
+			{
+				stubs[i].input[offset] = (uint8_t)(i * 37 + frame * 11 + offset);
+			}
+
+			const struct nv_batch_io io = {stubs[i].input, stubs[i].output, &stubs[i]};
+			success = nv_batch_submit(stubs[i].member, &io, frame);
+			stubs[i].submitted++;
+		}
+	}
+
+	nv_batch_flush(service);
+
+	for (uint32_t i = 0; i < members; ++i)
+	{
+		success = success && !stubs[i].failed && stubs[i].completed == stubs[i].submitted;
+		nv_batch_leave(stubs[i].member);
+	}
+
+	nv_batch_service_destroy(service);
+
+	return success;
+}
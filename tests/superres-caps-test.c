@@ -0,0 +1,116 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include <stdlib.h>
+#include "superres-caps.h"
+#include "superres-tests.h"
+
+
+
+/* Stands in for NvVFX, accepting inputs up to 1920x1080 and counting how often it's asked */
+struct stub_probe
+{
+	uint32_t calls;
+};
+
+static enum nv_caps_result stub_probe(void *context, const struct nv_caps_key *key)
+{
+	struct stub_probe *probe = (struct stub_probe *)context;
+	probe->calls++;
+
+	return key->width <= 1920 && key->height <= 1080 ? NV_CAPS_ACCEPTED : NV_CAPS_REJECTED;
+}
+
+/* Fails the check if it's ever asked, for tables that should already know everything */
+static enum nv_caps_result stub_unreachable(void *context, const struct nv_caps_key *key)
+{
+	(void)key;
+	*(bool *)context = false;
+
+	return NV_CAPS_UNKNOWN;
+}
+
+
+
+bool nv_caps_stub_check(void)
+{
+	const struct nv_caps_key keys[] =
+	{
+		{"SuperRes", 1, 1280, 720, 2560, 1440},
+		{"SuperRes", 1, 2560, 1440, 5120, 2880},
+		{"SuperRes", 0, 1280, 720, 2560, 1440},
+		{"ArtifactReduction", 0, 2560, 1440, 2560, 1440},
+		{"ArtifactReduction", 0, 1920, 1080, 1920, 1080},
+	};
+	const uint32_t key_count = sizeof(keys) / sizeof(keys[0]);
+
+	struct nv_caps *caps = nv_caps_create("Stub GPU\ndriver 1");
+	struct nv_caps *reloaded = nv_caps_create("Stub GPU\ndriver 1");
+	struct nv_caps *other = nv_caps_create("Stub GPU\ndriver 2");
+	char *text = NULL;
+	bool success = caps && reloaded && other;
+
+	struct stub_probe probe = {0};
+
+	/* Each configuration is probed once, however often it's asked for */
+	for (uint32_t pass = 0; pass < 2 && success; ++pass)
+	{
+		for (uint32_t i = 0; i < key_count && success; ++i)
+		{
+			const enum nv_caps_result expected = stub_probe(&(struct stub_probe){0}, &keys[i]);
+			success = nv_caps_probe(caps, &keys[i], stub_probe, &probe) == expected;
+		}
+	}
+
+	success = success && probe.calls == key_count && nv_caps_modified(caps);
+
+	if (success)
+	{
+		nv_caps_set_max_input(caps, "SuperRes", 1920, 1080);
+
+		const size_t len = nv_caps_serialize(caps, NULL, 0);
+		text = (char *)malloc(len + 1);
+		success = text && nv_caps_serialize(caps, text, len + 1) == len && !nv_caps_modified(caps);
+	}
+
+	/* The same device reads every outcome back, another device reads none of them */
+	success = success && nv_caps_parse(reloaded, text) && !nv_caps_parse(other, text);
+
+	for (uint32_t i = 0; i < key_count && success; ++i)
+	{
+		success = nv_caps_probe(reloaded, &keys[i], stub_unreachable, &success) == nv_caps_lookup(caps, &keys[i]) &&
+			  nv_caps_lookup(other, &keys[i]) == NV_CAPS_UNKNOWN;
+	}
+
+	uint32_t width = 0;
+	uint32_t height = 0;
+	success = success && nv_caps_max_input(reloaded, "SuperRes", &width, &height) && width == 1920 && height == 1080 &&
+		  !nv_caps_max_input(other, "SuperRes", &width, &height) && !nv_caps_modified(reloaded);
+
+	/* A malformed line means nothing is read */
+	success = success && !nv_caps_parse(other, "nv-superres-caps 1\ndevice Stub GPU driver 2\nmax SuperRes 1920\n") &&
+		  !nv_caps_max_input(other, "SuperRes", &width, &height);
+
+	free(text);
+	nv_caps_destroy(caps);
+	nv_caps_destroy(reloaded);
+	nv_caps_destroy(other);
+
+	return success;
+}
@@ -0,0 +1,223 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+
+#include <math.h>
+#include <string.h>
+#include "superres-convert.h"
+#include "superres-tests.h"
+
+
+
+/* Small enough to spell out, with rows padded past the pixels so the pitches are honored rather than assumed */
+#define CONVERT_WIDTH 3
+#define CONVERT_HEIGHT 2
+#define CONVERT_PITCH (CONVERT_WIDTH * 4 + 4)
+#define PLANAR_PITCH ((CONVERT_WIDTH + 1) * sizeof(float))
+#define PLANAR_FLOATS (PLANAR_PITCH / sizeof(float) * CONVERT_HEIGHT * NV_PLANAR_PLANES)
+
+/* Filler of the padding, which neither conversion may write to */
+#define PADDING 0xCD
+
+/* return - the component at x, y of the given plane of a planar image with a pitch of PLANAR_PITCH */
+static inline float *planar_at(float *planar, uint32_t plane, uint32_t x, uint32_t y)
+{
+	return planar + (plane * CONVERT_HEIGHT + y) * (PLANAR_PITCH / sizeof(float)) + x;
+}
+
+/* Fills a chunky image with every component of every pixel distinct, alpha included so it can't stand in for one of them */
+static void fill_chunky(uint8_t chunky[CONVERT_HEIGHT * CONVERT_PITCH])
+{
+	memset(chunky, PADDING, CONVERT_HEIGHT * CONVERT_PITCH);
+
+	for (uint32_t y = 0; y < CONVERT_HEIGHT; ++y)
+	{
+		for (uint32_t x = 0; x < CONVERT_WIDTH; ++x)
+		{
+			uint8_t *pixel = chunky + y * CONVERT_PITCH + x * 4;
+			const uint8_t i = (uint8_t)(y * CONVERT_WIDTH + x);
+
+			pixel[0] = 10 + i;
+			pixel[1] = 100 + i;
+			pixel[2] = 200 + i;
+			pixel[3] = 50 + i;
+		}
+	}
+}
+
+
+
+bool nv_convert_planar_check(void)
+{
+	uint8_t chunky[CONVERT_HEIGHT * CONVERT_PITCH];
+	fill_chunky(chunky);
+
+	const float scales[2] = {NV_PLANAR_SCALE_UNIT, NV_PLANAR_SCALE_BYTE};
+	float planar[PLANAR_FLOATS];
+	bool success = true;
+
+	for (uint32_t s = 0; s < 2 && success; ++s)
+	{
+		for (uint32_t order = 0; order < 2 && success; ++order)
+		{
+			const bool bgra = order == 1;
+
+			/* The planes are B, G then R, so the first one is read from the last component of RGBA and the first of BGRA */
+			const uint32_t offsets[NV_PLANAR_PLANES] = {bgra ? 0 : 2, 1, bgra ? 2 : 0};
+
+			memset(planar, 0, sizeof(planar));
+			nv_convert_rgba8_to_planar_f32(chunky, CONVERT_PITCH, CONVERT_WIDTH, CONVERT_HEIGHT, bgra, scales[s], planar, PLANAR_PITCH);
+
+			for (uint32_t plane = 0; plane < NV_PLANAR_PLANES && success; ++plane)
+			{
+				for (uint32_t y = 0; y < CONVERT_HEIGHT && success; ++y)
+				{
+					for (uint32_t x = 0; x < CONVERT_WIDTH && success; ++x)
+					{
+						const uint8_t value = chunky[y * CONVERT_PITCH + x * 4 + offsets[plane]];
+						success = *planar_at(planar, plane, x, y) == (float)value * scales[s];
+					}
+
+					success = success && *planar_at(planar, plane, CONVERT_WIDTH, y) == 0.0f;
+				}
+			}
+		}
+	}
+
+	return success;
+}
+
+
+
+/* return - true if the padding at the end of every row of a chunky image is untouched */
+static bool padding_intact(const uint8_t chunky[CONVERT_HEIGHT * CONVERT_PITCH])
+{
+	for (uint32_t y = 0; y < CONVERT_HEIGHT; ++y)
+	{
+		for (uint32_t i = CONVERT_WIDTH * 4; i < CONVERT_PITCH; ++i)
+		{
+			if (chunky[y * CONVERT_PITCH + i] != PADDING)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+
+bool nv_convert_resolve_check(void)
+{
+	uint8_t chunky[CONVERT_HEIGHT * CONVERT_PITCH];
+	fill_chunky(chunky);
+
+	const float scales[2] = {NV_PLANAR_SCALE_UNIT, NV_PLANAR_SCALE_BYTE};
+	float planar[PLANAR_FLOATS];
+	uint8_t resolved[CONVERT_HEIGHT * CONVERT_PITCH];
+	bool success = true;
+
+	/* Converting then resolving gives the source back in either order and at either scale, with alpha made opaque */
+	for (uint32_t s = 0; s < 2 && success; ++s)
+	{
+		for (uint32_t order = 0; order < 2 && success; ++order)
+		{
+			nv_convert_rgba8_to_planar_f32(chunky, CONVERT_PITCH, CONVERT_WIDTH, CONVERT_HEIGHT, order == 1, scales[s], planar,
+						       PLANAR_PITCH);
+
+			memset(resolved, PADDING, sizeof(resolved));
+			nv_convert_planar_f32_to_rgba8(planar, PLANAR_PITCH, CONVERT_WIDTH, CONVERT_HEIGHT, NV_PLANAR_SCALE_UNIT / scales[s],
+						       order == 1, resolved, CONVERT_PITCH);
+
+			for (uint32_t i = 0; i < CONVERT_WIDTH * CONVERT_HEIGHT && success; ++i)
+			{
+				const uint8_t *in = chunky + i / CONVERT_WIDTH * CONVERT_PITCH + i % CONVERT_WIDTH * 4;
+				const uint8_t *out = resolved + i / CONVERT_WIDTH * CONVERT_PITCH + i % CONVERT_WIDTH * 4;
+				success = memcmp(in, out, 3) == 0 && out[3] == 255;
+			}
+
+			success = success && padding_intact(resolved);
+		}
+	}
+
+	/* Components of the planar image at unit scale, and the 8 bit value each resolves to. Past either end of the range is clamped,
+	* NaN included, and a value half way between two 8 bit values rounds up
+	*/
+	const float inputs[CONVERT_HEIGHT][CONVERT_WIDTH][NV_PLANAR_PLANES] =
+	{
+		{{-1.0f, -0.001f, 1.001f}, {2.0f, 0.0f, 1.0f}, {0.5f, 127.49f / 255.0f, 127.51f / 255.0f}},
+		{{0.49f / 255.0f, 0.51f / 255.0f, 254.49f / 255.0f}, {254.51f / 255.0f, 64.0f / 255.0f, NAN}, {-0.0f, 1e30f, -1e30f}},
+	};
+	const uint8_t expected[CONVERT_HEIGHT][CONVERT_WIDTH][NV_PLANAR_PLANES] =
+	{
+		{{0, 0, 255}, {255, 0, 255}, {128, 127, 128}},
+		{{0, 1, 254}, {255, 64, 0}, {0, 255, 0}},
+	};
+
+	for (uint32_t s = 0; s < 2 && success; ++s)
+	{
+		/* The same values stored at byte scale resolve the same once brought back to unit scale */
+		for (uint32_t plane = 0; plane < NV_PLANAR_PLANES; ++plane)
+		{
+			for (uint32_t y = 0; y < CONVERT_HEIGHT; ++y)
+			{
+				for (uint32_t x = 0; x < CONVERT_WIDTH; ++x)
+				{
+					*planar_at(planar, plane, x, y) = inputs[y][x][plane] * (scales[s] / NV_PLANAR_SCALE_UNIT);
+				}
+			}
+		}
+
+		for (uint32_t order = 0; order < 2 && success; ++order)
+		{
+			const bool bgra = order == 1;
+			const uint32_t offsets[NV_PLANAR_PLANES] = {bgra ? 0 : 2, 1, bgra ? 2 : 0};
+
+			/* Alpha starts out as 0, so it's only 255 if it's written */
+			fill_chunky(resolved);
+			for (uint32_t y = 0; y < CONVERT_HEIGHT; ++y)
+			{
+				memset(resolved + y * CONVERT_PITCH, 0, CONVERT_WIDTH * 4);
+			}
+
+			nv_convert_planar_f32_to_rgba8(planar, PLANAR_PITCH, CONVERT_WIDTH, CONVERT_HEIGHT, NV_PLANAR_SCALE_UNIT / scales[s], bgra,
+						       resolved, CONVERT_PITCH);
+
+			for (uint32_t y = 0; y < CONVERT_HEIGHT && success; ++y)
+			{
+				for (uint32_t x = 0; x < CONVERT_WIDTH && success; ++x)
+				{
+					const uint8_t *pixel = resolved + y * CONVERT_PITCH + x * 4;
+
+					for (uint32_t plane = 0; plane < NV_PLANAR_PLANES; ++plane)
+					{
+						success = success && pixel[offsets[plane]] == expected[y][x][plane];
+					}
+
+					success = success && pixel[3] == 255;
+				}
+			}
+
+			success = success && padding_intact(resolved);
+		}
+	}
+
+	return success;
+}
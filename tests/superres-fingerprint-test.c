@@ -0,0 +1,236 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "superres-convert.h"
+#include "superres-fingerprint.h"
+#include "superres-tests.h"
+
+
+
+/* Sizes that don't divide into the grid evenly, so cells differ in size by a pixel */
+#define FRAME_WIDTH 70
+#define FRAME_HEIGHT 41
+#define FRAME_PITCH (FRAME_WIDTH * 4)
+
+/* A 4K frame, each cell of which sums to well past 2^23 */
+#define LARGE_WIDTH 3840
+#define LARGE_HEIGHT 2160
+
+/* return - the cell of the grid holding the pixel at x, y */
+static uint32_t cell_of(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+	uint32_t col = 0;
+	uint32_t row = 0;
+	uint32_t begin, end;
+
+	for (nv_fingerprint_cell_bounds(col, width, &begin, &end); x >= end; nv_fingerprint_cell_bounds(++col, width, &begin, &end))
+		;
+	for (nv_fingerprint_cell_bounds(row, height, &begin, &end); y >= end; nv_fingerprint_cell_bounds(++row, height, &begin, &end))
+		;
+
+	return row * NV_FINGERPRINT_GRID + col;
+}
+
+/* return - true if changed holds exactly the expected cells and count their number */
+static bool only_changed(const bool changed[NV_FINGERPRINT_CELLS], uint32_t count, const uint32_t *cells, uint32_t cell_count)
+{
+	if (count != cell_count)
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < NV_FINGERPRINT_CELLS; ++i)
+	{
+		bool expected = false;
+
+		for (uint32_t j = 0; j < cell_count; ++j)
+		{
+			expected = expected || cells[j] == i;
+		}
+
+		if (changed[i] != expected)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void fill_noise(uint8_t *pixels, size_t bytes)
+{
+	uint32_t seed = 0x1B873593u;
+
+	for (size_t i = 0; i < bytes; ++i)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		pixels[i] = (uint8_t)(seed >> 24);
+	}
+}
+
+
+
+/* Checks the sums of every cell of a frame against sums taken in 64 bits and then reduced, so they can't have wrapped early */
+static bool sums_wrap(const uint8_t *frame, uint32_t width, uint32_t height, const struct nv_fingerprint *fingerprint)
+{
+	bool wrapped = false;
+
+	for (uint32_t i = 0; i < NV_FINGERPRINT_CELLS; ++i)
+	{
+		uint32_t x0, x1, y0, y1;
+		nv_fingerprint_cell_bounds(i % NV_FINGERPRINT_GRID, width, &x0, &x1);
+		nv_fingerprint_cell_bounds(i / NV_FINGERPRINT_GRID, height, &y0, &y1);
+
+		uint64_t sums[4] = {0, 0, 0, 0};
+
+		for (uint32_t y = y0; y < y1; ++y)
+		{
+			for (uint32_t x = x0; x < x1; ++x)
+			{
+				const uint8_t *pixel = frame + ((size_t)y * width + x) * 4;
+				uint32_t weights[4];
+				nv_fingerprint_weights(x, y, weights);
+
+				sums[0] += (uint64_t)weights[0] * pixel[0];
+				sums[1] += (uint64_t)weights[1] * pixel[1];
+				sums[2] += (uint64_t)weights[2] * pixel[2];
+				sums[3] += (uint64_t)weights[3] * (pixel[0] + pixel[1] * 2 + pixel[2] * 4);
+			}
+		}
+
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			if (fingerprint->cells[i][c] != (float)(sums[c] & NV_FINGERPRINT_MASK))
+			{
+				return false;
+			}
+
+			wrapped = wrapped || sums[c] > NV_FINGERPRINT_MASK;
+		}
+	}
+
+	return wrapped;
+}
+
+
+
+bool nv_fingerprint_check(void)
+{
+	uint8_t frame[FRAME_HEIGHT * FRAME_PITCH];
+	uint8_t changed_frame[FRAME_HEIGHT * FRAME_PITCH];
+	fill_noise(frame, sizeof(frame));
+
+	struct nv_fingerprint a, b;
+	bool changed[NV_FINGERPRINT_CELLS];
+
+	/* The same frame fingerprints the same */
+	nv_fingerprint_rgba8(frame, FRAME_PITCH, FRAME_WIDTH, FRAME_HEIGHT, false, &a);
+	nv_fingerprint_rgba8(frame, FRAME_PITCH, FRAME_WIDTH, FRAME_HEIGHT, false, &b);
+	bool success = nv_fingerprint_equal(&a, &b) && nv_fingerprint_diff(&a, &b, changed) == 0;
+
+	/* A single component of a single pixel changed by one only changes its cell */
+	memcpy(changed_frame, frame, sizeof(frame));
+	changed_frame[17 * FRAME_PITCH + 33 * 4 + 1] ^= 1;
+	nv_fingerprint_rgba8(changed_frame, FRAME_PITCH, FRAME_WIDTH, FRAME_HEIGHT, false, &b);
+
+	const uint32_t one[1] = {cell_of(33, 17, FRAME_WIDTH, FRAME_HEIGHT)};
+	success = success && !nv_fingerprint_equal(&a, &b) && only_changed(changed, nv_fingerprint_diff(&a, &b, changed), one, 1);
+
+	/* Two pixels of the same cell swapped leave its plain sums alone, the weights still change it */
+	memcpy(changed_frame, frame, sizeof(frame));
+	const uint32_t x0 = 40, x1 = 42, y = 20;
+	const uint8_t first[4] = {10, 20, 30, 255};
+	const uint8_t second[4] = {200, 150, 100, 255};
+	memcpy(frame + y * FRAME_PITCH + x0 * 4, first, 4);
+	memcpy(frame + y * FRAME_PITCH + x1 * 4, second, 4);
+	memcpy(changed_frame + y * FRAME_PITCH + x0 * 4, second, 4);
+	memcpy(changed_frame + y * FRAME_PITCH + x1 * 4, first, 4);
+	nv_fingerprint_rgba8(frame, FRAME_PITCH, FRAME_WIDTH, FRAME_HEIGHT, false, &a);
+	nv_fingerprint_rgba8(changed_frame, FRAME_PITCH, FRAME_WIDTH, FRAME_HEIGHT, false, &b);
+
+	const uint32_t swapped[1] = {cell_of(x0, y, FRAME_WIDTH, FRAME_HEIGHT)};
+	success = success && swapped[0] == cell_of(x1, y, FRAME_WIDTH, FRAME_HEIGHT) &&
+		  only_changed(changed, nv_fingerprint_diff(&a, &b, changed), swapped, 1);
+
+	/* Changes scattered over the frame mark exactly the cells they fall in, however many pixels of each changed */
+	const uint32_t points[][2] = {{0, 0}, {1, 1}, {69, 40}, {35, 0}, {0, 21}, {5, 38}, {6, 38}};
+	uint32_t cells[sizeof(points) / sizeof(points[0])];
+	uint32_t cell_count = 0;
+
+	memcpy(changed_frame, frame, sizeof(frame));
+
+	for (uint32_t i = 0; i < sizeof(points) / sizeof(points[0]); ++i)
+	{
+		changed_frame[points[i][1] * FRAME_PITCH + points[i][0] * 4] += 1;
+
+		const uint32_t cell = cell_of(points[i][0], points[i][1], FRAME_WIDTH, FRAME_HEIGHT);
+		bool found = false;
+
+		for (uint32_t j = 0; j < cell_count; ++j)
+		{
+			found = found || cells[j] == cell;
+		}
+
+		if (!found)
+		{
+			cells[cell_count++] = cell;
+		}
+	}
+
+	nv_fingerprint_rgba8(changed_frame, FRAME_PITCH, FRAME_WIDTH, FRAME_HEIGHT, false, &b);
+	success = success && cell_count == 5 && only_changed(changed, nv_fingerprint_diff(&a, &b, changed), cells, cell_count);
+
+	/* The planar input of either scale fingerprints the same as the chunky image it was converted from, in either order */
+	const float scales[2] = {NV_PLANAR_SCALE_UNIT, NV_PLANAR_SCALE_BYTE};
+	float planar[NV_PLANAR_PLANES * FRAME_HEIGHT * FRAME_WIDTH];
+
+	for (uint32_t s = 0; s < 2 && success; ++s)
+	{
+		nv_convert_rgba8_to_planar_f32(frame, FRAME_PITCH, FRAME_WIDTH, FRAME_HEIGHT, false, scales[s], planar,
+					       FRAME_WIDTH * sizeof(float));
+		nv_fingerprint_planar_f32(planar, FRAME_WIDTH * sizeof(float), FRAME_WIDTH, FRAME_HEIGHT, scales[s], &b);
+		success = nv_fingerprint_equal(&a, &b);
+
+		nv_convert_rgba8_to_planar_f32(frame, FRAME_PITCH, FRAME_WIDTH, FRAME_HEIGHT, true, scales[s], planar,
+					       FRAME_WIDTH * sizeof(float));
+		nv_fingerprint_planar_f32(planar, FRAME_WIDTH * sizeof(float), FRAME_WIDTH, FRAME_HEIGHT, scales[s], &b);
+		nv_fingerprint_rgba8(frame, FRAME_PITCH, FRAME_WIDTH, FRAME_HEIGHT, true, &a);
+		success = success && nv_fingerprint_equal(&a, &b);
+
+		nv_fingerprint_rgba8(frame, FRAME_PITCH, FRAME_WIDTH, FRAME_HEIGHT, false, &a);
+	}
+
+	/* The sums of a 4K frame wrap, and still come out as the exact sums reduced modulo 2^23 */
+	uint8_t *large = malloc((size_t)LARGE_WIDTH * LARGE_HEIGHT * 4);
+
+	if (!large)
+	{
+		return false;
+	}
+
+	fill_noise(large, (size_t)LARGE_WIDTH * LARGE_HEIGHT * 4);
+	nv_fingerprint_rgba8(large, LARGE_WIDTH * 4, LARGE_WIDTH, LARGE_HEIGHT, false, &a);
+	success = success && sums_wrap(large, LARGE_WIDTH, LARGE_HEIGHT, &a);
+
+	free(large);
+	return success;
+}
@@ -0,0 +1,146 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include "superres-plan.h"
+#include "superres-tests.h"
+
+
+
+/* Checks that no two buffers sharing an allocation are live at once, and that every allocation fits its buffers */
+static bool plan_is_sound(const struct nv_plan_shape *shape, const struct nv_plan *plan)
+{
+	size_t planned = 0;
+
+	for (uint32_t b = 0; b < plan->backing_count; ++b)
+	{
+		planned += plan->backing_bytes[b];
+	}
+
+	if (planned != plan->planned_bytes || planned > plan->separate_bytes)
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < NV_PLAN_BUFFERS; ++i)
+	{
+		const uint32_t live = nv_plan_live_steps(shape, (enum nv_plan_buffer)i);
+
+		if ((live != 0) != (plan->backing[i] >= 0) || plan->backing[i] >= (int)plan->backing_count)
+		{
+			return false;
+		}
+
+		if (plan->backing[i] < 0)
+		{
+			continue;
+		}
+
+		if (plan->backing_bytes[plan->backing[i]] < shape->bytes[i])
+		{
+			return false;
+		}
+
+		for (uint32_t j = i + 1; j < NV_PLAN_BUFFERS; ++j)
+		{
+			if (plan->backing[j] == plan->backing[i] && (nv_plan_live_steps(shape, (enum nv_plan_buffer)j) & live))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+
+bool nv_plan_stub_check(void)
+{
+	/* Source and output sizes, with the bytes per pixel of BGR f32 planar and RGBA U8 buffers */
+	const size_t sizes[][2] =
+	{
+		{1280 * 720, 2560 * 1440},
+		{1920 * 1080, 3840 * 2160},
+		{640 * 480, 640 * 480},
+	};
+	const size_t planar = 12;
+	const size_t rgba = 4;
+
+	bool success = true;
+
+	for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && success; ++s)
+	{
+		const size_t in = sizes[s][0];
+		const size_t out = sizes[s][1];
+
+		/* Every combination of the passes, SuperRes or Upscaling, and batching */
+		for (uint32_t bits = 0; bits < 16 && success; ++bits)
+		{
+			struct nv_plan_shape shape = {0};
+			shape.ar = (bits & 1) != 0;
+			shape.sr = (bits & 2) != 0;
+			shape.sr_reads_ar = shape.ar && shape.sr && (bits & 4) != 0; // SuperRes, otherwise Upscaling
+			shape.batched = (bits & 8) != 0;
+
+			const size_t sr_pixel = shape.sr_reads_ar || !shape.ar ? planar : rgba;
+			shape.bytes[NV_PLAN_AR_SRC] = in * planar;
+			shape.bytes[NV_PLAN_AR_DST] = in * planar;
+			shape.bytes[NV_PLAN_SR_SRC] = in * sr_pixel;
+			shape.bytes[NV_PLAN_SR_DST] = out * sr_pixel;
+
+			struct nv_plan plan;
+			nv_plan_buffers(&shape, &plan);
+
+			success = plan_is_sound(&shape, &plan);
+
+			if (!success)
+			{
+				break;
+			}
+
+			const bool path_c = shape.ar && shape.sr;
+
+			if (!path_c || shape.batched)
+			{
+				/* Path A and B buffers are all live while their effect runs, and a batch keeps the SR ones live throughout */
+				success = plan.planned_bytes == plan.separate_bytes;
+			}
+			else if (shape.sr_reads_ar)
+			{
+				/* The AR source is done with by the time SuperRes writes its output */
+				success = plan.backing_count == 2 && plan.backing[NV_PLAN_AR_SRC] == plan.backing[NV_PLAN_SR_DST] &&
+					  plan.backing[NV_PLAN_SR_SRC] < 0;
+			}
+			else
+			{
+				/* The AR source holds the Upscaling source, and the AR output the Upscaling output */
+				success = plan.backing_count == 2 && plan.backing[NV_PLAN_AR_SRC] == plan.backing[NV_PLAN_SR_SRC] &&
+					  plan.backing[NV_PLAN_AR_DST] == plan.backing[NV_PLAN_SR_DST] &&
+					  plan.planned_bytes == in * planar + (out * rgba > in * planar ? out * rgba : in * planar);
+			}
+		}
+	}
+
+	/* A shape without any pass plans nothing */
+	struct nv_plan_shape none = {0};
+	struct nv_plan plan;
+	nv_plan_buffers(&none, &plan);
+
+	return success && plan.backing_count == 0 && plan.planned_bytes == 0;
+}
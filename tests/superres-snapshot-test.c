@@ -0,0 +1,97 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include <util/threading.h>
+#include "superres-snapshot.h"
+#include "superres-tests.h"
+
+
+
+/* Large enough that a torn copy would show, every word holds the generation it was published with */
+#define STUB_WORDS 64
+
+struct stub_writer
+{
+	struct nv_snapshot *snapshot;
+	uint32_t count;
+};
+
+static void *stub_writer_thread(void *data)
+{
+	struct stub_writer *writer = (struct stub_writer *)data;
+	uint64_t value[STUB_WORDS];
+
+	for (uint32_t i = 1; i <= writer->count; ++i)
+	{
+		for (uint32_t word = 0; word < STUB_WORDS; ++word)
+		{
+			value[word] = i;
+		}
+
+		nv_snapshot_publish(writer->snapshot, value);
+	}
+
+	return NULL;
+}
+
+
+
+bool nv_snapshot_stub_check(uint32_t count)
+{
+	const uint64_t initial[STUB_WORDS] = {0};
+	struct nv_snapshot *snapshot = nv_snapshot_create(sizeof(initial), initial);
+
+	if (!snapshot)
+	{
+		return false;
+	}
+
+	struct stub_writer writer = {snapshot, count};
+	pthread_t thread;
+
+	if (pthread_create(&thread, NULL, stub_writer_thread, &writer) != 0)
+	{
+		nv_snapshot_destroy(snapshot);
+		return false;
+	}
+
+	bool success = true;
+	uint64_t last = 0;
+
+	/* Until the last value shows up, which it has to once the writer is done */
+	while (success && last < count)
+	{
+		uint64_t generation;
+		const uint64_t *value = (const uint64_t *)nv_snapshot_acquire(snapshot, &generation);
+
+		success = generation >= last;
+
+		for (uint32_t word = 0; word < STUB_WORDS && success; ++word)
+		{
+			success = value[word] == generation;
+		}
+
+		last = generation;
+	}
+
+	pthread_join(thread, NULL);
+	nv_snapshot_destroy(snapshot);
+
+	return success;
+}
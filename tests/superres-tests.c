@@ -0,0 +1,94 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include "superres-batch.h"
+#include "superres-tests.h"
+
+
+
+/* The number of values the snapshot check publishes, enough for the reader to race the writer throughout */
+#define SNAPSHOT_VALUES 200000
+
+struct check
+{
+	const char *name;
+	bool (*run)(void);
+};
+
+static bool check_batch(void)
+{
+	return nv_batch_stub_check(2 * NV_BATCH_MAX);
+}
+
+static bool check_snapshot(void)
+{
+	return nv_snapshot_stub_check(SNAPSHOT_VALUES);
+}
+
+static const struct check checks[] =
+{
+	{"convert", nv_convert_planar_check},
+	{"resolve", nv_convert_resolve_check},
+	{"fingerprint", nv_fingerprint_check},
+	{"tiles", nv_tile_check},
+	{"oversized", nv_tile_oversized_check},
+	{"batch", check_batch},
+	{"caps", nv_caps_stub_check},
+	{"snapshot", check_snapshot},
+	{"yuv", nv_convert_yuv_check},
+	{"plan", nv_plan_stub_check},
+	{"arena", nv_arena_stub_check},
+};
+
+
+
+/*
+* Runs the check named on the command line, or all of them without one
+* return - 0 if every check that was run passed, 1 otherwise
+*/
+int main(int argc, char **argv)
+{
+	const char *name = argc > 1 ? argv[1] : NULL;
+	bool found = false;
+	bool success = true;
+
+	for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); ++i)
+	{
+		if (name && strcmp(name, checks[i].name) != 0)
+		{
+			continue;
+		}
+
+		const bool passed = checks[i].run();
+		printf("%s: %s\n", checks[i].name, passed ? "passed" : "FAILED");
+
+		found = true;
+		success = success && passed;
+	}
+
+	if (!found)
+	{
+		fprintf(stderr, "Unknown check %s\n", name);
+		return 1;
+	}
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+* Converts a small chunky image to planar in RGBA and BGRA order at both scales, checking the B, G and R planes are read from
+* the right components and scaled exactly, and that resolving the planes gives the image back with alpha made opaque
+*
+* return - true if every component came out as expected
+*/
+bool nv_convert_planar_check(void);
+
+/*
+* Resolves planar components at the edges of the range and half way between two 8 bit values, at both scales and in RGBA
+* and BGRA order, checking out of range values are clamped, halves round up, and alpha is written as 255
+*
+* return - true if every pixel came out as expected
+*/
+bool nv_convert_resolve_check(void);
+
+/*
+* Fingerprints frames with pixels changed, swapped and scattered over several cells, checking only the cells that changed differ,
+* that the planar fingerprint at both scales matches the chunky one, and that the sums of a 4K frame wrap modulo 2^23 exactly
+*
+* return - true if every fingerprint came out as expected
+*/
+bool nv_fingerprint_check(void);
+
+/*
+* Lays tiles over sources of sizes that don't divide into tiles, checking the cores cover every pixel once from aligned origins,
+* that the tiled output of a per-pixel effect is the untiled one, and that changed cells plan the tiles they touch
+*
+* return - true if every layout and plan is sound
+*/
+bool nv_tile_check(void);
+
+/*
+* Lays tiles of the size of the effect limits over sources past them, checking every tile fits the effect, and that the blended
+* bands between tiles ramp over output their neighbor already wrote with weights that add up to 1
+*
+* return - true if every layout is sound
+*/
+bool nv_tile_oversized_check(void);
+
+/*
+* Runs a batch service with a backend on the CPU through a sequence of frames, with members joining, leaving, skipping frames,
+* and sharing or not sharing a key, checking each member gets its own output back
+*
+* param members - the number of members to check with, at most 2 * NV_BATCH_MAX so groups also get split into several batches
+* return - true if every member got every output back, and only its own
+*/
+bool nv_batch_stub_check(uint32_t members);
+
+/*
+* Runs a table through a stub probe that stands in for NvVFX, checking every configuration is probed once, and that the outcomes
+* survive being saved and parsed again for the same device, but not for another
+*
+* return - true if the table behaved
+*/
+bool nv_caps_stub_check(void);
+
+/*
+* Publishes values from one thread while acquiring them on another as fast as both can, checking every value acquired is
+* one that was published whole, and that the generations acquired never go back. Meant to be run under ThreadSanitizer as well
+*
+* param count - the number of values to publish
+* return - true if the reader only ever got whole values, in order, and ended up with the last one
+*/
+bool nv_snapshot_stub_check(uint32_t count);
+
+/*
+* Converts solid colored 4:2:0 frames of partial range BT.709 through the CPU reference of the YUV ingest, checking I420 and NV12
+* give the same pixels, samples outside the range are clamped, each chroma sample covers its 2x2 luma samples,
+* and the planar effect input made from the pixels resolves back to them exactly
+*
+* return - true if every pixel came out as expected
+*/
+bool nv_convert_yuv_check(void);
+
+/*
+* Plans every shape of paths A, B and C, with and without batching and at several sizes, checking no two buffers live
+* during the same step share an allocation, every allocation fits its buffers, and the known aliases are found
+*
+* return - true if every plan is sound
+*/
+bool nv_plan_stub_check(void);
+
+/*
+* Runs an arena over a backend handing out fake addresses through resizes, frees in every order and trims,
+* checking blocks are aligned and never overlap, a resize to a size that was held before doesn't reserve anything,
+* the chunk reserved up front survives trims, and the counters add up
+*
+* return - true if the arena behaved
+*/
+bool nv_arena_stub_check(void);
+
+#ifdef __cplusplus
+}
+#endif
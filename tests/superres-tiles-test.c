@@ -0,0 +1,398 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "superres-tiles.h"
+#include "superres-tests.h"
+
+
+
+/* These mirror the filter: the tile size and overlap of tiled updates, the most tiles an oversized source may be split into,
+* and the rows of nv_type_resolutions the oversized layouts are checked against
+*/
+#define NV_TILE_SIZE 240
+#define NV_TILE_OVERLAP 12
+#define NV_TILE_MAX 64
+
+static const uint32_t ar_limits[2][2] = {{160, 90}, {1920, 1080}};
+static const uint32_t sr_3x_limits[2][2] = {{160, 90}, {1280, 720}};
+static const uint32_t sr_4x_limits[2][2] = {{160, 90}, {960, 540}};
+
+/* Sources that aren't multiples of NV_TILE_SIZE, nor of NV_TILE_ALIGN for some, with a last column or row of a single pixel,
+* and with the input of a tile before the last pushed back against the edge of the source
+*/
+static const uint32_t source_sizes[][2] =
+{
+	{1000, 563},
+	{1283, 721},
+	{1920, 1080},
+	{241, 240},
+	{457, 457},
+	{437, 441},
+};
+
+
+
+/* Checks the tiles of a layout are within the source, their cores within their inputs, their origins aligned,
+* and that the cores cover every pixel of the source exactly once
+*/
+static bool layout_covers(const struct nv_tile_layout *layout)
+{
+	uint8_t *covered = calloc((size_t)layout->width * layout->height, 1);
+
+	if (!covered)
+	{
+		return false;
+	}
+
+	bool success = true;
+
+	for (uint32_t row = 0; row < layout->rows && success; ++row)
+	{
+		for (uint32_t col = 0; col < layout->cols && success; ++col)
+		{
+			struct nv_tile tile;
+			nv_tile_at(layout, col, row, &tile);
+
+			success = tile.input.width == layout->tile_width && tile.input.height == layout->tile_height &&
+				  tile.input.x + tile.input.width <= layout->width && tile.input.y + tile.input.height <= layout->height &&
+				  tile.core.x >= tile.input.x && tile.core.y >= tile.input.y &&
+				  tile.core.x + tile.core.width <= tile.input.x + tile.input.width &&
+				  tile.core.y + tile.core.height <= tile.input.y + tile.input.height && tile.core.width && tile.core.height;
+
+			/* Only the last column or row of a source whose size isn't aligned may start off the alignment, flush with its edge */
+			success = success && tile.core.x % NV_TILE_ALIGN == 0 && tile.core.y % NV_TILE_ALIGN == 0 &&
+				  (tile.input.x % NV_TILE_ALIGN == 0 || (col == layout->cols - 1 && tile.input.x + tile.input.width == layout->width)) &&
+				  (tile.input.y % NV_TILE_ALIGN == 0 || (row == layout->rows - 1 && tile.input.y + tile.input.height == layout->height));
+
+			for (uint32_t y = tile.core.y; y < tile.core.y + tile.core.height && success; ++y)
+			{
+				for (uint32_t x = tile.core.x; x < tile.core.x + tile.core.width; ++x)
+				{
+					covered[(size_t)y * layout->width + x]++;
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < (size_t)layout->width * layout->height && success; ++i)
+	{
+		success = covered[i] == 1;
+	}
+
+	free(covered);
+	return success;
+}
+
+
+
+/* Checks the tiles planned for a changed mask are the tiles whose input touches a changed cell, in row order,
+* and that no more than max_tiles of them are written
+*/
+static bool plans_dirty(const struct nv_tile_layout *layout, const bool changed[NV_FINGERPRINT_CELLS], uint32_t max_tiles)
+{
+	struct nv_tile planned[NV_TILE_MAX + 1];
+	memset(planned, 0xCD, sizeof(planned));
+
+	const uint32_t count = nv_tile_plan_dirty(layout, changed, planned, max_tiles);
+	uint32_t expected = 0;
+
+	for (uint32_t i = 0; i < layout->cols * layout->rows; ++i)
+	{
+		struct nv_tile tile;
+		nv_tile_at(layout, i % layout->cols, i / layout->cols, &tile);
+
+		bool dirty = false;
+
+		for (uint32_t cell = 0; cell < NV_FINGERPRINT_CELLS; ++cell)
+		{
+			uint32_t x0, x1, y0, y1;
+			nv_fingerprint_cell_bounds(cell % NV_FINGERPRINT_GRID, layout->width, &x0, &x1);
+			nv_fingerprint_cell_bounds(cell / NV_FINGERPRINT_GRID, layout->height, &y0, &y1);
+
+			dirty = dirty || (changed[cell] && x0 < tile.input.x + tile.input.width && tile.input.x < x1 &&
+					  y0 < tile.input.y + tile.input.height && tile.input.y < y1);
+		}
+
+		if (!dirty)
+		{
+			continue;
+		}
+
+		if (expected < max_tiles && memcmp(&planned[expected], &tile, sizeof(tile)) != 0)
+		{
+			return false;
+		}
+
+		++expected;
+	}
+
+	struct nv_tile untouched;
+	memset(&untouched, 0xCD, sizeof(untouched));
+
+	return count == expected && (count >= max_tiles || memcmp(&planned[count], &untouched, sizeof(untouched)) == 0) &&
+	       memcmp(&planned[max_tiles], &untouched, sizeof(untouched)) == 0;
+}
+
+
+
+/* A per-pixel effect scaling by a whole factor, replicating every pixel and inverting its color, so the output of every
+* pixel is the same whichever tile it was processed in
+*/
+static void process_replicate(const uint8_t *src, uint32_t src_pitch, uint32_t width, uint32_t height, uint8_t *dst,
+			      uint32_t dst_pitch, uint32_t out_width, uint32_t out_height, void *param)
+{
+	const uint32_t factor = out_width / width;
+	(void)height;
+	(void)out_height;
+	(void)param;
+
+	for (uint32_t y = 0; y < out_height; ++y)
+	{
+		for (uint32_t x = 0; x < out_width; ++x)
+		{
+			const uint8_t *in = src + (size_t)(y / factor) * src_pitch + (x / factor) * 4;
+			uint8_t *out = dst + (size_t)y * dst_pitch + x * 4;
+
+			out[0] = 255 - in[0];
+			out[1] = 255 - in[1];
+			out[2] = 255 - in[2];
+			out[3] = in[3];
+		}
+	}
+}
+
+/* Runs every tile of a layout through the simulation, and compares the result to the effect run on the whole source */
+static bool simulates_untiled(const struct nv_tile_layout *layout, const uint8_t *src, uint32_t factor)
+{
+	const uint32_t out_width = layout->width * factor;
+	const uint32_t out_height = layout->height * factor;
+	const uint32_t src_pitch = layout->width * 4;
+	const uint32_t out_pitch = out_width * 4;
+	struct nv_tile *tiles = malloc(sizeof(struct nv_tile) * layout->cols * layout->rows);
+	uint8_t *tiled = calloc((size_t)out_pitch * out_height, 1);
+	uint8_t *whole = malloc((size_t)out_pitch * out_height);
+
+	bool success = tiles && tiled && whole;
+
+	if (success)
+	{
+		for (uint32_t i = 0; i < layout->cols * layout->rows; ++i)
+		{
+			nv_tile_at(layout, i % layout->cols, i / layout->cols, &tiles[i]);
+		}
+
+		process_replicate(src, src_pitch, layout->width, layout->height, whole, out_pitch, out_width, out_height, NULL);
+		success = nv_tile_simulate_rgba8(layout, tiles, layout->cols * layout->rows, src, src_pitch, tiled, out_pitch, out_width,
+						 out_height, layout->tile_width * factor, layout->tile_height * factor, process_replicate, NULL) &&
+			  memcmp(tiled, whole, (size_t)out_pitch * out_height) == 0;
+	}
+
+	free(tiles);
+	free(tiled);
+	free(whole);
+	return success;
+}
+
+
+
+bool nv_tile_check(void)
+{
+	bool success = true;
+
+	/* A source smaller than a tile, or a tile too small for its overlap, has no layout */
+	struct nv_tile_layout layout;
+	success = !nv_tile_layout_init(&layout, 200, 200, NV_TILE_SIZE, NV_TILE_SIZE, NV_TILE_OVERLAP) &&
+		  !nv_tile_layout_init(&layout, 1000, 1000, 30, 30, NV_TILE_OVERLAP);
+
+	for (uint32_t i = 0; i < sizeof(source_sizes) / sizeof(source_sizes[0]) && success; ++i)
+	{
+		success = nv_tile_layout_init(&layout, source_sizes[i][0], source_sizes[i][1], NV_TILE_SIZE, NV_TILE_SIZE, NV_TILE_OVERLAP) &&
+			  layout.feather > 0 && layout_covers(&layout);
+	}
+
+	/* The tiled output of an identity and of a per-pixel effect is the untiled output, seams and feathered bands included */
+	uint8_t *src = malloc((size_t)1283 * 721 * 4);
+	success = success && src;
+
+	if (success)
+	{
+		uint32_t seed = 0x68E31DA4u;
+
+		for (size_t i = 0; i < (size_t)1283 * 721 * 4; ++i)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			src[i] = (uint8_t)(seed >> 24);
+		}
+
+		success = nv_tile_layout_init(&layout, 1283, 721, NV_TILE_SIZE, NV_TILE_SIZE, NV_TILE_OVERLAP) &&
+			  simulates_untiled(&layout, src, 1) && simulates_untiled(&layout, src, 2);
+	}
+
+	free(src);
+
+	/* Changed cells map onto the tiles whose input they touch */
+	bool changed[NV_FINGERPRINT_CELLS];
+	memset(changed, 0, sizeof(changed));
+
+	success = success && nv_tile_layout_init(&layout, 1000, 563, NV_TILE_SIZE, NV_TILE_SIZE, NV_TILE_OVERLAP);
+	success = success && plans_dirty(&layout, changed, NV_TILE_MAX) && nv_tile_plan_dirty(&layout, changed, NULL, 0) == 0;
+
+	/* The top left cell is well within the core of the first tile, a cell on the boundary of two cores dirties both */
+	changed[0] = true;
+	struct nv_tile first;
+	success = success && nv_tile_plan_dirty(&layout, changed, &first, 1) == 1 && first.core.x == 0 && first.core.y == 0 &&
+		  plans_dirty(&layout, changed, NV_TILE_MAX);
+
+	changed[0] = false;
+	changed[3] = true;
+	success = success && nv_tile_plan_dirty(&layout, changed, NULL, 0) == 2 && plans_dirty(&layout, changed, NV_TILE_MAX);
+
+	/* A cell within the core of a tile but in the overlap of the one below dirties both */
+	changed[3] = false;
+	changed[NV_FINGERPRINT_GRID * 5] = true;
+	success = success && nv_tile_plan_dirty(&layout, changed, NULL, 0) == 2 && plans_dirty(&layout, changed, NV_TILE_MAX);
+
+	changed[NV_FINGERPRINT_GRID * 7 + 9] = true;
+	changed[NV_FINGERPRINT_CELLS - 1] = true;
+	success = success && plans_dirty(&layout, changed, NV_TILE_MAX);
+
+	/* More dirty tiles than fit are still counted, only the first of them written */
+	memset(changed, 1, sizeof(changed));
+	success = success && nv_tile_plan_dirty(&layout, changed, NULL, 0) == layout.cols * layout.rows && plans_dirty(&layout, changed, 4) &&
+		  plans_dirty(&layout, changed, NV_TILE_MAX);
+
+	return success;
+}
+
+
+
+/* Checks the tiles of an oversized layout fit the effect, and that written in row order the blended bands of every tile only
+* ever ramp over output a neighbor already wrote, so the weights of both add up to 1 across each overlap
+*/
+static bool blends_whole(const struct nv_tile_layout *layout, const uint32_t limits[2][2], uint32_t factor)
+{
+	const uint32_t out_width = layout->width * factor;
+	const uint32_t out_height = layout->height * factor;
+	const uint32_t tile_out_width = layout->tile_width * factor;
+	const uint32_t tile_out_height = layout->tile_height * factor;
+	uint8_t *covered = calloc((size_t)out_width * out_height, 1);
+
+	if (!covered)
+	{
+		return false;
+	}
+
+	bool success = layout->cols * layout->rows <= NV_TILE_MAX && layout->cols * layout->rows > 1;
+
+	for (uint32_t row = 0; row < layout->rows && success; ++row)
+	{
+		for (uint32_t col = 0; col < layout->cols && success; ++col)
+		{
+			struct nv_tile tile;
+			nv_tile_at(layout, col, row, &tile);
+
+			success = tile.input.width >= limits[0][0] && tile.input.width <= limits[1][0] && tile.input.height >= limits[0][1] &&
+				  tile.input.height <= limits[1][1];
+
+			struct nv_rect src, dst;
+			uint32_t ramp_left, ramp_top;
+			nv_tile_blend_rects(layout, &tile, out_width, out_height, tile_out_width, tile_out_height, &src, &dst, &ramp_left,
+					    &ramp_top);
+
+			success = success && src.width == dst.width && src.height == dst.height && src.x + src.width <= tile_out_width &&
+				  src.y + src.height <= tile_out_height && dst.x + dst.width <= out_width && dst.y + dst.height <= out_height;
+
+			/* Every tile with a neighbor before it ramps over a band centered on the boundary of their cores */
+			success = success && (col > 0) == (ramp_left > 0) && (row > 0) == (ramp_top > 0);
+
+			if (ramp_left)
+			{
+				const uint32_t boundary = tile.core.x * factor;
+				success = success && dst.x < boundary && dst.x + ramp_left > boundary && boundary - dst.x == dst.x + ramp_left - boundary;
+			}
+
+			if (ramp_top)
+			{
+				const uint32_t boundary = tile.core.y * factor;
+				success = success && dst.y < boundary && dst.y + ramp_top > boundary && boundary - dst.y == dst.y + ramp_top - boundary;
+			}
+
+			/* The ramp down of the neighbor mirrors the ramp up of the tile */
+			for (uint32_t i = 0; i < ramp_left && success; ++i)
+			{
+				const float sum = nv_tile_ramp(i, ramp_left) + nv_tile_ramp(ramp_left - 1 - i, ramp_left);
+				success = sum > 0.9999f && sum < 1.0001f;
+			}
+
+			for (uint32_t i = 0; i < ramp_top && success; ++i)
+			{
+				const float sum = nv_tile_ramp(i, ramp_top) + nv_tile_ramp(ramp_top - 1 - i, ramp_top);
+				success = sum > 0.9999f && sum < 1.0001f;
+			}
+
+			/* Wherever the tile's weight is below 1 the rest comes from output already written */
+			for (uint32_t y = 0; y < dst.height && success; ++y)
+			{
+				uint8_t *line = covered + (size_t)(dst.y + y) * out_width + dst.x;
+				const float weight_y = ramp_top ? nv_tile_ramp(y, ramp_top) : 1.0f;
+
+				for (uint32_t x = 0; x < dst.width; ++x)
+				{
+					const float weight = weight_y * (ramp_left ? nv_tile_ramp(x, ramp_left) : 1.0f);
+					success = success && (weight >= 1.0f || line[x]);
+					line[x] = 1;
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < (size_t)out_width * out_height && success; ++i)
+	{
+		success = covered[i] == 1;
+	}
+
+	free(covered);
+	return success;
+}
+
+
+
+bool nv_tile_oversized_check(void)
+{
+	struct nv_tile_layout layout;
+
+	/* Artifact Reduction on 1440p, past its 1080p limit, with tiles of the size of the limit */
+	bool success = nv_tile_layout_init(&layout, 2560, 1440, ar_limits[1][0], ar_limits[1][1], NV_TILE_OVERLAP) &&
+		       layout_covers(&layout) && blends_whole(&layout, ar_limits, 1);
+
+	/* SuperRes 4x on 720p, past its 540p limit, and 3x on 1080p, past its 720p one */
+	success = success && nv_tile_layout_init(&layout, 1280, 720, sr_4x_limits[1][0], sr_4x_limits[1][1], NV_TILE_OVERLAP) &&
+		  layout_covers(&layout) && blends_whole(&layout, sr_4x_limits, 4);
+	success = success && nv_tile_layout_init(&layout, 1920, 1080, sr_3x_limits[1][0], sr_3x_limits[1][1], NV_TILE_OVERLAP) &&
+		  layout_covers(&layout) && blends_whole(&layout, sr_3x_limits, 3);
+
+	/* A source only just past the limit along one axis spans it whole along the other, without a blend along it */
+	success = success && nv_tile_layout_init(&layout, 1921, 1080, ar_limits[1][0], ar_limits[1][1], NV_TILE_OVERLAP) &&
+		  layout.rows == 1 && layout_covers(&layout) && blends_whole(&layout, ar_limits, 1);
+
+	return success;
+}
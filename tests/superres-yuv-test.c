@@ -0,0 +1,211 @@
+/*
+obs-rtx_superresolution
+Copyright (C) 2023 Ben Jolley
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include <string.h>
+#include "superres-convert.h"
+#include "superres-tests.h"
+
+
+
+/* Clamps a [0, 1] float to an 8 bit unorm value, rounding to nearest as the GPU does when writing unorm render targets */
+static inline uint8_t unorm8(float value)
+{
+	if (!(value > 0.0f))
+		return 0;
+	if (value >= 1.0f)
+		return 255;
+
+	return (uint8_t)(value * 255.0f + 0.5f);
+}
+
+
+
+/* Clamps a normalized sample to the range of a frame, OBS does the same before applying the color matrix */
+static inline float clamp_sample(float value, const float *range_min, const float *range_max, uint32_t component)
+{
+	if (range_min && value < range_min[component])
+		return range_min[component];
+	if (range_max && value > range_max[component])
+		return range_max[component];
+
+	return value;
+}
+
+
+
+/*
+* CPU reference of the YUV ingest of async frames, NvCVImage_TransferFromYUV converting 8 bit 4:2:0 frames into the first effect input.
+* Converts the planes of a frame into an 8 bit RGBA (or BGRA) chunky image the way OBS draws the frame, clamping each sample to
+* the frame's range then multiplying (Y, U, V, 1) by the frame's color matrix. Each chroma sample covers the 2x2 luma samples
+* at its position, rather than being interpolated, so only solid colored areas compare exactly against the GPU.
+* Alpha is always written as opaque. Feed the result to nv_convert_rgba8_to_planar_f32 for the planar effect input.
+*
+* param y - pointer to sample (0, 0) of the luma plane
+* param y_pitch - byte stride between rows of y
+* param u - pointer to sample (0, 0) of the Cb plane, for NV12 the start of the interleaved plane
+* param v - pointer to sample (0, 0) of the Cr plane, for NV12 u + 1
+* param uv_step - byte stride between chroma samples horizontally, 1 for I420 and 2 for NV12
+* param uv_pitch - byte stride between rows of u and v
+* param width - width of both images
+* param height - height of both images
+* param matrix - the frame's color_matrix, row major, each row giving one of R, G and B from (Y, U, V, 1)
+* param range_min - the frame's color_range_min, the lowest Y, U and V value, or NULL to not clamp
+* param range_max - the frame's color_range_max, the highest Y, U and V value, or NULL to not clamp
+* param bgra - true if dst is BGRA ordered, false if RGBA
+* param dst - pointer to pixel (0, 0) of the chunky destination image
+* param dst_pitch - byte stride between rows of dst
+*/
+static void convert_yuv420_to_rgba8(const uint8_t *y, uint32_t y_pitch, const uint8_t *u, const uint8_t *v, uint32_t uv_step,
+				   uint32_t uv_pitch, uint32_t width, uint32_t height, const float matrix[16], const float range_min[3],
+				   const float range_max[3], bool bgra, uint8_t *dst, uint32_t dst_pitch)
+{
+	/* component offsets of R, G and B within a destination pixel, in matrix row order */
+	const uint32_t offsets[3] =
+	{
+		bgra ? 2 : 0,
+		1,
+		bgra ? 0 : 2
+	};
+
+	for (uint32_t row = 0; row < height; ++row)
+	{
+		const uint8_t *y_row = y + (size_t)row * y_pitch;
+		const uint8_t *u_row = u + (size_t)(row / 2) * uv_pitch;
+		const uint8_t *v_row = v + (size_t)(row / 2) * uv_pitch;
+		uint8_t *out = dst + (size_t)row * dst_pitch;
+
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const float yuv[3] =
+			{
+				clamp_sample((float)y_row[x] / 255.0f, range_min, range_max, 0),
+				clamp_sample((float)u_row[(x / 2) * uv_step] / 255.0f, range_min, range_max, 1),
+				clamp_sample((float)v_row[(x / 2) * uv_step] / 255.0f, range_min, range_max, 2)
+			};
+
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				const float *m = matrix + c * 4;
+				out[x * 4 + offsets[c]] = unorm8(m[0] * yuv[0] + m[1] * yuv[1] + m[2] * yuv[2] + m[3]);
+			}
+
+			out[x * 4 + 3] = 255;
+		}
+	}
+}
+
+
+
+/* The color_matrix and color_range_ OBS gives an 8 bit BT.709 frame of partial range */
+static const float bt709_matrix[16] =
+{
+	1.164384f, 0.000000f, 1.792741f, -0.972945f,
+	1.164384f, -0.213249f, -0.532909f, 0.301483f,
+	1.164384f, 2.112402f, 0.000000f, -1.133402f,
+	0.000000f, 0.000000f, 0.000000f, 1.000000f,
+};
+static const float bt709_min[3] = {16.0f / 255.0f, 16.0f / 255.0f, 16.0f / 255.0f};
+static const float bt709_max[3] = {235.0f / 255.0f, 240.0f / 255.0f, 240.0f / 255.0f};
+
+#define YUV_WIDTH 4
+#define YUV_HEIGHT 4
+
+/* return - the pixel at (x, y) of an RGBA8 image YUV_WIDTH wide */
+static inline const uint8_t *yuv_pixel(const uint8_t *rgba, uint32_t x, uint32_t y)
+{
+	return rgba + (y * YUV_WIDTH + x) * 4;
+}
+
+static inline bool pixel_equal(const uint8_t *a, const uint8_t *b)
+{
+	return memcmp(a, b, 4) == 0;
+}
+
+
+
+bool nv_convert_yuv_check(void)
+{
+	/* Black and white over neutral chroma on the left, a red on the right, then samples outside the range below them */
+	const uint8_t y[YUV_HEIGHT][YUV_WIDTH] =
+	{
+		{16, 235, 63, 63},
+		{235, 16, 63, 63},
+		{0, 255, 63, 63},
+		{16, 235, 63, 63},
+	};
+	const uint8_t u[YUV_HEIGHT / 2][YUV_WIDTH / 2] = {{128, 102}, {128, 102}};
+	const uint8_t v[YUV_HEIGHT / 2][YUV_WIDTH / 2] = {{128, 240}, {128, 240}};
+	uint8_t nv12[YUV_HEIGHT / 2][YUV_WIDTH];
+
+	for (uint32_t row = 0; row < YUV_HEIGHT / 2; ++row)
+	{
+		for (uint32_t x = 0; x < YUV_WIDTH / 2; ++x)
+		{
+			nv12[row][x * 2] = u[row][x];
+			nv12[row][x * 2 + 1] = v[row][x];
+		}
+	}
+
+	uint8_t i420_rgba[YUV_HEIGHT * YUV_WIDTH * 4];
+	uint8_t nv12_rgba[YUV_HEIGHT * YUV_WIDTH * 4];
+	uint8_t nv12_bgra[YUV_HEIGHT * YUV_WIDTH * 4];
+	const uint32_t pitch = YUV_WIDTH * 4;
+
+	convert_yuv420_to_rgba8(&y[0][0], YUV_WIDTH, &u[0][0], &v[0][0], 1, YUV_WIDTH / 2, YUV_WIDTH, YUV_HEIGHT, bt709_matrix, bt709_min,
+				bt709_max, false, i420_rgba, pitch);
+	convert_yuv420_to_rgba8(&y[0][0], YUV_WIDTH, &nv12[0][0], &nv12[0][1], 2, YUV_WIDTH, YUV_WIDTH, YUV_HEIGHT, bt709_matrix, bt709_min,
+				bt709_max, false, nv12_rgba, pitch);
+	convert_yuv420_to_rgba8(&y[0][0], YUV_WIDTH, &nv12[0][0], &nv12[0][1], 2, YUV_WIDTH, YUV_WIDTH, YUV_HEIGHT, bt709_matrix, bt709_min,
+				bt709_max, true, nv12_bgra, pitch);
+
+	const uint8_t black[4] = {0, 0, 0, 255};
+	const uint8_t white[4] = {255, 255, 255, 255};
+
+	/* Both layouts of the chroma read the same samples, and the range is the frame's */
+	bool success = memcmp(i420_rgba, nv12_rgba, sizeof(i420_rgba)) == 0 && pixel_equal(yuv_pixel(i420_rgba, 0, 0), black) &&
+		       pixel_equal(yuv_pixel(i420_rgba, 1, 0), white) && pixel_equal(yuv_pixel(i420_rgba, 0, 2), black) &&
+		       pixel_equal(yuv_pixel(i420_rgba, 1, 2), white);
+
+	/* A chroma sample covers its 2x2 luma samples, and the red comes out red */
+	const uint8_t *red = yuv_pixel(i420_rgba, 2, 0);
+	success = success && pixel_equal(red, yuv_pixel(i420_rgba, 3, 0)) && pixel_equal(red, yuv_pixel(i420_rgba, 2, 1)) &&
+		  pixel_equal(red, yuv_pixel(i420_rgba, 3, 3)) && red[0] > 200 && red[1] < 30 && red[2] < 30;
+
+	for (uint32_t i = 0; i < YUV_WIDTH * YUV_HEIGHT && success; ++i)
+	{
+		const uint8_t *rgba = i420_rgba + i * 4;
+		const uint8_t *bgra = nv12_bgra + i * 4;
+		success = rgba[0] == bgra[2] && rgba[1] == bgra[1] && rgba[2] == bgra[0] && bgra[3] == 255;
+	}
+
+	/* The planar effect input the ingest writes resolves back to the same pixels, at both scales the effects take */
+	const float scales[2] = {NV_PLANAR_SCALE_UNIT, NV_PLANAR_SCALE_BYTE};
+	float planar[NV_PLANAR_PLANES * YUV_HEIGHT * YUV_WIDTH];
+	uint8_t resolved[YUV_HEIGHT * YUV_WIDTH * 4];
+
+	for (uint32_t s = 0; s < 2 && success; ++s)
+	{
+		nv_convert_rgba8_to_planar_f32(nv12_bgra, pitch, YUV_WIDTH, YUV_HEIGHT, true, scales[s], planar, YUV_WIDTH * sizeof(float));
+		nv_convert_planar_f32_to_rgba8(planar, YUV_WIDTH * sizeof(float), YUV_WIDTH, YUV_HEIGHT, NV_PLANAR_SCALE_UNIT / scales[s], false,
+					       resolved, pitch);
+		success = memcmp(resolved, i420_rgba, sizeof(resolved)) == 0;
+	}
+
+	return success;
+}